@@ -119,4 +119,79 @@ inline int32_t dmAtomicCompareStore32(int32_atomic_t *ptr, int32_t value, int32_
 #endif
 }
 
+/**
+ * Atomic load of a int32_atomic_t, with acquire semantics.
+ * @param ptr Pointer to a int32_atomic_t to load.
+ * @return Value
+ */
+inline int32_t dmAtomicGet32(int32_atomic_t *ptr)
+{
+#if defined(_MSC_VER)
+	// Volatile loads have acquire semantics with /volatile:ms, the default on x86 and x64
+	int32_t value = *ptr;
+	_ReadWriteBarrier();
+	return value;
+#else
+	return __atomic_load_n((int32_atomic_t*) ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Atomic store of a int32_atomic_t, with release semantics. Cheaper than #dmAtomicStore32 as it isn't an exchange.
+ * @param ptr Pointer to a int32_atomic_t to store into.
+ * @param value Value to store.
+ */
+inline void dmAtomicSet32(int32_atomic_t *ptr, int32_t value)
+{
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+	*ptr = value;
+#else
+	__atomic_store_n((int32_atomic_t*) ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Atomic load of a pointer, with acquire semantics.
+ * @param ptr Pointer to the pointer to load.
+ * @return Value
+ */
+inline void* dmAtomicGetPointer(void* volatile* ptr)
+{
+#if defined(_MSC_VER)
+	void* value = *ptr;
+	_ReadWriteBarrier();
+	return value;
+#else
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/**
+ * Atomic store of a pointer, with release semantics.
+ * @param ptr Pointer to the pointer to store into.
+ * @param value Value to store.
+ */
+inline void dmAtomicSetPointer(void* volatile* ptr, void* value)
+{
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+	*ptr = value;
+#else
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+#endif
+}
+
+/**
+ * Full memory barrier. Loads and stores after the barrier are not reordered with loads and stores before it.
+ */
+inline void dmAtomicFence()
+{
+#if defined(_MSC_VER)
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
 #endif //DM_ATOMIC_H
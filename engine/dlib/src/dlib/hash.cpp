@@ -16,10 +16,11 @@
 #include "dlib.h"
 #include "hash.h"
 #include "mutex.h"
-#include "hashtable.h"
+#include "open_hashtable.h"
 #include "array.h"
 #include "index_pool.h"
 #include "align.h"
+#include "static_assert.h"
 
 struct ReverseHashEntry
 {
@@ -28,37 +29,179 @@ struct ReverseHashEntry
     uint16_t m_Length;
 };
 
+// Storage for the reverse hash strings of a shard. Strings are allocated from pages in power of two
+// size classes, and erased strings are reused by later strings of the same size class.
+struct ReverseHashArena
+{
+    static const uint32_t m_PageSize = 16384;
+    static const uint32_t m_MinSizeShift = 4;
+    static const uint32_t m_SizeClassCount = 8;
+
+    dmArray<uint8_t*> m_Pages;
+    void*             m_FreeLists[m_SizeClassCount];
+    uint32_t          m_PageUsed;
+
+    ReverseHashArena()
+    {
+        memset(m_FreeLists, 0, sizeof(m_FreeLists));
+        m_PageUsed = m_PageSize;
+    }
+
+    ~ReverseHashArena()
+    {
+        Clear();
+    }
+
+    static inline uint32_t SizeClass(uint32_t size)
+    {
+        uint32_t size_class = 0;
+        while ((1U << (size_class + m_MinSizeShift)) < size)
+            ++size_class;
+        return size_class;
+    }
+
+    char* Alloc(uint32_t size)
+    {
+        uint32_t size_class = SizeClass(size);
+        assert(size_class < m_SizeClassCount);
+        void* free_entry = m_FreeLists[size_class];
+        if (free_entry)
+        {
+            m_FreeLists[size_class] = *(void**) free_entry;
+            return (char*) free_entry;
+        }
+
+        uint32_t class_size = 1U << (size_class + m_MinSizeShift);
+        if (m_PageUsed + class_size > m_PageSize)
+        {
+            if (m_Pages.Full())
+                m_Pages.OffsetCapacity(16);
+            m_Pages.Push((uint8_t*) malloc(m_PageSize));
+            m_PageUsed = 0;
+        }
+        char* p = (char*) m_Pages.Back() + m_PageUsed;
+        m_PageUsed += class_size;
+        return p;
+    }
+
+    void Free(void* p, uint32_t size)
+    {
+        uint32_t size_class = SizeClass(size);
+        *(void**) p = m_FreeLists[size_class];
+        m_FreeLists[size_class] = p;
+    }
+
+    void Clear()
+    {
+        for (uint32_t i = 0; i < m_Pages.Size(); ++i)
+        {
+            free(m_Pages[i]);
+        }
+        m_Pages.SetSize(0);
+        memset(m_FreeLists, 0, sizeof(m_FreeLists));
+        m_PageUsed = m_PageSize;
+    }
+};
+
+// The reverse hash tables are split in shards, selected by the top bits of the hash, each with its own lock
+// and string arena. Threads hashing different strings then rarely wait for each other.
+struct ReverseHashShard
+{
+    dmMutex::HMutex                               m_Mutex;
+    dmOpenHashTable<uint32_t, ReverseHashEntry>   m_HashTable32Entries;
+    dmOpenHashTable<uint64_t, ReverseHashEntry>   m_HashTable64Entries;
+    ReverseHashArena                              m_Arena;
+
+    char* CopyString(const void* buffer, uint32_t len)
+    {
+        char* copy = m_Arena.Alloc(len + 1);
+        memcpy(copy, buffer, len);
+        copy[len] = '\0';
+        return copy;
+    }
+
+    template <typename KEY>
+    void Insert(dmOpenHashTable<KEY, ReverseHashEntry>* hash_table, KEY hash, const void* buffer, uint32_t len)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        if (hash_table->Get(hash) == 0)
+        {
+            hash_table->Put(hash, ReverseHashEntry(CopyString(buffer, len), len));
+        }
+    }
+
+    template <typename KEY>
+    const void* Get(dmOpenHashTable<KEY, ReverseHashEntry>* hash_table, KEY hash, uint32_t* length)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        ReverseHashEntry* reverse = hash_table->Get(hash);
+        if (reverse)
+        {
+            if (length)
+            {
+                *length = reverse->m_Length;
+            }
+            return reverse->m_Value;
+        }
+        return 0;
+    }
+
+    template <typename KEY>
+    void Erase(dmOpenHashTable<KEY, ReverseHashEntry>* hash_table, KEY hash)
+    {
+        DM_MUTEX_SCOPED_LOCK(m_Mutex);
+        ReverseHashEntry* reverse = hash_table->Get(hash);
+        if (reverse)
+        {
+            m_Arena.Free(reverse->m_Value, reverse->m_Length + 1);
+            hash_table->Erase(hash);
+        }
+    }
+};
+
 struct ReverseHashContainer
 {
-    static const size_t m_HashTableSize = 1024;
-    static const size_t m_HashTableCapacity = 512;
-    static const size_t m_HashTableCapacityIncrement = 256;
+    static const uint32_t m_ShardBits = 5;
+    static const uint32_t m_ShardCount = 1 << m_ShardBits;
     static const size_t m_HashStatesCapacity = 512;
     static const size_t m_HashStatesCapacityIncrement = 256;
 
+    // Guards enabling/disabling and the incremental hash states
     dmMutex::HMutex                 m_Mutex;
     bool                            m_Enabled;
-    dmHashTable32<ReverseHashEntry> m_HashTable32Entries;
-    dmHashTable64<ReverseHashEntry> m_HashTable64Entries;
+    ReverseHashShard                m_Shards[m_ShardCount];
     dmArray<ReverseHashEntry>       m_HashStates;
     dmIndexPool32                   m_HashStatesSlots;
 
     ReverseHashContainer()
     {
+        DM_STATIC_ASSERT((1U << (ReverseHashArena::m_SizeClassCount - 1 + ReverseHashArena::m_MinSizeShift)) >= DMHASH_MAX_REVERSE_LENGTH + 1, Invalid_Reverse_Hash_Size_Classes);
         m_Mutex = dmMutex::New();
         m_Enabled = false;
+        for (uint32_t i = 0; i < m_ShardCount; ++i)
+        {
+            m_Shards[i].m_Mutex = dmMutex::New();
+        }
     }
 
     ~ReverseHashContainer()
     {
         Enable(false);
+        for (uint32_t i = 0; i < m_ShardCount; ++i)
+        {
+            dmMutex::Delete(m_Shards[i].m_Mutex);
+        }
         dmMutex::Delete(m_Mutex);
     }
 
-    template <typename KEY>
-    static inline void FreeEntryCallback(void* context, const KEY* key, ReverseHashEntry* value)
+    inline ReverseHashShard& GetShard32(uint32_t hash)
+    {
+        return m_Shards[hash >> (32 - m_ShardBits)];
+    }
+
+    inline ReverseHashShard& GetShard64(uint64_t hash)
     {
-        free(value->m_Value);
+        return m_Shards[hash >> (64 - m_ShardBits)];
     }
 
     template <typename INDEX>
@@ -75,15 +218,17 @@ struct ReverseHashContainer
         DM_MUTEX_SCOPED_LOCK(m_Mutex);
         m_Enabled = enable;
 
-        if(enable)
+        for (uint32_t i = 0; i < m_ShardCount; ++i)
         {
+            ReverseHashShard& shard = m_Shards[i];
+            DM_MUTEX_SCOPED_LOCK(shard.m_Mutex);
+            shard.m_HashTable32Entries.Clear();
+            shard.m_HashTable64Entries.Clear();
+            shard.m_Arena.Clear();
+        }
 
-            if(m_HashTable32Entries.Capacity() < m_HashTableCapacity)
-                m_HashTable32Entries.SetCapacity(m_HashTableSize, m_HashTableCapacity);
-            m_HashTable32Entries.Clear();
-            if(m_HashTable64Entries.Capacity() < m_HashTableCapacity)
-                m_HashTable64Entries.SetCapacity(m_HashTableSize, m_HashTableCapacity);
-            m_HashTable64Entries.Clear();
+        if(enable)
+        {
             m_HashStates.SetCapacity(m_HashStatesCapacity);
             m_HashStates.SetSize(m_HashStatesCapacity);
             m_HashStatesSlots.SetCapacity(m_HashStatesCapacity);
@@ -93,10 +238,6 @@ struct ReverseHashContainer
         }
         else
         {
-            m_HashTable32Entries.Iterate(FreeEntryCallback, (void*) 0);
-            m_HashTable32Entries.Clear();
-            m_HashTable64Entries.Iterate(FreeEntryCallback, (void*) 0);
-            m_HashTable64Entries.Clear();
             if(m_HashStatesSlots.Size() != 0)
             {
                 m_HashStatesSlots.Push(0);
@@ -224,19 +365,8 @@ uint32_t dmHashBuffer32(const void * key, uint32_t len)
 
     if (dmHashContainer().m_Enabled && len <= DMHASH_MAX_REVERSE_LENGTH)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable32<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable32Entries;
-        if (hash_table->Get(h) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            char* copy = (char*) malloc(len + 1);
-            memcpy(copy, key, len);
-            copy[len] = '\0';
-            hash_table->Put(h, ReverseHashEntry(copy, len));
-        }
+        ReverseHashShard& shard = dmHashContainer().GetShard32(h);
+        shard.Insert(&shard.m_HashTable32Entries, h, key, len);
     }
 
     return h;
@@ -301,19 +431,8 @@ uint64_t dmHashBuffer64(const void * key, uint32_t len)
 
     if (dmHashContainer().m_Enabled && len <= DMHASH_MAX_REVERSE_LENGTH)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable64<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable64Entries;
-        if (hash_table->Get(h) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            char* copy = (char*) malloc(len + 1);
-            memcpy(copy, key, len);
-            copy[len] = '\0';
-            hash_table->Put(h, ReverseHashEntry(copy, len));
-        }
+        ReverseHashShard& shard = dmHashContainer().GetShard64(h);
+        shard.Insert(&shard.m_HashTable64Entries, h, key, len);
     }
 
     return h;
@@ -429,19 +548,10 @@ uint32_t dmHashFinal32(HashState32* hash_state)
     if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex && hash_state->m_Size <= DMHASH_MAX_REVERSE_LENGTH)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable32<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable32Entries;
-        if (hash_table->Get(hash_state->m_Hash) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            hash_table->Put(hash_state->m_Hash, dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex]);
-        }
-        else
-        {
-            free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
-        }
+        ReverseHashEntry& state = dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex];
+        ReverseHashShard& shard = dmHashContainer().GetShard32(hash_state->m_Hash);
+        shard.Insert(&shard.m_HashTable32Entries, hash_state->m_Hash, state.m_Value, state.m_Length);
+        free(state.m_Value);
         dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
@@ -565,19 +675,10 @@ uint64_t dmHashFinal64(HashState64* hash_state)
     if (dmHashContainer().m_Enabled && hash_state->m_ReverseHashEntryIndex && hash_state->m_Size <= DMHASH_MAX_REVERSE_LENGTH)
     {
         DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        dmHashTable64<ReverseHashEntry>* hash_table = &dmHashContainer().m_HashTable64Entries;
-        if (hash_table->Get(hash_state->m_Hash) == 0)
-        {
-            if (hash_table->Full())
-            {
-                hash_table->SetCapacity(dmHashContainer().m_HashTableSize, hash_table->Capacity() + dmHashContainer().m_HashTableCapacityIncrement);
-            }
-            hash_table->Put(hash_state->m_Hash, dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex]);
-        }
-        else
-        {
-            free(dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex].m_Value);
-        }
+        ReverseHashEntry& state = dmHashContainer().m_HashStates[hash_state->m_ReverseHashEntryIndex];
+        ReverseHashShard& shard = dmHashContainer().GetShard64(hash_state->m_Hash);
+        shard.Insert(&shard.m_HashTable64Entries, hash_state->m_Hash, state.m_Value, state.m_Length);
+        free(state.m_Value);
         dmHashContainer().FreeReverseHashStatesSlot(hash_state->m_ReverseHashEntryIndex);
         hash_state->m_ReverseHashEntryIndex = 0;
     }
@@ -600,16 +701,8 @@ DM_DLLEXPORT const void* dmHashReverse32(uint32_t hash, uint32_t* length)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
-        if (reverse)
-        {
-            if (length)
-            {
-                *length = reverse->m_Length;
-            }
-            return reverse->m_Value;
-        }
+        ReverseHashShard& shard = dmHashContainer().GetShard32(hash);
+        return shard.Get(&shard.m_HashTable32Entries, hash, length);
     }
     return 0;
 }
@@ -618,16 +711,8 @@ DM_DLLEXPORT const void* dmHashReverse64(uint64_t hash, uint32_t* length)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
-        if (reverse)
-        {
-            if (length)
-            {
-                *length = reverse->m_Length;
-            }
-            return reverse->m_Value;
-        }
+        ReverseHashShard& shard = dmHashContainer().GetShard64(hash);
+        return shard.Get(&shard.m_HashTable64Entries, hash, length);
     }
     return 0;
 }
@@ -636,13 +721,8 @@ DM_DLLEXPORT void dmHashReverseErase32(uint32_t hash)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable32Entries.Get(hash);
-        if (reverse)
-        {
-            free(reverse->m_Value);
-            dmHashContainer().m_HashTable32Entries.Erase(hash);
-        }
+        ReverseHashShard& shard = dmHashContainer().GetShard32(hash);
+        shard.Erase(&shard.m_HashTable32Entries, hash);
     }
 }
 
@@ -650,13 +730,8 @@ DM_DLLEXPORT void dmHashReverseErase64(uint64_t hash)
 {
     if (dmHashContainer().m_Enabled)
     {
-        DM_MUTEX_SCOPED_LOCK(dmHashContainer().m_Mutex);
-        ReverseHashEntry* reverse = dmHashContainer().m_HashTable64Entries.Get(hash);
-        if (reverse)
-        {
-            free(reverse->m_Value);
-            dmHashContainer().m_HashTable64Entries.Erase(hash);
-        }
+        ReverseHashShard& shard = dmHashContainer().GetShard64(hash);
+        shard.Erase(&shard.m_HashTable64Entries, hash);
     }
 }
 
@@ -21,6 +21,8 @@
 #include "mutex.h"
 #include "condition_variable.h"
 #include "dstrings.h"
+#include "time.h"
+#include "thread.h"
 #include <dlib/static_assert.h>
 #include <dlib/spinlock.h>
 
@@ -29,24 +31,44 @@ namespace dmMessage
     // Alignment of allocations
     const uint32_t DM_MESSAGE_ALIGNMENT = 16U;
 
+    // Messages are posted without locks, from any number of threads, and dispatched by one thread at a time.
+    //
+    // The messages of a queue are stored back to back in a chain of pages, used as a ring buffer:
+    //  - Post reserves memory for the message by adding to the offset of the current page, writes the message
+    //    and publishes it by setting its size in the page.
+    //  - Only when the current page is full, a new page is linked under the socket mutex.
+    //  - Dispatch reads the messages in the order they were reserved, and stops at the first message not
+    //    yet published. It clears the sizes, and reuses the pages that are read to the end.
+    //
+    // A socket has two queues. The thread that created the socket is the single producer of the owner queue,
+    // and reserves memory without atomic read-modify-write operations. Other threads post to the shared queue,
+    // with an atomic add. The owner queue is dispatched first, so the owner thread also posts to the shared
+    // queue while messages from other threads are pending, to keep them in the order they were posted.
+
     struct MemoryPage
     {
-        uint8_t     m_Memory[DM_MESSAGE_PAGE_SIZE];
-        uint32_t    m_Current;
-        MemoryPage* m_NextPage;
+        uint8_t              m_Memory[DM_MESSAGE_PAGE_SIZE];
+        // Size of the message at each aligned offset. Zero until the message is published
+        int32_atomic_t       m_MessageSizes[DM_MESSAGE_PAGE_SIZE / DM_MESSAGE_ALIGNMENT];
+        // Allocation offset. Grows past the capacity when the page is full
+        int32_atomic_t       m_Offset;
+        // End of the messages in the page, set by the one allocation that didn't fit. Zero until then
+        int32_atomic_t       m_End;
+        MemoryPage* volatile m_NextPage;
+        // Position of the page in the message order of the queue
+        uint64_t             m_Base;
     };
 
-    struct MemoryAllocator
+    struct MessageQueue
     {
-        MemoryAllocator()
-        {
-            m_CurrentPage = 0;
-            m_FreePages = 0;
-            m_FullPages = 0;
-        }
-        MemoryPage* m_CurrentPage;
-        MemoryPage* m_FreePages;
-        MemoryPage* m_FullPages;
+        // Page messages are posted to
+        MemoryPage* volatile m_CurrentPage;
+        // Dispatch position and pages read to the end. Only used by the dispatching thread
+        MemoryPage*          m_ReadPage;
+        uint32_t             m_ReadOffset;
+        MemoryPage*          m_ReadPages;
+        // Protected by the socket mutex. Pages are never moved between queues, see AllocateNewPage
+        MemoryPage*          m_FreePages;
     };
 
     struct GlobalInit
@@ -58,65 +80,229 @@ namespace dmMessage
 
     } g_MessageInit;
 
-    static void AllocateNewPage(MemoryAllocator* allocator)
+    struct MessageSocket
+    {
+        uint32_t            m_RefCount; // Is protected by "g_MessageContext->m_Spinlock"
+        dmhash_t            m_NameHash;
+        const char*         m_Name;
+        MessageQueue        m_OwnerQueue;
+        MessageQueue        m_SharedQueue;
+        // Thread that created the socket, see GetThreadId
+        uint32_t            m_OwnerThread;
+        // Number of messages posted to the shared queue and not yet dispatched
+        int32_atomic_t      m_SharedCount;
+        // Only used by the dispatching thread
+        uint32_t            m_DispatchDepth;
+        // Number of threads in DispatchBlocking
+        int32_atomic_t      m_Waiting;
+        // Protects the free pages and the linking of new pages, and is used for blocking dispatch.
+        // Not a spinlock, as a posting thread might be preempted while linking a new page
+        dmMutex::HMutex     m_Mutex;
+        dmConditionVariable::HConditionVariable m_Condition;
+    };
+
+    static dmThread::TlsKey g_ThreadIdKey = dmThread::AllocTls();
+    static int32_atomic_t g_ThreadIdCounter = 0;
+
+    // Returns a non-zero id of the calling thread. Unlike dmThread::GetCurrentThread, unique on all platforms
+    static uint32_t GetThreadId()
+    {
+        uintptr_t id = (uintptr_t) dmThread::GetTlsValue(g_ThreadIdKey);
+        if (id == 0)
+        {
+            id = (uintptr_t) dmAtomicIncrement32(&g_ThreadIdCounter) + 1;
+            dmThread::SetTlsValue(g_ThreadIdKey, (void*) id);
+        }
+        return (uint32_t) id;
+    }
+
+    static MemoryPage* NewPage()
+    {
+        MemoryPage* page = new MemoryPage;
+        memset(page, 0, sizeof(MemoryPage));
+        return page;
+    }
+
+    static void FreePages(MemoryPage* p)
     {
-        if (allocator->m_CurrentPage)
+        while (p)
         {
-            // Link current page to full pages
-            allocator->m_CurrentPage->m_NextPage = allocator->m_FullPages;
-            allocator->m_FullPages = allocator->m_CurrentPage;
+            MemoryPage* next = p->m_NextPage;
+            delete p;
+            p = next;
         }
+    }
 
-        MemoryPage* new_page = 0;
+    static void InitQueue(MessageQueue* queue)
+    {
+        queue->m_CurrentPage = NewPage();
+        queue->m_ReadPage = queue->m_CurrentPage;
+        queue->m_ReadOffset = 0;
+        queue->m_ReadPages = 0;
+        queue->m_FreePages = 0;
+    }
+
+    static void FreeQueue(MessageQueue* queue)
+    {
+        FreePages(queue->m_ReadPage);
+        FreePages(queue->m_ReadPages);
+        FreePages(queue->m_FreePages);
+    }
 
-        if (allocator->m_FreePages)
+    // Assumes the socket mutex is held, and that the current page is full
+    static void AllocateNewPage(MessageQueue* queue, MemoryPage* current_page)
+    {
+        MemoryPage* new_page = queue->m_FreePages;
+        if (new_page)
         {
-            // Free page to use
-            new_page = allocator->m_FreePages;
-            allocator->m_FreePages = new_page->m_NextPage;
+            queue->m_FreePages = new_page->m_NextPage;
         }
         else
         {
-            // Allocate new page
-            new_page = new MemoryPage;
+            new_page = NewPage();
         }
 
-        new_page->m_Current = 0;
+        new_page->m_End = 0;
         new_page->m_NextPage = 0;
+        new_page->m_Base = current_page->m_Base + DM_MESSAGE_PAGE_SIZE;
+        // Threads posting to the shared queue that read the page pointer while the page was last in use might
+        // still add to the offset. They didn't get any memory from the page then, and allocate from it as any
+        // other thread once it's reset. Hence pages are never moved to the owner queue
+        dmAtomicStore32(&new_page->m_Offset, 0);
+
+        dmAtomicSetPointer((void* volatile*) &current_page->m_NextPage, new_page);
+        dmAtomicSetPointer((void* volatile*) &queue->m_CurrentPage, new_page);
+    }
+
+    // Reserves memory for messages of the given total size. Only the owner thread posts to the owner queue,
+    // and needs no atomic add
+    static uint8_t* AllocateMessages(MessageSocket* socket, MessageQueue* queue, bool owner_queue, uint32_t size, MemoryPage** out_page)
+    {
+        assert(size <= DM_MESSAGE_PAGE_SIZE);
+
+        for (;;)
+        {
+            MemoryPage* page = (MemoryPage*) dmAtomicGetPointer((void* volatile*) &queue->m_CurrentPage);
+            uint32_t offset;
+            if (owner_queue)
+            {
+                offset = (uint32_t) dmAtomicGet32(&page->m_Offset);
+                dmAtomicSet32(&page->m_Offset, (int32_t) (offset + size));
+            }
+            else
+            {
+                offset = (uint32_t) dmAtomicAdd32(&page->m_Offset, (int32_t) size);
+            }
+            if (offset + size <= DM_MESSAGE_PAGE_SIZE)
+            {
+                *out_page = page;
+                return &page->m_Memory[offset];
+            }
 
-        allocator->m_CurrentPage = new_page;
+            // The page is full. Exactly one allocation starts within the page and doesn't fit, and marks the end of the messages
+            if (offset <= DM_MESSAGE_PAGE_SIZE)
+            {
+                dmAtomicSet32(&page->m_End, (int32_t) offset);
+            }
+
+            DM_MUTEX_SCOPED_LOCK(socket->m_Mutex);
+            // The offset is only reset under the lock, and only grows past the capacity when the page is full
+            if (queue->m_CurrentPage == page && (uint32_t) dmAtomicGet32(&page->m_Offset) > DM_MESSAGE_PAGE_SIZE)
+            {
+                AllocateNewPage(queue, page);
+            }
+        }
     }
 
-    static void* AllocateMessage(MemoryAllocator* allocator, uint32_t size)
+    static inline uint32_t GetMessageSize(uint32_t data_size)
     {
         // At least ALIGNMENT bytes alignment of size in order to ensure that the next allocation is aligned
+        uint32_t size = sizeof(Message) + data_size;
         size += DM_MESSAGE_ALIGNMENT-1;
         size &= ~(DM_MESSAGE_ALIGNMENT-1);
-        assert(size <= DM_MESSAGE_PAGE_SIZE);
+        return size;
+    }
 
-        if (allocator->m_CurrentPage == 0 || (DM_MESSAGE_PAGE_SIZE-allocator->m_CurrentPage->m_Current) < size)
+    // Position in the message order of the queue, up to which messages are reserved
+    static uint64_t GetWritePosition(MessageQueue* queue)
+    {
+        MemoryPage* page = (MemoryPage*) dmAtomicGetPointer((void* volatile*) &queue->m_CurrentPage);
+        uint32_t offset = (uint32_t) dmAtomicGet32(&page->m_Offset);
+        return page->m_Base + (offset < DM_MESSAGE_PAGE_SIZE ? offset : DM_MESSAGE_PAGE_SIZE);
+    }
+
+    static inline uint64_t GetReadPosition(MessageQueue* queue)
+    {
+        return queue->m_ReadPage->m_Base + queue->m_ReadOffset;
+    }
+
+    // Returns the size of the next published message, or 0. Moves on to the next page at the end of a page.
+    // Only called by the dispatching thread
+    static uint32_t PeekMessage(MessageQueue* queue)
+    {
+        for (;;)
         {
-            // No current page or allocation didn't fit.
-            AllocateNewPage(allocator);
+            MemoryPage* page = queue->m_ReadPage;
+            uint32_t offset = queue->m_ReadOffset;
+            if (offset != 0 && (uint32_t) dmAtomicGet32(&page->m_End) == offset)
+            {
+                MemoryPage* next = (MemoryPage*) dmAtomicGetPointer((void* volatile*) &page->m_NextPage);
+                if (!next)
+                {
+                    return 0;
+                }
+                // No thread touches the page again until it's reclaimed, after the dispatch
+                page->m_NextPage = queue->m_ReadPages;
+                queue->m_ReadPages = page;
+                queue->m_ReadPage = next;
+                queue->m_ReadOffset = 0;
+                continue;
+            }
+
+            if (offset >= DM_MESSAGE_PAGE_SIZE)
+            {
+                return 0;
+            }
+            return (uint32_t) dmAtomicGet32(&page->m_MessageSizes[offset / DM_MESSAGE_ALIGNMENT]);
         }
+    }
 
-        MemoryPage* page = allocator->m_CurrentPage;
-        void* ret = (void*) ((uintptr_t) &page->m_Memory[0] + page->m_Current);
-        page->m_Current += size;
-        return ret;
+    // Returns the next published message before the position end, and moves past it
+    static Message* NextMessage(MessageQueue* queue, uint64_t end)
+    {
+        uint32_t size = PeekMessage(queue);
+        if (!size || GetReadPosition(queue) >= end)
+        {
+            return 0;
+        }
+        MemoryPage* page = queue->m_ReadPage;
+        uint32_t offset = queue->m_ReadOffset;
+        // Marks the message as not published, for the next use of the page
+        page->m_MessageSizes[offset / DM_MESSAGE_ALIGNMENT] = 0;
+        queue->m_ReadOffset = offset + size;
+        return (Message*) &page->m_Memory[offset];
     }
 
-    struct MessageSocket
+    // Frees the pages read to the end, once no message in them is referenced
+    static void ReclaimPages(MessageSocket* s, MessageQueue* queue)
     {
-        uint32_t        m_RefCount; // Is protected by "g_MessageContext->m_Spinlock"
-        dmhash_t        m_NameHash;
-        Message*        m_Header;
-        Message*        m_Tail;
-        const char*     m_Name;
-        dmMutex::HMutex m_Mutex;
-        dmConditionVariable::HConditionVariable m_Condition;
-        MemoryAllocator m_Allocator;
-    };
+        MemoryPage* pages = queue->m_ReadPages;
+        if (!pages)
+        {
+            return;
+        }
+        queue->m_ReadPages = 0;
+
+        MemoryPage* last = pages;
+        while (last->m_NextPage)
+        {
+            last = last->m_NextPage;
+        }
+
+        DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
+        last->m_NextPage = queue->m_FreePages;
+        queue->m_FreePages = pages;
+    }
 
     const uint32_t MAX_SOCKETS = 256;
 
@@ -178,10 +364,14 @@ namespace dmMessage
 
         MessageSocket s;
         s.m_RefCount = 1;
-        s.m_Header = 0;
-        s.m_Tail = 0;
         s.m_NameHash = name_hash;
         s.m_Name = strdup(name);
+        InitQueue(&s.m_OwnerQueue);
+        InitQueue(&s.m_SharedQueue);
+        s.m_OwnerThread = GetThreadId();
+        s.m_SharedCount = 0;
+        s.m_DispatchDepth = 0;
+        s.m_Waiting = 0;
         s.m_Mutex = dmMutex::New();
         s.m_Condition = dmConditionVariable::New();
 
@@ -193,37 +383,22 @@ namespace dmMessage
 
     static void DisposeSocket(MessageSocket* s)
     {
-        Message *message_object = s->m_Header;
-        while (message_object)
+        MessageQueue* queues[] = {&s->m_OwnerQueue, &s->m_SharedQueue};
+        for (uint32_t i = 0; i < sizeof(queues) / sizeof(queues[0]); ++i)
         {
-            if (message_object->m_DestroyCallback)
+            Message* message_object;
+            while ((message_object = NextMessage(queues[i], ~0ULL)) != 0)
             {
-                message_object->m_DestroyCallback(message_object);
+                if (message_object->m_DestroyCallback)
+                {
+                    message_object->m_DestroyCallback(message_object);
+                }
             }
-            message_object = message_object->m_Next;
+            FreeQueue(queues[i]);
         }
 
         free((void*) s->m_Name);
 
-        MemoryPage* p = s->m_Allocator.m_FreePages;
-        while (p)
-        {
-            MemoryPage* next = p->m_NextPage;
-            delete p;
-            p = next;
-        }
-        p = s->m_Allocator.m_FullPages;
-        while (p)
-        {
-            MemoryPage* next = p->m_NextPage;
-            delete p;
-            p = next;
-        }
-        if (s->m_Allocator.m_CurrentPage)
-        {
-            delete s->m_Allocator.m_CurrentPage;
-        }
-
         dmConditionVariable::Delete(s->m_Condition);
 
         dmMutex::Delete(s->m_Mutex);
@@ -343,11 +518,7 @@ namespace dmMessage
         MessageSocket* s = AcquireSocket(socket);
         if (s != 0)
         {
-            bool has_messages;
-            {
-                DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
-                has_messages = s->m_Header != 0;
-            }
+            bool has_messages = PeekMessage(&s->m_OwnerQueue) != 0 || PeekMessage(&s->m_SharedQueue) != 0;
             ReleaseSocket(s);
             return has_messages;
         }
@@ -359,6 +530,80 @@ namespace dmMessage
         memset((void*)&url, 0, sizeof(URL));
     }
 
+    // Writes and publishes a message in memory reserved with AllocateMessages. Returns the size of the message
+    static uint32_t WriteMessage(MemoryPage* page, uint8_t* memory, const URL* sender, const URL* receiver, const MessagePost* message)
+    {
+        Message *new_message = (Message *) memory;
+        if (sender != 0x0)
+        {
+            new_message->m_Sender = *sender;
+        }
+        else
+        {
+            ResetURL(new_message->m_Sender);
+        }
+        new_message->m_Receiver = *receiver;
+        new_message->m_Id = message->m_Id;
+        new_message->m_UserData = message->m_UserData;
+        new_message->m_Descriptor = message->m_Descriptor;
+        new_message->m_DataSize = message->m_DataSize;
+        new_message->m_Next = 0;
+        new_message->m_DestroyCallback = message->m_DestroyCallback;
+        memcpy(&new_message->m_Data[0], message->m_Data, message->m_DataSize);
+
+        uint32_t size = GetMessageSize(message->m_DataSize);
+        dmAtomicSet32(&page->m_MessageSizes[(memory - page->m_Memory) / DM_MESSAGE_ALIGNMENT], (int32_t) size);
+        return size;
+    }
+
+    static void PostMessages(MessageSocket* s, const URL* sender, const URL* receiver, const MessagePost* messages, uint32_t message_count)
+    {
+        bool owner_queue = GetThreadId() == s->m_OwnerThread && dmAtomicGet32(&s->m_SharedCount) == 0;
+        MessageQueue* queue = owner_queue ? &s->m_OwnerQueue : &s->m_SharedQueue;
+        if (!owner_queue)
+        {
+            // Counted before the messages are reserved, so the owner thread doesn't post to the owner queue once it's seen them
+            dmAtomicAdd32(&s->m_SharedCount, (int32_t) message_count);
+        }
+
+        // Consecutive messages that fit in a page are reserved at once
+        uint32_t i = 0;
+        while (i < message_count)
+        {
+            uint32_t size = GetMessageSize(messages[i].m_DataSize);
+            uint32_t end = i + 1;
+            while (end < message_count)
+            {
+                uint32_t message_size = GetMessageSize(messages[end].m_DataSize);
+                if (size + message_size > DM_MESSAGE_PAGE_SIZE)
+                {
+                    break;
+                }
+                size += message_size;
+                ++end;
+            }
+
+            MemoryPage* page;
+            uint8_t* memory = AllocateMessages(s, queue, owner_queue, size, &page);
+            for (; i < end; ++i)
+            {
+                memory += WriteMessage(page, memory, sender, receiver, &messages[i]);
+            }
+        }
+
+        // A full barrier between reserving the messages and reading m_Waiting, see InternalDispatch. For the shared
+        // queue, the atomic add is one
+        if (owner_queue)
+        {
+            dmAtomicFence();
+        }
+        if (dmAtomicGet32(&s->m_Waiting))
+        {
+            DM_MUTEX_SCOPED_LOCK(s->m_Mutex);
+            dmConditionVariable::Signal(s->m_Condition);
+        }
+    }
+
     Result Post(const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data, uintptr_t descriptor, const void* message_data, uint32_t message_data_size, MessageDestroyCallback destroy_callback)
     {
         DM_PROFILE(Message, "Post")
@@ -375,46 +620,37 @@ namespace dmMessage
             return RESULT_SOCKET_NOT_FOUND;
         }
 
-        dmMutex::Lock(s->m_Mutex);
+        MessagePost message;
+        message.m_Id = message_id;
+        message.m_UserData = user_data;
+        message.m_Descriptor = descriptor;
+        message.m_Data = message_data;
+        message.m_DataSize = message_data_size;
+        message.m_DestroyCallback = destroy_callback;
+        PostMessages(s, sender, receiver, &message, 1);
 
-        MemoryAllocator* allocator = &s->m_Allocator;
-        uint32_t data_size = sizeof(Message) + message_data_size;
-        Message *new_message = (Message *) AllocateMessage(allocator, data_size);
-        if (sender != 0x0)
-        {
-            new_message->m_Sender = *sender;
-        }
-        else
-        {
-            ResetURL(new_message->m_Sender);
-        }
-        new_message->m_Receiver = *receiver;
-        new_message->m_Id = message_id;
-        new_message->m_UserData = user_data;
-        new_message->m_Descriptor = descriptor;
-        new_message->m_DataSize = message_data_size;
-        new_message->m_Next = 0;
-        new_message->m_DestroyCallback = destroy_callback;
-        memcpy(&new_message->m_Data[0], message_data, message_data_size);
+        ReleaseSocket(s);
 
-        bool is_first_message = !s->m_Header;
+        return RESULT_OK;
+    }
 
-        if (!s->m_Header)
-        {
-            s->m_Header = new_message;
-            s->m_Tail = new_message;
-        }
-        else
+    Result PostMany(const URL* sender, const URL* receiver, const MessagePost* messages, uint32_t message_count)
+    {
+        DM_PROFILE(Message, "PostMany")
+        DM_COUNTER("Messages", message_count)
+
+        if (receiver == 0x0)
         {
-            s->m_Tail->m_Next = new_message;
-            s->m_Tail = new_message;
+            return RESULT_SOCKET_NOT_FOUND;
         }
 
-        if (is_first_message)
+        MessageSocket* s = AcquireSocket(receiver->m_Socket);
+        if (s == 0x0)
         {
-            dmConditionVariable::Signal(s->m_Condition);
+            return RESULT_SOCKET_NOT_FOUND;
         }
-        dmMutex::Unlock(s->m_Mutex);
+
+        PostMessages(s, sender, receiver, messages, message_count);
 
         ReleaseSocket(s);
 
@@ -461,16 +697,33 @@ namespace dmMessage
             return 0;
         }
 
-        dmMutex::Lock(s->m_Mutex);
-
-        MemoryAllocator* allocator = &s->m_Allocator;
-
-        if (!s->m_Header)
+        MessageQueue* owner_queue = &s->m_OwnerQueue;
+        MessageQueue* shared_queue = &s->m_SharedQueue;
+        if (!PeekMessage(owner_queue) && !PeekMessage(shared_queue))
         {
             if (blocking) {
-                dmConditionVariable::Wait(s->m_Condition, s->m_Mutex);
-            } else {
+                dmMutex::Lock(s->m_Mutex);
+                // Posting threads check m_Waiting after a full barrier, so either the reserved messages
+                // are seen below, or the posting thread signals once they're published
+                dmAtomicIncrement32(&s->m_Waiting);
+                while (!PeekMessage(owner_queue) && !PeekMessage(shared_queue))
+                {
+                    if (GetWritePosition(owner_queue) > GetReadPosition(owner_queue) ||
+                        GetWritePosition(shared_queue) > GetReadPosition(shared_queue))
+                    {
+                        // Reserved but not yet published
+                        dmMutex::Unlock(s->m_Mutex);
+                        dmTime::Sleep(0);
+                        dmMutex::Lock(s->m_Mutex);
+                    }
+                    else
+                    {
+                        dmConditionVariable::Wait(s->m_Condition, s->m_Mutex);
+                    }
+                }
+                dmAtomicDecrement32(&s->m_Waiting);
                 dmMutex::Unlock(s->m_Mutex);
+            } else {
                 ReleaseSocket(s);
                 return 0;
             }
@@ -482,37 +735,43 @@ namespace dmMessage
 
         uint32_t dispatch_count = 0;
 
-        Message *message_object = s->m_Header;
-        s->m_Header = 0;
-        s->m_Tail = 0;
-
-        // Unlink full pages
-        MemoryPage* full_pages = allocator->m_FullPages;
-        allocator->m_FullPages = 0;
-
-        dmMutex::Unlock(s->m_Mutex);
+        // Messages posted during the dispatch are dispatched in the next one. The end of the owner queue is read
+        // last, so that it includes the owner messages posted before any message of the shared queue
+        uint64_t shared_end = GetWritePosition(shared_queue);
+        uint64_t owner_end = GetWritePosition(owner_queue);
 
-        while (message_object)
+        ++s->m_DispatchDepth;
+        Message* message_object;
+        while ((message_object = NextMessage(owner_queue, owner_end)) != 0)
         {
             dispatch_callback(message_object, user_ptr);
             if (message_object->m_DestroyCallback) {
                 message_object->m_DestroyCallback(message_object);
             }
-            message_object = message_object->m_Next;
             dispatch_count++;
         }
 
-        // Reclaim all full pages active when dispatch started
-        dmMutex::Lock(s->m_Mutex);
-        MemoryPage* p = full_pages;
-        while (p)
+        uint32_t shared_count = 0;
+        while ((message_object = NextMessage(shared_queue, shared_end)) != 0)
         {
-            MemoryPage* next = p->m_NextPage;
-            p->m_NextPage = allocator->m_FreePages;
-            allocator->m_FreePages = p;
-            p = next;
+            dispatch_callback(message_object, user_ptr);
+            if (message_object->m_DestroyCallback) {
+                message_object->m_DestroyCallback(message_object);
+            }
+            shared_count++;
+        }
+        if (shared_count > 0)
+        {
+            dmAtomicAdd32(&s->m_SharedCount, -(int32_t) shared_count);
+            dispatch_count += shared_count;
+        }
+
+        // Pages are reclaimed when no dispatch of the socket refers to their messages
+        if (--s->m_DispatchDepth == 0)
+        {
+            ReclaimPages(s, owner_queue);
+            ReclaimPages(s, shared_queue);
         }
-        dmMutex::Unlock(s->m_Mutex);
 
         ReleaseSocket(s);
 
@@ -169,6 +169,7 @@ namespace dmMessage
 
     /**
      * Test if a socket has any messages
+     * @note Must be called from the thread dispatching the socket
      * @param socket Socket
      * @return if the socket has messages or not
      */
@@ -197,10 +198,37 @@ namespace dmMessage
      */
     Result Post(const URL* sender, const URL* receiver, dmhash_t message_id, uintptr_t user_data, uintptr_t descriptor, const void* message_data, uint32_t message_data_size, MessageDestroyCallback destroy_callback);
 
+    /**
+     * Description of a message posted with #PostMany
+     */
+    struct MessagePost
+    {
+        dmhash_t               m_Id;                //! Unique id of message
+        uintptr_t              m_UserData;          //! User data pointer
+        uintptr_t              m_Descriptor;        //! User specified descriptor of the message data
+        const void*            m_Data;              //! Message data reference
+        uint32_t               m_DataSize;          //! Size of message data in bytes
+        MessageDestroyCallback m_DestroyCallback;   //! If set, will be called after each dispatch
+    };
+
+    /**
+     * Post several messages to the same receiver. Equivalent to calling #Post for each message,
+     * but cheaper as the socket is looked up once, and memory is reserved once per page, for the whole batch.
+     * The messages are dispatched in the order they are given.
+     * @note Message data is copied by value
+     * @param sender The sender URL if the receiver wants to respond. 0x0 is accepted
+     * @param receiver The receiver URL, must not be 0x0
+     * @param messages Messages to post
+     * @param message_count Number of messages
+     * @return RESULT_OK if the messages were posted
+     */
+    Result PostMany(const URL* sender, const URL* receiver, const MessagePost* messages, uint32_t message_count);
+
     /**
      * Dispatch messages
      * @note When dispatched, the messages are considered destroyed. Messages posted during dispatch
      *       are handled in the next invocation to #Dispatch
+     * @note Messages can be posted from any thread, but a socket must only be dispatched from one thread at a time
      * @param socket Socket handle of the socket of which messages to dispatch.
      * @param dispatch_callback Callback function that will be called for each message
      *        dispatched. The callbacks parameters contains a pointer to a unique Message
@@ -0,0 +1,455 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_OPEN_HASHTABLE_H
+#define DM_OPEN_HASHTABLE_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "simd.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dmOpenHashTableInternal
+{
+    /// Number of slots probed at once. Each group of slots has one control byte per slot
+    static const uint32_t GROUP_SIZE = 16;
+
+    /// Control byte of a slot that was never used. Stops the probing.
+    static const uint8_t CTRL_EMPTY = 0x80;
+    /// Control byte of a slot whose entry was erased. Probing continues past it.
+    static const uint8_t CTRL_DELETED = 0xfe;
+    // A used slot stores the 7 top bits of the key hash (high bit cleared)
+
+    static inline uint64_t Hash(uint64_t key)
+    {
+        // Keys are often already hashes, but small integer keys must be spread too
+        uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    static inline uint32_t FirstBit(uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (uint32_t)index;
+#else
+        return (uint32_t)__builtin_ctz(mask);
+#endif
+    }
+
+#if defined(DM_SIMD_NEON)
+    static inline uint32_t MoveMask(uint8x16_t v)
+    {
+        static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t m = vandq_u8(v, vld1q_u8(bits));
+        uint8x8_t t = vpadd_u8(vget_low_u8(m), vget_high_u8(m));
+        t = vpadd_u8(t, t);
+        t = vpadd_u8(t, t);
+        return vget_lane_u16(vreinterpret_u16_u8(t), 0);
+    }
+#endif
+
+    /// Bit mask of the slots in the group whose control byte equals "value"
+    static inline uint32_t MatchByte(const uint8_t* group, uint8_t value)
+    {
+#if defined(DM_SIMD_SSE2)
+        __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+        return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#elif defined(DM_SIMD_NEON)
+        return MoveMask(vceqq_u8(vld1q_u8(group), vdupq_n_u8(value)));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_SIZE; ++i)
+        {
+            mask |= (group[i] == value) << i;
+        }
+        return mask;
+#endif
+    }
+
+    /// Bit mask of the slots in the group that are empty or deleted (i.e. control byte high bit set)
+    static inline uint32_t MatchFree(const uint8_t* group)
+    {
+#if defined(DM_SIMD_SSE2)
+        return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#elif defined(DM_SIMD_NEON)
+        return MoveMask(vtstq_u8(vld1q_u8(group), vdupq_n_u8(0x80)));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_SIZE; ++i)
+        {
+            mask |= (group[i] >> 7) << i;
+        }
+        return mask;
+#endif
+    }
+}
+
+/**
+ * Open addressing hashtable (SwissTable style) with automatic growth and assignment semantics.
+ * Slots are split into groups of 16 with one control byte per slot, and a lookup compares
+ * the control bytes of a whole group at once (SSE2/NEON). The table grows when 7/8 full.
+ * Only integer types (e.g. uint32_t and uint64_t hashes) are supported as KEY type.
+ * @note Pointers to values are invalidated when the table grows
+ */
+template <typename KEY, typename T>
+class dmOpenHashTable
+{
+public:
+    struct Entry
+    {
+        KEY m_Key;
+        T   m_Value;
+    };
+
+    /**
+     * Constructor. Create an empty hashtable. No memory is allocated until the first Put()
+     */
+    dmOpenHashTable()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
+    /**
+     * Destructor.
+     */
+    ~dmOpenHashTable()
+    {
+        free(m_Ctrl);
+        free(m_Entries);
+    }
+
+    /**
+     * Remove all entries. The allocated memory is kept.
+     */
+    void Clear()
+    {
+        if (m_Ctrl)
+        {
+            memset(m_Ctrl, dmOpenHashTableInternal::CTRL_EMPTY, m_SlotCount);
+        }
+        m_Count = 0;
+        m_GrowthLeft = MaxLoad(m_SlotCount);
+    }
+
+    /**
+     * Number of entries stored in table.
+     * @return Number of entries.
+     */
+    uint32_t Size() const
+    {
+        return m_Count;
+    }
+
+    /**
+     * Number of entries that fit before the table grows
+     * @return Capacity
+     */
+    uint32_t Capacity() const
+    {
+        return MaxLoad(m_SlotCount);
+    }
+
+    /**
+     * Check if the table is empty
+     * @return true if the table is empty
+     */
+    bool Empty() const
+    {
+        return m_Count == 0;
+    }
+
+    /**
+     * Grow the table so that at least "capacity" entries can be stored without rehashing.
+     * A smaller capacity than the current one is ignored.
+     * @param capacity Number of entries
+     */
+    void SetCapacity(uint32_t capacity)
+    {
+        assert(capacity < 0x80000000);
+        if (capacity <= Capacity())
+            return;
+
+        uint32_t slot_count = dmOpenHashTableInternal::GROUP_SIZE;
+        while (MaxLoad(slot_count) < capacity)
+        {
+            slot_count *= 2;
+        }
+        Rehash(slot_count);
+    }
+
+    void Swap(dmOpenHashTable<KEY, T>& other)
+    {
+        char buf[sizeof(*this)];
+        memcpy(buf, &other, sizeof(buf));
+        memcpy(&other, this, sizeof(buf));
+        memcpy(this, buf, sizeof(buf));
+    }
+
+    /**
+     * Put key/value pair in hash table. The table grows if needed.
+     * @param key Key
+     * @param value Value
+     */
+    void Put(KEY key, const T& value)
+    {
+        uint64_t hash = dmOpenHashTableInternal::Hash((uint64_t)key);
+        uint8_t h2 = (uint8_t)(hash >> 57);
+
+        uint32_t index;
+        if (FindIndex(key, hash, h2, &index))
+        {
+            m_Entries[index].m_Value = value;
+            return;
+        }
+
+        index = FindFreeIndex(hash);
+        if (m_SlotCount == 0 || (m_GrowthLeft == 0 && m_Ctrl[index] == dmOpenHashTableInternal::CTRL_EMPTY))
+        {
+            // Only rehash at the same size if most of the used slots are tombstones
+            uint32_t slot_count = m_SlotCount == 0 ? dmOpenHashTableInternal::GROUP_SIZE : m_SlotCount;
+            if (m_Count >= MaxLoad(slot_count) / 2)
+            {
+                slot_count *= 2;
+            }
+            Rehash(slot_count);
+            index = FindFreeIndex(hash);
+        }
+
+        if (m_Ctrl[index] == dmOpenHashTableInternal::CTRL_EMPTY)
+        {
+            m_GrowthLeft--;
+        }
+        m_Ctrl[index] = h2;
+        m_Entries[index].m_Key = key;
+        m_Entries[index].m_Value = value;
+        m_Count++;
+    }
+
+    /**
+     * Get pointer to value from key
+     * @param key Key
+     * @return Pointer to value. NULL if the key/value pair doesn't exists.
+     */
+    T* Get(KEY key)
+    {
+        uint64_t hash = dmOpenHashTableInternal::Hash((uint64_t)key);
+        uint32_t index;
+        if (FindIndex(key, hash, (uint8_t)(hash >> 57), &index))
+        {
+            return &m_Entries[index].m_Value;
+        }
+        return 0;
+    }
+
+    /**
+     * Get pointer to value from key. "const" version.
+     * @param key Key
+     * @return Pointer to value. NULL if the key/value pair doesn't exists.
+     */
+    const T* Get(KEY key) const
+    {
+        uint64_t hash = dmOpenHashTableInternal::Hash((uint64_t)key);
+        uint32_t index;
+        if (FindIndex(key, hash, (uint8_t)(hash >> 57), &index))
+        {
+            return &m_Entries[index].m_Value;
+        }
+        return 0;
+    }
+
+    /**
+     * Remove key/value pair. NOTE: Only valid if key exists in table.
+     * @param key Key to remove
+     */
+    void Erase(KEY key)
+    {
+        uint64_t hash = dmOpenHashTableInternal::Hash((uint64_t)key);
+        uint32_t index;
+        bool found = FindIndex(key, hash, (uint8_t)(hash >> 57), &index);
+        assert(found && "Key not found (erase)");
+        (void)found;
+
+        // If the group still has an empty slot, no probe sequence has passed through it
+        // and the slot can be marked empty again instead of leaving a tombstone
+        uint8_t* group = m_Ctrl + (index & ~(dmOpenHashTableInternal::GROUP_SIZE - 1));
+        if (dmOpenHashTableInternal::MatchByte(group, dmOpenHashTableInternal::CTRL_EMPTY))
+        {
+            m_Ctrl[index] = dmOpenHashTableInternal::CTRL_EMPTY;
+            m_GrowthLeft++;
+        }
+        else
+        {
+            m_Ctrl[index] = dmOpenHashTableInternal::CTRL_DELETED;
+        }
+        m_Count--;
+    }
+
+    /**
+     * Iterate over all entries in table
+     * @param call_back Call-back called for every entry
+     * @param context Context
+     */
+    template <typename CONTEXT>
+    void Iterate(void (*call_back)(CONTEXT *context, const KEY* key, T* value), CONTEXT* context)
+    {
+        for (uint32_t g = 0; g < m_SlotCount; g += dmOpenHashTableInternal::GROUP_SIZE)
+        {
+            uint32_t used = ~dmOpenHashTableInternal::MatchFree(m_Ctrl + g) & 0xffff;
+            while (used)
+            {
+                Entry* e = &m_Entries[g + dmOpenHashTableInternal::FirstBit(used)];
+                used &= used - 1;
+                call_back(context, &e->m_Key, &e->m_Value);
+            }
+        }
+    }
+
+    /**
+     * Verify internal structure. "assert" if invalid.
+     */
+    void Verify()
+    {
+        uint32_t real_count = 0;
+        uint32_t empty_count = 0;
+        for (uint32_t i = 0; i < m_SlotCount; ++i)
+        {
+            uint8_t ctrl = m_Ctrl[i];
+            if (ctrl == dmOpenHashTableInternal::CTRL_EMPTY)
+            {
+                empty_count++;
+                continue;
+            }
+            if (ctrl == dmOpenHashTableInternal::CTRL_DELETED)
+                continue;
+
+            assert((ctrl & 0x80) == 0);
+            real_count++;
+            KEY key = m_Entries[i].m_Key;
+            uint64_t hash = dmOpenHashTableInternal::Hash((uint64_t)key);
+            assert(ctrl == (uint8_t)(hash >> 57));
+            uint32_t index;
+            bool found = FindIndex(key, hash, ctrl, &index);
+            assert(found && index == i);
+            (void)found;
+        }
+        assert(real_count == m_Count);
+        assert(m_SlotCount == 0 || empty_count > 0);
+        assert(m_SlotCount - empty_count + m_GrowthLeft == MaxLoad(m_SlotCount));
+        (void)empty_count;
+    }
+
+private:
+    // Forbid assignment operator and copy-constructor
+    dmOpenHashTable(const dmOpenHashTable<KEY, T>&);
+    const dmOpenHashTable<KEY, T>& operator=(const dmOpenHashTable<KEY, T>&);
+
+    static uint32_t MaxLoad(uint32_t slot_count)
+    {
+        return slot_count - slot_count / 8;
+    }
+
+    bool FindIndex(KEY key, uint64_t hash, uint8_t h2, uint32_t* out_index) const
+    {
+        if (m_SlotCount == 0)
+            return false;
+
+        // Triangular probing over the groups visits every group once, since the group count is a power of two
+        uint32_t group_mask = m_SlotCount / dmOpenHashTableInternal::GROUP_SIZE - 1;
+        uint32_t group_index = (uint32_t)hash & group_mask;
+        for (uint32_t step = 1; ; ++step)
+        {
+            uint32_t base = group_index * dmOpenHashTableInternal::GROUP_SIZE;
+            const uint8_t* group = m_Ctrl + base;
+            uint32_t match = dmOpenHashTableInternal::MatchByte(group, h2);
+            while (match)
+            {
+                uint32_t index = base + dmOpenHashTableInternal::FirstBit(match);
+                if (m_Entries[index].m_Key == key)
+                {
+                    *out_index = index;
+                    return true;
+                }
+                match &= match - 1;
+            }
+            if (dmOpenHashTableInternal::MatchByte(group, dmOpenHashTableInternal::CTRL_EMPTY))
+                return false;
+            group_index = (group_index + step) & group_mask;
+        }
+    }
+
+    /// First empty or deleted slot along the probe sequence. Requires that the table has an empty slot.
+    uint32_t FindFreeIndex(uint64_t hash) const
+    {
+        if (m_SlotCount == 0)
+            return 0;
+
+        uint32_t group_mask = m_SlotCount / dmOpenHashTableInternal::GROUP_SIZE - 1;
+        uint32_t group_index = (uint32_t)hash & group_mask;
+        for (uint32_t step = 1; ; ++step)
+        {
+            uint32_t base = group_index * dmOpenHashTableInternal::GROUP_SIZE;
+            uint32_t free_mask = dmOpenHashTableInternal::MatchFree(m_Ctrl + base);
+            if (free_mask)
+                return base + dmOpenHashTableInternal::FirstBit(free_mask);
+            group_index = (group_index + step) & group_mask;
+        }
+    }
+
+    void Rehash(uint32_t slot_count)
+    {
+        uint8_t* old_ctrl = m_Ctrl;
+        Entry* old_entries = m_Entries;
+        uint32_t old_slot_count = m_SlotCount;
+
+        m_SlotCount = slot_count;
+        m_Ctrl = (uint8_t*) malloc(slot_count);
+        m_Entries = (Entry*) malloc(sizeof(Entry) * slot_count);
+        memset(m_Ctrl, dmOpenHashTableInternal::CTRL_EMPTY, slot_count);
+
+        // All keys are unique, so only a free slot needs to be found for each entry
+        for (uint32_t i = 0; i < old_slot_count; ++i)
+        {
+            if (old_ctrl[i] & 0x80)
+                continue;
+            Entry* e = &old_entries[i];
+            uint32_t index = FindFreeIndex(dmOpenHashTableInternal::Hash((uint64_t)e->m_Key));
+            m_Ctrl[index] = old_ctrl[i];
+            m_Entries[index].m_Key = e->m_Key;
+            m_Entries[index].m_Value = e->m_Value;
+        }
+        m_GrowthLeft = MaxLoad(slot_count) - m_Count;
+
+        free(old_ctrl);
+        free(old_entries);
+    }
+
+    // One control byte per slot
+    uint8_t*  m_Ctrl;
+    // One entry per slot
+    Entry*    m_Entries;
+    // Number of slots. Zero or a power of two, multiple of GROUP_SIZE
+    uint32_t  m_SlotCount;
+    // Number of key/value pairs in table
+    uint32_t  m_Count;
+    // Number of empty slots that can be used before the table must grow
+    uint32_t  m_GrowthLeft;
+};
+
+#endif // DM_OPEN_HASHTABLE_H
@@ -40,11 +40,27 @@ namespace dmProfile
 {
     const uint32_t PROFILE_BUFFER_COUNT = 3;
 
+    // Number of samples a thread reserves from the active profile at a time
+    const uint32_t SAMPLE_BLOCK_SIZE = 64;
+
     dmArray<Scope> g_Scopes;
 
     dmHashTable32<uint32_t> g_CountersTable;
     dmArray<Counter> g_Counters;
 
+    /*
+     * Samples are recorded without taking g_ProfileLock:
+     *
+     *  - Each thread reserves a block of SAMPLE_BLOCK_SIZE samples from the active profile
+     *    with an atomic add on m_SampleCount, and fills it without any synchronization.
+     *  - Begin() publishes the recorded samples by setting the size of m_Samples. Samples of a thread
+     *    are in start order, which is what CalculateScopeProfileThread requires.
+     *  - Samples never written, at the end of partly used blocks, have a null m_Scope and are skipped.
+     *    The samples are cleared before the profile becomes active, so a block is initialized before
+     *    it's reserved.
+     *  - Each profile has a generation that changes when it becomes active, so that threads
+     *    don't write to blocks reserved from an earlier use of the same profile.
+     */
     struct Profile
     {
         dmArray<Sample>      m_Samples;
@@ -52,6 +68,22 @@ namespace dmProfile
         dmArray<ScopeData>   m_ScopesData;
         uint32_t             m_ScopeCount;
         uint32_t             m_CounterCount;
+        // Reserved samples, can be larger than the capacity of m_Samples
+        int32_atomic_t       m_SampleCount;
+        uint32_t             m_Generation;
+        // Time when the profile became active. Sample start times are relative to it
+        uint64_t             m_BeginTicks;
+    };
+
+    // Per thread state. Threads may record samples at any time, so it's kept until the process exits (the thread id isn't reused)
+    struct ThreadSamples
+    {
+        Profile*    m_Profile;
+        uint32_t    m_Generation;
+        // Next and end sample index of the reserved block
+        uint32_t    m_Next;
+        uint32_t    m_End;
+        uint16_t    m_ThreadId;
     };
 
     // Default profile if not dmProfile::Initialize is invoked
@@ -81,6 +113,10 @@ namespace dmProfile
 
     dmThread::TlsKey g_TlsKey = dmThread::AllocTls();
     int32_atomic_t g_ThreadCount = 0;
+    // All ThreadSamples, deleted when the process exits. Separate lock since samples may be recorded while holding g_ProfileLock
+    dmArray<ThreadSamples*> g_ThreadSamples;
+    dmSpinlock::lock_t g_ThreadSamplesLock;
+    uint32_t g_Generation = 0;
 
     // Used when out of scopes in order to remove conditional branches
     ScopeData g_DummyScopeData;
@@ -91,11 +127,24 @@ namespace dmProfile
         InitSpinLocks()
         {
             dmSpinlock::Init(&g_ProfileLock);
+            dmSpinlock::Init(&g_ThreadSamplesLock);
         }
     };
 
     InitSpinLocks g_InitSpinlocks;
 
+    struct ThreadSamplesDestroyer
+    {
+        ~ThreadSamplesDestroyer()
+        {
+            for (uint32_t i = 0; i < g_ThreadSamples.Size(); ++i)
+            {
+                delete g_ThreadSamples[i];
+            }
+            g_ThreadSamples.SetCapacity(0);
+        }
+    } g_ThreadSamplesDestroyer;
+
     void Initialize(uint32_t max_scopes, uint32_t max_samples, uint32_t max_counters)
     {
         if (!dLib::IsDebugMode())
@@ -128,6 +177,8 @@ namespace dmProfile
 
             p->m_Samples.SetCapacity(max_samples);
             p->m_Samples.SetSize(0); // Could be > 0 if Initialized is called again after Finalize
+            // No sample is in use, see ReserveSamples
+            memset(p->m_Samples.Begin(), 0, max_samples * sizeof(Sample));
 
             p->m_CountersData.SetCapacity(max_counters);
             p->m_CountersData.SetSize(max_counters);
@@ -137,11 +188,13 @@ namespace dmProfile
 
             p->m_ScopeCount = 0;
             p->m_CounterCount = 0;
+            p->m_SampleCount = 0;
+            p->m_Generation = ++g_Generation;
 
             g_FreeProfiles.Push(p);
         }
 
-        g_ActiveProfile = g_FreeProfiles[0];
+        Profile* active_profile = g_FreeProfiles[0];
         g_FreeProfiles.EraseSwap(0);
 
         /*
@@ -154,10 +207,10 @@ namespace dmProfile
         uint32_t n = g_Scopes.Size();
         for (uint32_t i = 0; i < n; ++i)
         {
-            ScopeData* scope_data = &g_ActiveProfile->m_ScopesData[i];
+            ScopeData* scope_data = &active_profile->m_ScopesData[i];
             scope_data->m_Elapsed = 0;
             scope_data->m_Count = 0;
-            g_ActiveProfile->m_ScopesData[i].m_Scope = &g_Scopes[i];
+            active_profile->m_ScopesData[i].m_Scope = &g_Scopes[i];
         }
 
         g_CountersTable.SetCapacity(dmMath::Max(16U, 2 * max_counters / 3), max_counters);
@@ -176,7 +229,9 @@ namespace dmProfile
         // Set g_BeginTime even if we haven't started since threads may calculate scopes outside of
         // engine Begin()/End() of profiles which happens in Engine::Step() - just so we don't get
         // totally crazy numbers if this happens
-        g_BeginTime = GetNowTicks();
+        active_profile->m_BeginTicks = GetNowTicks();
+        g_BeginTime = (uint32_t) active_profile->m_BeginTicks;
+        dmAtomicSetPointer((void* volatile*) &g_ActiveProfile, active_profile);
         g_IsInitialized = true;
     }
 
@@ -186,6 +241,8 @@ namespace dmProfile
         // Might be dangerous as we have static references to Scope* in functions due to DM_PROFILE
         // See Initialize. It's not even valid to change the number of scopes
 
+        dmAtomicSetPointer((void* volatile*) &g_ActiveProfile, &g_EmptyProfile);
+
         for (uint32_t i = 0; i < PROFILE_BUFFER_COUNT; ++i)
         {
             Profile* p = &g_AllProfiles[i];
@@ -197,8 +254,6 @@ namespace dmProfile
         g_CountersTable.Clear();
         g_Counters.SetCapacity(0);
 
-        g_ActiveProfile = &g_EmptyProfile;
-
         g_StringTable.Clear();
         if (g_StringPool != 0)
             dmStringPool::Delete(g_StringPool);
@@ -222,6 +277,8 @@ namespace dmProfile
         for (uint32_t i = 0; i < n_samples; ++i)
         {
             Sample* sample = &profile->m_Samples[i];
+            if (sample->m_Scope == 0)
+                continue; // Not used
 
             if (g_StringTable.Get((uintptr_t)sample->m_Name) == 0)
             {
@@ -325,6 +382,8 @@ namespace dmProfile
         for (uint32_t i = 0; i < n_samples; ++i)
         {
             Sample* sample = &profile->m_Samples[i];
+            if (sample->m_Scope == 0)
+                continue; // Not used
             if (!active_threads.Get(sample->m_ThreadId))
             {
                 if (active_threads.Full())
@@ -349,9 +408,11 @@ namespace dmProfile
 
         dmSpinlock::Lock(&g_ProfileLock);
 
-        CalculateScopeProfile(g_ActiveProfile);
-
         Profile* ret = g_ActiveProfile;
+        ret->m_Samples.SetSize(dmMath::Min((uint32_t) dmAtomicGet32(&ret->m_SampleCount), ret->m_Samples.Capacity()));
+
+        CalculateScopeProfile(ret);
+
         ret->m_ScopeCount = g_Scopes.Size();
         ret->m_CounterCount = g_Counters.Size();
 
@@ -372,7 +433,6 @@ namespace dmProfile
 
         Profile* profile = g_FreeProfiles[0];
         g_FreeProfiles.EraseSwap(0);
-        g_ActiveProfile = profile;
 
         uint32_t n = g_Scopes.Size();
         for (uint32_t i = 0; i < n; ++i)
@@ -390,14 +450,27 @@ namespace dmProfile
             profile->m_CountersData[i].m_Value = 0;
         }
 
+        // Clear the samples reserved during the last use of the profile, before any thread can reserve them again
+        Sample* samples = profile->m_Samples.Begin();
+        uint32_t sample_count = dmMath::Min((uint32_t) dmAtomicGet32(&profile->m_SampleCount), profile->m_Samples.Capacity());
+        for (uint32_t i = 0; i < sample_count; ++i)
+        {
+            samples[i].m_Scope = 0;
+        }
         profile->m_Samples.SetSize(0);
+        dmAtomicSet32(&profile->m_SampleCount, 0);
+        profile->m_Generation = ++g_Generation;
 
-        g_BeginTime = GetNowTicks();
+        profile->m_BeginTicks = GetNowTicks();
+        g_BeginTime = (uint32_t) profile->m_BeginTicks;
 
         g_OutOfScopes = false;
         g_OutOfSamples = false;
         g_OutOfCounters = false;
 
+        // Threads read the generation and samples after the profile pointer
+        dmAtomicSetPointer((void* volatile*) &g_ActiveProfile, profile);
+
         dmSpinlock::Unlock(&g_ProfileLock);
         return ret;
     }
@@ -459,52 +532,78 @@ namespace dmProfile
     // Used when out of samples in order to remove conditional branches
     Sample g_DummySample = { "OUT_OF_SAMPLES", 0, 0, 0, 0 };
 
-    static Sample* AllocateNewSample()
+    static ThreadSamples* GetThreadSamples()
     {
-        // NOTE: We can't take the spinlock if paused
-        // as it might already been taken in dmProfile:Begin()
-        // A deadlock case occur in dmMessage::Post if http-server is logging
-        // TODO: Use mutex instead?
-        if (g_Paused)
+        ThreadSamples* thread_samples = (ThreadSamples*) dmThread::GetTlsValue(g_TlsKey);
+        if (thread_samples == 0)
         {
-            return &g_DummySample;
+            thread_samples = new ThreadSamples;
+            thread_samples->m_Profile = 0;
+            thread_samples->m_Generation = 0;
+            thread_samples->m_Next = 0;
+            thread_samples->m_End = 0;
+            thread_samples->m_ThreadId = (uint16_t) (dmAtomicIncrement32(&g_ThreadCount));
+            dmThread::SetTlsValue(g_TlsKey, thread_samples);
+
+            DM_SPINLOCK_SCOPED_LOCK(g_ThreadSamplesLock);
+            if (g_ThreadSamples.Full())
+            {
+                g_ThreadSamples.OffsetCapacity(16);
+            }
+            g_ThreadSamples.Push(thread_samples);
         }
+        return thread_samples;
+    }
 
-        DM_SPINLOCK_SCOPED_LOCK(g_ProfileLock)
-        Profile* profile = g_ActiveProfile;
-
-        bool full = profile->m_Samples.Full();
-        if (full)
+    // Reserve a new block of samples from the profile. Returns false if the profile is full
+    static bool ReserveSamples(ThreadSamples* thread_samples, Profile* profile, uint32_t generation)
+    {
+        thread_samples->m_Profile = profile;
+        thread_samples->m_Generation = generation;
+        thread_samples->m_Next = 0;
+        thread_samples->m_End = 0;
+
+        // Check first, so that the count doesn't keep growing once the profile is full
+        uint32_t capacity = profile->m_Samples.Capacity();
+        uint32_t begin = capacity;
+        if ((uint32_t) dmAtomicGet32(&profile->m_SampleCount) < capacity)
+        {
+            begin = (uint32_t) dmAtomicAdd32(&profile->m_SampleCount, (int32_t) SAMPLE_BLOCK_SIZE);
+        }
+        if (begin >= capacity)
         {
             g_OutOfSamples = true;
-            return &g_DummySample;
+            return false;
         }
-        profile->m_Samples.SetSize(profile->m_Samples.Size() + 1);
-        Sample* ret = profile->m_Samples.End() - 1;
-        return ret;
+
+        // The samples were cleared before the profile became active
+        thread_samples->m_Next = begin;
+        thread_samples->m_End = dmMath::Min(begin + SAMPLE_BLOCK_SIZE, capacity);
+        return true;
     }
 
     Sample* AllocateSample()
     {
-        Sample* ret = AllocateNewSample();
-        if (ret == &g_DummySample)
+        // Samples may be recorded while Begin() holds g_ProfileLock, e.g. if the http-server is logging
+        // from dmMessage::Post. Recording samples doesn't take the lock, but paused means no sampling.
+        if (g_Paused)
         {
-            return ret;
+            return &g_DummySample;
         }
 
-        void* tls_data = dmThread::GetTlsValue(g_TlsKey);
-        if (tls_data == 0)
+        ThreadSamples* thread_samples = GetThreadSamples();
+        Profile* profile = (Profile*) dmAtomicGetPointer((void* volatile*) &g_ActiveProfile);
+        uint32_t generation = profile->m_Generation;
+        if (thread_samples->m_Next == thread_samples->m_End || thread_samples->m_Profile != profile || thread_samples->m_Generation != generation)
         {
-            // NOTE: We store thread_id + 1. Otherwise we can't differentiate between thread-id 0 and not initialized
-            int32_t next_thread_id = dmAtomicIncrement32(&g_ThreadCount) + 1;
-            void* thread_id = (void*)((uintptr_t)next_thread_id);
-            dmThread::SetTlsValue(g_TlsKey, thread_id);
-            tls_data = thread_id;
+            if (!ReserveSamples(thread_samples, profile, generation))
+            {
+                return &g_DummySample;
+            }
         }
-        intptr_t thread_id = ((intptr_t)tls_data) - 1;
-        assert(thread_id >= 0);
 
-        ret->m_ThreadId = thread_id;
+        Sample* ret = &profile->m_Samples.Begin()[thread_samples->m_Next++];
+        ret->m_ThreadId = thread_samples->m_ThreadId;
         return ret;
     }
 
@@ -730,23 +829,30 @@ namespace dmProfile
 
     void IterateSamples(HProfile profile, void* context, bool sort, void (*call_back)(void* context, const Sample* sample))
     {
-        uint32_t n = profile->m_Samples.Size();
-        if (n == 0)
+        uint32_t size = profile->m_Samples.Size();
+        if (size == 0)
         {
             return;
         }
         if (!sort)
         {
-            for (uint32_t i = 0; i < n; ++i)
+            for (uint32_t i = 0; i < size; ++i)
             {
-                call_back(context, &profile->m_Samples[i]);
+                if (profile->m_Samples[i].m_Scope != 0)
+                {
+                    call_back(context, &profile->m_Samples[i]);
+                }
             }
             return;
         }
-        uint32_t* sorted_samples = (uint32_t*)alloca(sizeof(uint32_t) * n);
-        for (uint32_t i = 0; i < n; ++i)
+        uint32_t* sorted_samples = (uint32_t*)alloca(sizeof(uint32_t) * size);
+        uint32_t n = 0;
+        for (uint32_t i = 0; i < size; ++i)
         {
-            sorted_samples[i] = i;
+            if (profile->m_Samples[i].m_Scope != 0)
+            {
+                sorted_samples[n++] = i;
+            }
         }
         std::sort(sorted_samples, &sorted_samples[n], SampleSorter(profile));
 
@@ -820,4 +926,270 @@ namespace dmProfile
         }
 
     }
+
+    struct TraceWriter
+    {
+        TraceWriteCallback m_Callback;
+        void*              m_Context;
+        uint64_t           m_OriginTicks;
+        char               m_Buffer[4096];
+        uint32_t           m_BufferSize;
+        bool               m_FirstEvent;
+        bool               m_FirstFrame;
+        bool               m_Failed;
+    };
+
+    static void FlushTrace(TraceWriter* writer)
+    {
+        if (writer->m_BufferSize > 0 && !writer->m_Failed)
+        {
+            writer->m_Failed = !writer->m_Callback(writer->m_Context, writer->m_Buffer, writer->m_BufferSize);
+        }
+        writer->m_BufferSize = 0;
+    }
+
+    static void WriteTrace(TraceWriter* writer, const char* data, uint32_t size)
+    {
+        if (writer->m_BufferSize + size > sizeof(writer->m_Buffer))
+        {
+            FlushTrace(writer);
+            if (size > sizeof(writer->m_Buffer))
+            {
+                if (!writer->m_Failed)
+                    writer->m_Failed = !writer->m_Callback(writer->m_Context, data, size);
+                return;
+            }
+        }
+        memcpy(writer->m_Buffer + writer->m_BufferSize, data, size);
+        writer->m_BufferSize += size;
+    }
+
+    static void WriteTraceString(TraceWriter* writer, const char* str)
+    {
+        WriteTrace(writer, str, (uint32_t) strlen(str));
+    }
+
+    // Writes the string as a quoted and escaped json string
+    static void WriteTraceJsonString(TraceWriter* writer, const char* str)
+    {
+        WriteTrace(writer, "\"", 1);
+        if (str == 0)
+            str = "";
+        const char* begin = str;
+        for (; *str; ++str)
+        {
+            unsigned char c = (unsigned char) *str;
+            if (c == '"' || c == '\\' || c < 0x20)
+            {
+                WriteTrace(writer, begin, (uint32_t) (str - begin));
+                char escaped[8];
+                if (c == '"' || c == '\\')
+                    dmSnPrintf(escaped, sizeof(escaped), "\\%c", c);
+                else
+                    dmSnPrintf(escaped, sizeof(escaped), "\\u%04x", c);
+                WriteTraceString(writer, escaped);
+                begin = str + 1;
+            }
+        }
+        WriteTrace(writer, begin, (uint32_t) (str - begin));
+        WriteTrace(writer, "\"", 1);
+    }
+
+    static void BeginTraceEvent(TraceWriter* writer)
+    {
+        WriteTraceString(writer, writer->m_FirstEvent ? "\n" : ",\n");
+        writer->m_FirstEvent = false;
+    }
+
+    // Microseconds since the first written frame
+    static double TraceTimestamp(TraceWriter* writer, uint64_t ticks)
+    {
+        return (double) (int64_t) (ticks - writer->m_OriginTicks) * 1000000.0 / (double) g_TicksPerSecond;
+    }
+
+    HTraceWriter NewTraceWriter(TraceWriteCallback callback, void* context)
+    {
+        TraceWriter* writer = new TraceWriter;
+        writer->m_Callback = callback;
+        writer->m_Context = context;
+        writer->m_OriginTicks = 0;
+        writer->m_BufferSize = 0;
+        writer->m_FirstEvent = true;
+        writer->m_FirstFrame = true;
+        writer->m_Failed = false;
+        WriteTraceString(writer, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        return writer;
+    }
+
+    static void WriteTraceEvents(TraceWriter* writer, uint64_t begin_ticks, const Sample* samples, uint32_t sample_count,
+                                 const CounterData* counters_data, uint32_t counter_count)
+    {
+        if (writer->m_FirstFrame)
+        {
+            writer->m_OriginTicks = begin_ticks;
+            writer->m_FirstFrame = false;
+        }
+
+        char buf[128];
+        double ticks_to_us = 1000000.0 / (double) g_TicksPerSecond;
+
+        for (uint32_t i = 0; i < sample_count; ++i)
+        {
+            const Sample* sample = &samples[i];
+            if (sample->m_Scope == 0)
+                continue; // Not used
+
+            BeginTraceEvent(writer);
+            WriteTraceString(writer, "{\"name\":");
+            WriteTraceJsonString(writer, sample->m_Name);
+            WriteTraceString(writer, ",\"cat\":");
+            WriteTraceJsonString(writer, sample->m_Scope->m_Name);
+            dmSnPrintf(buf, sizeof(buf), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":%u}",
+                        TraceTimestamp(writer, begin_ticks + sample->m_Start), sample->m_Elapsed * ticks_to_us, (uint32_t) sample->m_ThreadId);
+            WriteTraceString(writer, buf);
+        }
+
+        // Counters are totals for the frame, and are placed at the start of it
+        double frame_ts = TraceTimestamp(writer, begin_ticks);
+        for (uint32_t i = 0; i < counter_count; ++i)
+        {
+            const CounterData* counter_data = &counters_data[i];
+            BeginTraceEvent(writer);
+            WriteTraceString(writer, "{\"name\":");
+            WriteTraceJsonString(writer, counter_data->m_Counter->m_Name);
+            dmSnPrintf(buf, sizeof(buf), ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":0,\"tid\":0,\"args\":{\"value\":%d}}", frame_ts, (int32_t) counter_data->m_Value);
+            WriteTraceString(writer, buf);
+        }
+        FlushTrace(writer);
+    }
+
+    void WriteTraceFrame(HTraceWriter writer, HProfile profile)
+    {
+        WriteTraceEvents(writer, profile->m_BeginTicks, profile->m_Samples.Begin(), profile->m_Samples.Size(),
+                         profile->m_CountersData.Begin(), profile->m_CounterCount);
+    }
+
+    bool DeleteTraceWriter(HTraceWriter writer)
+    {
+        WriteTraceString(writer, "\n]}\n");
+        FlushTrace(writer);
+        bool result = !writer->m_Failed;
+        delete writer;
+        return result;
+    }
+
+    // A copy of the used samples and counters of a profile
+    struct TraceFrame
+    {
+        dmArray<Sample>      m_Samples;
+        dmArray<CounterData> m_CountersData;
+        uint64_t             m_BeginTicks;
+    };
+
+    // Ring buffer of the latest frames. The total number of samples is bounded as well,
+    // the oldest frames are dropped to make room for new ones
+    struct TraceHistory
+    {
+        TraceFrame* m_Frames;
+        uint32_t    m_MaxFrames;
+        uint32_t    m_MaxSamples;
+        // Index of the oldest frame
+        uint32_t    m_First;
+        uint32_t    m_FrameCount;
+        uint32_t    m_SampleCount;
+    };
+
+    HTraceHistory NewTraceHistory(uint32_t max_frames, uint32_t max_samples)
+    {
+        TraceHistory* history = new TraceHistory;
+        history->m_Frames = new TraceFrame[max_frames];
+        history->m_MaxFrames = max_frames;
+        history->m_MaxSamples = max_samples;
+        history->m_First = 0;
+        history->m_FrameCount = 0;
+        history->m_SampleCount = 0;
+        return history;
+    }
+
+    void DeleteTraceHistory(HTraceHistory history)
+    {
+        delete [] history->m_Frames;
+        delete history;
+    }
+
+    static void DropOldestTraceFrame(TraceHistory* history)
+    {
+        TraceFrame* frame = &history->m_Frames[history->m_First];
+        history->m_SampleCount -= frame->m_Samples.Size();
+        frame->m_Samples.SetSize(0);
+        frame->m_CountersData.SetSize(0);
+        history->m_First = (history->m_First + 1) % history->m_MaxFrames;
+        history->m_FrameCount--;
+    }
+
+    void AddTraceFrame(HTraceHistory history, HProfile profile)
+    {
+        if (history->m_MaxFrames == 0)
+            return;
+
+        uint32_t sample_count = 0;
+        uint32_t n = profile->m_Samples.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            if (profile->m_Samples[i].m_Scope != 0)
+                ++sample_count;
+        }
+        sample_count = dmMath::Min(sample_count, history->m_MaxSamples);
+
+        while (history->m_FrameCount > 0 &&
+               (history->m_FrameCount == history->m_MaxFrames || history->m_SampleCount + sample_count > history->m_MaxSamples))
+        {
+            DropOldestTraceFrame(history);
+        }
+
+        TraceFrame* frame = &history->m_Frames[(history->m_First + history->m_FrameCount) % history->m_MaxFrames];
+        history->m_FrameCount++;
+        history->m_SampleCount += sample_count;
+
+        frame->m_BeginTicks = profile->m_BeginTicks;
+        if (frame->m_Samples.Capacity() < sample_count)
+            frame->m_Samples.SetCapacity(sample_count);
+        for (uint32_t i = 0; i < n && frame->m_Samples.Size() < sample_count; ++i)
+        {
+            const Sample* sample = &profile->m_Samples[i];
+            if (sample->m_Scope != 0)
+                frame->m_Samples.Push(*sample);
+        }
+
+        uint32_t counter_count = profile->m_CounterCount;
+        if (frame->m_CountersData.Capacity() < counter_count)
+            frame->m_CountersData.SetCapacity(counter_count);
+        frame->m_CountersData.SetSize(counter_count);
+        if (counter_count > 0)
+            memcpy(frame->m_CountersData.Begin(), profile->m_CountersData.Begin(), counter_count * sizeof(CounterData));
+    }
+
+    uint32_t GetTraceFrameCount(HTraceHistory history)
+    {
+        return history->m_FrameCount;
+    }
+
+    uint32_t WriteTraceHistory(HTraceWriter writer, HTraceHistory history, uint32_t offset, uint32_t frame_count)
+    {
+        if (offset >= history->m_FrameCount)
+            return 0;
+        frame_count = dmMath::Min(frame_count, history->m_FrameCount - offset);
+
+        // Oldest first, ending offset frames before the latest one
+        uint32_t start = history->m_FrameCount - offset - frame_count;
+        for (uint32_t i = 0; i < frame_count; ++i)
+        {
+            TraceFrame* frame = &history->m_Frames[(history->m_First + start + i) % history->m_MaxFrames];
+            WriteTraceEvents(writer, frame->m_BeginTicks, frame->m_Samples.Begin(), frame->m_Samples.Size(),
+                             frame->m_CountersData.Begin(), frame->m_CountersData.Size());
+        }
+        return frame_count;
+    }
+
+
 } // namespace dmProfile
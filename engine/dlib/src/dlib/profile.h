@@ -266,6 +266,84 @@ namespace dmProfile
      */
     void IterateCounterData(HProfile profile, void* context, void (*call_back)(void* context, const CounterData* counter));
 
+    /// Trace writer handle
+    typedef struct TraceWriter* HTraceWriter;
+
+    /**
+     * Trace output callback
+     * @param context User context
+     * @param data Data to write
+     * @param size Size of the data in bytes
+     * @return False if the data couldn't be written. Nothing more is written after a failure.
+     */
+    typedef bool (*TraceWriteCallback)(void* context, const void* data, uint32_t size);
+
+    /**
+     * Create a writer of profile frames in the Chrome Trace Event format (json), which can be
+     * opened in chrome://tracing or https://ui.perfetto.dev
+     * @param callback Callback to output the data with
+     * @param context User context passed to the callback
+     * @return The trace writer
+     */
+    HTraceWriter NewTraceWriter(TraceWriteCallback callback, void* context);
+
+    /**
+     * Write the samples and counters of a profile snapshot to the trace. Samples are written as complete
+     * events with their thread id, counters as counter events at the start of the frame.
+     * Timestamps are relative to the first written frame.
+     * @param writer Trace writer
+     * @param profile Profile snapshot, as returned by #Begin
+     */
+    void WriteTraceFrame(HTraceWriter writer, HProfile profile);
+
+    /**
+     * Finish the trace and delete the writer
+     * @param writer Trace writer
+     * @return True if all data was written successfully
+     */
+    bool DeleteTraceWriter(HTraceWriter writer);
+
+    /// Trace history handle
+    typedef struct TraceHistory* HTraceHistory;
+
+    /**
+     * Create a history of the latest profile frames, to write a range of past frames to a trace
+     * @param max_frames Maximum number of frames kept
+     * @param max_samples Maximum number of samples kept in total. The oldest frames are dropped to make room
+     * @return The trace history
+     */
+    HTraceHistory NewTraceHistory(uint32_t max_frames, uint32_t max_samples);
+
+    /**
+     * Delete a trace history
+     * @param history Trace history
+     */
+    void DeleteTraceHistory(HTraceHistory history);
+
+    /**
+     * Copy the samples and counters of a profile snapshot to the history, as the latest frame
+     * @param history Trace history
+     * @param profile Profile snapshot, as returned by #Begin
+     */
+    void AddTraceFrame(HTraceHistory history, HProfile profile);
+
+    /**
+     * Get the number of frames in the history
+     * @param history Trace history
+     * @return Number of frames
+     */
+    uint32_t GetTraceFrameCount(HTraceHistory history);
+
+    /**
+     * Write a range of frames from the history to the trace, oldest first
+     * @param writer Trace writer
+     * @param history Trace history
+     * @param offset Number of frames between the last written frame and the latest frame. 0 ends with the latest frame
+     * @param frame_count Number of frames to write
+     * @return Number of frames written, which is less than frame_count if the history doesn't hold them all
+     */
+    uint32_t WriteTraceHistory(HTraceWriter writer, HTraceHistory history, uint32_t offset, uint32_t frame_count);
+
     /**
      * Internal function
      * @param name
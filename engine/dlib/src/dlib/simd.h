@@ -0,0 +1,191 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_SIMD_H
+#define DM_SIMD_H
+
+/*
+ * Minimal four-wide float vector abstraction used by the data parallel kernels in the engine.
+ * Maps to SSE2 on x86/x86_64, NEON on arm64 (and armv7 when compiled with NEON enabled),
+ * and a scalar fallback elsewhere (e.g. web).
+ *
+ * Only plain multiplications and additions are used (no fused multiply-add), so kernels written
+ * with the same operation order as the scalar vectormath code produce identical results.
+ */
+
+#include <stdint.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define DM_SIMD_SSE2
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    #define DM_SIMD_NEON
+    #include <arm_neon.h>
+#else
+    #define DM_SIMD_SCALAR
+#endif
+
+namespace dmSIMD
+{
+#if defined(DM_SIMD_SSE2)
+    typedef __m128 Vector4f;
+#elif defined(DM_SIMD_NEON)
+    typedef float32x4_t Vector4f;
+#else
+    struct Vector4f
+    {
+        float m_V[4];
+    };
+#endif
+
+#if defined(DM_SIMD_SSE2)
+
+    static inline Vector4f Load(const float* p)                 { return _mm_loadu_ps(p); }
+    static inline void     Store(float* p, Vector4f v)          { _mm_storeu_ps(p, v); }
+    static inline Vector4f Splat(float f)                       { return _mm_set1_ps(f); }
+    static inline Vector4f Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+    static inline Vector4f Add(Vector4f a, Vector4f b)          { return _mm_add_ps(a, b); }
+    static inline Vector4f Sub(Vector4f a, Vector4f b)          { return _mm_sub_ps(a, b); }
+    static inline Vector4f Neg(Vector4f v)                      { return _mm_xor_ps(v, _mm_set1_ps(-0.0f)); }
+    static inline Vector4f Mul(Vector4f a, Vector4f b)          { return _mm_mul_ps(a, b); }
+    static inline Vector4f Min(Vector4f a, Vector4f b)          { return _mm_min_ps(a, b); }
+    static inline Vector4f Max(Vector4f a, Vector4f b)          { return _mm_max_ps(a, b); }
+    static inline Vector4f SplatX(Vector4f v)                   { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)); }
+    static inline Vector4f SplatY(Vector4f v)                   { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)); }
+    static inline Vector4f SplatZ(Vector4f v)                   { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)); }
+    static inline Vector4f SplatW(Vector4f v)                   { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)); }
+    static inline Vector4f Div(Vector4f a, Vector4f b)          { return _mm_div_ps(a, b); }
+    static inline Vector4f Sqrt(Vector4f v)                     { return _mm_sqrt_ps(v); }
+    static inline Vector4f Select(Vector4f x, Vector4f a, Vector4f b)
+    {
+        __m128 mask = _mm_cmpge_ps(x, _mm_setzero_ps());
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // (a.x, b.x, a.y, b.y) and (a.z, b.z, a.w, b.w)
+    static inline Vector4f InterleaveLo(Vector4f a, Vector4f b) { return _mm_unpacklo_ps(a, b); }
+    static inline Vector4f InterleaveHi(Vector4f a, Vector4f b) { return _mm_unpackhi_ps(a, b); }
+
+    static inline void Transpose(Vector4f& a, Vector4f& b, Vector4f& c, Vector4f& d)
+    {
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+    }
+
+#elif defined(DM_SIMD_NEON)
+
+    static inline Vector4f Load(const float* p)                 { return vld1q_f32(p); }
+    static inline void     Store(float* p, Vector4f v)          { vst1q_f32(p, v); }
+    static inline Vector4f Splat(float f)                       { return vdupq_n_f32(f); }
+    static inline Vector4f Set(float x, float y, float z, float w) { float v[4] = {x, y, z, w}; return vld1q_f32(v); }
+    static inline Vector4f Add(Vector4f a, Vector4f b)          { return vaddq_f32(a, b); }
+    static inline Vector4f Sub(Vector4f a, Vector4f b)          { return vsubq_f32(a, b); }
+    static inline Vector4f Neg(Vector4f v)                      { return vnegq_f32(v); }
+    static inline Vector4f Mul(Vector4f a, Vector4f b)          { return vmulq_f32(a, b); }
+    static inline Vector4f Min(Vector4f a, Vector4f b)          { return vminq_f32(a, b); }
+    static inline Vector4f Max(Vector4f a, Vector4f b)          { return vmaxq_f32(a, b); }
+    static inline Vector4f SplatX(Vector4f v)                   { return vdupq_lane_f32(vget_low_f32(v), 0); }
+    static inline Vector4f SplatY(Vector4f v)                   { return vdupq_lane_f32(vget_low_f32(v), 1); }
+    static inline Vector4f SplatZ(Vector4f v)                   { return vdupq_lane_f32(vget_high_f32(v), 0); }
+    static inline Vector4f SplatW(Vector4f v)                   { return vdupq_lane_f32(vget_high_f32(v), 1); }
+#if defined(__aarch64__)
+    static inline Vector4f Div(Vector4f a, Vector4f b)          { return vdivq_f32(a, b); }
+    static inline Vector4f Sqrt(Vector4f v)                     { return vsqrtq_f32(v); }
+#else
+    // No vector division or square root on ARMv7, and the estimate instructions are not exact
+    static inline Vector4f Div(Vector4f a, Vector4f b)
+    {
+        float fa[4], fb[4];
+        vst1q_f32(fa, a); vst1q_f32(fb, b);
+        return Set(fa[0] / fb[0], fa[1] / fb[1], fa[2] / fb[2], fa[3] / fb[3]);
+    }
+    static inline Vector4f Sqrt(Vector4f v)
+    {
+        float f[4];
+        vst1q_f32(f, v);
+        return Set(sqrtf(f[0]), sqrtf(f[1]), sqrtf(f[2]), sqrtf(f[3]));
+    }
+#endif
+    static inline Vector4f Select(Vector4f x, Vector4f a, Vector4f b)
+    {
+        return vbslq_f32(vcgeq_f32(x, vdupq_n_f32(0.0f)), a, b);
+    }
+
+#if defined(__aarch64__)
+    static inline Vector4f InterleaveLo(Vector4f a, Vector4f b) { return vzip1q_f32(a, b); }
+    static inline Vector4f InterleaveHi(Vector4f a, Vector4f b) { return vzip2q_f32(a, b); }
+#else
+    static inline Vector4f InterleaveLo(Vector4f a, Vector4f b) { return vzipq_f32(a, b).val[0]; }
+    static inline Vector4f InterleaveHi(Vector4f a, Vector4f b) { return vzipq_f32(a, b).val[1]; }
+#endif
+
+    static inline void Transpose(Vector4f& a, Vector4f& b, Vector4f& c, Vector4f& d)
+    {
+        float32x4x2_t ab = vtrnq_f32(a, b);
+        float32x4x2_t cd = vtrnq_f32(c, d);
+        a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+        b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+        c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+        d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+    }
+
+#else
+
+    static inline Vector4f Set(float x, float y, float z, float w) { Vector4f r = {{x, y, z, w}}; return r; }
+    static inline Vector4f Load(const float* p)                 { return Set(p[0], p[1], p[2], p[3]); }
+    static inline void     Store(float* p, Vector4f v)          { p[0] = v.m_V[0]; p[1] = v.m_V[1]; p[2] = v.m_V[2]; p[3] = v.m_V[3]; }
+    static inline Vector4f Splat(float f)                       { return Set(f, f, f, f); }
+    static inline Vector4f Add(Vector4f a, Vector4f b)          { return Set(a.m_V[0] + b.m_V[0], a.m_V[1] + b.m_V[1], a.m_V[2] + b.m_V[2], a.m_V[3] + b.m_V[3]); }
+    static inline Vector4f Sub(Vector4f a, Vector4f b)          { return Set(a.m_V[0] - b.m_V[0], a.m_V[1] - b.m_V[1], a.m_V[2] - b.m_V[2], a.m_V[3] - b.m_V[3]); }
+    static inline Vector4f Neg(Vector4f v)                      { return Set(-v.m_V[0], -v.m_V[1], -v.m_V[2], -v.m_V[3]); }
+    static inline Vector4f Mul(Vector4f a, Vector4f b)          { return Set(a.m_V[0] * b.m_V[0], a.m_V[1] * b.m_V[1], a.m_V[2] * b.m_V[2], a.m_V[3] * b.m_V[3]); }
+    static inline float    MinF(float a, float b)               { return a < b ? a : b; }
+    static inline float    MaxF(float a, float b)               { return a > b ? a : b; }
+    static inline Vector4f Min(Vector4f a, Vector4f b)          { return Set(MinF(a.m_V[0], b.m_V[0]), MinF(a.m_V[1], b.m_V[1]), MinF(a.m_V[2], b.m_V[2]), MinF(a.m_V[3], b.m_V[3])); }
+    static inline Vector4f Max(Vector4f a, Vector4f b)          { return Set(MaxF(a.m_V[0], b.m_V[0]), MaxF(a.m_V[1], b.m_V[1]), MaxF(a.m_V[2], b.m_V[2]), MaxF(a.m_V[3], b.m_V[3])); }
+    static inline Vector4f SplatX(Vector4f v)                   { return Splat(v.m_V[0]); }
+    static inline Vector4f SplatY(Vector4f v)                   { return Splat(v.m_V[1]); }
+    static inline Vector4f SplatZ(Vector4f v)                   { return Splat(v.m_V[2]); }
+    static inline Vector4f SplatW(Vector4f v)                   { return Splat(v.m_V[3]); }
+    static inline Vector4f Div(Vector4f a, Vector4f b)          { return Set(a.m_V[0] / b.m_V[0], a.m_V[1] / b.m_V[1], a.m_V[2] / b.m_V[2], a.m_V[3] / b.m_V[3]); }
+    static inline Vector4f Sqrt(Vector4f v)                     { return Set(sqrtf(v.m_V[0]), sqrtf(v.m_V[1]), sqrtf(v.m_V[2]), sqrtf(v.m_V[3])); }
+    static inline float    SelectF(float x, float a, float b)   { return x >= 0.0f ? a : b; }
+    static inline Vector4f Select(Vector4f x, Vector4f a, Vector4f b)
+    {
+        return Set(SelectF(x.m_V[0], a.m_V[0], b.m_V[0]), SelectF(x.m_V[1], a.m_V[1], b.m_V[1]),
+                   SelectF(x.m_V[2], a.m_V[2], b.m_V[2]), SelectF(x.m_V[3], a.m_V[3], b.m_V[3]));
+    }
+
+    static inline Vector4f InterleaveLo(Vector4f a, Vector4f b) { return Set(a.m_V[0], b.m_V[0], a.m_V[1], b.m_V[1]); }
+    static inline Vector4f InterleaveHi(Vector4f a, Vector4f b) { return Set(a.m_V[2], b.m_V[2], a.m_V[3], b.m_V[3]); }
+
+    static inline void Transpose(Vector4f& a, Vector4f& b, Vector4f& c, Vector4f& d)
+    {
+        Vector4f ta = Set(a.m_V[0], b.m_V[0], c.m_V[0], d.m_V[0]);
+        Vector4f tb = Set(a.m_V[1], b.m_V[1], c.m_V[1], d.m_V[1]);
+        Vector4f tc = Set(a.m_V[2], b.m_V[2], c.m_V[2], d.m_V[2]);
+        Vector4f td = Set(a.m_V[3], b.m_V[3], c.m_V[3], d.m_V[3]);
+        a = ta; b = tb; c = tc; d = td;
+    }
+
+#endif
+
+    /**
+     * Multiply and add, a * b + c. Not fused, i.e. rounded after each operation.
+     */
+    static inline Vector4f MulAdd(Vector4f a, Vector4f b, Vector4f c)
+    {
+        return Add(Mul(a, b), c);
+    }
+}
+
+#endif // DM_SIMD_H
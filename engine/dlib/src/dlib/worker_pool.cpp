@@ -0,0 +1,206 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "array.h"
+#include "atomic.h"
+#include "condition_variable.h"
+#include "mutex.h"
+#include "thread.h"
+#include "profile.h"
+#include "worker_pool.h"
+
+namespace dmWorkerPool
+{
+    struct WorkerPool
+    {
+        dmArray<dmThread::Thread>               m_Threads;
+
+        // Protects the job description and m_Generation/m_ActiveWorkers/m_Run
+        dmMutex::HMutex                         m_Mutex;
+        dmConditionVariable::HConditionVariable m_WorkCondition;
+        dmConditionVariable::HConditionVariable m_DoneCondition;
+
+        RangeFunction                           m_Function;
+        void*                                   m_Context;
+        uint32_t                                m_Count;
+        uint32_t                                m_BatchSize;
+        uint32_t                                m_BatchCount;
+        int32_atomic_t                          m_NextBatch;
+        int32_atomic_t                          m_BatchesDone;
+        // Set while a ParallelFor is in progress. Not a (recursive) mutex as nested calls must be detected
+        int32_atomic_t                          m_Busy;
+
+        uint32_t                                m_Generation;
+        uint32_t                                m_ActiveWorkers;
+        bool                                    m_Run;
+    };
+
+    // Claim and execute batches until there are none left
+    static void RunBatches(WorkerPool* pool, RangeFunction fn, void* context, uint32_t count, uint32_t batch_size, uint32_t batch_count)
+    {
+        for (;;)
+        {
+            uint32_t batch = (uint32_t) dmAtomicIncrement32(&pool->m_NextBatch);
+            if (batch >= batch_count)
+                break;
+
+            uint32_t begin = batch * batch_size;
+            uint32_t end = begin + batch_size;
+            if (end > count)
+                end = count;
+            fn(context, begin, end);
+
+            dmAtomicIncrement32(&pool->m_BatchesDone);
+        }
+    }
+
+    static void WorkerThread(void* arg)
+    {
+        WorkerPool* pool = (WorkerPool*) arg;
+        uint32_t generation = 0;
+
+        dmMutex::Lock(pool->m_Mutex);
+        for (;;)
+        {
+            while (pool->m_Run && pool->m_Generation == generation)
+            {
+                dmConditionVariable::Wait(pool->m_WorkCondition, pool->m_Mutex);
+            }
+            if (!pool->m_Run)
+                break;
+
+            generation = pool->m_Generation;
+            RangeFunction fn = pool->m_Function;
+            void* context = pool->m_Context;
+            uint32_t count = pool->m_Count;
+            uint32_t batch_size = pool->m_BatchSize;
+            uint32_t batch_count = pool->m_BatchCount;
+            pool->m_ActiveWorkers++;
+            dmMutex::Unlock(pool->m_Mutex);
+
+            {
+                DM_PROFILE(WorkerPool, "ParallelFor");
+                RunBatches(pool, fn, context, count, batch_size, batch_count);
+            }
+
+            dmMutex::Lock(pool->m_Mutex);
+            pool->m_ActiveWorkers--;
+            if (pool->m_ActiveWorkers == 0)
+            {
+                dmConditionVariable::Signal(pool->m_DoneCondition);
+            }
+        }
+        dmMutex::Unlock(pool->m_Mutex);
+    }
+
+    HWorkerPool New(uint32_t worker_count, const char* name)
+    {
+#if defined(__EMSCRIPTEN__)
+        // No thread support
+        worker_count = 0;
+#endif
+        WorkerPool* pool = new WorkerPool;
+        pool->m_Mutex = dmMutex::New();
+        pool->m_WorkCondition = dmConditionVariable::New();
+        pool->m_DoneCondition = dmConditionVariable::New();
+        pool->m_Function = 0;
+        pool->m_Context = 0;
+        pool->m_Count = 0;
+        pool->m_BatchSize = 0;
+        pool->m_BatchCount = 0;
+        pool->m_NextBatch = 0;
+        pool->m_BatchesDone = 0;
+        pool->m_Busy = 0;
+        pool->m_Generation = 0;
+        pool->m_ActiveWorkers = 0;
+        pool->m_Run = true;
+
+        pool->m_Threads.SetCapacity(worker_count);
+        for (uint32_t i = 0; i < worker_count; ++i)
+        {
+            pool->m_Threads.Push(dmThread::New(WorkerThread, 0x80000, pool, name));
+        }
+        return pool;
+    }
+
+    void Delete(HWorkerPool pool)
+    {
+        if (!pool)
+            return;
+
+        dmMutex::Lock(pool->m_Mutex);
+        pool->m_Run = false;
+        dmConditionVariable::Broadcast(pool->m_WorkCondition);
+        dmMutex::Unlock(pool->m_Mutex);
+
+        for (uint32_t i = 0; i < pool->m_Threads.Size(); ++i)
+        {
+            dmThread::Join(pool->m_Threads[i]);
+        }
+
+        dmConditionVariable::Delete(pool->m_DoneCondition);
+        dmConditionVariable::Delete(pool->m_WorkCondition);
+        dmMutex::Delete(pool->m_Mutex);
+        delete pool;
+    }
+
+    uint32_t GetWorkerCount(HWorkerPool pool)
+    {
+        return pool ? pool->m_Threads.Size() : 0;
+    }
+
+    void ParallelFor(HWorkerPool pool, uint32_t count, uint32_t batch_size, RangeFunction fn, void* context)
+    {
+        assert(batch_size > 0);
+        if (count == 0)
+            return;
+
+        if (!pool || pool->m_Threads.Empty() || count <= batch_size || dmAtomicCompareStore32(&pool->m_Busy, 1, 0) != 0)
+        {
+            fn(context, 0, count);
+            return;
+        }
+
+        uint32_t batch_count = (count + batch_size - 1) / batch_size;
+
+        dmMutex::Lock(pool->m_Mutex);
+        // Workers that woke up late for the previous job might still be claiming batches
+        while (pool->m_ActiveWorkers > 0)
+        {
+            dmConditionVariable::Wait(pool->m_DoneCondition, pool->m_Mutex);
+        }
+        pool->m_Function = fn;
+        pool->m_Context = context;
+        pool->m_Count = count;
+        pool->m_BatchSize = batch_size;
+        pool->m_BatchCount = batch_count;
+        pool->m_NextBatch = 0;
+        pool->m_BatchesDone = 0;
+        pool->m_Generation++;
+        dmConditionVariable::Broadcast(pool->m_WorkCondition);
+        dmMutex::Unlock(pool->m_Mutex);
+
+        RunBatches(pool, fn, context, count, batch_size, batch_count);
+
+        dmMutex::Lock(pool->m_Mutex);
+        while (pool->m_ActiveWorkers > 0 || (uint32_t) pool->m_BatchesDone < batch_count)
+        {
+            dmConditionVariable::Wait(pool->m_DoneCondition, pool->m_Mutex);
+        }
+        dmMutex::Unlock(pool->m_Mutex);
+
+        dmAtomicStore32(&pool->m_Busy, 0);
+    }
+}
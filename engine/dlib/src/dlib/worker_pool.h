@@ -0,0 +1,72 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#ifndef DM_WORKER_POOL_H
+#define DM_WORKER_POOL_H
+
+#include <stdint.h>
+
+namespace dmWorkerPool
+{
+    /**
+     * Worker pool handle.
+     */
+    typedef struct WorkerPool* HWorkerPool;
+
+    /**
+     * Range function. Called with a sub range [begin, end) of the range passed to ParallelFor
+     * @param context User context
+     * @param begin First index in range
+     * @param end One past the last index in range
+     */
+    typedef void (*RangeFunction)(void* context, uint32_t begin, uint32_t end);
+
+    /**
+     * Create a new worker pool. On platforms without thread support no threads are created
+     * and all work is executed on the calling thread.
+     * @param worker_count Number of worker threads. The calling thread of ParallelFor also
+     * participates, i.e. the degree of parallelism is worker_count + 1
+     * @param name Name of the worker threads
+     * @return Worker pool
+     */
+    HWorkerPool New(uint32_t worker_count, const char* name);
+
+    /**
+     * Delete worker pool. Must not be called while a ParallelFor is in progress.
+     * @param pool Pool to delete
+     */
+    void Delete(HWorkerPool pool);
+
+    /**
+     * Get number of worker threads
+     * @param pool Pool. Zero is a valid pool with no workers
+     * @return Number of worker threads
+     */
+    uint32_t GetWorkerCount(HWorkerPool pool);
+
+    /**
+     * Split the range [0, count) into batches of at most batch_size elements and
+     * execute them on the worker threads and the calling thread. The call blocks
+     * until all batches are done.
+     * If the pool is zero, has no workers, is busy with another ParallelFor (e.g. nested
+     * or from another thread) or the range fits in a single batch, the function
+     * is executed on the calling thread with the full range.
+     * @param pool Pool. Zero is a valid pool with no workers
+     * @param count Number of elements
+     * @param batch_size Max number of elements per batch, must be greater than zero
+     * @param fn Range function
+     * @param context User context passed to fn
+     */
+    void ParallelFor(HWorkerPool pool, uint32_t count, uint32_t batch_size, RangeFunction fn, void* context);
+}
+
+#endif // DM_WORKER_POOL_H
@@ -16,8 +16,11 @@
 #include <map>
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
+#include "../dlib/dstrings.h"
 #include "../dlib/hash.h"
 #include "../dlib/log.h"
+#include "../dlib/thread.h"
+#include "../dlib/time.h"
 
 class dlib : public jc_test_base_class
 {
@@ -570,6 +573,109 @@ TEST_F(dlib, HashReverseEnable)
     dmHashEnableReverseHash(true);
 }
 
+TEST_F(dlib, HashReverseEraseReuse)
+{
+    // Erased strings are reused by later strings of the same size
+    char buffer[64];
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        dmSnPrintf(buffer, sizeof(buffer), "/erase_reuse_%u", i);
+        uint64_t h = dmHashString64(buffer);
+        const void* reverse = dmHashReverse64(h, 0);
+        ASSERT_STREQ(buffer, (const char*) reverse);
+        dmHashReverseErase64(h);
+        ASSERT_EQ((const void*) 0, dmHashReverse64(h, 0));
+
+        // The string is put in the slot it was erased from
+        ASSERT_EQ(h, dmHashString64(buffer));
+        ASSERT_EQ(reverse, dmHashReverse64(h, 0));
+        ASSERT_STREQ(buffer, (const char*) dmHashReverse64(h, 0));
+        dmHashReverseErase64(h);
+    }
+}
+
+struct HashThreadContext
+{
+    uint32_t m_ThreadIndex;
+    uint32_t m_StringCount;
+    uint32_t m_Iterations;
+    uint32_t m_NewStrings;
+    uint32_t m_Errors;
+};
+
+static void HashThread(void* arg)
+{
+    HashThreadContext* ctx = (HashThreadContext*) arg;
+    char buffer[64];
+    for (uint32_t i = 0; i < ctx->m_Iterations; ++i)
+    {
+        // Mostly strings that are already known, like script hash() calls with constant strings
+        uint32_t index = i % ctx->m_StringCount;
+        uint32_t len = dmSnPrintf(buffer, sizeof(buffer), "/shared/go%u#component", index);
+        uint64_t h64 = dmHashBuffer64(buffer, len);
+        uint32_t h32 = dmHashBuffer32(buffer, len);
+
+        // Some new ones, like spawned instance ids
+        if (ctx->m_NewStrings && (i % 16) == 0)
+        {
+            len = dmSnPrintf(buffer, sizeof(buffer), "/instance_%u_%u", ctx->m_ThreadIndex, i);
+            h64 = dmHashBuffer64(buffer, len);
+        }
+
+        const char* reverse = (const char*) dmHashReverse64(h64, 0);
+        if (reverse == 0 || strcmp(reverse, buffer) != 0 || dmHashReverse32(h32, 0) == 0)
+        {
+            ctx->m_Errors++;
+        }
+    }
+}
+
+static uint64_t RunHashThreads(uint32_t thread_count, uint32_t iterations, bool new_strings, uint32_t* errors)
+{
+    const uint32_t max_threads = 8;
+    dmThread::Thread threads[max_threads];
+    HashThreadContext contexts[max_threads];
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        contexts[i].m_ThreadIndex = i;
+        contexts[i].m_StringCount = 1024;
+        contexts[i].m_Iterations = iterations;
+        contexts[i].m_NewStrings = new_strings;
+        contexts[i].m_Errors = 0;
+        threads[i] = dmThread::New(HashThread, 0x80000, &contexts[i], "hash");
+    }
+    *errors = 0;
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+        *errors += contexts[i].m_Errors;
+    }
+    return dmTime::GetTime() - start;
+}
+
+TEST_F(dlib, HashReverseThreaded)
+{
+    uint32_t errors;
+    RunHashThreads(8, 20000, true, &errors);
+    ASSERT_EQ(0u, errors);
+}
+
+TEST_F(dlib, HashReverseContentionBench)
+{
+    const uint32_t iterations = 200000;
+    for (uint32_t threads = 1; threads <= 8; threads *= 2)
+    {
+        uint32_t errors;
+        uint64_t t_known = RunHashThreads(threads, iterations, false, &errors);
+        ASSERT_EQ(0u, errors);
+        uint64_t t_new = RunHashThreads(threads, iterations, true, &errors);
+        ASSERT_EQ(0u, errors);
+        printf("Reverse hashing, %u threads x %u hashes: known strings %.2f ms, with new strings %.2f ms\n",
+                threads, iterations, t_known / 1000.0, t_new / 1000.0);
+    }
+}
+
 TEST_F(dlib, Log)
 {
     dmLogWarning("Test warning message. Should have domain DLIB");
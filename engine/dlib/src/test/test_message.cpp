@@ -461,6 +461,243 @@ TEST(dmMessage, MessagePostDispatch)
 }
 
 
+struct OrderContext
+{
+    uint32_t m_Next[4];
+    uint32_t m_Count;
+    uint32_t m_Errors;
+};
+
+void HandleOrderMessage(dmMessage::Message *message_object, void *user_ptr)
+{
+    // Messages from the same thread must be dispatched in the order they were posted
+    OrderContext* ctx = (OrderContext*) user_ptr;
+    uint32_t thread = (uint32_t) message_object->m_UserData;
+    uint32_t value = *(uint32_t*) message_object->m_Data;
+    if (ctx->m_Next[thread] != value)
+    {
+        ctx->m_Errors++;
+    }
+    ctx->m_Next[thread] = value + 1;
+    ctx->m_Count++;
+}
+
+TEST(dmMessage, PostMany)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    // Larger messages to span several pages
+    const uint32_t count = 64;
+    uint32_t data[count][64];
+    dmMessage::MessagePost messages[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        data[i][0] = i;
+        messages[i].m_Id = m_HashMessage1;
+        messages[i].m_UserData = 0;
+        messages[i].m_Descriptor = 0;
+        messages[i].m_Data = data[i];
+        messages[i].m_DataSize = sizeof(data[i]);
+        messages[i].m_DestroyCallback = 0;
+    }
+
+    for (uint32_t iter = 0; iter < 4; ++iter)
+    {
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::PostMany(0x0, &receiver, messages, count));
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, data[0], sizeof(uint32_t), 0));
+        ASSERT_TRUE(dmMessage::HasMessages(receiver.m_Socket));
+
+        OrderContext ctx;
+        memset(&ctx, 0, sizeof(ctx));
+        ASSERT_EQ(count + 1, dmMessage::Dispatch(receiver.m_Socket, HandleOrderMessage, &ctx));
+        // The single message posted after the batch has value 0
+        ASSERT_EQ(1u, ctx.m_Errors);
+        ASSERT_EQ(count + 1, ctx.m_Count);
+        ASSERT_FALSE(dmMessage::HasMessages(receiver.m_Socket));
+    }
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::PostMany(0x0, &receiver, messages, 0));
+    ASSERT_EQ(0u, dmMessage::Dispatch(receiver.m_Socket, HandleOrderMessage, 0));
+
+    dmMessage::URL invalid_receiver;
+    dmMessage::ResetURL(invalid_receiver);
+    ASSERT_EQ(dmMessage::RESULT_SOCKET_NOT_FOUND, dmMessage::PostMany(0x0, &invalid_receiver, messages, count));
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
+struct PostOrderThreadContext
+{
+    dmMessage::URL* m_Receiver;
+    uint32_t        m_Thread;
+    uint32_t        m_Count;
+    uint32_t        m_BatchSize;
+};
+
+void PostOrderThread(void* arg)
+{
+    PostOrderThreadContext* ctx = (PostOrderThreadContext*) arg;
+    const uint32_t max_batch_size = 64;
+    uint32_t values[max_batch_size];
+    dmMessage::MessagePost messages[max_batch_size];
+    for (uint32_t i = 0; i < ctx->m_Count; i += ctx->m_BatchSize)
+    {
+        if (ctx->m_BatchSize == 1)
+        {
+            dmMessage::Post(0x0, ctx->m_Receiver, m_HashMessage1, ctx->m_Thread, 0x0, &i, sizeof(i), 0);
+            continue;
+        }
+        for (uint32_t j = 0; j < ctx->m_BatchSize; ++j)
+        {
+            values[j] = i + j;
+            messages[j].m_Id = m_HashMessage1;
+            messages[j].m_UserData = ctx->m_Thread;
+            messages[j].m_Descriptor = 0;
+            messages[j].m_Data = &values[j];
+            messages[j].m_DataSize = sizeof(values[j]);
+            messages[j].m_DestroyCallback = 0;
+        }
+        dmMessage::PostMany(0x0, ctx->m_Receiver, messages, ctx->m_BatchSize);
+    }
+}
+
+// Post from several threads while dispatching. Returns the time in us
+static uint64_t PostOrderTest(uint32_t thread_count, uint32_t count_per_thread, uint32_t batch_size, OrderContext* order)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    dmMessage::NewSocket("my_socket", &receiver.m_Socket);
+
+    memset(order, 0, sizeof(*order));
+    PostOrderThreadContext ctx[4];
+    dmThread::Thread threads[4];
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        ctx[i].m_Receiver = &receiver;
+        ctx[i].m_Thread = i;
+        ctx[i].m_Count = count_per_thread;
+        ctx[i].m_BatchSize = batch_size;
+        threads[i] = dmThread::New(&PostOrderThread, 0xf0000, (void*) &ctx[i], "post");
+    }
+
+    while (order->m_Count < thread_count * count_per_thread)
+    {
+        dmMessage::Dispatch(receiver.m_Socket, HandleOrderMessage, order);
+    }
+    uint64_t elapsed = dmTime::GetTime() - start;
+
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        dmThread::Join(threads[i]);
+    }
+    dmMessage::Dispatch(receiver.m_Socket, HandleOrderMessage, order);
+    dmMessage::DeleteSocket(receiver.m_Socket);
+    return elapsed;
+}
+
+TEST(dmMessage, ThreadOrder)
+{
+    OrderContext order;
+    for (uint32_t batch_size = 1; batch_size <= 16; batch_size *= 16)
+    {
+        PostOrderTest(4, 1024 * 16, batch_size, &order);
+        ASSERT_EQ(4u * 1024u * 16u, order.m_Count);
+        ASSERT_EQ(0u, order.m_Errors);
+    }
+}
+
+static void HandleValueMessage(dmMessage::Message *message_object, void *user_ptr)
+{
+    std::vector<uint32_t>* values = (std::vector<uint32_t>*) user_ptr;
+    values->push_back(*(uint32_t*) message_object->m_Data);
+}
+
+static void PostValueThread(void* arg)
+{
+    dmMessage::URL* receiver = (dmMessage::URL*) arg;
+    uint32_t value = 1;
+    dmMessage::Post(0x0, receiver, m_HashMessage1, 0, 0x0, &value, sizeof(value), 0);
+}
+
+// Messages posted by the thread that created the socket are dispatched in order with messages from other threads
+TEST(dmMessage, OwnerThreadOrder)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    for (uint32_t iter = 0; iter < 4; ++iter)
+    {
+        uint32_t value = 0;
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, &value, sizeof(value), 0));
+        dmThread::Thread t = dmThread::New(&PostValueThread, 0xf0000, (void*) &receiver, "post");
+        dmThread::Join(t);
+        value = 2;
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, &value, sizeof(value), 0));
+
+        std::vector<uint32_t> values;
+        ASSERT_EQ(3u, dmMessage::Dispatch(receiver.m_Socket, HandleValueMessage, &values));
+        ASSERT_EQ(3u, values.size());
+        for (uint32_t i = 0; i < values.size(); ++i)
+        {
+            ASSERT_EQ(i, values[i]);
+        }
+    }
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
+static void DispatchBlockingThread(void* arg)
+{
+    dmMessage::URL* receiver = (dmMessage::URL*) arg;
+    uint32_t count = 0;
+    while (count < 1024 * 16)
+    {
+        count += dmMessage::DispatchBlocking(receiver->m_Socket, HandleMessage, 0);
+    }
+}
+
+// A thread blocking on a socket is woken by messages posted by the thread that created the socket
+TEST(dmMessage, OwnerThreadDispatchBlocking)
+{
+    dmMessage::URL receiver;
+    dmMessage::ResetURL(receiver);
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::NewSocket("my_socket", &receiver.m_Socket));
+
+    dmThread::Thread t = dmThread::New(&DispatchBlockingThread, 0xf0000, (void*) &receiver, "dispatch");
+    for (uint32_t i = 0; i < 1024 * 16; ++i)
+    {
+        ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::Post(0x0, &receiver, m_HashMessage1, 0, 0x0, &i, sizeof(i), 0));
+        if (i % 1024 == 0)
+        {
+            dmTime::Sleep(1000);
+        }
+    }
+    dmThread::Join(t);
+    ASSERT_FALSE(dmMessage::HasMessages(receiver.m_Socket));
+
+    ASSERT_EQ(dmMessage::RESULT_OK, dmMessage::DeleteSocket(receiver.m_Socket));
+}
+
+TEST(dmMessage, BenchContention)
+{
+    const uint32_t message_count = 1024 * 256;
+    printf("Post/dispatch %u messages under contention\n", message_count);
+    for (uint32_t thread_count = 1; thread_count <= 4; thread_count *= 2)
+    {
+        OrderContext order;
+        uint64_t post = PostOrderTest(thread_count, message_count / thread_count, 1, &order);
+        ASSERT_EQ(0u, order.m_Errors);
+        uint64_t post_many = PostOrderTest(thread_count, message_count / thread_count, 16, &order);
+        ASSERT_EQ(0u, order.m_Errors);
+        printf("  %u posting thread(s): Post %f ms, PostMany (16) %f ms\n", thread_count, post / 1000.0f, post_many / 1000.0f);
+    }
+}
+
+
 int main(int argc, char **argv)
 {
     dmProfile::Initialize(1024, 1024 * 1024, 64);
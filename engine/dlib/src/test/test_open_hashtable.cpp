@@ -0,0 +1,311 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+
+#include "dlib/hashtable.h"
+#include "dlib/open_hashtable.h"
+#include "dlib/time.h"
+
+TEST(dmOpenHashTable, EmptyConstructor)
+{
+    dmOpenHashTable<uint32_t, int> ht;
+
+    EXPECT_EQ(0U, ht.Size());
+    EXPECT_EQ(0U, ht.Capacity());
+    EXPECT_TRUE(ht.Empty());
+    EXPECT_EQ((void*) 0, ht.Get(10));
+    ht.Verify();
+}
+
+TEST(dmOpenHashTable, PutGet)
+{
+    dmOpenHashTable<uint64_t, uint32_t> ht;
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        ht.Put(i, i * 10);
+    }
+    ht.Verify();
+    ASSERT_EQ(1000U, ht.Size());
+    ASSERT_GE(ht.Capacity(), 1000U);
+
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        ASSERT_NE((void*) 0, ht.Get(i));
+        ASSERT_EQ(i * 10, *ht.Get(i));
+    }
+    ASSERT_EQ((void*) 0, ht.Get(1000));
+
+    // Overwrite
+    ht.Put(17, 4711);
+    ASSERT_EQ(1000U, ht.Size());
+    ASSERT_EQ(4711U, *ht.Get(17));
+
+    const dmOpenHashTable<uint64_t, uint32_t>& cht = ht;
+    ASSERT_EQ(4711U, *cht.Get(17));
+}
+
+TEST(dmOpenHashTable, SetCapacity)
+{
+    dmOpenHashTable<uint32_t, uint32_t> ht;
+    ht.SetCapacity(100);
+    uint32_t capacity = ht.Capacity();
+    ASSERT_GE(capacity, 100U);
+
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+        ht.Put(i, i);
+    }
+    // No rehash while within capacity
+    ASSERT_EQ(capacity, ht.Capacity());
+
+    // Smaller capacity is ignored
+    ht.SetCapacity(10);
+    ASSERT_EQ(capacity, ht.Capacity());
+
+    ht.Put(capacity, capacity);
+    ASSERT_GT(ht.Capacity(), capacity);
+    ht.Verify();
+    for (uint32_t i = 0; i <= capacity; ++i)
+    {
+        ASSERT_EQ(i, *ht.Get(i));
+    }
+}
+
+TEST(dmOpenHashTable, ClearSwap)
+{
+    dmOpenHashTable<uint32_t, uint32_t> a;
+    dmOpenHashTable<uint32_t, uint32_t> b;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        a.Put(i, i + 1);
+    }
+    a.Swap(b);
+    ASSERT_EQ(0U, a.Size());
+    ASSERT_EQ(100U, b.Size());
+    ASSERT_EQ(51U, *b.Get(50));
+
+    uint32_t capacity = b.Capacity();
+    b.Clear();
+    b.Verify();
+    ASSERT_TRUE(b.Empty());
+    ASSERT_EQ(capacity, b.Capacity());
+    ASSERT_EQ((void*) 0, b.Get(50));
+    b.Put(50, 1);
+    ASSERT_EQ(1U, *b.Get(50));
+}
+
+// Keep the table at a constant size while cycling keys, which leaves tombstones behind.
+// The table must clean them up by rehashing instead of growing forever.
+TEST(dmOpenHashTable, Tombstones)
+{
+    dmOpenHashTable<uint64_t, uint64_t> ht;
+    const uint32_t n = 200;
+    for (uint64_t i = 0; i < n; ++i)
+    {
+        ht.Put(i, i);
+    }
+    uint32_t capacity = ht.Capacity();
+
+    for (uint64_t i = n; i < 100000; ++i)
+    {
+        ht.Erase(i - n);
+        ht.Put(i, i);
+        ASSERT_EQ(n, ht.Size());
+    }
+    ht.Verify();
+    ASSERT_EQ(capacity, ht.Capacity());
+
+    for (uint64_t i = 100000 - n; i < 100000; ++i)
+    {
+        ASSERT_EQ(i, *ht.Get(i));
+    }
+    ASSERT_EQ((void*) 0, ht.Get(100000 - n - 1));
+}
+
+TEST(dmOpenHashTable, Exhaustive)
+{
+    for (int iter = 0; iter < 50; ++iter)
+    {
+        std::map<uint64_t, uint32_t> map;
+        dmOpenHashTable<uint64_t, uint32_t> ht;
+
+        uint32_t max_size = 1 + rand() % 300;
+        for (int op = 0; op < 2000; ++op)
+        {
+            if (map.size() < max_size && (rand() & 1))
+            {
+                uint64_t key = rand() & 0x3ff;
+                uint32_t val = rand();
+                map[key] = val;
+                ht.Put(key, val);
+            }
+            else if (!map.empty())
+            {
+                std::map<uint64_t, uint32_t>::iterator it = map.lower_bound(rand() & 0x3ff);
+                if (it == map.end())
+                    it = map.begin();
+                ht.Erase(it->first);
+                map.erase(it);
+            }
+            ASSERT_EQ(map.size(), ht.Size());
+        }
+        ht.Verify();
+
+        for (uint64_t key = 0; key < 0x400; ++key)
+        {
+            std::map<uint64_t, uint32_t>::iterator it = map.find(key);
+            if (it == map.end())
+            {
+                ASSERT_EQ((void*) 0, ht.Get(key));
+            }
+            else
+            {
+                ASSERT_NE((void*) 0, ht.Get(key));
+                ASSERT_EQ(it->second, *ht.Get(key));
+            }
+        }
+    }
+}
+
+static void IterateCallback(uint64_t* context, const uint32_t* key, uint32_t* value)
+{
+    context[0] += *key;
+    context[1] += *value;
+    context[2]++;
+}
+
+TEST(dmOpenHashTable, Iterate)
+{
+    dmOpenHashTable<uint32_t, uint32_t> ht;
+    uint64_t expected_keys = 0;
+    uint64_t expected_values = 0;
+    for (uint32_t i = 0; i < 500; ++i)
+    {
+        ht.Put(i * 3, i * 7);
+    }
+    for (uint32_t i = 0; i < 500; i += 2)
+    {
+        ht.Erase(i * 3);
+    }
+    for (uint32_t i = 1; i < 500; i += 2)
+    {
+        expected_keys += i * 3;
+        expected_values += i * 7;
+    }
+
+    uint64_t context[3] = { 0, 0, 0 };
+    ht.Iterate(IterateCallback, context);
+    ASSERT_EQ(expected_keys, context[0]);
+    ASSERT_EQ(expected_values, context[1]);
+    ASSERT_EQ(250U, context[2]);
+}
+
+static uint64_t NextKey(uint64_t* state)
+{
+    // xorshift64*, gives keys that look like dmHashString64 hashes
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+template <typename TABLE>
+static void BenchTable(const char* name, TABLE& ht, uint32_t n, const uint64_t* keys, const uint64_t* missing_keys)
+{
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ht.Put(keys[i], i);
+    }
+    uint64_t put_time = dmTime::GetTime() - start;
+
+    uint64_t sum = 0;
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        sum += *ht.Get(keys[i]);
+    }
+    uint64_t get_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        sum += ht.Get(missing_keys[i]) != 0;
+    }
+    uint64_t miss_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ht.Erase(keys[i]);
+    }
+    uint64_t erase_time = dmTime::GetTime() - start;
+
+    ASSERT_EQ((uint64_t)n * (n - 1) / 2, sum);
+    ASSERT_EQ(0U, ht.Size());
+
+    printf("%-24s %8u: put %6.1f ns  get %6.1f ns  miss %6.1f ns  erase %6.1f ns\n", name, n,
+           put_time * 1000.0 / n, get_time * 1000.0 / n, miss_time * 1000.0 / n, erase_time * 1000.0 / n);
+}
+
+TEST(dmOpenHashTable, Bench)
+{
+    printf("\n");
+    const uint32_t sizes[] = { 10000, 100000, 1000000 };
+    for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+    {
+        uint32_t n = sizes[s];
+        uint64_t* keys = (uint64_t*) malloc(sizeof(uint64_t) * n);
+        uint64_t* missing_keys = (uint64_t*) malloc(sizeof(uint64_t) * n);
+        uint64_t state = 0x12345678 + s;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            keys[i] = NextKey(&state);
+            missing_keys[i] = NextKey(&state); // a collision with "keys" is practically impossible
+        }
+
+        {
+            dmHashTable64<uint32_t> ht;
+            ht.SetCapacity(n / 2, n);
+            BenchTable("dmHashTable64", ht, n, keys, missing_keys);
+        }
+        {
+            dmOpenHashTable<uint64_t, uint32_t> ht;
+            BenchTable("dmOpenHashTable (grow)", ht, n, keys, missing_keys);
+        }
+        {
+            dmOpenHashTable<uint64_t, uint32_t> ht;
+            ht.SetCapacity(n);
+            BenchTable("dmOpenHashTable", ht, n, keys, missing_keys);
+        }
+
+        free(keys);
+        free(missing_keys);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -388,6 +388,230 @@ TEST(dmProfile, ThreadProfile)
     dmProfile::Finalize();
 }
 
+// Samples are reserved in blocks per thread. Make sure a partially used block isn't reused in the next frame
+TEST(dmProfile, SampleBlocks)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    for (uint32_t frame = 0; frame < 8; ++frame)
+    {
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::Release(profile);
+
+        uint32_t count = 10 + frame * 20;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            DM_PROFILE(X, "a")
+        }
+
+        std::vector<dmProfile::Sample> samples;
+        std::map<std::string, const dmProfile::ScopeData*> scopes;
+        profile = dmProfile::Begin();
+        dmProfile::IterateSamples(profile, &samples, true, &ProfileSampleCallback);
+        dmProfile::IterateScopeData(profile, &scopes, false, &ProfileScopeCallback);
+        dmProfile::Release(profile);
+
+        ASSERT_EQ(count, (uint32_t) samples.size());
+        ASSERT_EQ(count, scopes["X"]->m_Count);
+    }
+
+    dmProfile::Finalize();
+}
+
+// The per thread sample state is kept over Finalize, make sure threads that recorded samples before can record again
+TEST(dmProfile, SampleAfterReinitialize)
+{
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        dmProfile::Initialize(128, 1024 * 1024, 16);
+
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::Release(profile);
+
+        dmThread::Thread t = dmThread::New(ProfileThread, 0xf0000, 0, "p1");
+        ProfileThread(0);
+        dmThread::Join(t);
+
+        std::vector<dmProfile::Sample> samples;
+        profile = dmProfile::Begin();
+        dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+        dmProfile::Release(profile);
+
+        ASSERT_EQ(20000U * 2U, samples.size());
+
+        dmProfile::Finalize();
+    }
+}
+
+void ProfileBenchThread(void* arg)
+{
+    uint32_t count = *(uint32_t*) arg;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        DM_PROFILE(X, "bench")
+    }
+}
+
+// Cost of recording a scope, with one or more threads recording at the same time
+TEST(dmProfile, BenchOverhead)
+{
+    uint32_t count = 100000;
+    dmProfile::Initialize(128, 4 * count + 1024, 16);
+
+    printf("Time per profile scope\n");
+    for (uint32_t thread_count = 1; thread_count <= 4; thread_count *= 2)
+    {
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::Release(profile);
+
+        dmThread::Thread threads[4];
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            threads[i] = dmThread::New(ProfileBenchThread, 0xf0000, &count, "bench");
+        }
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            dmThread::Join(threads[i]);
+        }
+        uint64_t elapsed = dmTime::GetTime() - start;
+
+        std::vector<dmProfile::Sample> samples;
+        profile = dmProfile::Begin();
+        dmProfile::IterateSamples(profile, &samples, false, &ProfileSampleCallback);
+        dmProfile::Release(profile);
+        ASSERT_EQ(thread_count * count, (uint32_t) samples.size());
+
+        // Wall time per recorded scope, i.e. the throughput of all threads
+        printf("  %u thread(s): %f ns\n", thread_count, (elapsed * 1000.0f) / (thread_count * count));
+    }
+
+    dmProfile::Finalize();
+}
+
+static bool TraceWriteString(void* context, const void* data, uint32_t size)
+{
+    std::string* trace = (std::string*) context;
+    trace->append((const char*) data, size);
+    return true;
+}
+
+static bool TraceWriteFail(void* context, const void* data, uint32_t size)
+{
+    return false;
+}
+
+TEST(dmProfile, TraceExport)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    std::string trace;
+    dmProfile::HTraceWriter writer = dmProfile::NewTraceWriter(TraceWriteString, &trace);
+    for (int i = 0; i < 2; ++i)
+    {
+        dmProfile::HProfile profile = dmProfile::Begin();
+        dmProfile::Release(profile);
+        {
+            DM_PROFILE(A, "a");
+            { DM_PROFILE(B, "b\"quoted\""); }
+            DM_COUNTER("c1", 5);
+        }
+        profile = dmProfile::Begin();
+        dmProfile::WriteTraceFrame(writer, profile);
+        dmProfile::Release(profile);
+    }
+    ASSERT_TRUE(dmProfile::DeleteTraceWriter(writer));
+
+    ASSERT_EQ(0u, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    ASSERT_EQ(trace.size() - 4, trace.rfind("\n]}\n"));
+
+    // Two frames with two samples and one counter each
+    uint32_t complete_events = 0;
+    uint32_t counter_events = 0;
+    for (size_t pos = trace.find("\"ph\":\"X\""); pos != std::string::npos; pos = trace.find("\"ph\":\"X\"", pos + 1))
+        ++complete_events;
+    for (size_t pos = trace.find("\"ph\":\"C\""); pos != std::string::npos; pos = trace.find("\"ph\":\"C\"", pos + 1))
+        ++counter_events;
+    ASSERT_EQ(4u, complete_events);
+    ASSERT_EQ(2u, counter_events);
+
+    ASSERT_NE(std::string::npos, trace.find("{\"name\":\"a\",\"cat\":\"A\",\"ph\":\"X\",\"ts\":"));
+    ASSERT_NE(std::string::npos, trace.find("{\"name\":\"b\\\"quoted\\\"\",\"cat\":\"B\""));
+    ASSERT_NE(std::string::npos, trace.find("{\"name\":\"c1\",\"ph\":\"C\""));
+    ASSERT_NE(std::string::npos, trace.find("\"args\":{\"value\":5}}"));
+
+    writer = dmProfile::NewTraceWriter(TraceWriteFail, 0);
+    ASSERT_FALSE(dmProfile::DeleteTraceWriter(writer));
+
+    dmProfile::Finalize();
+}
+
+static uint32_t CountTraceEvents(const std::string& trace, const char* pattern)
+{
+    uint32_t count = 0;
+    for (size_t pos = trace.find(pattern); pos != std::string::npos; pos = trace.find(pattern, pos + 1))
+        ++count;
+    return count;
+}
+
+TEST(dmProfile, TraceHistory)
+{
+    dmProfile::Initialize(128, 1024, 16);
+
+    // Room for three frames, or five samples
+    dmProfile::HTraceHistory history = dmProfile::NewTraceHistory(3, 5);
+
+    dmProfile::HProfile profile = dmProfile::Begin();
+    dmProfile::Release(profile);
+    for (int i = 0; i < 4; ++i)
+    {
+        {
+            DM_PROFILE(A, "a");
+            DM_COUNTER("c1", 1);
+        }
+        profile = dmProfile::Begin();
+        dmProfile::AddTraceFrame(history, profile);
+        dmProfile::Release(profile);
+    }
+    ASSERT_EQ(3u, dmProfile::GetTraceFrameCount(history));
+
+    std::string trace;
+    dmProfile::HTraceWriter writer = dmProfile::NewTraceWriter(TraceWriteString, &trace);
+    ASSERT_EQ(2u, dmProfile::WriteTraceHistory(writer, history, 1, 2));
+    ASSERT_TRUE(dmProfile::DeleteTraceWriter(writer));
+    ASSERT_EQ(2u, CountTraceEvents(trace, "\"ph\":\"X\""));
+    ASSERT_EQ(2u, CountTraceEvents(trace, "\"ph\":\"C\""));
+
+    // Clamped to the frames in the history
+    trace.clear();
+    writer = dmProfile::NewTraceWriter(TraceWriteString, &trace);
+    ASSERT_EQ(3u, dmProfile::WriteTraceHistory(writer, history, 0, 100));
+    ASSERT_EQ(0u, dmProfile::WriteTraceHistory(writer, history, 3, 1));
+    ASSERT_TRUE(dmProfile::DeleteTraceWriter(writer));
+    ASSERT_EQ(3u, CountTraceEvents(trace, "\"ph\":\"X\""));
+
+    // A frame with four samples drops the older frames to stay within the sample budget
+    {
+        DM_PROFILE(A, "a");
+        DM_PROFILE(A, "b");
+        DM_PROFILE(A, "c");
+        DM_PROFILE(A, "d");
+    }
+    profile = dmProfile::Begin();
+    dmProfile::AddTraceFrame(history, profile);
+    dmProfile::Release(profile);
+    ASSERT_EQ(2u, dmProfile::GetTraceFrameCount(history));
+
+    trace.clear();
+    writer = dmProfile::NewTraceWriter(TraceWriteString, &trace);
+    ASSERT_EQ(2u, dmProfile::WriteTraceHistory(writer, history, 0, 3));
+    ASSERT_TRUE(dmProfile::DeleteTraceWriter(writer));
+    ASSERT_EQ(5u, CountTraceEvents(trace, "\"ph\":\"X\""));
+
+    dmProfile::DeleteTraceHistory(history);
+    dmProfile::Finalize();
+}
+
 TEST(dmProfile, DynamicScope)
 {
     const char* FUNCTION_NAMES[] = {
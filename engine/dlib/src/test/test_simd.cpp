@@ -0,0 +1,95 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "../dlib/simd.h"
+
+static void AssertVector(dmSIMD::Vector4f v, float x, float y, float z, float w)
+{
+    float r[4];
+    dmSIMD::Store(r, v);
+    ASSERT_EQ(x, r[0]);
+    ASSERT_EQ(y, r[1]);
+    ASSERT_EQ(z, r[2]);
+    ASSERT_EQ(w, r[3]);
+}
+
+TEST(dmSIMD, LoadStore)
+{
+    float data[] = {1.0f, 2.0f, 3.0f, 4.0f, 5.0f};
+    AssertVector(dmSIMD::Load(data), 1.0f, 2.0f, 3.0f, 4.0f);
+    // Unaligned
+    AssertVector(dmSIMD::Load(data + 1), 2.0f, 3.0f, 4.0f, 5.0f);
+    AssertVector(dmSIMD::Set(1.0f, 2.0f, 3.0f, 4.0f), 1.0f, 2.0f, 3.0f, 4.0f);
+    AssertVector(dmSIMD::Splat(7.0f), 7.0f, 7.0f, 7.0f, 7.0f);
+}
+
+TEST(dmSIMD, Arithmetic)
+{
+    dmSIMD::Vector4f a = dmSIMD::Set(1.0f, 2.0f, 3.0f, 4.0f);
+    dmSIMD::Vector4f b = dmSIMD::Set(4.0f, 3.0f, 2.0f, 1.0f);
+    AssertVector(dmSIMD::Add(a, b), 5.0f, 5.0f, 5.0f, 5.0f);
+    AssertVector(dmSIMD::Sub(a, b), -3.0f, -1.0f, 1.0f, 3.0f);
+    AssertVector(dmSIMD::Neg(a), -1.0f, -2.0f, -3.0f, -4.0f);
+    AssertVector(dmSIMD::Mul(a, b), 4.0f, 6.0f, 6.0f, 4.0f);
+    AssertVector(dmSIMD::MulAdd(a, b, a), 5.0f, 8.0f, 9.0f, 8.0f);
+    AssertVector(dmSIMD::Min(a, b), 1.0f, 2.0f, 2.0f, 1.0f);
+    AssertVector(dmSIMD::Max(a, b), 4.0f, 3.0f, 3.0f, 4.0f);
+    AssertVector(dmSIMD::Div(a, b), 0.25f, 2.0f / 3.0f, 1.5f, 4.0f);
+    AssertVector(dmSIMD::Sqrt(dmSIMD::Set(1.0f, 4.0f, 9.0f, 2.0f)), 1.0f, 2.0f, 3.0f, sqrtf(2.0f));
+}
+
+TEST(dmSIMD, Select)
+{
+    dmSIMD::Vector4f x = dmSIMD::Set(-1.0f, 0.0f, 1.0f, -0.5f);
+    dmSIMD::Vector4f a = dmSIMD::Set(1.0f, 2.0f, 3.0f, 4.0f);
+    dmSIMD::Vector4f b = dmSIMD::Set(5.0f, 6.0f, 7.0f, 8.0f);
+    AssertVector(dmSIMD::Select(x, a, b), 5.0f, 2.0f, 3.0f, 8.0f);
+}
+
+TEST(dmSIMD, Splat)
+{
+    dmSIMD::Vector4f a = dmSIMD::Set(1.0f, 2.0f, 3.0f, 4.0f);
+    AssertVector(dmSIMD::SplatX(a), 1.0f, 1.0f, 1.0f, 1.0f);
+    AssertVector(dmSIMD::SplatY(a), 2.0f, 2.0f, 2.0f, 2.0f);
+    AssertVector(dmSIMD::SplatZ(a), 3.0f, 3.0f, 3.0f, 3.0f);
+    AssertVector(dmSIMD::SplatW(a), 4.0f, 4.0f, 4.0f, 4.0f);
+}
+
+TEST(dmSIMD, Transpose)
+{
+    dmSIMD::Vector4f a = dmSIMD::Set(0.0f, 1.0f, 2.0f, 3.0f);
+    dmSIMD::Vector4f b = dmSIMD::Set(4.0f, 5.0f, 6.0f, 7.0f);
+    dmSIMD::Vector4f c = dmSIMD::Set(8.0f, 9.0f, 10.0f, 11.0f);
+    dmSIMD::Vector4f d = dmSIMD::Set(12.0f, 13.0f, 14.0f, 15.0f);
+    dmSIMD::Transpose(a, b, c, d);
+    AssertVector(a, 0.0f, 4.0f, 8.0f, 12.0f);
+    AssertVector(b, 1.0f, 5.0f, 9.0f, 13.0f);
+    AssertVector(c, 2.0f, 6.0f, 10.0f, 14.0f);
+    AssertVector(d, 3.0f, 7.0f, 11.0f, 15.0f);
+}
+
+TEST(dmSIMD, Interleave)
+{
+    dmSIMD::Vector4f a = dmSIMD::Set(0.0f, 1.0f, 2.0f, 3.0f);
+    dmSIMD::Vector4f b = dmSIMD::Set(4.0f, 5.0f, 6.0f, 7.0f);
+    AssertVector(dmSIMD::InterleaveLo(a, b), 0.0f, 4.0f, 1.0f, 5.0f);
+    AssertVector(dmSIMD::InterleaveHi(a, b), 2.0f, 6.0f, 3.0f, 7.0f);
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
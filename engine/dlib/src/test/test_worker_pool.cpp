@@ -0,0 +1,173 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include "../dlib/array.h"
+#include "../dlib/atomic.h"
+#include "../dlib/thread.h"
+#include "../dlib/worker_pool.h"
+
+struct RangeContext
+{
+    dmArray<uint32_t> m_Values;
+    int32_atomic_t    m_CallCount;
+};
+
+static void IncrementRange(void* _ctx, uint32_t begin, uint32_t end)
+{
+    RangeContext* ctx = (RangeContext*) _ctx;
+    dmAtomicIncrement32(&ctx->m_CallCount);
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        ctx->m_Values[i]++;
+    }
+}
+
+static void SetupContext(RangeContext* ctx, uint32_t count)
+{
+    ctx->m_Values.SetCapacity(count);
+    ctx->m_Values.SetSize(count);
+    memset(ctx->m_Values.Begin(), 0, sizeof(uint32_t) * count);
+    ctx->m_CallCount = 0;
+}
+
+static void VerifyContext(RangeContext* ctx, uint32_t expected)
+{
+    for (uint32_t i = 0; i < ctx->m_Values.Size(); ++i)
+    {
+        ASSERT_EQ(expected, ctx->m_Values[i]);
+    }
+}
+
+TEST(dmWorkerPool, NoPool)
+{
+    RangeContext ctx;
+    SetupContext(&ctx, 1000);
+    dmWorkerPool::ParallelFor(0, 1000, 16, IncrementRange, &ctx);
+    VerifyContext(&ctx, 1);
+    ASSERT_EQ(1, ctx.m_CallCount);
+    ASSERT_EQ(0u, dmWorkerPool::GetWorkerCount(0));
+}
+
+TEST(dmWorkerPool, Empty)
+{
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(2, "test_worker");
+    RangeContext ctx;
+    SetupContext(&ctx, 0);
+    dmWorkerPool::ParallelFor(pool, 0, 16, IncrementRange, &ctx);
+    ASSERT_EQ(0, ctx.m_CallCount);
+    dmWorkerPool::Delete(pool);
+}
+
+TEST(dmWorkerPool, SingleBatch)
+{
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(2, "test_worker");
+    RangeContext ctx;
+    SetupContext(&ctx, 10);
+    dmWorkerPool::ParallelFor(pool, 10, 16, IncrementRange, &ctx);
+    VerifyContext(&ctx, 1);
+    ASSERT_EQ(1, ctx.m_CallCount);
+    dmWorkerPool::Delete(pool);
+}
+
+TEST(dmWorkerPool, ParallelFor)
+{
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(4, "test_worker");
+    ASSERT_EQ(4u, dmWorkerPool::GetWorkerCount(pool));
+
+    const uint32_t count = 10007;
+    const uint32_t batch_size = 64;
+    RangeContext ctx;
+    SetupContext(&ctx, count);
+    const uint32_t iterations = 200;
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        dmWorkerPool::ParallelFor(pool, count, batch_size, IncrementRange, &ctx);
+    }
+    VerifyContext(&ctx, iterations);
+    ASSERT_EQ((int32_t) (iterations * ((count + batch_size - 1) / batch_size)), ctx.m_CallCount);
+    dmWorkerPool::Delete(pool);
+}
+
+struct NestedContext
+{
+    dmWorkerPool::HWorkerPool m_Pool;
+    RangeContext              m_Inner[8];
+};
+
+static void NestedRange(void* _ctx, uint32_t begin, uint32_t end)
+{
+    NestedContext* ctx = (NestedContext*) _ctx;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        // The pool is busy, so this is executed on the calling thread
+        dmWorkerPool::ParallelFor(ctx->m_Pool, ctx->m_Inner[i].m_Values.Size(), 8, IncrementRange, &ctx->m_Inner[i]);
+    }
+}
+
+TEST(dmWorkerPool, Nested)
+{
+    NestedContext ctx;
+    ctx.m_Pool = dmWorkerPool::New(3, "test_worker");
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        SetupContext(&ctx.m_Inner[i], 100);
+    }
+    dmWorkerPool::ParallelFor(ctx.m_Pool, 8, 1, NestedRange, &ctx);
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        VerifyContext(&ctx.m_Inner[i], 1);
+    }
+    dmWorkerPool::Delete(ctx.m_Pool);
+}
+
+struct ThreadContext
+{
+    dmWorkerPool::HWorkerPool m_Pool;
+    RangeContext              m_Range;
+};
+
+static void SubmitThread(void* _ctx)
+{
+    ThreadContext* ctx = (ThreadContext*) _ctx;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        dmWorkerPool::ParallelFor(ctx->m_Pool, ctx->m_Range.m_Values.Size(), 32, IncrementRange, &ctx->m_Range);
+    }
+}
+
+TEST(dmWorkerPool, ConcurrentSubmit)
+{
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(2, "test_worker");
+    ThreadContext ctx[2];
+    dmThread::Thread threads[2];
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        ctx[i].m_Pool = pool;
+        SetupContext(&ctx[i].m_Range, 1000);
+        threads[i] = dmThread::New(SubmitThread, 0x80000, &ctx[i], "test_submit");
+    }
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        dmThread::Join(threads[i]);
+        VerifyContext(&ctx[i].m_Range, 100);
+    }
+    dmWorkerPool::Delete(pool);
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
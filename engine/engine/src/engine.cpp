@@ -204,6 +204,8 @@ namespace dmEngine
     Engine::Engine(dmEngineService::HEngineService engine_service)
     : m_Config(0)
     , m_Alive(true)
+    , m_WorkerPool(0)
+    , m_TextureDecodePool(0)
     , m_MainCollection(0)
     , m_LastReloadMTime(0)
     , m_MouseSensitivity(1.0f)
@@ -250,6 +252,61 @@ namespace dmEngine
         m_MeshContext.m_MaxMeshCount = 0;
     }
 
+    static bool TraceFileWrite(void* context, const void* data, uint32_t size)
+    {
+        return fwrite(data, 1, size, (FILE*) context) == size;
+    }
+
+    static void StartTrace(HEngine engine, const char* path, uint32_t first_frame, uint32_t frame_count)
+    {
+        TraceData* trace_data = &engine->m_TraceData;
+        trace_data->m_File = fopen(path, "wb");
+        if (!trace_data->m_File)
+        {
+            dmLogError("Failed to open profile trace file '%s'", path);
+            return;
+        }
+        trace_data->m_Writer = dmProfile::NewTraceWriter(TraceFileWrite, trace_data->m_File);
+        trace_data->m_FirstFrame = first_frame;
+        trace_data->m_EndFrame = first_frame + frame_count;
+        dmLogInfo("Writing profile trace of frames %u to %u to '%s'", first_frame, trace_data->m_EndFrame - 1, path);
+    }
+
+    static void StopTrace(HEngine engine)
+    {
+        TraceData* trace_data = &engine->m_TraceData;
+        if (!trace_data->m_Writer)
+            return;
+
+        bool ok = dmProfile::DeleteTraceWriter(trace_data->m_Writer);
+        ok = fclose(trace_data->m_File) == 0 && ok;
+        if (!ok)
+        {
+            dmLogError("Failed to write the profile trace");
+        }
+        trace_data->m_Writer = 0;
+        trace_data->m_File = 0;
+    }
+
+    // The profile returned by dmProfile::Begin() holds the frame before the current one
+    static void UpdateTrace(HEngine engine, dmProfile::HProfile profile)
+    {
+        TraceData* trace_data = &engine->m_TraceData;
+        if (!trace_data->m_Writer)
+            return;
+
+        uint32_t frame = engine->m_Stats.m_FrameCount;
+        if (frame >= trace_data->m_FirstFrame)
+        {
+            DM_PROFILE(Engine, "Trace");
+            dmProfile::WriteTraceFrame(trace_data->m_Writer, profile);
+        }
+        if (frame + 1 >= trace_data->m_EndFrame)
+        {
+            StopTrace(engine);
+        }
+    }
+
     HEngine New(dmEngineService::HEngineService engine_service)
     {
         return new Engine(engine_service);
@@ -263,6 +320,8 @@ namespace dmEngine
 
         dmHttpClient::ShutdownConnectionPool();
 
+        StopTrace(engine);
+
         dmLiveUpdate::Finalize();
 
         dmGameSystem::ScriptLibContext script_lib_context;
@@ -284,6 +343,8 @@ namespace dmEngine
         dmHttpClient::ReopenConnectionPool();
 
         dmGameObject::DeleteRegister(engine->m_Register);
+        dmWorkerPool::Delete(engine->m_WorkerPool);
+        dmWorkerPool::Delete(engine->m_TextureDecodePool);
 
         UnloadBootstrapContent(engine);
 
@@ -689,6 +750,10 @@ namespace dmEngine
         dmResource::NewFactoryParams params;
         int32_t http_cache = dmConfigFile::GetInt(engine->m_Config, "resource.http_cache", 1);
         params.m_MaxResources = max_resources;
+        params.m_LoaderThreadCount = dmConfigFile::GetInt(engine->m_Config, dmResource::LOADER_THREADS_KEY, 1);
+        params.m_LoaderQueueSlots = dmConfigFile::GetInt(engine->m_Config, dmResource::LOADER_QUEUE_SLOTS_KEY, 16);
+        params.m_LoaderMaxPendingData = dmConfigFile::GetInt(engine->m_Config, dmResource::LOADER_MAX_PENDING_KB_KEY, 4096) * 1024;
+        params.m_PreloaderMaxRequests = dmConfigFile::GetInt(engine->m_Config, dmResource::PRELOADER_MAX_REQUESTS_KEY, 8192);
         params.m_Flags = 0;
         if (dLib::IsDebugMode())
         {
@@ -782,6 +847,7 @@ namespace dmEngine
             dmLogInfo("Initialised sound device '%s'\n", sound_params.m_OutputDevice);
         }
 
+        dmGameObject::SetCollectionWideIndices(engine->m_Register, dmConfigFile::GetInt(engine->m_Config, dmGameObject::COLLECTION_WIDE_INDICES_KEY, 0) != 0);
         dmGameObject::Result go_result = dmGameObject::SetCollectionDefaultCapacity(engine->m_Register, dmConfigFile::GetInt(engine->m_Config, dmGameObject::COLLECTION_MAX_INSTANCES_KEY, dmGameObject::DEFAULT_MAX_COLLECTION_CAPACITY));
         if(go_result != dmGameObject::RESULT_OK)
         {
@@ -790,6 +856,31 @@ namespace dmEngine
         }
         dmGameObject::SetInputStackDefaultCapacity(engine->m_Register, dmConfigFile::GetInt(engine->m_Config, dmGameObject::COLLECTION_MAX_INPUT_STACK_ENTRIES_KEY, dmGameObject::DEFAULT_MAX_INPUT_STACK_CAPACITY));
 
+        int32_t worker_thread_count = dmConfigFile::GetInt(engine->m_Config, "engine.worker_thread_count", 0);
+        if (worker_thread_count > 0)
+        {
+            engine->m_WorkerPool = dmWorkerPool::New((uint32_t) worker_thread_count, "worker");
+        }
+        dmGameObject::SetWorkerPool(engine->m_Register, engine->m_WorkerPool);
+
+        // Separate from the shared worker pool, since the texture decoding runs on the resource loader thread
+        // and would otherwise compete with (and serialise) the main thread's parallel work
+        int32_t texture_decode_thread_count = dmConfigFile::GetInt(engine->m_Config, "engine.texture_decode_thread_count", 0);
+        if (texture_decode_thread_count > 0)
+        {
+            engine->m_TextureDecodePool = dmWorkerPool::New((uint32_t) texture_decode_thread_count, "texdecode");
+        }
+
+        const char* trace_file = dmConfigFile::GetString(engine->m_Config, "profiler.trace_file", 0);
+        if (trace_file && trace_file[0] != 0)
+        {
+            int32_t trace_frame_count = dmConfigFile::GetInt(engine->m_Config, "profiler.trace_frame_count", 600);
+            if (trace_frame_count > 0)
+            {
+                StartTrace(engine, trace_file, (uint32_t) dmMath::Max(0, dmConfigFile::GetInt(engine->m_Config, "profiler.trace_first_frame", 0)), (uint32_t) trace_frame_count);
+            }
+        }
+
         dmRender::RenderContextParams render_params;
         render_params.m_MaxRenderTypes = 16;
         render_params.m_MaxInstances = (uint32_t) dmConfigFile::GetInt(engine->m_Config, "graphics.max_draw_calls", 1024);
@@ -810,6 +901,7 @@ namespace dmEngine
         engine->m_ParticleFXContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ParticleFXContext.m_MaxParticleFXCount = dmConfigFile::GetInt(engine->m_Config, dmParticle::MAX_INSTANCE_COUNT_KEY, 64);
         engine->m_ParticleFXContext.m_MaxParticleCount = dmConfigFile::GetInt(engine->m_Config, dmParticle::MAX_PARTICLE_COUNT_KEY, 1024);
+        engine->m_ParticleFXContext.m_WorkerPool = engine->m_WorkerPool;
         engine->m_ParticleFXContext.m_Debug = false;
 
         dmInput::NewContextParams input_params;
@@ -851,6 +943,7 @@ namespace dmEngine
         engine->m_GuiContext.m_MaxParticleFXCount = dmConfigFile::GetInt(engine->m_Config, "gui.max_particlefx_count", 64);
         engine->m_GuiContext.m_MaxParticleCount = dmConfigFile::GetInt(engine->m_Config, "gui.max_particle_count", 1024);
         engine->m_GuiContext.m_MaxSpineCount = dmConfigFile::GetInt(engine->m_Config, "gui.max_spine_count", max_spine_count);
+        engine->m_GuiContext.m_WorkerPool = engine->m_WorkerPool;
 
         dmPhysics::NewContextParams physics_params;
         physics_params.m_WorldCount = dmConfigFile::GetInt(engine->m_Config, "physics.world_count", 4);
@@ -862,6 +955,7 @@ namespace dmEngine
         physics_params.m_RayCastLimit2D = dmConfigFile::GetInt(engine->m_Config, "physics.ray_cast_limit_2d", 64);
         physics_params.m_RayCastLimit3D = dmConfigFile::GetInt(engine->m_Config, "physics.ray_cast_limit_3d", 128);
         physics_params.m_TriggerOverlapCapacity = dmConfigFile::GetInt(engine->m_Config, "physics.trigger_overlap_capacity", 16);
+        physics_params.m_WorkerPool = engine->m_WorkerPool;
         if (physics_params.m_Scale < dmPhysics::MIN_SCALE || physics_params.m_Scale > dmPhysics::MAX_SCALE)
         {
             dmLogWarning("Physics scale must be in the range %.2f - %.2f and has been clamped.", dmPhysics::MIN_SCALE, dmPhysics::MAX_SCALE);
@@ -909,11 +1003,13 @@ namespace dmEngine
 #endif
 
         engine->m_SpriteContext.m_RenderContext = engine->m_RenderContext;
+        engine->m_SpriteContext.m_WorkerPool = engine->m_WorkerPool;
         engine->m_SpriteContext.m_MaxSpriteCount = dmConfigFile::GetInt(engine->m_Config, "sprite.max_count", 128);
         engine->m_SpriteContext.m_Subpixels = dmConfigFile::GetInt(engine->m_Config, "sprite.subpixels", 1);
 
         engine->m_ModelContext.m_RenderContext = engine->m_RenderContext;
         engine->m_ModelContext.m_Factory = engine->m_Factory;
+        engine->m_ModelContext.m_WorkerPool = engine->m_WorkerPool;
         engine->m_ModelContext.m_MaxModelCount = max_model_count;
 
         engine->m_MeshContext.m_RenderContext = engine->m_RenderContext;
@@ -922,6 +1018,7 @@ namespace dmEngine
 
         engine->m_SpineModelContext.m_RenderContext = engine->m_RenderContext;
         engine->m_SpineModelContext.m_Factory = engine->m_Factory;
+        engine->m_SpineModelContext.m_WorkerPool = engine->m_WorkerPool;
         engine->m_SpineModelContext.m_MaxSpineModelCount = max_spine_count;
 
         engine->m_LabelContext.m_RenderContext      = engine->m_RenderContext;
@@ -929,11 +1026,15 @@ namespace dmEngine
         engine->m_LabelContext.m_Subpixels          = dmConfigFile::GetInt(engine->m_Config, "label.subpixels", 1);
 
         engine->m_TilemapContext.m_RenderContext    = engine->m_RenderContext;
+        engine->m_TilemapContext.m_WorkerPool       = engine->m_WorkerPool;
         engine->m_TilemapContext.m_MaxTilemapCount  = dmConfigFile::GetInt(engine->m_Config, "tilemap.max_count", 16);
         engine->m_TilemapContext.m_MaxTileCount     = dmConfigFile::GetInt(engine->m_Config, "tilemap.max_tile_count", 2048);
 
         engine->m_SoundContext.m_MaxComponentCount  = dmConfigFile::GetInt(engine->m_Config, "sound.max_component_count", 32);
 
+        engine->m_TextureContext.m_GraphicsContext  = engine->m_GraphicsContext;
+        engine->m_TextureContext.m_WorkerPool       = engine->m_TextureDecodePool;
+
         engine->m_CollectionProxyContext.m_Factory = engine->m_Factory;
         engine->m_CollectionProxyContext.m_MaxCollectionProxyCount = dmConfigFile::GetInt(engine->m_Config, dmGameSystem::COLLECTION_PROXY_MAX_COUNT_KEY, 8);
 
@@ -956,7 +1057,7 @@ namespace dmEngine
         fact_result = dmGameObject::RegisterResourceTypes(engine->m_Factory, engine->m_Register, engine->m_GOScriptContext, &engine->m_ModuleContext);
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
-        fact_result = dmGameSystem::RegisterResourceTypes(engine->m_Factory, engine->m_RenderContext, &engine->m_GuiContext, engine->m_InputContext, &engine->m_PhysicsContext);
+        fact_result = dmGameSystem::RegisterResourceTypes(engine->m_Factory, engine->m_RenderContext, &engine->m_GuiContext, engine->m_InputContext, &engine->m_PhysicsContext, &engine->m_TextureContext);
         if (fact_result != dmResource::RESULT_OK)
             goto bail;
 
@@ -1292,6 +1393,7 @@ bail:
             }
 
             dmProfile::HProfile profile = dmProfile::Begin();
+            UpdateTrace(engine, profile);
             {
                 DM_PROFILE(Engine, "Frame");
 
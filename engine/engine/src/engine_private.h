@@ -14,10 +14,13 @@
 #define DM_ENGINE_PRIVATE_H
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include <dlib/configfile.h>
 #include <dlib/hashtable.h>
 #include <dlib/message.h>
+#include <dlib/profile.h>
+#include <dlib/worker_pool.h>
 
 #include <resource/resource.h>
 
@@ -97,6 +100,20 @@ namespace dmEngine
         uint32_t            m_Fps;
     };
 
+    /// Profile frames written to a Chrome trace file (profiler.trace_file)
+    struct TraceData
+    {
+        TraceData()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+
+        dmProfile::HTraceWriter m_Writer;
+        FILE*                   m_File;
+        uint32_t                m_FirstFrame;
+        uint32_t                m_EndFrame;
+    };
+
     enum Vsync
     {
         VSYNC_SOFTWARE = 0,
@@ -117,6 +134,10 @@ namespace dmEngine
         bool                                        m_Alive;
 
         dmGameObject::HRegister                     m_Register;
+        /// Shared pool of worker threads for data parallel work, zero if disabled (engine.worker_thread_count)
+        dmWorkerPool::HWorkerPool                   m_WorkerPool;
+        /// Pool of worker threads for decoding texture mipmaps, zero if disabled (engine.texture_decode_thread_count)
+        dmWorkerPool::HWorkerPool                   m_TextureDecodePool;
         dmGameObject::HCollection                   m_MainCollection;
         dmArray<dmGameObject::InputAction>          m_InputBuffer;
 
@@ -146,6 +167,7 @@ namespace dmEngine
         dmGameSystem::LabelContext                  m_LabelContext;
         dmGameSystem::TilemapContext                m_TilemapContext;
         dmGameSystem::SoundContext                  m_SoundContext;
+        dmGameSystem::TextureContext                m_TextureContext;
         dmGameObject::ModuleContext                 m_ModuleContext;
 
         dmRender::HFontMap                          m_SystemFontMap;
@@ -176,6 +198,7 @@ namespace dmEngine
         Vsync                                       m_VsyncMode;
 
         RecordData                                  m_RecordData;
+        TraceData                                   m_TraceData;
     };
 
 
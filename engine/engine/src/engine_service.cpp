@@ -55,6 +55,10 @@ namespace dmEngineService
     "{\"version\": \"${ENGINE_VERSION}\", \"platform\": \"${ENGINE_PLATFORM}\", \"sha1\": \"${ENGINE_SHA1}\"}";
 
     static const char INTERNAL_SERVER_ERROR[] = "(500) Internal server error";
+
+    // Frames kept for /profile_trace
+    static const uint32_t TRACE_HISTORY_MAX_FRAMES = 120;
+    static const uint32_t TRACE_HISTORY_MAX_SAMPLES = 64 * 1024;
     const char* const FOURCC_RESOURCES = "RESS";
 
     struct EngineService
@@ -453,6 +457,7 @@ namespace dmEngineService
             m_WebServerRedirect = web_server_redirect;
             m_SSDP = ssdp;
             m_Profile = 0; // Set during the update
+            m_TraceHistory = dmProfile::NewTraceHistory(TRACE_HISTORY_MAX_FRAMES, TRACE_HISTORY_MAX_SAMPLES);
             return true;
         }
 
@@ -470,6 +475,8 @@ namespace dmEngineService
                 dmSSDP::DeregisterDevice(m_SSDP, "defold");
                 dmSSDP::Delete(m_SSDP);
             }
+
+            dmProfile::DeleteTraceHistory(m_TraceHistory);
         }
 
 
@@ -488,6 +495,7 @@ namespace dmEngineService
         char                 m_InfoJson[sizeof(INFO_TEMPLATE) + 512]; // 512 is rather arbitrary :-)
 
         dmProfile::HProfile  m_Profile;
+        dmProfile::HTraceHistory m_TraceHistory;
     };
 
     HEngineService New(uint16_t port)
@@ -519,6 +527,7 @@ namespace dmEngineService
     {
         DM_PROFILE(Engine, "Service");
         engine_service->m_Profile = profile;
+        dmProfile::AddTraceFrame(engine_service->m_TraceHistory, profile);
         dmWebServer::Update(engine_service->m_WebServer);
         if (engine_service->m_WebServerRedirect)
         {
@@ -848,6 +857,64 @@ namespace dmEngineService
     }
 
 
+    static bool ProfileTraceWrite(void* context, const void* data, uint32_t size)
+    {
+        return dmWebServer::Send((dmWebServer::Request*)context, data, size) == dmWebServer::RESULT_OK;
+    }
+
+    // Returns the value of an unsigned integer query parameter, e.g. "frames" in "/profile_trace?frames=60"
+    static uint32_t GetQueryParamUInt(const char* resource, const char* name, uint32_t default_value)
+    {
+        const char* query = strchr(resource, '?');
+        if (!query)
+            return default_value;
+
+        uint32_t name_length = strlen(name);
+        const char* param = query + 1;
+        while (*param)
+        {
+            unsigned int value;
+            if (strncmp(param, name, name_length) == 0 && param[name_length] == '=' && sscanf(param + name_length + 1, "%u", &value) == 1)
+                return value;
+
+            param = strchr(param, '&');
+            if (!param)
+                break;
+            ++param;
+        }
+        return default_value;
+    }
+
+    // A range of recent profile frames in the Chrome Trace Event format. See dmProfile::NewTraceWriter
+    // Query parameters:
+    //   frames: number of frames, default 1
+    //   offset: number of frames between the last frame in the range and the latest frame, default 0
+    static void HttpProfileSendTrace(void* user_ctx, dmWebServer::Request* request)
+    {
+        HEngineService engine_service = (HEngineService)user_ctx;
+        if (dmProfile::GetTraceFrameCount(engine_service->m_TraceHistory) == 0)
+        {
+            dmWebServer::SetStatusCode(request, 500);
+            const char* msg = "Error. The profiler was not active!";
+            dmWebServer::Send(request, msg, strlen(msg));
+            return;
+        }
+
+        uint32_t frame_count = GetQueryParamUInt(request->m_Resource, "frames", 1);
+        uint32_t offset = GetQueryParamUInt(request->m_Resource, "offset", 0);
+
+        dmWebServer::SendAttribute(request, "Content-Type", "application/json");
+        dmWebServer::SendAttribute(request, "Access-Control-Allow-Origin", "*");
+        dmWebServer::SendAttribute(request, "Cache-Control", "no-store");
+
+        dmProfile::HTraceWriter writer = dmProfile::NewTraceWriter(ProfileTraceWrite, request);
+        dmProfile::WriteTraceHistory(writer, engine_service->m_TraceHistory, offset, frame_count);
+        if (!dmProfile::DeleteTraceWriter(writer))
+        {
+            dmLogWarning("Unexpected http-server error when transmitting profile trace");
+        }
+    }
+
 #undef CHECK_RESULT_BOOL
 
     //
@@ -884,6 +951,11 @@ namespace dmEngineService
         frame_params.m_Userdata = engine_service;
         dmWebServer::AddHandler(engine_service->m_WebServer, "/profile_frame", &frame_params);
 
+        dmWebServer::HandlerParams trace_params;
+        trace_params.m_Handler = HttpProfileSendTrace;
+        trace_params.m_Userdata = engine_service;
+        dmWebServer::AddHandler(engine_service->m_WebServer, "/profile_trace", &trace_params);
+
         // The entry point to the engine service profiler
         dmWebServer::HandlerParams profile_params;
         profile_params.m_Handler = ProfileHandler;
@@ -20,6 +20,7 @@
 
 #include "gameobject_script.h"
 #include "gameobject_props_lua.h"
+#include "gameobject_private.h"
 
 extern "C"
 {
@@ -304,6 +305,9 @@ namespace dmGameObject
                 if (anim.m_Value != 0x0)
                 {
                     *anim.m_Value = v;
+                    // The properties of the game object itself point into its local transform
+                    if (anim.m_ComponentId == 0)
+                        SetLocalTransformDirty(anim.m_Instance);
                 }
                 else
                 {
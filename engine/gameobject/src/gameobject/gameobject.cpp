@@ -24,6 +24,7 @@
 #include <dlib/math.h>
 #include <dlib/vmath.h>
 #include <dlib/mutex.h>
+#include <dlib/simd.h>
 #include <ddf/ddf.h>
 #include "gameobject.h"
 #include "gameobject_script.h"
@@ -42,6 +43,7 @@
 namespace dmGameObject
 {
     const char* COLLECTION_MAX_INSTANCES_KEY = "collection.max_instances";
+    const char* COLLECTION_WIDE_INDICES_KEY = "collection.wide_indices";
     const char* COLLECTION_MAX_INPUT_STACK_ENTRIES_KEY = "collection.max_input_stack_entries";
     const dmhash_t UNNAMED_IDENTIFIER = dmHashBuffer64("__unnamed__", strlen("__unnamed__"));
     const char* ID_SEPARATOR = "/";
@@ -159,7 +161,9 @@ namespace dmGameObject
     {
         m_ComponentTypeCount = 0;
         m_DefaultCollectionCapacity = DEFAULT_MAX_COLLECTION_CAPACITY;
+        m_MaxCollectionCapacity = MAX_COMPACT_INSTANCES;
         m_DefaultInputStackCapacity = DEFAULT_MAX_INPUT_STACK_CAPACITY;
+        m_WorkerPool = 0;
         m_Mutex = dmMutex::New();
         m_SocketToCollection.SetCapacity(15, 17);
     }
@@ -191,9 +195,25 @@ namespace dmGameObject
         m_MaxInstances = max_instances;
         m_Instances.SetCapacity(max_instances);
         m_Instances.SetSize(max_instances);
-        m_InstanceIndices.SetCapacity(max_instances);
+        m_WideIndices = max_instances > MAX_COMPACT_INSTANCES;
+        if (m_WideIndices)
+        {
+            m_WideInstanceIndices.SetCapacity(max_instances);
+            m_WideLevelIndices = new dmArray<uint32_t>[MAX_HIERARCHICAL_DEPTH];
+            m_WideLevelParentIndices = new dmArray<uint32_t>[MAX_HIERARCHICAL_DEPTH];
+        }
+        else
+        {
+            m_InstanceIndices.SetCapacity(max_instances);
+            m_WideLevelIndices = 0;
+            m_WideLevelParentIndices = 0;
+        }
         m_WorldTransforms.SetCapacity(max_instances);
         m_WorldTransforms.SetSize(max_instances);
+        m_LocalTransformDirty.SetCapacity(max_instances);
+        m_LocalTransformDirty.SetSize(max_instances);
+        m_WorldTransformChanged.SetCapacity(max_instances);
+        m_WorldTransformChanged.SetSize(max_instances);
         m_IDToInstance.SetCapacity(dmMath::Max(1U, max_instances/3), max_instances);
         m_InputFocusStack.SetCapacity(max_input_stack_entries);
         m_NameHash = 0;
@@ -219,6 +239,8 @@ namespace dmGameObject
 
         memset(&m_Instances[0], 0, sizeof(Instance*) * max_instances);
         memset(&m_WorldTransforms[0], 0xcc, sizeof(dmTransform::Transform) * max_instances);
+        memset(&m_LocalTransformDirty[0], 0, sizeof(uint8_t) * max_instances);
+        memset(&m_WorldTransformChanged[0], 0, sizeof(uint8_t) * max_instances);
         memset(&m_LevelIndices[0], 0, sizeof(m_LevelIndices));
         memset(&m_ComponentInstanceCount[0], 0, sizeof(uint32_t) * MAX_COMPONENT_TYPES);
     }
@@ -226,18 +248,30 @@ namespace dmGameObject
     Result SetCollectionDefaultCapacity(HRegister regist, uint32_t capacity)
     {
         assert(regist != 0x0);
-        if(capacity >= INVALID_INSTANCE_INDEX-1)
+        if(capacity > regist->m_MaxCollectionCapacity)
             return RESULT_INVALID_OPERATION;
         regist->m_DefaultCollectionCapacity = capacity;
         return RESULT_OK;
     }
 
+    void SetCollectionWideIndices(HRegister regist, bool enable)
+    {
+        assert(regist != 0x0);
+        regist->m_MaxCollectionCapacity = enable ? MAX_WIDE_INSTANCES : MAX_COMPACT_INSTANCES;
+    }
+
     uint32_t GetCollectionDefaultCapacity(HRegister regist)
     {
         assert(regist != 0x0);
         return regist->m_DefaultCollectionCapacity;
     }
 
+    void SetWorkerPool(HRegister regist, dmWorkerPool::HWorkerPool pool)
+    {
+        assert(regist != 0x0);
+        regist->m_WorkerPool = pool;
+    }
+
     void SetInputStackDefaultCapacity(HRegister regist, uint32_t capacity)
     {
         assert(regist != 0x0);
@@ -301,6 +335,8 @@ namespace dmGameObject
                 regist->m_ComponentTypes[i].m_DeleteWorldFunction(params);
         }
         dmMutex::Delete(collection->m_Mutex);
+        delete[] collection->m_WideLevelIndices;
+        delete[] collection->m_WideLevelParentIndices;
         delete collection;
     }
 
@@ -400,9 +436,10 @@ namespace dmGameObject
 
     HCollection NewCollection(const char* name, dmResource::HFactory factory, HRegister regist, uint32_t max_instances)
     {
-        if (max_instances > INVALID_INSTANCE_INDEX)
+        if (max_instances > regist->m_MaxCollectionCapacity)
         {
-            dmLogError("max_instances must be less or equal to %d", INVALID_INSTANCE_INDEX);
+            dmLogError("max_instances must be less or equal to %d%s", regist->m_MaxCollectionCapacity,
+                regist->m_MaxCollectionCapacity == MAX_COMPACT_INSTANCES ? " (see collection.wide_indices)" : "");
             return 0;
         }
 
@@ -577,21 +614,33 @@ namespace dmGameObject
         return ret;
     }
 
+    template <typename T>
     static void EraseSwapLevelIndex(Collection* collection, HInstance instance)
     {
         /*
          * Remove instance from m_LevelIndices using an erase-swap operation
          */
 
-        dmArray<uint16_t>& level = collection->m_LevelIndices[instance->m_Depth];
+        dmArray<T>& level = CollectionIndexArrays<T>::LevelIndices(collection)[instance->m_Depth];
         assert(level.Size() > 0);
-        assert(instance->m_LevelIndex < level.Size());
+        assert(GetLevelIndex(instance) < level.Size());
 
-        uint16_t level_index = instance->m_LevelIndex;
-        uint16_t swap_in_index = level.EraseSwap(level_index);
+        InstanceIndex level_index = GetLevelIndex(instance);
+        InstanceIndex swap_in_index = level.EraseSwap(level_index);
+        CollectionIndexArrays<T>::LevelParentIndices(collection)[instance->m_Depth].EraseSwap(level_index);
         HInstance swap_in_instance = collection->m_Instances[swap_in_index];
-        assert(swap_in_instance->m_Index == swap_in_index);
-        swap_in_instance->m_LevelIndex = level_index;
+        assert(GetIndex(swap_in_instance) == swap_in_index);
+        SetLevelIndex(swap_in_instance, level_index);
+        // The local transform in the level stream is left at the old place
+        SetLocalTransformDirty(swap_in_instance);
+    }
+
+    static void EraseSwapLevelIndex(Collection* collection, HInstance instance)
+    {
+        if (collection->m_WideIndices)
+            EraseSwapLevelIndex<uint32_t>(collection, instance);
+        else
+            EraseSwapLevelIndex<uint16_t>(collection, instance);
     }
 
     /*
@@ -600,7 +649,8 @@ namespace dmGameObject
      * ** 10 elements as min
      * ** Up to max_instances as max
      */
-    static void ExpandLevel(dmArray<uint16_t>& level, uint32_t max_instances)
+    template <typename T>
+    static void ExpandLevel(dmArray<T>& level, uint32_t max_instances)
     {
         const uint32_t min_offset = 10;
         const uint32_t max_offset = max_instances - level.Capacity();
@@ -608,23 +658,50 @@ namespace dmGameObject
         level.OffsetCapacity(offset);
     }
 
+    template <typename T>
     static void InsertInstanceInLevelIndex(Collection* collection, HInstance instance)
     {
         /*
          * Insert instance in m_LevelIndices at level set in instance->m_Depth
          */
-        dmArray<uint16_t>& level = collection->m_LevelIndices[instance->m_Depth];
+        dmArray<T>& level = CollectionIndexArrays<T>::LevelIndices(collection)[instance->m_Depth];
+        dmArray<T>& parents = CollectionIndexArrays<T>::LevelParentIndices(collection)[instance->m_Depth];
         if (level.Full())
+        {
             ExpandLevel(level, collection->m_MaxInstances);
+            parents.SetCapacity(level.Capacity());
+
+            // The local transforms are stored in whole groups of four, the padding is never stored to the world transforms
+            dmArray<float>& locals = collection->m_LevelLocalTransforms[instance->m_Depth];
+            uint32_t old_size = locals.Size();
+            uint32_t new_size = ((level.Capacity() + 3) / 4) * TRANSFORM_SOA_STRIDE;
+            locals.SetCapacity(new_size);
+            locals.SetSize(new_size);
+            memset(locals.Begin() + old_size, 0, (new_size - old_size) * sizeof(float));
+        }
         assert(!level.Full());
 
-        uint16_t level_index = (uint16_t)level.Size();
+        InstanceIndex level_index = level.Size();
         level.SetSize(level_index + 1);
-        level[level_index] = instance->m_Index;
-        instance->m_LevelIndex = level_index;
+        level[level_index] = (T) GetIndex(instance);
+        parents.SetSize(level_index + 1);
+        parents[level_index] = (T) GetParentIndex(instance);
+        SetLevelIndex(instance, level_index);
+    }
+
+    static void InsertInstanceInLevelIndex(Collection* collection, HInstance instance)
+    {
+        if (collection->m_WideIndices)
+            InsertInstanceInLevelIndex<uint32_t>(collection, instance);
+        else
+            InsertInstanceInLevelIndex<uint16_t>(collection, instance);
+
+        // The parent has changed, so the world transform must be recalculated even if the local transform is unchanged
+        SetLocalTransformDirty(instance);
+        collection->m_DirtyTransforms = 1;
     }
 
-    static HInstance AllocInstance(Prototype* proto, const char* prototype_name) {
+    static HInstance AllocInstance(Prototype* proto, const char* prototype_name, bool wide_indices) {
         // Count number of component userdata fields required
         uint32_t component_instance_userdata_count = 0;
         for (uint32_t i = 0; i < proto->m_ComponentCount; ++i)
@@ -641,10 +718,16 @@ namespace dmGameObject
         }
 
         uint32_t component_userdata_size = sizeof(((Instance*)0)->m_ComponentInstanceUserData[0]);
-        // NOTE: Allocate actual Instance with *all* component instance user-data accounted
-        void* instance_memory = ::operator new (sizeof(Instance) + component_instance_userdata_count * component_userdata_size);
+        // NOTE: Allocate actual Instance with *all* component instance user-data accounted, and the wide indices after them if used
+        uint32_t wide_indices_size = wide_indices ? sizeof(InstanceWideIndices) : 0;
+        void* instance_memory = ::operator new (sizeof(Instance) + component_instance_userdata_count * component_userdata_size + wide_indices_size);
         Instance* instance = new(instance_memory) Instance(proto);
         instance->m_ComponentInstanceUserDataCount = component_instance_userdata_count;
+        if (wide_indices)
+        {
+            instance->m_WideIndices = 1;
+            memset(GetWideIndices(instance), 0xff, sizeof(InstanceWideIndices));
+        }
         return instance;
     }
 
@@ -659,17 +742,30 @@ namespace dmGameObject
         operator delete (instance_memory);
     }
 
+    static InstanceIndex PopInstanceIndex(Collection* collection)
+    {
+        return collection->m_WideIndices ? collection->m_WideInstanceIndices.Pop() : collection->m_InstanceIndices.Pop();
+    }
+
+    static void PushInstanceIndex(Collection* collection, InstanceIndex index)
+    {
+        if (collection->m_WideIndices)
+            collection->m_WideInstanceIndices.Push(index);
+        else
+            collection->m_InstanceIndices.Push((uint16_t) index);
+    }
+
     HInstance NewInstance(Collection* collection, Prototype* proto, const char* prototype_name) {
-        if (collection->m_InstanceIndices.Remaining() == 0)
+        if (GetInstanceCount(collection) == collection->m_MaxInstances)
         {
-            dmLogError("The game object instance could not be created since the buffer is full (%d).", collection->m_InstanceIndices.Capacity());
+            dmLogError("The game object instance could not be created since the buffer is full (%d).", collection->m_MaxInstances);
             return 0;
         }
-        HInstance instance = AllocInstance(proto, prototype_name);
+        HInstance instance = AllocInstance(proto, prototype_name, collection->m_WideIndices);
         instance->m_Collection = collection;
         instance->m_ScaleAlongZ = collection->m_ScaleAlongZ;
-        uint16_t instance_index = collection->m_InstanceIndices.Pop();
-        instance->m_Index = instance_index;
+        InstanceIndex instance_index = PopInstanceIndex(collection);
+        SetIndex(instance, instance_index);
         assert(collection->m_Instances[instance_index] == 0);
         collection->m_Instances[instance_index] = instance;
 
@@ -688,16 +784,16 @@ namespace dmGameObject
         }
         EraseSwapLevelIndex(collection, instance);
 
-        if (instance->m_Parent != INVALID_INSTANCE_INDEX)
+        if (GetParentIndex(instance) != INVALID_INSTANCE_INDEX)
         {
             Unlink(collection, instance);
         }
 
-        uint16_t instance_index = instance->m_Index;
+        InstanceIndex instance_index = GetIndex(instance);
         operator delete ((void*)instance);
         collection->m_Instances[instance_index] = 0x0;
-        collection->m_InstanceIndices.Push(instance_index);
-        assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
+        PushInstanceIndex(collection, instance_index);
+        assert(collection->m_IDToInstance.Size() <= GetInstanceCount(collection));
     }
 
     void UndoNewInstance(HCollection hcollection, HInstance instance) {
@@ -916,7 +1012,7 @@ namespace dmGameObject
         instance->m_Identifier = id;
         collection->m_IDToInstance.Put(id, instance);
 
-        assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
+        assert(collection->m_IDToInstance.Size() <= GetInstanceCount(collection));
         return RESULT_OK;
     }
 
@@ -942,11 +1038,11 @@ namespace dmGameObject
             return;
         }
         instance->m_ToBeAdded = 1;
-        uint16_t index = instance->m_Index;
-        uint16_t tail = collection->m_InstancesToAddTail;
+        InstanceIndex index = GetIndex(instance);
+        InstanceIndex tail = collection->m_InstancesToAddTail;
         if (tail != INVALID_INSTANCE_INDEX) {
             HInstance tail_instance = collection->m_Instances[tail];
-            tail_instance->m_NextToAdd = index;
+            SetNextToAdd(tail_instance, index);
         } else {
             collection->m_InstancesToAddHead = index;
         }
@@ -959,7 +1055,7 @@ namespace dmGameObject
         {
             instance->m_ToBeAdded = 0;
             if (instance->m_ToBeDeleted == 0) {
-                assert(collection->m_Instances[instance->m_Index] == instance);
+                assert(collection->m_Instances[GetIndex(instance)] == instance);
 
                 uint32_t next_component_instance_data = 0;
                 Prototype* prototype = instance->m_Prototype;
@@ -1002,15 +1098,15 @@ namespace dmGameObject
             dmLogError("Instances can not be added to update during the update.");
             return false;
         }
-        uint16_t index = collection->m_InstancesToAddHead;
+        InstanceIndex index = collection->m_InstancesToAddHead;
         bool result = true;
         while (index != INVALID_INSTANCE_INDEX) {
             HInstance instance = collection->m_Instances[index];
             if (!DoAddToUpdate(collection, instance)) {
                 result = false;
             }
-            index = instance->m_NextToAdd;
-            instance->m_NextToAdd = INVALID_INSTANCE_INDEX;
+            index = GetNextToAdd(instance);
+            SetNextToAdd(instance, INVALID_INSTANCE_INDEX);
         }
         collection->m_InstancesToAddHead = INVALID_INSTANCE_INDEX;
         collection->m_InstancesToAddTail = INVALID_INSTANCE_INDEX;
@@ -1074,7 +1170,7 @@ namespace dmGameObject
         SetPosition(instance, position);
         SetRotation(instance, rotation);
         SetScale(instance, scale);
-        collection->m_WorldTransforms[instance->m_Index] = dmTransform::ToMatrix4(instance->m_Transform);
+        collection->m_WorldTransforms[GetIndex(instance)] = dmTransform::ToMatrix4(instance->m_Transform);
 
         dmHashInit64(&instance->m_CollectionPathHashState, true);
         dmHashUpdateBuffer64(&instance->m_CollectionPathHashState, ID_SEPARATOR, strlen(ID_SEPARATOR));
@@ -1245,7 +1341,7 @@ namespace dmGameObject
                 }
 
                 // world transforms need to be up to date in time for the script init calls
-                collection->m_WorldTransforms[new_instances[i]->m_Index] = dmTransform::ToMatrix4(new_instances[i]->m_Transform);
+                collection->m_WorldTransforms[GetIndex(new_instances[i])] = dmTransform::ToMatrix4(new_instances[i]->m_Transform);
             }
         }
 
@@ -1454,11 +1550,11 @@ namespace dmGameObject
     static void Unlink(Collection* collection, Instance* instance)
     {
         // Unlink "me" from parent
-        if (instance->m_Parent != INVALID_INSTANCE_INDEX)
+        if (GetParentIndex(instance) != INVALID_INSTANCE_INDEX)
         {
             assert(instance->m_Depth > 0);
-            Instance* parent = collection->m_Instances[instance->m_Parent];
-            uint32_t index = parent->m_FirstChildIndex;
+            Instance* parent = collection->m_Instances[GetParentIndex(instance)];
+            uint32_t index = GetFirstChildIndex(parent);
             Instance* prev_child = 0;
             while (index != INVALID_INSTANCE_INDEX)
             {
@@ -1466,18 +1562,17 @@ namespace dmGameObject
                 if (child == instance)
                 {
                     if (prev_child)
-                        prev_child->m_SiblingIndex = child->m_SiblingIndex;
+                        SetSiblingIndex(prev_child, GetSiblingIndex(child));
                     else
-                        parent->m_FirstChildIndex = child->m_SiblingIndex;
-
+                        SetFirstChildIndex(parent, GetSiblingIndex(child));
                     break;
                 }
 
                 prev_child = child;
-                index = collection->m_Instances[index]->m_SiblingIndex;
+                index = GetSiblingIndex(collection->m_Instances[index]);
             }
-            instance->m_SiblingIndex = INVALID_INSTANCE_INDEX;
-            instance->m_Parent = INVALID_INSTANCE_INDEX;
+            SetSiblingIndex(instance, INVALID_INSTANCE_INDEX);
+            SetParentIndex(instance, INVALID_INSTANCE_INDEX);
         }
     }
 
@@ -1499,7 +1594,7 @@ namespace dmGameObject
          * Move all children up in hierarchy
          */
 
-        uint32_t index = instance->m_FirstChildIndex;
+        uint32_t index = GetFirstChildIndex(instance);
         while (index != INVALID_INSTANCE_INDEX)
         {
             Instance* child = collection->m_Instances[index];
@@ -1509,7 +1604,7 @@ namespace dmGameObject
             //assert(child->m_Depth == instance->m_Depth + 1);
             MoveAllUp(collection, child);
             MoveUp(collection, child);
-            index = collection->m_Instances[index]->m_SiblingIndex;
+            index = GetSiblingIndex(collection->m_Instances[index]);
         }
     }
 
@@ -1531,7 +1626,7 @@ namespace dmGameObject
          * Move all children down in hierarchy
          */
 
-        uint32_t index = instance->m_FirstChildIndex;
+        uint32_t index = GetFirstChildIndex(instance);
         while (index != INVALID_INSTANCE_INDEX)
         {
             Instance* child = collection->m_Instances[index];
@@ -1541,7 +1636,7 @@ namespace dmGameObject
             //assert(child->m_Depth == instance->m_Depth + 1);
             MoveAllDown(collection, child);
             MoveDown(collection, child);
-            index = collection->m_Instances[index]->m_SiblingIndex;
+            index = GetSiblingIndex(collection->m_Instances[index]);
         }
     }
 
@@ -1592,17 +1687,17 @@ namespace dmGameObject
                 instance->m_Initialized = 1;
             }
 
-            assert(collection->m_Instances[instance->m_Index] == instance);
+            assert(collection->m_Instances[GetIndex(instance)] == instance);
 
             // Update world transforms since some components might need them in their init-callback
-            Matrix4* trans = &collection->m_WorldTransforms[instance->m_Index];
-            if (instance->m_Parent == INVALID_INSTANCE_INDEX)
+            Matrix4* trans = &collection->m_WorldTransforms[GetIndex(instance)];
+            if (GetParentIndex(instance) == INVALID_INSTANCE_INDEX)
             {
                 *trans = dmTransform::ToMatrix4(instance->m_Transform);
             }
             else
             {
-                const Matrix4* parent_trans = &collection->m_WorldTransforms[instance->m_Parent];
+                const Matrix4* parent_trans = &collection->m_WorldTransforms[GetParentIndex(instance)];
                 if (instance->m_ScaleAlongZ)
                 {
                     *trans = (*parent_trans) * dmTransform::ToMatrix4(instance->m_Transform);
@@ -1636,7 +1731,7 @@ namespace dmGameObject
 
         bool result = true;
         // Update scripts
-        uint32_t count = collection->m_InstanceIndices.Size();
+        uint32_t count = GetInstanceCount(collection);
         for (uint32_t i = 0; i < count; ++i) {
             Instance* instance = collection->m_Instances[i];
             if (!InitInstance(collection, instance)) {
@@ -1706,7 +1801,7 @@ namespace dmGameObject
             else
                 dmLogWarning("%s", "Instance is finalized without being initialized, this may lead to undefined behaviour.");
 
-            assert(collection->m_Instances[instance->m_Index] == instance);
+            assert(collection->m_Instances[GetIndex(instance)] == instance);
             return FinalComponents(collection, instance);
         }
 
@@ -1740,7 +1835,7 @@ namespace dmGameObject
 
     void Delete(Collection* collection, HInstance instance, bool recursive)
     {
-        assert(collection->m_Instances[instance->m_Index] == instance);
+        assert(collection->m_Instances[GetIndex(instance)] == instance);
         assert(instance->m_Collection == collection);
 
         // NOTE: Do not add for delete twice.
@@ -1755,12 +1850,12 @@ namespace dmGameObject
         // If recursive, Delete child hierarchy recursively, child to parent order (leaf first).
         if(recursive)
         {
-            uint32_t childIndex = instance->m_FirstChildIndex;
+            uint32_t childIndex = GetFirstChildIndex(instance);
             while (childIndex != INVALID_INSTANCE_INDEX)
             {
                 Instance* child = collection->m_Instances[childIndex];
-                assert(child->m_Parent == instance->m_Index);
-                childIndex = child->m_SiblingIndex;
+                assert(GetParentIndex(child) == GetIndex(instance));
+                childIndex = GetSiblingIndex(child);
                 Delete(collection, child, true);
             }
         }
@@ -1768,11 +1863,11 @@ namespace dmGameObject
         // Delete instance
         instance->m_ToBeDeleted = 1;
 
-        uint16_t index = instance->m_Index;
-        uint16_t tail = collection->m_InstancesToDeleteTail;
+        InstanceIndex index = GetIndex(instance);
+        InstanceIndex tail = collection->m_InstancesToDeleteTail;
         if (tail != INVALID_INSTANCE_INDEX) {
             HInstance tail_instance = collection->m_Instances[tail];
-            tail_instance->m_NextToDelete = index;
+            SetNextToDelete(tail_instance, index);
         } else {
             collection->m_InstancesToDeleteHead = index;
         }
@@ -1786,22 +1881,30 @@ namespace dmGameObject
 
     static void RemoveFromAddToUpdate(Collection* collection, HInstance instance)
     {
-        uint16_t index = instance->m_Index;
-        assert(collection->m_InstancesToAddTail == index || instance->m_NextToAdd != INVALID_INSTANCE_INDEX);
-        uint16_t* prev_index_ptr = &collection->m_InstancesToAddHead;
-        uint16_t prev_index = *prev_index_ptr;
-        while (prev_index != index) {
-            prev_index_ptr = &collection->m_Instances[prev_index]->m_NextToAdd;
-            if (collection->m_InstancesToAddTail == *prev_index_ptr) {
-                collection->m_InstancesToAddTail = prev_index;
+        InstanceIndex index = GetIndex(instance);
+        InstanceIndex next_index = GetNextToAdd(instance);
+        assert(collection->m_InstancesToAddTail == index || next_index != INVALID_INSTANCE_INDEX);
+        if (collection->m_InstancesToAddHead == index)
+        {
+            collection->m_InstancesToAddHead = next_index;
+            if (next_index == INVALID_INSTANCE_INDEX) { // If we unlinked the last item
+                collection->m_InstancesToAddTail = INVALID_INSTANCE_INDEX;
             }
-            prev_index = *prev_index_ptr;
         }
-        *prev_index_ptr = instance->m_NextToAdd;
-        if (prev_index_ptr == &collection->m_InstancesToAddHead && *prev_index_ptr == INVALID_INSTANCE_INDEX) { // If we unlinked the last item
-            collection->m_InstancesToAddTail = INVALID_INSTANCE_INDEX;
+        else
+        {
+            InstanceIndex prev_index = collection->m_InstancesToAddHead;
+            Instance* prev = collection->m_Instances[prev_index];
+            while (GetNextToAdd(prev) != index) {
+                prev_index = GetNextToAdd(prev);
+                prev = collection->m_Instances[prev_index];
+            }
+            SetNextToAdd(prev, next_index);
+            if (collection->m_InstancesToAddTail == index) {
+                collection->m_InstancesToAddTail = prev_index;
+            }
         }
-        instance->m_NextToAdd = INVALID_INSTANCE_INDEX;
+        SetNextToAdd(instance, INVALID_INSTANCE_INDEX);
         instance->m_ToBeAdded = 0;
     }
 
@@ -1830,41 +1933,41 @@ namespace dmGameObject
         }
         ReleaseIdentifier(collection, instance);
 
-        assert(collection->m_LevelIndices[instance->m_Depth].Size() > 0);
-        assert(instance->m_LevelIndex < collection->m_LevelIndices[instance->m_Depth].Size());
+        assert(GetLevelSize(collection, instance->m_Depth) > 0);
+        assert(GetLevelIndex(instance) < GetLevelSize(collection, instance->m_Depth));
 
         // Reparent child nodes
-        uint32_t index = instance->m_FirstChildIndex;
+        uint32_t index = GetFirstChildIndex(instance);
         while (index != INVALID_INSTANCE_INDEX)
         {
             Instance* child = collection->m_Instances[index];
-            assert(child->m_Parent == instance->m_Index);
-            child->m_Parent = instance->m_Parent;
-            index = collection->m_Instances[index]->m_SiblingIndex;
+            assert(GetParentIndex(child) == GetIndex(instance));
+            SetParentIndex(child, GetParentIndex(instance));
+            index = GetSiblingIndex(collection->m_Instances[index]);
         }
 
         // Add child nodes to parent
-        if (instance->m_Parent != INVALID_INSTANCE_INDEX)
+        if (GetParentIndex(instance) != INVALID_INSTANCE_INDEX)
         {
-            Instance* parent = collection->m_Instances[instance->m_Parent];
-            uint32_t index = parent->m_FirstChildIndex;
+            Instance* parent = collection->m_Instances[GetParentIndex(instance)];
+            uint32_t index = GetFirstChildIndex(parent);
             Instance* child = 0;
             while (index != INVALID_INSTANCE_INDEX)
             {
                 child = collection->m_Instances[index];
-                index = collection->m_Instances[index]->m_SiblingIndex;
+                index = GetSiblingIndex(collection->m_Instances[index]);
             }
 
             // Child is last child if present
             if (child)
             {
-                assert(child->m_SiblingIndex == INVALID_INSTANCE_INDEX);
-                child->m_SiblingIndex = instance->m_FirstChildIndex;
+                assert(GetSiblingIndex(child) == INVALID_INSTANCE_INDEX);
+                SetSiblingIndex(child, GetFirstChildIndex(instance));
             }
             else
             {
-                assert(parent->m_FirstChildIndex == INVALID_INSTANCE_INDEX);
-                parent->m_FirstChildIndex = instance->m_FirstChildIndex;
+                assert(GetFirstChildIndex(parent) == INVALID_INSTANCE_INDEX);
+                SetFirstChildIndex(parent, GetFirstChildIndex(instance));
             }
         }
 
@@ -1875,8 +1978,8 @@ namespace dmGameObject
 
         if (prototype != &EMPTY_PROTOTYPE)
             dmResource::Release(factory, prototype);
-        collection->m_InstanceIndices.Push(instance->m_Index);
-        collection->m_Instances[instance->m_Index] = 0;
+        PushInstanceIndex(collection, GetIndex(instance));
+        collection->m_Instances[GetIndex(instance)] = 0;
 
         // Erase from input stack
         bool found_instance = false;
@@ -1901,7 +2004,7 @@ namespace dmGameObject
 
         DeallocInstance(instance);
 
-        assert(collection->m_IDToInstance.Size() <= collection->m_InstanceIndices.Size());
+        assert(collection->m_IDToInstance.Size() <= GetInstanceCount(collection));
     }
 
     void DeleteAll(HCollection hcollection)
@@ -2010,11 +2113,11 @@ namespace dmGameObject
         return instance->m_Bone;
     }
 
-    static uint32_t DoSetBoneTransforms(HCollection hcollection, dmTransform::Transform* component_transform, uint16_t first_index, dmTransform::Transform* transforms, uint32_t transform_count)
+    static uint32_t DoSetBoneTransforms(HCollection hcollection, dmTransform::Transform* component_transform, InstanceIndex first_index, dmTransform::Transform* transforms, uint32_t transform_count)
     {
         if (transform_count == 0)
             return 0;
-        uint16_t current_index = first_index;
+        InstanceIndex current_index = first_index;
         uint32_t count = 0;
         Collection* collection = hcollection->m_Collection;
         while (current_index != INVALID_INSTANCE_INDEX)
@@ -2026,40 +2129,41 @@ namespace dmGameObject
                 if (component_transform && count == 1) {
                     instance->m_Transform = dmTransform::Mul(*component_transform, instance->m_Transform);
                 }
+                SetLocalTransformDirty(instance);
                 if (count < transform_count)
                 {
-                    count += DoSetBoneTransforms(hcollection, 0x0, instance->m_FirstChildIndex, &transforms[count], transform_count - count);
+                    count += DoSetBoneTransforms(hcollection, 0x0, GetFirstChildIndex(instance), &transforms[count], transform_count - count);
                 }
                 if (transform_count == count)
                 {
                     return count;
                 }
             }
-            current_index = instance->m_SiblingIndex;
+            current_index = GetSiblingIndex(instance);
         }
         return count;
     }
 
     uint32_t SetBoneTransforms(HInstance instance, dmTransform::Transform& component_transform, dmTransform::Transform* transforms, uint32_t transform_count)
     {
-        return DoSetBoneTransforms(instance->m_Collection->m_HCollection, &component_transform, instance->m_Index, transforms, transform_count);
+        return DoSetBoneTransforms(instance->m_Collection->m_HCollection, &component_transform, GetIndex(instance), transforms, transform_count);
     }
 
-    static void DeleteBones(Collection* collection, uint16_t first_index) {
-        uint16_t current_index = first_index;
+    static void DeleteBones(Collection* collection, InstanceIndex first_index) {
+        InstanceIndex current_index = first_index;
         while (current_index != INVALID_INSTANCE_INDEX) {
             HInstance instance = collection->m_Instances[current_index];
             if (instance->m_Bone && instance->m_ToBeDeleted == 0) {
-                DeleteBones(collection, instance->m_FirstChildIndex);
+                DeleteBones(collection, GetFirstChildIndex(instance));
                 // Delete children first, to avoid any unnecessary re-parenting
                 Delete(collection, instance, false);
             }
-            current_index = instance->m_SiblingIndex;
+            current_index = GetSiblingIndex(instance);
         }
     }
 
     void DeleteBones(HInstance parent) {
-        return DeleteBones(parent->m_Collection, parent->m_FirstChildIndex);
+        return DeleteBones(parent->m_Collection, GetFirstChildIndex(parent));
     }
 
     struct DispatchMessagesContext
@@ -2157,12 +2261,12 @@ namespace dmGameObject
 
                 if (parent)
                 {
-                    parent_t = collection->m_WorldTransforms[parent->m_Index];
+                    parent_t = collection->m_WorldTransforms[GetIndex(parent)];
                 }
 
                 if (sp->m_KeepWorldTransform == 0)
                 {
-                    Matrix4& world = collection->m_WorldTransforms[instance->m_Index];
+                    Matrix4& world = collection->m_WorldTransforms[GetIndex(instance)];
                     if (instance->m_ScaleAlongZ)
                     {
                         world = parent_t * dmTransform::ToMatrix4(instance->m_Transform);
@@ -2176,13 +2280,14 @@ namespace dmGameObject
                 {
                     if (instance->m_ScaleAlongZ)
                     {
-                        instance->m_Transform = dmTransform::ToTransform(inverse(parent_t) * collection->m_WorldTransforms[instance->m_Index]);
+                        instance->m_Transform = dmTransform::ToTransform(inverse(parent_t) * collection->m_WorldTransforms[GetIndex(instance)]);
                     }
                     else
                     {
-                        Matrix4 tmp = dmTransform::MulNoScaleZ(inverse(parent_t), collection->m_WorldTransforms[instance->m_Index]);
+                        Matrix4 tmp = dmTransform::MulNoScaleZ(inverse(parent_t), collection->m_WorldTransforms[GetIndex(instance)]);
                         instance->m_Transform = dmTransform::ToTransform(tmp);
                     }
+                    SetLocalTransformDirty(instance);
                 }
 
                 dmGameObject::Result result = dmGameObject::SetParent(instance, parent);
@@ -2351,65 +2456,239 @@ namespace dmGameObject
         }
     }
 
-    void UpdateTransforms(Collection* collection)
-    {
-        DM_PROFILE(GameObject, "UpdateTransforms");
+    // Writes a local transform to lane "lane" of a group of four local transforms in a level stream (see TRANSFORM_SOA_STRIDE)
+    static inline void PackLocalTransform(float* group, uint32_t lane, const dmTransform::Transform& transform)
+    {
+        Vector3 t = transform.GetTranslation();
+        Quat r = transform.GetRotation();
+        Vector3 s = transform.GetScale();
+        group[0*4 + lane] = t.getX();
+        group[1*4 + lane] = t.getY();
+        group[2*4 + lane] = t.getZ();
+        group[3*4 + lane] = r.getX();
+        group[4*4 + lane] = r.getY();
+        group[5*4 + lane] = r.getZ();
+        group[6*4 + lane] = r.getW();
+        group[7*4 + lane] = s.getX();
+        group[8*4 + lane] = s.getY();
+        group[9*4 + lane] = s.getZ();
+    }
+
+    // Calculates the local matrices of a group of four local transforms, one element of all four matrices per vector (m[column * 4 + row]).
+    // Same operation order as dmTransform::ToMatrix4, so the results are identical
+    static inline void CalcLocalMatrices(const float* group, dmSIMD::Vector4f* m)
+    {
+        using namespace dmSIMD;
+        Vector4f qx = Load(group + 3*4);
+        Vector4f qy = Load(group + 4*4);
+        Vector4f qz = Load(group + 5*4);
+        Vector4f qw = Load(group + 6*4);
+        Vector4f qx2 = Add(qx, qx);
+        Vector4f qy2 = Add(qy, qy);
+        Vector4f qz2 = Add(qz, qz);
+        Vector4f qxqx2 = Mul(qx, qx2);
+        Vector4f qxqy2 = Mul(qx, qy2);
+        Vector4f qxqz2 = Mul(qx, qz2);
+        Vector4f qxqw2 = Mul(qw, qx2);
+        Vector4f qyqy2 = Mul(qy, qy2);
+        Vector4f qyqz2 = Mul(qy, qz2);
+        Vector4f qyqw2 = Mul(qw, qy2);
+        Vector4f qzqz2 = Mul(qz, qz2);
+        Vector4f qzqw2 = Mul(qw, qz2);
+        Vector4f one = Splat(1.0f);
+        Vector4f zero = Splat(0.0f);
+        Vector4f sx = Load(group + 7*4);
+        Vector4f sy = Load(group + 8*4);
+        Vector4f sz = Load(group + 9*4);
+
+        m[0*4 + 0] = Mul(Sub(Sub(one, qyqy2), qzqz2), sx);
+        m[0*4 + 1] = Mul(Add(qxqy2, qzqw2), sx);
+        m[0*4 + 2] = Mul(Sub(qxqz2, qyqw2), sx);
+        m[0*4 + 3] = Mul(zero, sx);
+        m[1*4 + 0] = Mul(Sub(qxqy2, qzqw2), sy);
+        m[1*4 + 1] = Mul(Sub(Sub(one, qxqx2), qzqz2), sy);
+        m[1*4 + 2] = Mul(Add(qyqz2, qxqw2), sy);
+        m[1*4 + 3] = Mul(zero, sy);
+        m[2*4 + 0] = Mul(Add(qxqz2, qyqw2), sz);
+        m[2*4 + 1] = Mul(Sub(qyqz2, qxqw2), sz);
+        m[2*4 + 2] = Mul(Sub(Sub(one, qxqx2), qyqy2), sz);
+        m[2*4 + 3] = Mul(zero, sz);
+        m[3*4 + 0] = Load(group + 0*4);
+        m[3*4 + 1] = Load(group + 1*4);
+        m[3*4 + 2] = Load(group + 2*4);
+        m[3*4 + 3] = one;
+    }
+
+    // Calculates a column of the world matrices of a group, p * l[column] with the same operation order as Matrix4 * Vector4.
+    // The parent matrices are given as p[column * 4 + row], and p2 replaces the third column (see dmTransform::MulNoScaleZ)
+    static inline void MulParentColumn(const dmSIMD::Vector4f* p, dmSIMD::Vector4f p20, dmSIMD::Vector4f p21, dmSIMD::Vector4f p22, dmSIMD::Vector4f p23,
+                                       const dmSIMD::Vector4f* l, dmSIMD::Vector4f* out)
+    {
+        using namespace dmSIMD;
+        out[0] = Add(Add(Add(Mul(p[0*4 + 0], l[0]), Mul(p[1*4 + 0], l[1])), Mul(p20, l[2])), Mul(p[3*4 + 0], l[3]));
+        out[1] = Add(Add(Add(Mul(p[0*4 + 1], l[0]), Mul(p[1*4 + 1], l[1])), Mul(p21, l[2])), Mul(p[3*4 + 1], l[3]));
+        out[2] = Add(Add(Add(Mul(p[0*4 + 2], l[0]), Mul(p[1*4 + 2], l[1])), Mul(p22, l[2])), Mul(p[3*4 + 2], l[3]));
+        out[3] = Add(Add(Add(Mul(p[0*4 + 3], l[0]), Mul(p[1*4 + 3], l[1])), Mul(p23, l[2])), Mul(p[3*4 + 3], l[3]));
+    }
+
+    // Calculates the world transforms of a group of four instances in a hierarchy level, from the local transforms in the level
+    // stream and the parent world transforms. Only the lanes in lane_mask are stored
+    template <typename T>
+    static void CalcGroupWorldTransforms(Collection* collection, const float* group, const T* indices, const T* parents, uint32_t lane_mask)
+    {
+        using namespace dmSIMD;
+        float* world_transforms = (float*) collection->m_WorldTransforms.Begin();
+
+        Vector4f local[16];
+        CalcLocalMatrices(group, local);
+
+        Vector4f world[16];
+        if (parents == 0)
+        {
+            memcpy(world, local, sizeof(world));
+        }
+        else
+        {
+            // Parent world transforms of the group, one element of all four matrices per vector like the local matrices.
+            // Lanes that aren't stored use the parent of the first lane, which is always in the level
+            const float* parent[4];
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                parent[lane] = world_transforms + parents[(lane_mask >> lane) & 1 ? lane : 0] * 16;
+            }
+            Vector4f p[16];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                Vector4f* pc = &p[c * 4];
+                pc[0] = Load(parent[0] + c * 4);
+                pc[1] = Load(parent[1] + c * 4);
+                pc[2] = Load(parent[2] + c * 4);
+                pc[3] = Load(parent[3] + c * 4);
+                Transpose(pc[0], pc[1], pc[2], pc[3]);
+            }
+
+            MulParentColumn(p, p[8], p[9], p[10], p[11], &local[0], &world[0]);
+            MulParentColumn(p, p[8], p[9], p[10], p[11], &local[4], &world[4]);
+            MulParentColumn(p, p[8], p[9], p[10], p[11], &local[8], &world[8]);
+            if (collection->m_ScaleAlongZ)
+            {
+                MulParentColumn(p, p[8], p[9], p[10], p[11], &local[12], &world[12]);
+            }
+            else
+            {
+                // See dmTransform::MulNoScaleZ, the translation is not scaled along z.
+                // The z axis of a parent is normalized, unless it has zero length
+                Vector4f z_mag_sqr = Add(Add(Add(Mul(p[8], p[8]), Mul(p[9], p[9])), Mul(p[10], p[10])), Mul(p[11], p[11]));
+                Vector4f inv_z_mag = Div(Splat(1.0f), Sqrt(z_mag_sqr));
+                Vector4f no_z = Neg(z_mag_sqr);
+                Vector4f p20 = Select(no_z, p[8], Mul(p[8], inv_z_mag));
+                Vector4f p21 = Select(no_z, p[9], Mul(p[9], inv_z_mag));
+                Vector4f p22 = Select(no_z, p[10], Mul(p[10], inv_z_mag));
+                Vector4f p23 = Select(no_z, p[11], Mul(p[11], inv_z_mag));
+                MulParentColumn(p, p20, p21, p22, p23, &local[12], &world[12]);
+            }
+        }
 
-        // Calculate world transforms
-        // First root-level instances
-        dmArray<uint16_t>& root_level = collection->m_LevelIndices[0];
-        uint32_t root_count = root_level.Size();
-        for (uint32_t i = 0; i < root_count; ++i)
+        for (uint32_t c = 0; c < 4; ++c)
         {
-            uint16_t index = root_level[i];
-            Instance* instance = collection->m_Instances[index];
-            CheckEuler(instance);
-            collection->m_WorldTransforms[index] = dmTransform::ToMatrix4(instance->m_Transform);
-            uint16_t parent_index = instance->m_Parent;
-            assert(parent_index == INVALID_INSTANCE_INDEX);
+            Vector4f* wc = &world[c * 4];
+            Transpose(wc[0], wc[1], wc[2], wc[3]);
         }
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            if ((lane_mask >> lane) & 1)
+            {
+                float* w = world_transforms + indices[lane] * 16;
+                Store(w + 0, world[0*4 + lane]);
+                Store(w + 4, world[1*4 + lane]);
+                Store(w + 8, world[2*4 + lane]);
+                Store(w + 12, world[3*4 + lane]);
+            }
+        }
+    }
 
+    // Calculates the world transforms in range [begin, end) of a hierarchy level, four at a time.
+    // Only instances with a dirty local transform or a changed parent world transform are recalculated, and only
+    // instances with a dirty local transform are read from m_Instances, to update their place in the level stream.
+    template <typename T>
+    static void UpdateLevelTransforms(Collection* collection, uint32_t level_i, uint32_t begin, uint32_t end)
+    {
+        assert((begin & 3) == 0);
+        const T* level = CollectionIndexArrays<T>::LevelIndices(collection)[level_i].Begin();
+        const T* parents = CollectionIndexArrays<T>::LevelParentIndices(collection)[level_i].Begin();
+        float* locals = collection->m_LevelLocalTransforms[level_i].Begin();
+        uint8_t* dirty = collection->m_LocalTransformDirty.Begin();
+        uint8_t* changed = collection->m_WorldTransformChanged.Begin();
+        bool root_level = level_i == 0;
 
-        if (collection->m_ScaleAlongZ) {
-            for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+        for (uint32_t group_start = begin; group_start < end; group_start += 4)
+        {
+            float* group = locals + (group_start / 4) * TRANSFORM_SOA_STRIDE;
+            uint32_t lane_count = dmMath::Min(4u, end - group_start);
+            uint32_t lane_mask = 0;
+            for (uint32_t lane = 0; lane < lane_count; ++lane)
             {
-                dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-                uint32_t instance_count = level.Size();
-                for (uint32_t i = 0; i < instance_count; ++i)
+                uint32_t i = group_start + lane;
+                InstanceIndex index = level[i];
+                bool c = dirty[index] != 0;
+                if (c)
                 {
-                    uint16_t index = level[i];
                     Instance* instance = collection->m_Instances[index];
+                    // NOTE: The euler rotation might have been set through a property pointer
                     CheckEuler(instance);
-                    Matrix4* trans = &collection->m_WorldTransforms[index];
-
-                    uint16_t parent_index = instance->m_Parent;
-                    assert(parent_index != INVALID_INSTANCE_INDEX);
-
-                    Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
-                    Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
-                    *trans = *parent_trans * own;
+                    PackLocalTransform(group, lane, instance->m_Transform);
+                    dirty[index] = 0;
+                }
+                if (!root_level)
+                {
+                    c |= changed[parents[i]] != 0;
                 }
+                changed[index] = c;
+                lane_mask |= (uint32_t) c << lane;
             }
-        } else {
-            for (uint32_t level_i = 1; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+
+            if (lane_mask != 0)
             {
-                dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-                uint32_t instance_count = level.Size();
-                for (uint32_t i = 0; i < instance_count; ++i)
-                {
-                    uint16_t index = level[i];
-                    Instance* instance = collection->m_Instances[index];
-                    CheckEuler(instance);
-                    Matrix4* trans = &collection->m_WorldTransforms[index];
+                CalcGroupWorldTransforms<T>(collection, group, level + group_start, root_level ? 0 : parents + group_start, lane_mask);
+            }
+        }
+    }
 
-                    uint16_t parent_index = instance->m_Parent;
-                    assert(parent_index != INVALID_INSTANCE_INDEX);
+    struct UpdateLevelTransformsContext
+    {
+        Collection* m_Collection;
+        uint32_t    m_Level;
+    };
 
-                    Matrix4* parent_trans = &collection->m_WorldTransforms[parent_index];
-                    Matrix4 own = dmTransform::ToMatrix4(instance->m_Transform);
-                    *trans = dmTransform::MulNoScaleZ(*parent_trans, own);
-                }
+    static void UpdateLevelTransformsRange(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        UpdateLevelTransformsContext* ctx = (UpdateLevelTransformsContext*) _ctx;
+        if (ctx->m_Collection->m_WideIndices)
+            UpdateLevelTransforms<uint32_t>(ctx->m_Collection, ctx->m_Level, begin, end);
+        else
+            UpdateLevelTransforms<uint16_t>(ctx->m_Collection, ctx->m_Level, begin, end);
+    }
+
+    void UpdateTransforms(Collection* collection)
+    {
+        DM_PROFILE(GameObject, "UpdateTransforms");
+
+        // Calculate world transforms, level by level starting with the root-level instances
+        // Instances within a level only depend on the previous level, so each level may be split across the worker pool
+        dmWorkerPool::HWorkerPool pool = collection->m_Register->m_WorkerPool;
+        for (uint32_t level_i = 0; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
+        {
+            uint32_t instance_count = GetLevelSize(collection, level_i);
+            if (instance_count == 0)
+            {
+                // Every instance below this level would need a parent in this level
+                break;
             }
+
+            UpdateLevelTransformsContext ctx;
+            ctx.m_Collection = collection;
+            ctx.m_Level = level_i;
+            dmWorkerPool::ParallelFor(pool, instance_count, TRANSFORM_UPDATE_BATCH_SIZE, UpdateLevelTransformsRange, &ctx);
         }
 
         collection->m_DirtyTransforms = false;
@@ -2420,10 +2699,129 @@ namespace dmGameObject
         UpdateTransforms(hcollection->m_Collection);
     }
 
+    static bool CallComponentsUpdate(Collection* collection, const UpdateContext* update_context, uint16_t update_index, bool* transforms_updated)
+    {
+        ComponentType* component_type = &collection->m_Register->m_ComponentTypes[update_index];
+        DM_PROFILE_DYN(GameObject, component_type->m_Name, component_type->m_NameHash);
+        ComponentsUpdateParams params;
+        params.m_Collection = collection->m_HCollection;
+        params.m_UpdateContext = update_context;
+        params.m_World = collection->m_ComponentWorlds[update_index];
+        params.m_Context = component_type->m_Context;
+
+        ComponentsUpdateResult update_result;
+        update_result.m_TransformsUpdated = false;
+        UpdateResult res = component_type->m_UpdateFunction(params, update_result);
+        *transforms_updated = update_result.m_TransformsUpdated;
+        return res == UPDATE_RESULT_OK;
+    }
+
+    // Returns true if the component type can be updated concurrently with a group of component types with the accumulated access
+    static bool IsUpdateAccessCompatible(uint32_t group_access, bool group_reads_transforms, const ComponentType* component_type)
+    {
+        uint32_t access = component_type->m_UpdateAccess;
+        if (!(access & COMPONENT_UPDATE_ACCESS_CONCURRENT))
+            return false;
+        if ((group_access & COMPONENT_UPDATE_ACCESS_WRITES_TRANSFORMS) && (component_type->m_ReadsTransforms || (access & COMPONENT_UPDATE_ACCESS_WRITES_TRANSFORMS)))
+            return false;
+        if ((access & COMPONENT_UPDATE_ACCESS_WRITES_TRANSFORMS) && group_reads_transforms)
+            return false;
+        if (group_access & access & COMPONENT_UPDATE_ACCESS_PHYSICS)
+            return false;
+        return true;
+    }
+
+    uint32_t GetConcurrentUpdateGroupEnd(HRegister regist, uint32_t begin)
+    {
+        uint32_t group_access = 0;
+        bool group_reads_transforms = false;
+        uint32_t update_count = 0;
+        uint32_t end = begin;
+        for (; end < regist->m_ComponentTypeCount; ++end)
+        {
+            const ComponentType* component_type = &regist->m_ComponentTypes[regist->m_ComponentTypesOrder[end]];
+            if (!component_type->m_UpdateFunction)
+            {
+                if (end == begin)
+                    break;
+                continue;
+            }
+            if (!IsUpdateAccessCompatible(group_access, group_reads_transforms, component_type))
+                break;
+            group_access |= component_type->m_UpdateAccess;
+            group_reads_transforms |= component_type->m_ReadsTransforms != 0;
+            ++update_count;
+            // A component type posting messages ends the group, since its messages are dispatched before the next component type is updated
+            if (component_type->m_UpdateAccess & COMPONENT_UPDATE_ACCESS_POSTS_MESSAGES)
+            {
+                ++end;
+                break;
+            }
+        }
+        return update_count > 1 ? end : begin + 1;
+    }
+
+    struct ConcurrentUpdateContext
+    {
+        Collection*          m_Collection;
+        const UpdateContext* m_UpdateContext;
+        uint16_t             m_UpdateIndices[MAX_COMPONENT_TYPES];
+        bool                 m_Results[MAX_COMPONENT_TYPES];
+        bool                 m_TransformsUpdated[MAX_COMPONENT_TYPES];
+    };
+
+    static void ConcurrentUpdateRange(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        ConcurrentUpdateContext* ctx = (ConcurrentUpdateContext*) _ctx;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            ctx->m_Results[i] = CallComponentsUpdate(ctx->m_Collection, ctx->m_UpdateContext, ctx->m_UpdateIndices[i], &ctx->m_TransformsUpdated[i]);
+        }
+    }
+
+    // Updates the component types in [begin, end) of the update order concurrently on the worker pool
+    static bool UpdateConcurrentGroup(Collection* collection, const UpdateContext* update_context, uint32_t begin, uint32_t end)
+    {
+        DM_PROFILE(GameObject, "ConcurrentUpdate");
+        Register* regist = collection->m_Register;
+
+        ConcurrentUpdateContext ctx;
+        ctx.m_Collection = collection;
+        ctx.m_UpdateContext = update_context;
+        uint32_t count = 0;
+        bool reads_transforms = false;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            uint16_t update_index = regist->m_ComponentTypesOrder[i];
+            ComponentType* component_type = &regist->m_ComponentTypes[update_index];
+            DM_COUNTER_DYN(regist->m_ComponentProfileCounterIndex[update_index], collection->m_ComponentInstanceCount[update_index]);
+            if (component_type->m_UpdateFunction)
+            {
+                reads_transforms |= component_type->m_ReadsTransforms != 0;
+                ctx.m_UpdateIndices[count++] = update_index;
+            }
+        }
+
+        // The transforms are not written by any component type in the group if any of them reads transforms
+        if (reads_transforms && collection->m_DirtyTransforms) {
+            UpdateTransforms(collection);
+        }
+
+        dmWorkerPool::ParallelFor(regist->m_WorkerPool, count, 1, ConcurrentUpdateRange, &ctx);
+
+        bool ret = true;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ret &= ctx.m_Results[i];
+            collection->m_DirtyTransforms |= ctx.m_TransformsUpdated[i];
+        }
+        return ret;
+    }
+
     static bool Update(Collection* collection, const UpdateContext* update_context)
     {
         DM_PROFILE(GameObject, "Update");
-        DM_COUNTER("Instances", collection->m_InstanceIndices.Size());
+        DM_COUNTER("Instances", GetInstanceCount(collection));
 
         assert(collection != 0x0);
 
@@ -2434,37 +2832,44 @@ namespace dmGameObject
 
         bool ret = true;
 
+        // Consecutive component types with compatible declared access are grouped and updated concurrently when there is a worker pool.
+        // The messages of a group are dispatched after the whole group. Only the last component type of a group may post messages,
+        // so the messages are dispatched in the same order, and before the same component types are updated, as when updated one by one.
+        bool concurrent = dmWorkerPool::GetWorkerCount(collection->m_Register->m_WorkerPool) > 0;
         uint32_t component_types = collection->m_Register->m_ComponentTypeCount;
-        for (uint32_t i = 0; i < component_types; ++i)
+        uint32_t i = 0;
+        while (i < component_types)
         {
-            uint16_t update_index = collection->m_Register->m_ComponentTypesOrder[i];
-            ComponentType* component_type = &collection->m_Register->m_ComponentTypes[update_index];
-
-            DM_COUNTER_DYN(collection->m_Register->m_ComponentProfileCounterIndex[update_index], collection->m_ComponentInstanceCount[update_index]);
-
-            // Avoid to call UpdateTransforms for each/all component types.
-            if (component_type->m_ReadsTransforms && collection->m_DirtyTransforms) {
-                UpdateTransforms(collection);
+            uint32_t group_end = concurrent ? GetConcurrentUpdateGroupEnd(collection->m_Register, i) : i + 1;
+            if (group_end - i > 1)
+            {
+                if (!UpdateConcurrentGroup(collection, update_context, i, group_end))
+                    ret = false;
+                i = group_end;
             }
-
-            if (component_type->m_UpdateFunction)
+            else
             {
-                DM_PROFILE_DYN(GameObject, component_type->m_Name, component_type->m_NameHash);
-                ComponentsUpdateParams params;
-                params.m_Collection = collection->m_HCollection;
-                params.m_UpdateContext = update_context;
-                params.m_World = collection->m_ComponentWorlds[update_index];
-                params.m_Context = component_type->m_Context;
+                uint16_t update_index = collection->m_Register->m_ComponentTypesOrder[i];
+                ComponentType* component_type = &collection->m_Register->m_ComponentTypes[update_index];
 
-                ComponentsUpdateResult update_result;
-                update_result.m_TransformsUpdated = false;
-                UpdateResult res = component_type->m_UpdateFunction(params, update_result);
-                if (res != UPDATE_RESULT_OK)
-                    ret = false;
+                DM_COUNTER_DYN(collection->m_Register->m_ComponentProfileCounterIndex[update_index], collection->m_ComponentInstanceCount[update_index]);
+
+                // Avoid to call UpdateTransforms for each/all component types.
+                if (component_type->m_ReadsTransforms && collection->m_DirtyTransforms) {
+                    UpdateTransforms(collection);
+                }
+
+                if (component_type->m_UpdateFunction)
+                {
+                    bool transforms_updated;
+                    if (!CallComponentsUpdate(collection, update_context, update_index, &transforms_updated))
+                        ret = false;
 
-                // Mark the collections transforms as dirty if this component has updated
-                // them in its update function.
-                collection->m_DirtyTransforms |= update_result.m_TransformsUpdated;
+                    // Mark the collections transforms as dirty if this component has updated
+                    // them in its update function.
+                    collection->m_DirtyTransforms |= transforms_updated;
+                }
+                ++i;
             }
 
             if (!DispatchMessages(collection, &collection->m_ComponentSocket, 1))
@@ -2563,22 +2968,22 @@ namespace dmGameObject
             while (collection->m_InstancesToDeleteHead != INVALID_INSTANCE_INDEX && pass_count < max_pass_count) {
                 ++pass_count;
                 // Save the list and clear the head and tail
-                uint16_t head = collection->m_InstancesToDeleteHead;
+                InstanceIndex head = collection->m_InstancesToDeleteHead;
                 collection->m_InstancesToDeleteHead = INVALID_INSTANCE_INDEX;
                 collection->m_InstancesToDeleteTail = INVALID_INSTANCE_INDEX;
 
-                uint16_t index = head;
+                InstanceIndex index = head;
                 while (index != INVALID_INSTANCE_INDEX) {
                     Instance* instance = collection->m_Instances[index];
 
-                    assert(collection->m_Instances[instance->m_Index] == instance);
+                    assert(collection->m_Instances[GetIndex(instance)] == instance);
                     assert(instance->m_ToBeDeleted);
                     if (instance->m_Initialized) {
                         if (!FinalInstance(collection, instance) && result) {
                             result = false;
                         }
                     }
-                    index = instance->m_NextToDelete;
+                    index = GetNextToDelete(instance);
                 }
 
                 if (!DispatchAllSockets(collection)) {
@@ -2590,9 +2995,9 @@ namespace dmGameObject
                 while (index != INVALID_INSTANCE_INDEX) {
                     Instance* instance = collection->m_Instances[index];
 
-                    assert(collection->m_Instances[instance->m_Index] == instance);
+                    assert(collection->m_Instances[GetIndex(instance)] == instance);
                     assert(instance->m_ToBeDeleted);
-                    index = instance->m_NextToDelete;
+                    index = GetNextToDelete(instance);
                     DoDeleteInstance(collection, instance);
                     ++instances_deleted;
                 }
@@ -2809,6 +3214,7 @@ namespace dmGameObject
     void SetPosition(HInstance instance, Point3 position)
     {
         instance->m_Transform.SetTranslation(Vector3(position));
+        SetLocalTransformDirty(instance);
     }
 
     Point3 GetPosition(HInstance instance)
@@ -2819,6 +3225,7 @@ namespace dmGameObject
     void SetRotation(HInstance instance, Quat rotation)
     {
         instance->m_Transform.SetRotation(rotation);
+        SetLocalTransformDirty(instance);
     }
 
     Quat GetRotation(HInstance instance)
@@ -2829,11 +3236,13 @@ namespace dmGameObject
     void SetScale(HInstance instance, float scale)
     {
         instance->m_Transform.SetUniformScale(scale);
+        SetLocalTransformDirty(instance);
     }
 
     void SetScale(HInstance instance, Vector3 scale)
     {
         instance->m_Transform.SetScale(scale);
+        SetLocalTransformDirty(instance);
     }
 
     float GetUniformScale(HInstance instance)
@@ -2848,13 +3257,13 @@ namespace dmGameObject
 
     Point3 GetWorldPosition(HInstance instance)
     {
-        Vector4 translation = instance->m_Collection->m_WorldTransforms[instance->m_Index].getCol(3);
+        Vector4 translation = instance->m_Collection->m_WorldTransforms[GetIndex(instance)].getCol(3);
         return Point3(translation.getX(), translation.getY(), translation.getZ());
     }
 
     Quat GetWorldRotation(HInstance instance)
     {
-        Matrix4 world_transform = instance->m_Collection->m_WorldTransforms[instance->m_Index];
+        Matrix4 world_transform = instance->m_Collection->m_WorldTransforms[GetIndex(instance)];
         dmTransform::ResetScale(&world_transform);
         return Quat(world_transform.getUpper3x3());
     }
@@ -2867,7 +3276,7 @@ namespace dmGameObject
 
     Vector3 GetWorldScale(HInstance instance)
     {
-        return dmTransform::ExtractScale(instance->m_Collection->m_WorldTransforms[instance->m_Index]);
+        return dmTransform::ExtractScale(instance->m_Collection->m_WorldTransforms[GetIndex(instance)]);
     }
 
     /*
@@ -2876,18 +3285,18 @@ namespace dmGameObject
     */
     const dmTransform::Transform GetWorldTransform(HInstance instance)
     {
-        Matrix4 mtx = instance->m_Collection->m_WorldTransforms[instance->m_Index];
+        Matrix4 mtx = instance->m_Collection->m_WorldTransforms[GetIndex(instance)];
         return dmTransform::ToTransform(mtx);
     }
 
     const Matrix4 & GetWorldMatrix(HInstance instance)
     {
-        return instance->m_Collection->m_WorldTransforms[instance->m_Index];
+        return instance->m_Collection->m_WorldTransforms[GetIndex(instance)];
     }
 
     Result SetParent(HInstance child, HInstance parent)
     {
-        if (parent == 0 && child->m_Parent == INVALID_INSTANCE_INDEX)
+        if (parent == 0 && GetParentIndex(child) == INVALID_INSTANCE_INDEX)
             return RESULT_OK;
 
         if (parent != 0 && parent->m_Depth >= MAX_HIERARCHICAL_DEPTH-1)
@@ -2900,7 +3309,7 @@ namespace dmGameObject
 
         if (parent != 0)
         {
-            uint32_t index = parent->m_Index;
+            uint32_t index = GetIndex(parent);
             while (index != INVALID_INSTANCE_INDEX)
             {
                 Instance* i = collection->m_Instances[index];
@@ -2911,17 +3320,17 @@ namespace dmGameObject
                     return RESULT_INVALID_OPERATION;
 
                 }
-                index = i->m_Parent;
+                index = GetParentIndex(i);
             }
             assert(child->m_Collection == parent->m_Collection);
-            assert(collection->m_LevelIndices[child->m_Depth+1].Size() < collection->m_MaxInstances);
+            assert(GetLevelSize(collection, child->m_Depth+1) < collection->m_MaxInstances);
         }
         else
         {
-            assert(collection->m_LevelIndices[0].Size() < collection->m_MaxInstances);
+            assert(GetLevelSize(collection, 0) < collection->m_MaxInstances);
         }
 
-        if (child->m_Parent != INVALID_INSTANCE_INDEX)
+        if (GetParentIndex(child) != INVALID_INSTANCE_INDEX)
         {
             Unlink(collection, child);
         }
@@ -2931,29 +3340,29 @@ namespace dmGameObject
         // Add child to parent
         if (parent != 0)
         {
-            if (parent->m_FirstChildIndex == INVALID_INSTANCE_INDEX)
+            if (GetFirstChildIndex(parent) == INVALID_INSTANCE_INDEX)
             {
-                parent->m_FirstChildIndex = child->m_Index;
+                SetFirstChildIndex(parent, GetIndex(child));
             }
             else
             {
-                Instance* first_child = collection->m_Instances[parent->m_FirstChildIndex];
+                Instance* first_child = collection->m_Instances[GetFirstChildIndex(parent)];
                 assert(parent->m_Depth == first_child->m_Depth - 1);
 
-                child->m_SiblingIndex = first_child->m_Index;
-                parent->m_FirstChildIndex = child->m_Index;
+                SetSiblingIndex(child, GetIndex(first_child));
+                SetFirstChildIndex(parent, GetIndex(child));
             }
         }
 
         int original_child_depth = child->m_Depth;
         if (parent != 0)
         {
-            child->m_Parent = parent->m_Index;
+            SetParentIndex(child, GetIndex(parent));
             child->m_Depth = parent->m_Depth + 1;
         }
         else
         {
-            child->m_Parent = INVALID_INSTANCE_INDEX;
+            SetParentIndex(child, INVALID_INSTANCE_INDEX);
             child->m_Depth = 0;
         }
         InsertInstanceInLevelIndex(collection, child);
@@ -2979,13 +3388,13 @@ namespace dmGameObject
 
     HInstance GetParent(HInstance instance)
     {
-        if (instance->m_Parent == INVALID_INSTANCE_INDEX)
+        if (GetParentIndex(instance) == INVALID_INSTANCE_INDEX)
         {
             return 0;
         }
         else
         {
-            return instance->m_Collection->m_Instances[instance->m_Parent];
+            return instance->m_Collection->m_Instances[GetParentIndex(instance)];
         }
     }
 
@@ -2998,11 +3407,11 @@ namespace dmGameObject
     {
         Collection* collection = instance->m_Collection;
         uint32_t count = 0;
-        uint32_t index = instance->m_FirstChildIndex;
+        uint32_t index = GetFirstChildIndex(instance);
         while (index != INVALID_INSTANCE_INDEX)
         {
             ++count;
-            index = collection->m_Instances[index]->m_SiblingIndex;
+            index = GetSiblingIndex(collection->m_Instances[index]);
         }
 
         return count;
@@ -3011,13 +3420,13 @@ namespace dmGameObject
     bool IsChildOf(HInstance child, HInstance parent)
     {
         Collection* collection = parent->m_Collection;
-        uint32_t index = parent->m_FirstChildIndex;
+        uint32_t index = GetFirstChildIndex(parent);
         while (index != INVALID_INSTANCE_INDEX)
         {
             Instance*i = collection->m_Instances[index];
             if (i == child)
                 return true;
-            index = collection->m_Instances[index]->m_SiblingIndex;
+            index = GetSiblingIndex(collection->m_Instances[index]);
         }
 
         return false;
@@ -3222,6 +3631,7 @@ namespace dmGameObject
             return PROPERTY_RESULT_INVALID_INSTANCE;
         if (component_id == 0)
         {
+            SetLocalTransformDirty(instance);
             float* position = instance->m_Transform.GetPositionPtr();
             float* rotation = instance->m_Transform.GetRotationPtr();
             float* scale = instance->m_Transform.GetScalePtr();
@@ -3418,24 +3828,24 @@ namespace dmGameObject
     //  - patch data structures for identification and input stack
     //  - copy the rest of the fields
     // The old instance is destroyed.
-    static void RecreateInstance(Collection* collection, uint16_t index, Prototype* old_proto, Prototype* new_proto, const char* new_proto_name) {
+    static void RecreateInstance(Collection* collection, InstanceIndex index, Prototype* old_proto, Prototype* new_proto, const char* new_proto_name) {
         HInstance instance = collection->m_Instances[index];
         // We don't support recreating instances that are 'transitioning'
         assert(instance->m_ToBeAdded == 0);
         assert(instance->m_ToBeDeleted == 0);
-        HInstance new_instance = AllocInstance(new_proto, new_proto_name);
+        HInstance new_instance = AllocInstance(new_proto, new_proto_name, collection->m_WideIndices);
         if (!new_instance) {
             return;
         }
         new_instance->m_Collection = instance->m_Collection;
         // hierarchy-related
-        new_instance->m_Index = instance->m_Index;
-        new_instance->m_LevelIndex = instance->m_LevelIndex;
+        SetIndex(new_instance, GetIndex(instance));
+        SetLevelIndex(new_instance, GetLevelIndex(instance));
         new_instance->m_Depth = instance->m_Depth;
         new_instance->m_Bone = instance->m_Bone;
-        new_instance->m_Parent = instance->m_Parent;
-        new_instance->m_FirstChildIndex = instance->m_FirstChildIndex;
-        new_instance->m_SiblingIndex = instance->m_SiblingIndex;
+        SetParentIndex(new_instance, GetParentIndex(instance));
+        SetFirstChildIndex(new_instance, GetFirstChildIndex(instance));
+        SetSiblingIndex(new_instance, GetSiblingIndex(instance));
         // transform-related
         new_instance->m_Transform = instance->m_Transform;
         new_instance->m_EulerRotation = instance->m_EulerRotation;
@@ -3485,11 +3895,10 @@ namespace dmGameObject
         Collection* collection = (Collection*) params.m_UserData;
         for (uint32_t level_i = 0; level_i < MAX_HIERARCHICAL_DEPTH; ++level_i)
         {
-            dmArray<uint16_t>& level = collection->m_LevelIndices[level_i];
-            uint32_t instance_count = level.Size();
+            uint32_t instance_count = GetLevelSize(collection, level_i);
             for (uint32_t i = 0; i < instance_count; ++i)
             {
-                uint16_t index = level[i];
+                InstanceIndex index = GetLevelInstanceIndex(collection, level_i, i);
                 Instance* instance = collection->m_Instances[index];
                 if (instance->m_Prototype == params.m_Resource->m_Resource) {
                     RecreateInstance(collection, index, (Prototype*)params.m_Resource->m_PrevResource, (Prototype*)params.m_Resource->m_Resource, params.m_Name);
@@ -3532,9 +3941,9 @@ namespace dmGameObject
     {
         Collection* collection = hcollection->m_Collection;
         uint32_t count = 0;
-        uint16_t index = collection->m_InstancesToAddHead;
+        InstanceIndex index = collection->m_InstancesToAddHead;
         while (index != INVALID_INSTANCE_INDEX) {
-            index = collection->m_Instances[index]->m_NextToAdd;
+            index = GetNextToAdd(collection->m_Instances[index]);
             ++count;
         }
         return count;
@@ -3544,9 +3953,9 @@ namespace dmGameObject
     {
         Collection* collection = hcollection->m_Collection;
         uint32_t count = 0;
-        uint16_t index = collection->m_InstancesToDeleteHead;
+        InstanceIndex index = collection->m_InstancesToDeleteHead;
         while (index != INVALID_INSTANCE_INDEX) {
-            index = collection->m_Instances[index]->m_NextToDelete;
+            index = GetNextToDelete(collection->m_Instances[index]);
             ++count;
         }
         return count;
@@ -21,6 +21,7 @@
 #include <dlib/hashtable.h>
 #include <dlib/message.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include <ddf/ddf.h>
 
@@ -50,6 +51,9 @@ namespace dmGameObject
     /// Config key to use for tweaking the maximum capacity of the input stack
     extern const char* COLLECTION_MAX_INPUT_STACK_ENTRIES_KEY;
 
+    /// Config key to use for allowing more than 32767 instances in a collection
+    extern const char* COLLECTION_WIDE_INDICES_KEY;
+
     /// Instance handle
     typedef struct Instance* HInstance;
 
@@ -662,6 +666,24 @@ namespace dmGameObject
      */
     typedef PropertyResult (*ComponentSetProperty)(const ComponentSetPropertyParams& params);
 
+    /**
+     * Declared access of the update function of a component type, see ComponentType::m_UpdateAccess.
+     * Used for scheduling the update functions of independent component types concurrently.
+     */
+    enum ComponentUpdateAccess
+    {
+        /// The update function writes game object transforms (see ComponentsUpdateResult::m_TransformsUpdated)
+        COMPONENT_UPDATE_ACCESS_WRITES_TRANSFORMS   = 1 << 0,
+        /// The update function posts messages that are dispatched during the collection update (e.g. to components or scripts)
+        COMPONENT_UPDATE_ACCESS_POSTS_MESSAGES      = 1 << 1,
+        /// The update function accesses the physics world
+        COMPONENT_UPDATE_ACCESS_PHYSICS             = 1 << 2,
+        /// The update function may run on a worker thread, concurrently with the update functions of other
+        /// component types with this flag. Only set this if the update function accesses nothing but its own
+        /// component world and what is declared (by m_ReadsTransforms and the flags above), and never calls into Lua.
+        COMPONENT_UPDATE_ACCESS_CONCURRENT          = 1 << 3,
+    };
+
     /**
      * Collection of component registration data.
      */
@@ -692,7 +714,9 @@ namespace dmGameObject
         ComponentSetProperty    m_SetPropertyFunction;
         uint32_t                m_InstanceHasUserData : 1;
         uint32_t                m_ReadsTransforms : 1;
-        uint32_t                m_Reserved : 30;
+        /// Bitmask of ComponentUpdateAccess
+        uint32_t                m_UpdateAccess : 4;
+        uint32_t                m_Reserved : 26;
         uint16_t                m_UpdateOrderPrio;
     };
 
@@ -712,11 +736,20 @@ namespace dmGameObject
     /**
      * Set default capacity of collections in this register. This does not affect existing collections.
      * @param regist Register
-     * @param capacity Default capacity of collections in this register (0-32766).
+     * @param capacity Default capacity of collections in this register (0-32767, or up to 16777215 with wide indices enabled).
      * @return RESULT_OK on success or RESULT_INVALID_OPERATION if max_count is not within range
      */
     Result SetCollectionDefaultCapacity(HRegister regist, uint32_t capacity);
 
+    /**
+     * Enable wide indices, i.e. allow collections with more than 32767 instances in this register.
+     * Must be set before the default capacity of collections is set.
+     * Only collections with a capacity above 32767 use the wider (32-bit) instance indices.
+     * @param regist Register
+     * @param enable true to allow up to 16777215 instances per collection
+     */
+    void SetCollectionWideIndices(HRegister regist, bool enable);
+
     /**
      * Get default capacity of collections in this register.
      * @param regist Register
@@ -731,6 +764,14 @@ namespace dmGameObject
      */
     void SetInputStackDefaultCapacity(HRegister regist, uint32_t capacity);
 
+    /**
+     * Set the worker pool used for updating the transforms of large hierarchy levels in parallel.
+     * The pool must outlive the register, or be reset to 0 before it is deleted.
+     * @param regist Register
+     * @param pool Worker pool, or 0 to update all transforms on the calling thread
+     */
+    void SetWorkerPool(HRegister regist, dmWorkerPool::HWorkerPool pool);
+
     /**
      * Delete a component type register
      * @param regist Register to delete
@@ -19,6 +19,7 @@
 #include <dlib/math.h>
 #include <dlib/mutex.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include "gameobject.h"
 #include "gameobject_props.h"
@@ -82,10 +83,32 @@ namespace dmGameObject
         dmArray<void*> m_PropertyResources;
     };
 
-    // Invalid instance index. Implies that maximum number of instances is 32766 (ie 0x7fff - 1)
-    const uint32_t INVALID_INSTANCE_INDEX = 0x7fff;
+    // Index to Collection::m_Instances
+    typedef uint32_t InstanceIndex;
+
+    // Invalid instance index, as returned by the index accessors below
+    const uint32_t INVALID_INSTANCE_INDEX = 0xffffffff;
+    // Invalid instance index in the 15-bit index fields of Instance. Implies that maximum number of instances is 32766 (ie 0x7fff - 1)
+    const uint32_t INVALID_COMPACT_INSTANCE_INDEX = 0x7fff;
+    // Maximum number of instances in a collection with the 15-bit index fields of Instance
+    const uint32_t MAX_COMPACT_INSTANCES = 0x7fff;
+    // Maximum number of instances in a collection with wide indices, see SetCollectionWideIndices()
+    const uint32_t MAX_WIDE_INSTANCES = 0xffffff;
+
+    // Indices of an instance in a collection with more than MAX_COMPACT_INSTANCES instances. These don't fit the
+    // index fields of Instance and are stored after the component instance user data instead, see GetWideIndices()
+    struct InstanceWideIndices
+    {
+        InstanceIndex   m_Parent;
+        InstanceIndex   m_Index;
+        InstanceIndex   m_LevelIndex;
+        InstanceIndex   m_NextToDelete;
+        InstanceIndex   m_NextToAdd;
+        InstanceIndex   m_SiblingIndex;
+        InstanceIndex   m_FirstChildIndex;
+    };
 
-    // NOTE: Actual size of Instance is sizeof(Instance) + sizeof(uintptr_t) * m_UserDataCount
+    // NOTE: Actual size of Instance is sizeof(Instance) + sizeof(uintptr_t) * m_UserDataCount, plus sizeof(InstanceWideIndices) if m_WideIndices is set
     struct Instance
     {
         Instance(Prototype* prototype)
@@ -103,13 +126,14 @@ namespace dmGameObject
             m_ScaleAlongZ = 0;
             m_Bone = 0;
             m_Generated = 0;
-            m_Parent = INVALID_INSTANCE_INDEX;
-            m_Index = INVALID_INSTANCE_INDEX;
-            m_LevelIndex = INVALID_INSTANCE_INDEX;
-            m_SiblingIndex = INVALID_INSTANCE_INDEX;
-            m_FirstChildIndex = INVALID_INSTANCE_INDEX;
-            m_NextToDelete = INVALID_INSTANCE_INDEX;
-            m_NextToAdd = INVALID_INSTANCE_INDEX;
+            m_WideIndices = 0;
+            m_Parent = INVALID_COMPACT_INSTANCE_INDEX;
+            m_Index = INVALID_COMPACT_INSTANCE_INDEX;
+            m_LevelIndex = INVALID_COMPACT_INSTANCE_INDEX;
+            m_SiblingIndex = INVALID_COMPACT_INSTANCE_INDEX;
+            m_FirstChildIndex = INVALID_COMPACT_INSTANCE_INDEX;
+            m_NextToDelete = INVALID_COMPACT_INSTANCE_INDEX;
+            m_NextToAdd = INVALID_COMPACT_INSTANCE_INDEX;
             m_ToBeDeleted = 0;
             m_ToBeAdded = 0;
         }
@@ -146,8 +170,12 @@ namespace dmGameObject
         uint16_t        m_Bone : 1;
         // If this is a generated instance, i.e. if the instance id is uniquely generated
         uint16_t        m_Generated : 1;
+        // If the indices are stored in InstanceWideIndices instead of the index fields below
+        uint16_t        m_WideIndices : 1;
         // Padding
-        uint16_t        m_Pad : 4;
+        uint16_t        m_Pad : 3;
+
+        // NOTE: The index fields are only valid if m_WideIndices isn't set. Use the accessors, e.g. GetIndex(), instead
 
         // Index to parent
         uint16_t        m_Parent : 16;
@@ -194,6 +222,45 @@ namespace dmGameObject
         uintptr_t       m_ComponentInstanceUserData[0];
     };
 
+    static inline InstanceWideIndices* GetWideIndices(const Instance* instance)
+    {
+        return (InstanceWideIndices*) &instance->m_ComponentInstanceUserData[instance->m_ComponentInstanceUserDataCount];
+    }
+
+    static inline InstanceIndex FromCompactIndex(uint32_t index)
+    {
+        return index == INVALID_COMPACT_INSTANCE_INDEX ? INVALID_INSTANCE_INDEX : index;
+    }
+
+    static inline uint16_t ToCompactIndex(InstanceIndex index)
+    {
+        return (uint16_t) (index == INVALID_INSTANCE_INDEX ? INVALID_COMPACT_INSTANCE_INDEX : index);
+    }
+
+    // Accessors for the index fields of Instance, for both the compact and the wide indices
+#define DM_INSTANCE_INDEX_ACCESSORS(NAME, FIELD) \
+    static inline InstanceIndex Get##NAME(const Instance* instance) \
+    { \
+        return instance->m_WideIndices ? GetWideIndices(instance)->FIELD : FromCompactIndex(instance->FIELD); \
+    } \
+    static inline void Set##NAME(Instance* instance, InstanceIndex index) \
+    { \
+        if (instance->m_WideIndices) \
+            GetWideIndices(instance)->FIELD = index; \
+        else \
+            instance->FIELD = ToCompactIndex(index); \
+    }
+
+    DM_INSTANCE_INDEX_ACCESSORS(ParentIndex, m_Parent)
+    DM_INSTANCE_INDEX_ACCESSORS(Index, m_Index)
+    DM_INSTANCE_INDEX_ACCESSORS(LevelIndex, m_LevelIndex)
+    DM_INSTANCE_INDEX_ACCESSORS(NextToDelete, m_NextToDelete)
+    DM_INSTANCE_INDEX_ACCESSORS(NextToAdd, m_NextToAdd)
+    DM_INSTANCE_INDEX_ACCESSORS(SiblingIndex, m_SiblingIndex)
+    DM_INSTANCE_INDEX_ACCESSORS(FirstChildIndex, m_FirstChildIndex)
+
+#undef DM_INSTANCE_INDEX_ACCESSORS
+
     // Max component types could not be larger than 255 since the index is stored as a uint8_t
     const uint32_t MAX_COMPONENT_TYPES = 255;
 
@@ -210,10 +277,15 @@ namespace dmGameObject
         dmArray<Collection*>        m_Collections;
         // Default capacity of collections
         uint32_t                    m_DefaultCollectionCapacity;
+        // Max capacity of collections, MAX_COMPACT_INSTANCES unless wide indices are enabled
+        uint32_t                    m_MaxCollectionCapacity;
         uint32_t                    m_DefaultInputStackCapacity;
 
         dmHashTable64<Collection*>  m_SocketToCollection;
 
+        // Optional worker pool used for updating transforms in parallel
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
+
         Register();
         ~Register();
     };
@@ -222,6 +294,10 @@ namespace dmGameObject
     // depth is interpreted as up to <depth> levels of child nodes including root-nodes
     // Must be greater than zero
     const uint32_t MAX_HIERARCHICAL_DEPTH = 128;
+    // Number of instances per batch when updating a hierarchy level in parallel. Must be a multiple of four
+    const uint32_t TRANSFORM_UPDATE_BATCH_SIZE = 256;
+    // Number of floats per group of four packed local transforms: translation (3), rotation (4) and scale (3)
+    const uint32_t TRANSFORM_SOA_STRIDE = 10 * 4;
     struct Collection
     {
         Collection(dmResource::HFactory factory, HRegister regist, uint32_t max_instances, uint32_t max_input_stack_entries);
@@ -248,8 +324,9 @@ namespace dmGameObject
         // Size if always = max_instances (at least for now)
         dmArray<Instance*>       m_Instances;
 
-        // Index pool for mapping Instance::m_Index to m_Instances
+        // Index pool for mapping Instance::m_Index to m_Instances. m_WideInstanceIndices is used instead if m_WideIndices is set
         dmIndexPool16            m_InstanceIndices;
+        dmIndexPool32            m_WideInstanceIndices;
 
         // Resources referenced through property overrides inside the collection
         dmArray<void*>         m_PropertyResources;
@@ -259,11 +336,27 @@ namespace dmGameObject
         // Two dimensional table of indices with stride "max_instances"
         // Level 0 contains root-nodes in [0..m_LevelIndices[0].Size()-1]
         // Level 1 contains level 1 indices in [0..m_LevelIndices[1].Size()-1]
+        // If m_WideIndices is set, the levels are stored in m_WideLevelIndices instead
         dmArray<uint16_t>        m_LevelIndices[MAX_HIERARCHICAL_DEPTH];
+        dmArray<uint32_t>*       m_WideLevelIndices;
 
         // Array of world transforms. Calculated using m_LevelIndices above
         dmArray<Matrix4>         m_WorldTransforms;
 
+        // Streams per level, parallel to m_LevelIndices, so that UpdateTransforms doesn't have to go through m_Instances:
+        // the parent index of each instance, and the local transforms as of the last UpdateTransforms, stored as
+        // structure of arrays in groups of four instances (TRANSFORM_SOA_STRIDE floats per group)
+        // If m_WideIndices is set, the parent indices are stored in m_WideLevelParentIndices instead
+        dmArray<uint16_t>        m_LevelParentIndices[MAX_HIERARCHICAL_DEPTH];
+        dmArray<uint32_t>*       m_WideLevelParentIndices;
+        dmArray<float>           m_LevelLocalTransforms[MAX_HIERARCHICAL_DEPTH];
+
+        // Non-zero if the local transform has been set since the last UpdateTransforms, see SetLocalTransformDirty()
+        dmArray<uint8_t>         m_LocalTransformDirty;
+
+        // Non-zero if the world transform changed during the last UpdateTransforms
+        dmArray<uint8_t>         m_WorldTransformChanged;
+
         // Identifier to Instance mapping
         dmHashTable64<Instance*> m_IDToInstance;
 
@@ -286,14 +379,14 @@ namespace dmGameObject
         dmIndexPool32            m_InstanceIdPool;
 
         // Head of linked list of instances scheduled for deferred deletion
-        uint16_t                 m_InstancesToDeleteHead;
+        InstanceIndex            m_InstancesToDeleteHead;
         // Tail of the same list, for O(1) appending
-        uint16_t                 m_InstancesToDeleteTail;
+        InstanceIndex            m_InstancesToDeleteTail;
 
         // Head of linked list of instances scheduled to be added to update
-        uint16_t                 m_InstancesToAddHead;
+        InstanceIndex            m_InstancesToAddHead;
         // Tail of the same list, for O(1) appending
-        uint16_t                 m_InstancesToAddTail;
+        InstanceIndex            m_InstancesToAddTail;
 
         // Set to 1 if in update-loop
         uint32_t                 m_InUpdate : 1;
@@ -303,8 +396,50 @@ namespace dmGameObject
         uint32_t                 m_ScaleAlongZ : 1;
         uint32_t                 m_DirtyTransforms : 1;
         uint32_t                 m_Initialized : 1;
+        // Set if the collection can hold more than MAX_COMPACT_INSTANCES instances. The instances then store their
+        // indices in InstanceWideIndices and the collection uses the 32-bit index pool and arrays
+        uint32_t                 m_WideIndices : 1;
     };
 
+    // Index arrays of a collection by index type, uint16_t for compact and uint32_t for wide indices
+    template <typename T> struct CollectionIndexArrays;
+
+    template <> struct CollectionIndexArrays<uint16_t>
+    {
+        static dmArray<uint16_t>* LevelIndices(Collection* collection)              { return collection->m_LevelIndices; }
+        static dmArray<uint16_t>* LevelParentIndices(Collection* collection)        { return collection->m_LevelParentIndices; }
+    };
+
+    template <> struct CollectionIndexArrays<uint32_t>
+    {
+        static dmArray<uint32_t>* LevelIndices(Collection* collection)              { return collection->m_WideLevelIndices; }
+        static dmArray<uint32_t>* LevelParentIndices(Collection* collection)        { return collection->m_WideLevelParentIndices; }
+    };
+
+    // Number of instances in a hierarchy level
+    static inline uint32_t GetLevelSize(const Collection* collection, uint32_t level)
+    {
+        return collection->m_WideIndices ? collection->m_WideLevelIndices[level].Size() : collection->m_LevelIndices[level].Size();
+    }
+
+    // Index to Collection::m_Instances of the i:th instance in a hierarchy level
+    static inline InstanceIndex GetLevelInstanceIndex(const Collection* collection, uint32_t level, uint32_t i)
+    {
+        return collection->m_WideIndices ? collection->m_WideLevelIndices[level][i] : collection->m_LevelIndices[level][i];
+    }
+
+    // Number of instances in the collection
+    static inline uint32_t GetInstanceCount(const Collection* collection)
+    {
+        return collection->m_WideIndices ? collection->m_WideInstanceIndices.Size() : collection->m_InstanceIndices.Size();
+    }
+
+    // Must be called when the local transform of an instance is set, for the world transform to be recalculated by the next UpdateTransforms
+    static inline void SetLocalTransformDirty(Instance* instance)
+    {
+        instance->m_Collection->m_LocalTransformDirty[GetIndex(instance)] = 1;
+    }
+
     struct CollectionHandle
     {
         Collection* m_Collection;
@@ -322,6 +457,10 @@ namespace dmGameObject
     bool CreateComponents(Collection* collection, HInstance instance);
     void Delete(Collection* collection, HInstance instance, bool recursive);
     void UpdateTransforms(Collection* collection);
+
+    // Returns the end of the group of component types, starting at "begin" in the update order, that can be updated concurrently.
+    // Returns begin + 1 if the component type at "begin" must be updated on its own.
+    uint32_t GetConcurrentUpdateGroupEnd(HRegister regist, uint32_t begin);
     void DeleteCollection(Collection* collection);
     bool IsCollectionInitialized(Collection* collection);
     Result AttachCollection(Collection* collection, const char* name, dmResource::HFactory factory, HRegister regist, HCollection hcollection);
@@ -49,12 +49,12 @@ static bool IterateGameObject(Collection* collection, HInstance instance, FGameO
     if (!callback(&iterator, user_ctx))
         return false;
 
-    uint32_t childIndex = instance->m_FirstChildIndex;
+    uint32_t childIndex = GetFirstChildIndex(instance);
     while (childIndex != INVALID_INSTANCE_INDEX)
     {
         Instance* child = collection->m_Instances[childIndex];
-        assert(child->m_Parent == instance->m_Index);
-        childIndex = child->m_SiblingIndex;
+        assert(GetParentIndex(child) == GetIndex(instance));
+        childIndex = GetSiblingIndex(child);
         if (!IterateGameObject(collection, child, callback, user_ctx))
             return false;
     }
@@ -64,10 +64,10 @@ static bool IterateGameObject(Collection* collection, HInstance instance, FGameO
 bool IterateGameObjects(HCollection hcollection, FGameObjectIterator callback, void* user_ctx)
 {
     Collection* collection = hcollection->m_Collection;
-    const dmArray<uint16_t>& root_level = collection->m_LevelIndices[0];
-    for (uint32_t j = 0; j < root_level.Size(); ++j)
+    uint32_t root_count = GetLevelSize(collection, 0);
+    for (uint32_t j = 0; j < root_count; ++j)
     {
-        if (!IterateGameObject(collection, collection->m_Instances[root_level[j]], callback, user_ctx))
+        if (!IterateGameObject(collection, collection->m_Instances[GetLevelInstanceIndex(collection, 0, j)], callback, user_ctx))
             return false;
     }
     return true;
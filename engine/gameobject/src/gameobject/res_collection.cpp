@@ -242,7 +242,10 @@ bail:
     static size_t CalcSize(Collection* collection)
     {
         size_t size = sizeof(Collection) + sizeof(CollectionHandle);
-        size += collection->m_InstanceIndices.Capacity()*sizeof(uint16_t);
+        if (collection->m_WideIndices)
+            size += collection->m_WideInstanceIndices.Capacity()*sizeof(uint32_t);
+        else
+            size += collection->m_InstanceIndices.Capacity()*sizeof(uint16_t);
         size += collection->m_WorldTransforms.Capacity()*sizeof(Matrix4);
         size += collection->m_IDToInstance.Capacity()*(sizeof(Instance*)+sizeof(dmhash_t));
         size += collection->m_InputFocusStack.Capacity()*sizeof(Instance*);
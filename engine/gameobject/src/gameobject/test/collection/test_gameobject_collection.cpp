@@ -286,6 +286,121 @@ TEST_F(CollectionTest, CollectionSpawningToFail)
     ASSERT_TRUE(true);
 }
 
+TEST_F(CollectionTest, WideIndices)
+{
+    const uint32_t max = dmGameObject::MAX_COMPACT_INSTANCES + 10;
+
+    ASSERT_EQ(dmGameObject::RESULT_INVALID_OPERATION, dmGameObject::SetCollectionDefaultCapacity(m_Register, max));
+    ASSERT_EQ((void*) 0, dmGameObject::NewCollection("TestCollection", m_Factory, m_Register, max));
+
+    dmGameObject::SetCollectionWideIndices(m_Register, true);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetCollectionDefaultCapacity(m_Register, max));
+    dmGameObject::HCollection coll = dmGameObject::NewCollection("TestCollection", m_Factory, m_Register, max);
+    ASSERT_NE((void*) 0, coll);
+    ASSERT_EQ(1u, coll->m_Collection->m_WideIndices);
+
+    // Fill the collection, so that the last instances are indexed beyond the compact limit
+    dmGameObject::HInstance parent = 0;
+    for (uint32_t i = 0; i < max; ++i)
+    {
+        dmGameObject::HInstance instance = dmGameObject::New(coll, 0x0);
+        ASSERT_NE((void*) 0, instance);
+        if (i >= max - 3)
+        {
+            dmGameObject::SetPosition(instance, Vectormath::Aos::Point3(1.0f, 0.0f, 0.0f));
+            if (parent)
+            {
+                ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(instance, parent));
+            }
+            parent = instance;
+        }
+    }
+    ASSERT_EQ((void*) 0, dmGameObject::New(coll, 0x0));
+
+    dmGameObject::UpdateTransforms(coll->m_Collection);
+    ASSERT_EQ(3.0f, dmGameObject::GetWorldPosition(parent).getX());
+
+    dmGameObject::DeleteCollection(coll);
+    dmGameObject::PostUpdate(m_Register);
+
+    dmGameObject::SetCollectionWideIndices(m_Register, false);
+    ASSERT_EQ(dmGameObject::RESULT_INVALID_OPERATION, dmGameObject::SetCollectionDefaultCapacity(m_Register, max));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetCollectionDefaultCapacity(m_Register, dmGameObject::DEFAULT_MAX_COLLECTION_CAPACITY));
+}
+
+// More instances than fit in 16 bits, to make sure no index is truncated anywhere
+TEST_F(CollectionTest, WideIndicesBeyond16Bits)
+{
+    const uint32_t max = 70000;
+    const uint32_t chain_length = 8;
+
+    dmGameObject::SetCollectionWideIndices(m_Register, true);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetCollectionDefaultCapacity(m_Register, max));
+    dmGameObject::HCollection coll = dmGameObject::NewCollection("TestCollection", m_Factory, m_Register, max);
+    ASSERT_NE((void*) 0, coll);
+
+    dmArray<dmGameObject::HInstance> instances;
+    instances.SetCapacity(max);
+    for (uint32_t i = 0; i < max; ++i)
+    {
+        dmGameObject::HInstance instance = dmGameObject::New(coll, 0x0);
+        ASSERT_NE((void*) 0, instance);
+        instances.Push(instance);
+    }
+    ASSERT_EQ((void*) 0, dmGameObject::New(coll, 0x0));
+
+    // A chain at the very end of the collection, with a root below the 16-bit limit
+    dmGameObject::HInstance root = instances[100];
+    dmGameObject::SetPosition(root, Vectormath::Aos::Point3(1.0f, 0.0f, 0.0f));
+    dmGameObject::HInstance parent = root;
+    for (uint32_t i = max - chain_length; i < max; ++i)
+    {
+        dmGameObject::HInstance instance = instances[i];
+        ASSERT_LT(0xffffu, dmGameObject::GetIndex(instance));
+        dmGameObject::SetPosition(instance, Vectormath::Aos::Point3(1.0f, 0.0f, 0.0f));
+        ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(instance, parent));
+        ASSERT_EQ(parent, dmGameObject::GetParent(instance));
+        parent = instance;
+    }
+    dmGameObject::HInstance leaf = parent;
+
+    dmGameObject::UpdateTransforms(coll->m_Collection);
+    ASSERT_EQ(1.0f + chain_length, dmGameObject::GetWorldPosition(leaf).getX());
+
+    // Reparent the tail of the chain to a root in the upper range
+    dmGameObject::HInstance new_root = instances[max - chain_length - 1];
+    dmGameObject::SetPosition(new_root, Vectormath::Aos::Point3(0.0f, 10.0f, 0.0f));
+    dmGameObject::HInstance tail = instances[max - 2];
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(tail, new_root));
+    ASSERT_EQ(new_root, dmGameObject::GetParent(tail));
+    dmGameObject::UpdateTransforms(coll->m_Collection);
+    ASSERT_EQ(2.0f, dmGameObject::GetWorldPosition(leaf).getX());
+    ASSERT_EQ(10.0f, dmGameObject::GetWorldPosition(leaf).getY());
+    ASSERT_EQ(chain_length - 1.0f, dmGameObject::GetWorldPosition(instances[max - 3]).getX());
+
+    // Delete the new sub tree and fill the freed slots again
+    dmGameObject::Delete(coll, new_root, true);
+    dmGameObject::PostUpdate(coll);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        dmGameObject::HInstance instance = dmGameObject::New(coll, 0x0);
+        ASSERT_NE((void*) 0, instance);
+        ASSERT_LT(0xffffu, dmGameObject::GetIndex(instance));
+        ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(instance, instances[max - 3]));
+        dmGameObject::SetPosition(instance, Vectormath::Aos::Point3(0.0f, 1.0f, 0.0f));
+    }
+    ASSERT_EQ((void*) 0, dmGameObject::New(coll, 0x0));
+
+    dmGameObject::UpdateTransforms(coll->m_Collection);
+    ASSERT_EQ(chain_length - 1.0f, dmGameObject::GetWorldPosition(instances[max - 3]).getX());
+
+    dmGameObject::DeleteCollection(coll);
+    dmGameObject::PostUpdate(m_Register);
+
+    dmGameObject::SetCollectionWideIndices(m_Register, false);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetCollectionDefaultCapacity(m_Register, dmGameObject::DEFAULT_MAX_COLLECTION_CAPACITY));
+}
+
 TEST_F(CollectionTest, PostCollection)
 {
     for (int i = 0; i < 10; ++i)
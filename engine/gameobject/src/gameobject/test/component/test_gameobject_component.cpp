@@ -15,6 +15,7 @@
 
 #include <map>
 
+#include <dlib/atomic.h>
 #include <dlib/dstrings.h>
 #include <dlib/hash.h>
 
@@ -533,6 +534,168 @@ TEST_F(ComponentTest, FinalCallsFinal)
     dmGameObject::PostUpdate(m_Register);
 }
 
+static dmGameObject::ComponentType* GetComponentType(dmResource::HFactory factory, dmGameObject::HRegister regist, const char* extension)
+{
+    dmResource::ResourceType resource_type;
+    if (dmResource::GetTypeFromExtension(factory, extension, &resource_type) != dmResource::RESULT_OK)
+        return 0;
+    uint32_t index;
+    return dmGameObject::FindComponentType(regist, resource_type, &index);
+}
+
+TEST_F(ComponentTest, TestConcurrentUpdateGroups)
+{
+    // Update order is c, b, a
+    dmGameObject::ComponentType* a = GetComponentType(m_Factory, m_Register, "a");
+    dmGameObject::ComponentType* b = GetComponentType(m_Factory, m_Register, "b");
+    dmGameObject::ComponentType* c = GetComponentType(m_Factory, m_Register, "c");
+    ASSERT_NE((void*) 0, a);
+    ASSERT_NE((void*) 0, b);
+    ASSERT_NE((void*) 0, c);
+
+    // Nothing declared
+    ASSERT_EQ(1u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+
+    a->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    b->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    c->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    ASSERT_EQ(3u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+    ASSERT_EQ(3u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 1));
+    // A single component type is not a group
+    ASSERT_EQ(3u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 2));
+
+    // A component type posting messages is the last one of its group
+    c->m_UpdateAccess |= dmGameObject::COMPONENT_UPDATE_ACCESS_POSTS_MESSAGES;
+    a->m_UpdateAccess |= dmGameObject::COMPONENT_UPDATE_ACCESS_POSTS_MESSAGES;
+    ASSERT_EQ(1u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+    ASSERT_EQ(3u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 1));
+    c->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    b->m_UpdateAccess |= dmGameObject::COMPONENT_UPDATE_ACCESS_POSTS_MESSAGES;
+    ASSERT_EQ(2u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+    ASSERT_EQ(3u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 2));
+
+    // At most one component type accessing physics per group
+    a->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT | dmGameObject::COMPONENT_UPDATE_ACCESS_PHYSICS;
+    b->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT | dmGameObject::COMPONENT_UPDATE_ACCESS_PHYSICS;
+    c->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    ASSERT_EQ(2u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+
+    // Transforms are not read and written within the same group
+    a->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    b->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT | dmGameObject::COMPONENT_UPDATE_ACCESS_WRITES_TRANSFORMS;
+    c->m_ReadsTransforms = 1;
+    ASSERT_EQ(1u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+    ASSERT_EQ(3u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 1));
+    a->m_UpdateAccess |= dmGameObject::COMPONENT_UPDATE_ACCESS_WRITES_TRANSFORMS;
+    ASSERT_EQ(2u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 1));
+
+    // Not declared as concurrent
+    c->m_ReadsTransforms = 0;
+    b->m_UpdateAccess = 0;
+    ASSERT_EQ(1u, dmGameObject::GetConcurrentUpdateGroupEnd(m_Register, 0));
+}
+
+static int32_atomic_t g_ConcurrentUpdateCount = 0;
+
+static dmGameObject::UpdateResult ConcurrentComponentsUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
+{
+    dmAtomicIncrement32(&g_ConcurrentUpdateCount);
+    return dmGameObject::UPDATE_RESULT_OK;
+}
+
+TEST_F(ComponentTest, TestConcurrentUpdate)
+{
+    const char* extensions[] = {"a", "b", "c"};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        dmGameObject::ComponentType* type = GetComponentType(m_Factory, m_Register, extensions[i]);
+        ASSERT_NE((void*) 0, type);
+        type->m_UpdateFunction = ConcurrentComponentsUpdate;
+        type->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    }
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(2, "test_worker");
+    dmGameObject::SetWorkerPool(m_Register, pool);
+
+    dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/go1.goc");
+    ASSERT_NE((void*) 0, (void*) go);
+    g_ConcurrentUpdateCount = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    }
+    ASSERT_EQ(300, g_ConcurrentUpdateCount);
+    dmGameObject::Delete(m_Collection, go, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+    dmGameObject::SetWorkerPool(m_Register, 0);
+    dmWorkerPool::Delete(pool);
+}
+
+static dmMessage::URL g_PostReceiver;
+static bool g_MessageDispatched = false;
+static uint32_t g_DispatchedBeforeUpdateCount = 0;
+
+static dmGameObject::UpdateResult PostingComponentsUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
+{
+    g_MessageDispatched = false;
+    dmMessage::Post(0x0, &g_PostReceiver, dmHashString64("test_message"), 0, 0, 0x0, 0, 0);
+    return dmGameObject::UPDATE_RESULT_OK;
+}
+
+static dmGameObject::UpdateResult ReceivingComponentOnMessage(const dmGameObject::ComponentOnMessageParams& params)
+{
+    g_MessageDispatched = true;
+    return dmGameObject::UPDATE_RESULT_OK;
+}
+
+static dmGameObject::UpdateResult CheckingComponentsUpdate(const dmGameObject::ComponentsUpdateParams& params, dmGameObject::ComponentsUpdateResult& update_result)
+{
+    if (g_MessageDispatched)
+        ++g_DispatchedBeforeUpdateCount;
+    return dmGameObject::UPDATE_RESULT_OK;
+}
+
+// The messages posted by a component type are dispatched before the next component type is updated, as when updated one by one
+TEST_F(ComponentTest, TestConcurrentUpdateMessageOrder)
+{
+    // Update order is c, b, a
+    dmGameObject::ComponentType* a = GetComponentType(m_Factory, m_Register, "a");
+    dmGameObject::ComponentType* b = GetComponentType(m_Factory, m_Register, "b");
+    dmGameObject::ComponentType* c = GetComponentType(m_Factory, m_Register, "c");
+    c->m_UpdateFunction = PostingComponentsUpdate;
+    c->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT | dmGameObject::COMPONENT_UPDATE_ACCESS_POSTS_MESSAGES;
+    b->m_UpdateFunction = CheckingComponentsUpdate;
+    b->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    a->m_UpdateFunction = ConcurrentComponentsUpdate;
+    a->m_UpdateAccess = dmGameObject::COMPONENT_UPDATE_ACCESS_CONCURRENT;
+    a->m_OnMessageFunction = ReceivingComponentOnMessage;
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(2, "test_worker");
+    dmGameObject::SetWorkerPool(m_Register, pool);
+
+    dmGameObject::HInstance go = dmGameObject::New(m_Collection, "/go1.goc");
+    ASSERT_NE((void*) 0, (void*) go);
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetIdentifier(m_Collection, go, "go1"));
+
+    dmMessage::ResetURL(g_PostReceiver);
+    g_PostReceiver.m_Socket = dmGameObject::GetMessageSocket(m_Collection);
+    g_PostReceiver.m_Path = dmGameObject::GetIdentifier(go);
+    g_PostReceiver.m_Fragment = dmHashString64("a");
+
+    g_DispatchedBeforeUpdateCount = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(dmGameObject::Update(m_Collection, &m_UpdateContext));
+    }
+    ASSERT_EQ(100u, g_DispatchedBeforeUpdateCount);
+    dmGameObject::Delete(m_Collection, go, false);
+    ASSERT_TRUE(dmGameObject::PostUpdate(m_Collection));
+
+    dmGameObject::SetWorkerPool(m_Register, 0);
+    dmWorkerPool::Delete(pool);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -888,6 +888,247 @@ TEST_F(HierarchyTest, TestEmptyInstance)
     dmGameObject::Delete(m_Collection, go, false);
 }
 
+// Only the changed sub tree should get new world transforms, but the result must be the same as a full update
+TEST_F(HierarchyTest, TestDirtySubTree)
+{
+    dmGameObject::HInstance parent = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance child = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance sibling = dmGameObject::New(m_Collection, "/go.goc");
+    dmGameObject::HInstance grandchild = dmGameObject::New(m_Collection, "/go.goc");
+
+    dmGameObject::SetPosition(parent, Point3(1, 0, 0));
+    dmGameObject::SetPosition(child, Point3(0, 1, 0));
+    dmGameObject::SetPosition(sibling, Point3(0, 2, 0));
+    dmGameObject::SetPosition(grandchild, Point3(0, 0, 1));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(child, parent));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(sibling, parent));
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(grandchild, child));
+
+    dmGameObject::Collection* collection = m_Collection->m_Collection;
+    dmGameObject::UpdateTransforms(collection);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(grandchild) - Point3(1, 1, 1)), EPSILON);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(sibling) - Point3(1, 2, 0)), EPSILON);
+
+    // Nothing changed
+    dmGameObject::UpdateTransforms(collection);
+    dmGameObject::HInstance instances[] = {parent, child, sibling, grandchild};
+    for (uint32_t i = 0; i < sizeof(instances) / sizeof(instances[0]); ++i)
+    {
+        ASSERT_EQ(0u, collection->m_WorldTransformChanged[instances[i]->m_Index]);
+    }
+
+    // Moving the child only affects the child and grand child
+    dmGameObject::SetPosition(child, Point3(0, 3, 0));
+    dmGameObject::UpdateTransforms(collection);
+    ASSERT_EQ(0u, collection->m_WorldTransformChanged[parent->m_Index]);
+    ASSERT_EQ(0u, collection->m_WorldTransformChanged[sibling->m_Index]);
+    ASSERT_EQ(1u, collection->m_WorldTransformChanged[child->m_Index]);
+    ASSERT_EQ(1u, collection->m_WorldTransformChanged[grandchild->m_Index]);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(grandchild) - Point3(1, 3, 1)), EPSILON);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(sibling) - Point3(1, 2, 0)), EPSILON);
+
+    // Moving the parent affects everything
+    dmGameObject::SetPosition(parent, Point3(2, 0, 0));
+    dmGameObject::UpdateTransforms(collection);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(grandchild) - Point3(2, 3, 1)), EPSILON);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(sibling) - Point3(2, 2, 0)), EPSILON);
+
+    // Re-parenting with an unchanged local transform
+    ASSERT_EQ(dmGameObject::RESULT_OK, dmGameObject::SetParent(grandchild, sibling));
+    dmGameObject::UpdateTransforms(collection);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(grandchild) - Point3(2, 2, 1)), EPSILON);
+
+    // Euler rotation set through a property pointer, like the animations do
+    dmGameObject::SetPosition(parent, Point3(0, 0, 0));
+    dmGameObject::UpdateTransforms(collection);
+    float euler[] = {0.0f, 0.0f, 90.0f};
+    memcpy(&parent->m_EulerRotation, euler, sizeof(euler));
+    dmGameObject::SetLocalTransformDirty(parent);
+    dmGameObject::UpdateTransforms(collection);
+    ASSERT_NEAR(0.0f, length(dmGameObject::GetWorldPosition(sibling) - Point3(-2, 0, 0)), 0.0001f);
+
+    dmGameObject::Delete(m_Collection, grandchild, false);
+    dmGameObject::Delete(m_Collection, sibling, false);
+    dmGameObject::Delete(m_Collection, child, false);
+    dmGameObject::Delete(m_Collection, parent, false);
+}
+
+static void CreateBenchHierarchy(dmGameObject::HCollection collection, uint32_t root_count, uint32_t depth, dmArray<dmGameObject::HInstance>& instances)
+{
+    for (uint32_t r = 0; r < root_count; ++r)
+    {
+        dmGameObject::HInstance parent = dmGameObject::New(collection, 0x0);
+        dmGameObject::SetPosition(parent, Point3((float)r, 0, 0));
+        dmGameObject::SetRotation(parent, Quat::rotationZ(0.01f * r));
+        instances.Push(parent);
+        for (uint32_t d = 1; d < depth; ++d)
+        {
+            dmGameObject::HInstance child = dmGameObject::New(collection, 0x0);
+            dmGameObject::SetPosition(child, Point3(0, 1, 0));
+            dmGameObject::SetScale(child, Vector3(1.1f, 1.1f, 1.0f));
+            dmGameObject::SetParent(child, parent);
+            instances.Push(child);
+            parent = child;
+        }
+    }
+}
+
+static float BenchUpdateTransforms(dmGameObject::HCollection hcollection, dmArray<dmGameObject::HInstance>& instances, uint32_t depth, bool move_all, uint32_t iterations)
+{
+    dmGameObject::Collection* collection = hcollection->m_Collection;
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < iterations; ++i)
+    {
+        if (move_all)
+        {
+            for (uint32_t j = 0; j < instances.Size(); j += depth)
+            {
+                dmGameObject::SetPosition(instances[j], Point3((float)j, (float)(i & 1), 0));
+            }
+        }
+        else
+        {
+            dmGameObject::SetPosition(instances.Back(), Point3(0, (float)(i & 1), 0));
+        }
+        dmGameObject::UpdateTransforms(collection);
+    }
+    uint64_t end = dmTime::GetTime();
+    return (end - start) / (1000.0f * iterations);
+}
+
+TEST_F(HierarchyTest, TestUpdateTransformsBench)
+{
+    const uint32_t root_count = 2000;
+    const uint32_t depth = 8;
+    const uint32_t iterations = 50;
+
+    dmGameObject::HCollection collection = dmGameObject::NewCollection("bench", m_Factory, m_Register, root_count * depth);
+    ASSERT_NE((void*) 0, collection);
+    dmArray<dmGameObject::HInstance> instances;
+    instances.SetCapacity(root_count * depth);
+    CreateBenchHierarchy(collection, root_count, depth, instances);
+    dmGameObject::UpdateTransforms(collection->m_Collection);
+
+    float full_ms = BenchUpdateTransforms(collection, instances, depth, true, iterations);
+    float leaf_ms = BenchUpdateTransforms(collection, instances, depth, false, iterations);
+
+    dmArray<Matrix4> serial_world;
+    serial_world.SetCapacity(instances.Size());
+    for (uint32_t i = 0; i < instances.Size(); ++i)
+    {
+        serial_world.Push(dmGameObject::GetWorldMatrix(instances[i]));
+    }
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(3, "bench_worker");
+    dmGameObject::SetWorkerPool(m_Register, pool);
+    float parallel_full_ms = BenchUpdateTransforms(collection, instances, depth, true, iterations);
+    float parallel_leaf_ms = BenchUpdateTransforms(collection, instances, depth, false, iterations);
+    dmGameObject::SetWorkerPool(m_Register, 0);
+    dmWorkerPool::Delete(pool);
+
+    for (uint32_t i = 0; i < instances.Size(); ++i)
+    {
+        Matrix4 world = dmGameObject::GetWorldMatrix(instances[i]);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            ASSERT_NEAR(0.0f, length(world.getCol(c) - serial_world[i].getCol(c)), EPSILON);
+        }
+    }
+
+    printf("UpdateTransforms, %u instances in %u levels\n", instances.Size(), depth);
+    printf("  all changed:                    %f ms\n", full_ms);
+    printf("  single leaf changed:            %f ms\n", leaf_ms);
+    printf("  all changed (3 workers):        %f ms\n", parallel_full_ms);
+    printf("  single leaf changed (3 workers): %f ms\n", parallel_leaf_ms);
+
+    dmGameObject::DeleteCollection(collection);
+    dmGameObject::PostUpdate(m_Register);
+}
+
+// Approximate memory used by the hierarchy of a collection: instances (excluding component user data) and the index arrays
+static uint32_t CalcHierarchyMemory(dmGameObject::Collection* collection)
+{
+    bool wide = collection->m_WideIndices != 0;
+    uint32_t index_size = wide ? sizeof(uint32_t) : sizeof(uint16_t);
+    uint32_t instance_size = sizeof(dmGameObject::Instance) + (wide ? sizeof(dmGameObject::InstanceWideIndices) : 0);
+    uint32_t size = dmGameObject::GetInstanceCount(collection) * instance_size;
+    size += (wide ? collection->m_WideInstanceIndices.Capacity() : collection->m_InstanceIndices.Capacity()) * index_size;
+    for (uint32_t i = 0; i < dmGameObject::MAX_HIERARCHICAL_DEPTH; ++i)
+    {
+        size += (wide ? collection->m_WideLevelIndices[i].Capacity() : collection->m_LevelIndices[i].Capacity()) * index_size;
+        size += (wide ? collection->m_WideLevelParentIndices[i].Capacity() : collection->m_LevelParentIndices[i].Capacity()) * index_size;
+    }
+    return size;
+}
+
+struct WideIndicesBenchResult
+{
+    uint32_t m_Count;
+    uint32_t m_Memory;
+    float    m_Ms;
+};
+
+static void RunWideIndicesBench(dmResource::HFactory factory, dmGameObject::HRegister regist, uint32_t capacity, uint32_t roots, uint32_t depth, uint32_t iterations, bool wide, WideIndicesBenchResult* result)
+{
+    dmGameObject::HCollection collection = dmGameObject::NewCollection("bench", factory, regist, capacity);
+    ASSERT_NE((void*) 0, collection);
+    ASSERT_EQ(wide, collection->m_Collection->m_WideIndices != 0);
+    dmArray<dmGameObject::HInstance> instances;
+    instances.SetCapacity(roots * depth);
+    CreateBenchHierarchy(collection, roots, depth, instances);
+    dmGameObject::UpdateTransforms(collection->m_Collection);
+    result->m_Ms = BenchUpdateTransforms(collection, instances, depth, true, iterations);
+    result->m_Count = instances.Size();
+    result->m_Memory = CalcHierarchyMemory(collection->m_Collection);
+
+    // Verify the last chain, which is indexed at the end of the collection
+    uint32_t count = instances.Size();
+    ASSERT_EQ(dmGameObject::GetParent(instances[count - 1]), instances[count - 2]);
+    Matrix4 parent_world = dmGameObject::GetWorldMatrix(instances[count - 2]);
+    Vector4 expected_pos = parent_world * Point3(0, 1, 0);
+    Point3 leaf_pos = dmGameObject::GetWorldPosition(instances[count - 1]);
+    ASSERT_NEAR(0.0f, length(Vector3(leaf_pos) - expected_pos.getXYZ()), 0.001f * length(expected_pos.getXYZ()));
+
+    dmGameObject::DeleteCollection(collection);
+    dmGameObject::PostUpdate(regist);
+}
+
+static void PrintWideIndicesBenchResult(const char* name, const WideIndicesBenchResult& result)
+{
+    printf("  %-22s %6u instances: %f ms (%f us/instance), %u bytes/instance\n", name, result.m_Count, result.m_Ms, 1000.0f * result.m_Ms / result.m_Count, result.m_Memory / result.m_Count);
+}
+
+TEST_F(HierarchyTest, TestWideIndicesBench)
+{
+    const uint32_t depth = 8;
+    const uint32_t iterations = 20;
+    const uint32_t compact_roots = dmGameObject::MAX_COMPACT_INSTANCES / depth;
+    const uint32_t large_roots = compact_roots * 4;
+
+    // Compact layout, the default
+    WideIndicesBenchResult compact;
+    RunWideIndicesBench(m_Factory, m_Register, dmGameObject::MAX_COMPACT_INSTANCES, compact_roots, depth, iterations, false, &compact);
+
+    // A collection beyond the compact limit requires wide indices to be enabled
+    ASSERT_EQ((void*) 0, dmGameObject::NewCollection("bench", m_Factory, m_Register, dmGameObject::MAX_COMPACT_INSTANCES + 1));
+    dmGameObject::SetCollectionWideIndices(m_Register, true);
+
+    // Wide layout with the same number of instances
+    WideIndicesBenchResult wide;
+    RunWideIndicesBench(m_Factory, m_Register, dmGameObject::MAX_COMPACT_INSTANCES + 1, compact_roots, depth, iterations, true, &wide);
+
+    // Wide layout beyond the compact limit
+    WideIndicesBenchResult large;
+    RunWideIndicesBench(m_Factory, m_Register, large_roots * depth, large_roots, depth, iterations, true, &large);
+
+    dmGameObject::SetCollectionWideIndices(m_Register, false);
+
+    printf("Wide indices, sizeof(Instance) %u (+%u when wide)\n", (uint32_t) sizeof(dmGameObject::Instance), (uint32_t) sizeof(dmGameObject::InstanceWideIndices));
+    PrintWideIndicesBenchResult("compact:", compact);
+    PrintWideIndicesBenchResult("wide:", wide);
+    PrintWideIndicesBenchResult("wide, beyond compact:", large);
+}
+
 #undef EPSILON
 
 int main(int argc, char **argv)
@@ -187,6 +187,8 @@ namespace dmGameSystem
         {
             return false;
         }
+        // Factory resources are requested by gameplay code, so load them ahead of e.g. collection proxies
+        dmResource::SetPreloaderPriority(component->m_Preloader, dmResource::LOAD_PRIORITY_HIGH);
         component->m_Loading = 1;
         return true;
     }
@@ -92,6 +92,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &gui_world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = gui_context->m_MaxSpineCount;
+        rig_params.m_WorkerPool = gui_context->m_WorkerPool;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -143,6 +144,7 @@ namespace dmGameSystem
         gui_world->m_MaxParticleFXCount = gui_context->m_MaxParticleFXCount;
         gui_world->m_MaxParticleCount = gui_context->m_MaxParticleCount;
         gui_world->m_ParticleContext = dmParticle::CreateContext(gui_world->m_MaxParticleFXCount, gui_world->m_MaxParticleCount);
+        dmParticle::SetWorkerPool(gui_world->m_ParticleContext, gui_context->m_WorkerPool);
 
         gui_world->m_ScriptWorld = dmScript::NewScriptWorld(gui_context->m_ScriptContext);
 
@@ -87,6 +87,9 @@ namespace dmGameSystem
     static const dmhash_t PROP_ANIMATION = dmHashString64("animation");
     static const dmhash_t PROP_CURSOR = dmHashString64("cursor");
     static const dmhash_t PROP_PLAYBACK_RATE = dmHashString64("playback_rate");
+    static const dmhash_t PROP_LOD_UPDATE_INTERVAL = dmHashString64("lod_update_interval");
+    static const dmhash_t PROP_LOD_BONE_COUNT = dmHashString64("lod_bone_count");
+    static const dmhash_t PROP_LOD_CULLED = dmHashString64("lod_culled");
 
     static const uint32_t MAX_TEXTURE_COUNT = dmRender::RenderObject::MAX_TEXTURE_COUNT;
 
@@ -102,6 +105,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxModelCount;
+        rig_params.m_WorkerPool = context->m_WorkerPool;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -642,7 +646,8 @@ namespace dmGameSystem
                 ReHash(&component);
             }
 
-            component.m_DoRender = 1;
+            // Culled instances don't generate any vertex data
+            component.m_DoRender = !dmRig::GetCulled(component.m_RigInstance);
         }
 
         update_result.m_TransformsUpdated = rig_res == dmRig::RESULT_UPDATED_POSE;
@@ -901,6 +906,21 @@ namespace dmGameSystem
             out_value.m_Variant = dmGameObject::PropertyVar(dmRig::GetPlaybackRate(component->m_RigInstance));
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (params.m_PropertyId == PROP_LOD_UPDATE_INTERVAL)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)dmRig::GetUpdateInterval(component->m_RigInstance));
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_BONE_COUNT)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)dmRig::GetLODBoneCount(component->m_RigInstance));
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_CULLED)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar(dmRig::GetCulled(component->m_RigInstance));
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             return GetResourceProperty(dmGameObject::GetFactory(params.m_Instance), GetMaterial(component, component->m_Resource), out_value);
@@ -958,6 +978,40 @@ namespace dmGameSystem
             }
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (params.m_PropertyId == PROP_LOD_UPDATE_INTERVAL)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_NUMBER)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+
+            if (params.m_Value.m_Number < 1.0)
+            {
+                dmLogError("Could not set lod update interval %f on the model, it must be at least 1.", params.m_Value.m_Number);
+                return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+            }
+            dmRig::SetUpdateInterval(component->m_RigInstance, (uint32_t)params.m_Value.m_Number);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_BONE_COUNT)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_NUMBER)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+
+            if (params.m_Value.m_Number < 0.0)
+            {
+                dmLogError("Could not set lod bone count %f on the model, it must not be negative.", params.m_Value.m_Number);
+                return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+            }
+            dmRig::SetLODBoneCount(component->m_RigInstance, (uint32_t)params.m_Value.m_Number);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_CULLED)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_BOOLEAN)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+
+            dmRig::SetCulled(component->m_RigInstance, params.m_Value.m_Bool);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, MATERIAL_EXT_HASH, (void**)&component->m_Material);
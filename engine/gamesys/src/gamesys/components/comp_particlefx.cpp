@@ -67,6 +67,7 @@ namespace dmGameSystem
         dmParticle::HParticleContext m_ParticleContext;
         dmGraphics::HVertexBuffer m_VertexBuffer;
         dmArray<dmParticle::Vertex> m_VertexBufferData;
+        dmArray<dmParticle::EmitterVertexData> m_EmitterVertexData;
         dmGraphics::HVertexDeclaration m_VertexDeclaration;
         uint32_t m_EmitterCount;
         float m_DT;
@@ -82,6 +83,7 @@ namespace dmGameSystem
         world->m_Context = ctx;
         uint32_t particle_fx_count = ctx->m_MaxParticleFXCount;
         world->m_ParticleContext = dmParticle::CreateContext(particle_fx_count, ctx->m_MaxParticleCount);
+        dmParticle::SetWorkerPool(world->m_ParticleContext, ctx->m_WorkerPool);
         world->m_Components.SetCapacity(particle_fx_count);
         world->m_RenderObjects.SetCapacity(particle_fx_count);
         world->m_Prototypes.SetCapacity(particle_fx_count);
@@ -236,11 +238,22 @@ namespace dmGameSystem
         uint32_t vb_size = vb_size_init;
         uint32_t vb_max_size =  dmParticle::GetVertexBufferSize(pfx_context->m_MaxParticleCount, dmParticle::PARTICLE_GO);
 
-        for (uint32_t *i = begin; i != end; ++i)
+        dmArray<dmParticle::EmitterVertexData>& emitters = pfx_world->m_EmitterVertexData;
+        uint32_t emitter_count = end - begin;
+        if (emitters.Capacity() < emitter_count)
         {
-            const dmParticle::EmitterRenderData* emitter_render_data = (dmParticle::EmitterRenderData*) buf[*i].m_UserData;
-            dmParticle::GenerateVertexData(particle_context, pfx_world->m_DT, emitter_render_data->m_Instance, emitter_render_data->m_EmitterIndex, Vector4(1,1,1,1), (void*)vertex_buffer.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO);
+            emitters.SetCapacity(emitter_count);
         }
+        emitters.SetSize(emitter_count);
+        for (uint32_t i = 0; i < emitter_count; ++i)
+        {
+            const dmParticle::EmitterRenderData* emitter_render_data = (dmParticle::EmitterRenderData*) buf[begin[i]].m_UserData;
+            dmParticle::EmitterVertexData& emitter = emitters[i];
+            emitter.m_Instance = emitter_render_data->m_Instance;
+            emitter.m_EmitterIndex = emitter_render_data->m_EmitterIndex;
+            emitter.m_Color = Vector4(1,1,1,1);
+        }
+        dmParticle::GenerateVertexDataBatch(particle_context, pfx_world->m_DT, emitters.Begin(), emitter_count, (void*)vertex_buffer.Begin(), vb_max_size, &vb_size, dmParticle::PARTICLE_GO);
 
         vb_end = (vb_begin + (vb_size - vb_size_init) / sizeof(dmParticle::Vertex));
 
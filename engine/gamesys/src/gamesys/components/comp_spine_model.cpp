@@ -47,6 +47,9 @@ namespace dmGameSystem
     static const dmhash_t PROP_ANIMATION = dmHashString64("animation");
     static const dmhash_t PROP_CURSOR = dmHashString64("cursor");
     static const dmhash_t PROP_PLAYBACK_RATE = dmHashString64("playback_rate");
+    static const dmhash_t PROP_LOD_UPDATE_INTERVAL = dmHashString64("lod_update_interval");
+    static const dmhash_t PROP_LOD_BONE_COUNT = dmHashString64("lod_bone_count");
+    static const dmhash_t PROP_LOD_CULLED = dmHashString64("lod_culled");
 
     static void ResourceReloadedCallback(const dmResource::ResourceReloadedParams& params);
     static void DestroyComponent(SpineModelWorld* world, uint32_t index);
@@ -76,6 +79,7 @@ namespace dmGameSystem
         dmRig::NewContextParams rig_params = {0};
         rig_params.m_Context = &world->m_RigContext;
         rig_params.m_MaxRigInstanceCount = context->m_MaxSpineModelCount;
+        rig_params.m_WorkerPool = context->m_WorkerPool;
         dmRig::Result rr = dmRig::NewContext(rig_params);
         if (rr != dmRig::RESULT_OK)
         {
@@ -560,7 +564,8 @@ namespace dmGameSystem
                 ReHash(&component);
             }
 
-            component.m_DoRender = 1;
+            // Culled instances don't generate any vertex data
+            component.m_DoRender = !dmRig::GetCulled(component.m_RigInstance);
         }
 
         update_result.m_TransformsUpdated = rig_res == dmRig::RESULT_UPDATED_POSE;
@@ -804,6 +809,21 @@ namespace dmGameSystem
             out_value.m_Variant = dmGameObject::PropertyVar(dmRig::GetPlaybackRate(component->m_RigInstance));
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (params.m_PropertyId == PROP_LOD_UPDATE_INTERVAL)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)dmRig::GetUpdateInterval(component->m_RigInstance));
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_BONE_COUNT)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar((float)dmRig::GetLODBoneCount(component->m_RigInstance));
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_CULLED)
+        {
+            out_value.m_Variant = dmGameObject::PropertyVar(dmRig::GetCulled(component->m_RigInstance));
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             dmRender::HMaterial material = GetMaterial(component, component->m_Resource);
@@ -855,6 +875,40 @@ namespace dmGameSystem
             }
             return dmGameObject::PROPERTY_RESULT_OK;
         }
+        else if (params.m_PropertyId == PROP_LOD_UPDATE_INTERVAL)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_NUMBER)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+
+            if (params.m_Value.m_Number < 1.0)
+            {
+                dmLogError("Could not set lod update interval %f on the spine model, it must be at least 1.", params.m_Value.m_Number);
+                return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+            }
+            dmRig::SetUpdateInterval(component->m_RigInstance, (uint32_t)params.m_Value.m_Number);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_BONE_COUNT)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_NUMBER)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+
+            if (params.m_Value.m_Number < 0.0)
+            {
+                dmLogError("Could not set lod bone count %f on the spine model, it must not be negative.", params.m_Value.m_Number);
+                return dmGameObject::PROPERTY_RESULT_UNSUPPORTED_VALUE;
+            }
+            dmRig::SetLODBoneCount(component->m_RigInstance, (uint32_t)params.m_Value.m_Number);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
+        else if (params.m_PropertyId == PROP_LOD_CULLED)
+        {
+            if (params.m_Value.m_Type != dmGameObject::PROPERTY_TYPE_BOOLEAN)
+                return dmGameObject::PROPERTY_RESULT_TYPE_MISMATCH;
+
+            dmRig::SetCulled(component->m_RigInstance, params.m_Value.m_Bool);
+            return dmGameObject::PROPERTY_RESULT_OK;
+        }
         else if (params.m_PropertyId == PROP_MATERIAL)
         {
             dmGameObject::PropertyResult res = SetResourceProperty(dmGameObject::GetFactory(params.m_Instance), params.m_Value, MATERIAL_EXT_HASH, (void**)&component->m_Material);
@@ -24,6 +24,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/object_pool.h>
 #include <dlib/math.h>
+#include <dlib/worker_pool.h>
 #include <graphics/graphics.h>
 #include <render/render.h>
 #include <gameobject/gameobject_ddf.h>
@@ -90,6 +91,8 @@ namespace dmGameSystem
     {
         dmObjectPool<SpriteComponent>   m_Components;
         dmArray<dmRender::RenderObject> m_RenderObjects;
+        dmArray<uint32_t>               m_ChunkOffsets;
+        dmWorkerPool::HWorkerPool       m_WorkerPool;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
         dmGraphics::HVertexBuffer       m_VertexBuffer;
         SpriteVertex*                   m_VertexBufferData;
@@ -178,6 +181,7 @@ namespace dmGameSystem
         sprite_world->m_Components.SetCapacity(sprite_context->m_MaxSpriteCount);
         memset(sprite_world->m_Components.m_Objects.Begin(), 0, sizeof(SpriteComponent) * sprite_context->m_MaxSpriteCount);
         sprite_world->m_RenderObjects.SetCapacity(sprite_context->m_MaxSpriteCount);
+        sprite_world->m_WorkerPool = sprite_context->m_WorkerPool;
 
         dmGraphics::VertexElement ve[] =
         {
@@ -385,165 +389,250 @@ namespace dmGameSystem
     }
 
 
-    static void CreateVertexData(SpriteWorld* sprite_world, SpriteVertex** vb_where, uint8_t** ib_where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    // Sprites per vertex generation job
+    static const uint32_t SPRITE_VERTEX_CHUNK_SIZE = 256;
+
+    struct SpriteVertexJob
     {
-        DM_PROFILE(Sprite, "CreateVertexData");
+        SpriteWorld*                m_World;
+        TextureSetResource*         m_TextureSet;
+        dmRender::RenderListEntry*  m_Buf;
+        uint32_t*                   m_Begin;
+        SpriteVertex*               m_Vertices;
+        uint8_t*                    m_Indices;
+        // Only used with geometries: Vertex and index (element) offsets to the first sprite in each chunk
+        const uint32_t*             m_ChunkOffsets;
+    };
 
+    static inline const dmGameSystemDDF::SpriteGeometry* GetGeometry(const SpriteComponent* component, dmGameSystemDDF::TextureSet* texture_set_ddf)
+    {
+        const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &texture_set_ddf->m_Animations[component->m_AnimationID];
+        uint32_t frame_index = texture_set_ddf->m_FrameIndices[animation_ddf->m_Start + component->m_CurrentAnimationFrame];
+        return &texture_set_ddf->m_Geometries[frame_index];
+    }
+
+    static void CreateGeometryVertexData(SpriteWorld* sprite_world, SpriteVertex* vertices, uint8_t* indices, uint32_t vertex_offset, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
         dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
         dmGameSystemDDF::TextureSetAnimation* animations = texture_set_ddf->m_Animations.m_Data;
-        uint32_t* frame_indices = texture_set_ddf->m_FrameIndices.m_Data;
-
-        SpriteVertex*   vertices = *vb_where;
-        uint8_t*        indices = *ib_where;
 
         uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
 
-        if (sprite_world->m_UseGeometries)
+        for (uint32_t* i = begin; i != end; ++i)
         {
-            const dmGameSystemDDF::SpriteGeometry* geometries = texture_set_ddf->m_Geometries.m_Data;
-
-            // The offset for the indices
-            uint32_t vertex_offset = *vb_where - sprite_world->m_VertexBufferData;
-
-            for (uint32_t* i = begin; i != end; ++i)
-            {
-                const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
-
-                const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+            const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
 
-                uint32_t frame_index = frame_indices[animation_ddf->m_Start + component->m_CurrentAnimationFrame];
+            const dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
 
-                const dmGameSystemDDF::SpriteGeometry* geometry = &geometries[frame_index];
+            const dmGameSystemDDF::SpriteGeometry* geometry = GetGeometry(component, texture_set_ddf);
 
-                const Matrix4& w = component->m_World;
+            const Matrix4& w = component->m_World;
 
-                uint32_t num_points = geometry->m_Vertices.m_Count / 2;
+            uint32_t num_points = geometry->m_Vertices.m_Count / 2;
 
-                const float* points = geometry->m_Vertices.m_Data;
-                const float* uvs = geometry->m_Uvs.m_Data;
+            const float* points = geometry->m_Vertices.m_Data;
+            const float* uvs = geometry->m_Uvs.m_Data;
 
-                // Depending on the sprite is flipped or not, we loop the vertices forward or backward
-                // to respect face winding (and backface culling)
-                int flipx = animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal;
-                int flipy = animation_ddf->m_FlipVertical ^ component->m_FlipVertical;
-                int reverse = flipx ^ flipy;
+            // Depending on the sprite is flipped or not, we loop the vertices forward or backward
+            // to respect face winding (and backface culling)
+            int flipx = animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal;
+            int flipy = animation_ddf->m_FlipVertical ^ component->m_FlipVertical;
+            int reverse = flipx ^ flipy;
 
-                float scaleX = flipx ? -1 : 1;
-                float scaleY = flipy ? -1 : 1;
+            float scaleX = flipx ? -1 : 1;
+            float scaleY = flipy ? -1 : 1;
 
-                int step = reverse ? -2 : 2;
-                points = reverse ? points + num_points*2 - 2 : points;
-                uvs = reverse ? uvs + num_points*2 - 2 : uvs;
+            int step = reverse ? -2 : 2;
+            points = reverse ? points + num_points*2 - 2 : points;
+            uvs = reverse ? uvs + num_points*2 - 2 : uvs;
 
-                for (uint32_t vert = 0; vert < num_points; ++vert, ++vertices, points += step, uvs += step)
-                {
-                    float x = points[0] * scaleX; // range -0.5,+0.5
-                    float y = points[1] * scaleY;
-                    float u = uvs[0];
-                    float v = uvs[1];
-
-                    Vector4 p0 = w * Point3(x, y, 0.0f);
-                    vertices[0].x = ((float*)&p0)[0];
-                    vertices[0].y = ((float*)&p0)[1];
-                    vertices[0].z = ((float*)&p0)[2];
-                    vertices[0].u = u;
-                    vertices[0].v = v;
-                }
+            for (uint32_t vert = 0; vert < num_points; ++vert, ++vertices, points += step, uvs += step)
+            {
+                float x = points[0] * scaleX; // range -0.5,+0.5
+                float y = points[1] * scaleY;
+                float u = uvs[0];
+                float v = uvs[1];
+
+                Vector4 p0 = w * Point3(x, y, 0.0f);
+                vertices[0].x = ((float*)&p0)[0];
+                vertices[0].y = ((float*)&p0)[1];
+                vertices[0].z = ((float*)&p0)[2];
+                vertices[0].u = u;
+                vertices[0].v = v;
+            }
 
-                uint32_t index_count = geometry->m_Indices.m_Count;
-                uint32_t* geom_indices = geometry->m_Indices.m_Data;
-                if (sprite_world->m_Is16BitIndex)
+            uint32_t index_count = geometry->m_Indices.m_Count;
+            uint32_t* geom_indices = geometry->m_Indices.m_Data;
+            if (sprite_world->m_Is16BitIndex)
+            {
+                for (uint32_t index = 0; index < index_count; ++index)
                 {
-                    for (uint32_t index = 0; index < index_count; ++index)
-                    {
-                        ((uint16_t*)indices)[index] = vertex_offset + geom_indices[index];
-                    }
+                    ((uint16_t*)indices)[index] = vertex_offset + geom_indices[index];
                 }
-                else
+            }
+            else
+            {
+                for (uint32_t index = 0; index < index_count; ++index)
                 {
-                    for (uint32_t index = 0; index < index_count; ++index)
-                    {
-                        ((uint32_t*)indices)[index] = vertex_offset + geom_indices[index];
-                    }
+                    ((uint32_t*)indices)[index] = vertex_offset + geom_indices[index];
                 }
-                indices += index_type_size * geometry->m_Indices.m_Count;
-                vertex_offset += num_points;
             }
+            indices += index_type_size * geometry->m_Indices.m_Count;
+            vertex_offset += num_points;
         }
-        else // original path using quads
+    }
+
+    // The index buffer is static for quads, so only the vertices are written
+    static void CreateQuadVertexData(SpriteVertex* vertices, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        static int tex_coord_order[] = {
+            0,1,2,2,3,0,
+            3,2,1,1,0,3,    //h
+            1,0,3,3,2,1,    //v
+            2,3,0,0,1,2     //hv
+        };
+
+        dmGameSystemDDF::TextureSetAnimation* animations = texture_set->m_TextureSet->m_Animations.m_Data;
+        const float* tex_coords = (const float*) texture_set->m_TextureSet->m_TexCoords.m_Data;
+
+        for (uint32_t *i = begin;i != end; ++i)
         {
-            static int tex_coord_order[] = {
-                0,1,2,2,3,0,
-                3,2,1,1,0,3,    //h
-                1,0,3,3,2,1,    //v
-                2,3,0,0,1,2     //hv
-            };
+            const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
 
-            const float* tex_coords = (const float*) texture_set->m_TextureSet->m_TexCoords.m_Data;
+            dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
 
-            for (uint32_t *i = begin;i != end; ++i)
+            uint32_t frame_index = animation_ddf->m_Start + component->m_CurrentAnimationFrame;
+            const float* tc = &tex_coords[frame_index * 4 * 2];
+            uint32_t flip_flag = 0;
+
+            // ddf values are guaranteed to be 0 or 1 when saved by the editor
+            // component values are guaranteed to be 0 or 1
+            if (animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal)
+            {
+                flip_flag = 1;
+            }
+            if (animation_ddf->m_FlipVertical ^ component->m_FlipVertical)
             {
-                const SpriteComponent* component = (SpriteComponent*) buf[*i].m_UserData;
+                flip_flag |= 2;
+            }
 
-                dmGameSystemDDF::TextureSetAnimation* animation_ddf = &animations[component->m_AnimationID];
+            const int* tex_lookup = &tex_coord_order[flip_flag * 6];
+
+            const Matrix4& w = component->m_World;
+
+            Vector4 p0 = w * Point3(-0.5f, -0.5f, 0.0f);
+            vertices[0].x = p0.getX();
+            vertices[0].y = p0.getY();
+            vertices[0].z = p0.getZ();
+            vertices[0].u = tc[tex_lookup[0] * 2];
+            vertices[0].v = tc[tex_lookup[0] * 2 + 1];
+
+            Vector4 p1 = w * Point3(-0.5f, 0.5f, 0.0f);
+            vertices[1].x = p1.getX();
+            vertices[1].y = p1.getY();
+            vertices[1].z = p1.getZ();
+            vertices[1].u = tc[tex_lookup[1] * 2];
+            vertices[1].v = tc[tex_lookup[1] * 2 + 1];
+
+            Vector4 p2 = w * Point3(0.5f, 0.5f, 0.0f);
+            vertices[2].x = p2.getX();
+            vertices[2].y = p2.getY();
+            vertices[2].z = p2.getZ();
+            vertices[2].u = tc[tex_lookup[2] * 2];
+            vertices[2].v = tc[tex_lookup[2] * 2 + 1];
+
+            Vector4 p3 = w * Point3(0.5f, -0.5f, 0.0f);
+            vertices[3].x = p3.getX();
+            vertices[3].y = p3.getY();
+            vertices[3].z = p3.getZ();
+            vertices[3].u = tc[tex_lookup[4] * 2];
+            vertices[3].v = tc[tex_lookup[4] * 2 + 1];
+
+            // for (int f = 0; f < 4; ++f)
+            //     printf("  %u: %.2f, %.2f\t%.2f, %.2f\n", f, vertices[f].x, vertices[f].y, vertices[f].u, vertices[f].v );
+
+            vertices += 4;
+        }
+    }
 
-                uint32_t frame_index = animation_ddf->m_Start + component->m_CurrentAnimationFrame;
-                const float* tc = &tex_coords[frame_index * 4 * 2];
-                uint32_t flip_flag = 0;
+    // Called from the worker threads. The range always starts at a chunk boundary
+    static void CreateVertexDataChunk(void* _job, uint32_t begin, uint32_t end)
+    {
+        DM_PROFILE(Sprite, "CreateVertexDataChunk");
+        DM_COUNTER("SpriteVertexChunks", 1);
 
-                // ddf values are guaranteed to be 0 or 1 when saved by the editor
-                // component values are guaranteed to be 0 or 1
-                if (animation_ddf->m_FlipHorizontal ^ component->m_FlipHorizontal)
-                {
-                    flip_flag = 1;
-                }
-                if (animation_ddf->m_FlipVertical ^ component->m_FlipVertical)
+        SpriteVertexJob* job = (SpriteVertexJob*) _job;
+        SpriteWorld* sprite_world = job->m_World;
+        if (sprite_world->m_UseGeometries)
+        {
+            uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+            const uint32_t* offsets = &job->m_ChunkOffsets[(begin / SPRITE_VERTEX_CHUNK_SIZE) * 2];
+            uint32_t vertex_offset = (job->m_Vertices - sprite_world->m_VertexBufferData) + offsets[0];
+            CreateGeometryVertexData(sprite_world, job->m_Vertices + offsets[0], job->m_Indices + offsets[1] * index_type_size, vertex_offset,
+                                     job->m_TextureSet, job->m_Buf, job->m_Begin + begin, job->m_Begin + end);
+        }
+        else
+        {
+            CreateQuadVertexData(job->m_Vertices + begin * 4, job->m_TextureSet, job->m_Buf, job->m_Begin + begin, job->m_Begin + end);
+        }
+    }
+
+    // The output offsets of all sprites in the batch are known up front, so the batch is split into chunks
+    // that are written directly to their final location in the vertex (and index) buffer on the worker threads
+    static void CreateVertexData(SpriteWorld* sprite_world, SpriteVertex** vb_where, uint8_t** ib_where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(Sprite, "CreateVertexData");
+
+        uint32_t count = end - begin;
+        uint32_t index_type_size = sprite_world->m_Is16BitIndex ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        SpriteVertexJob job;
+        job.m_World = sprite_world;
+        job.m_TextureSet = texture_set;
+        job.m_Buf = buf;
+        job.m_Begin = begin;
+        job.m_Vertices = *vb_where;
+        job.m_Indices = *ib_where;
+        job.m_ChunkOffsets = 0;
+
+        if (sprite_world->m_UseGeometries)
+        {
+            // The number of vertices varies per sprite, so calculate where each chunk starts
+            dmArray<uint32_t>& offsets = sprite_world->m_ChunkOffsets;
+            uint32_t chunk_count = (count + SPRITE_VERTEX_CHUNK_SIZE - 1) / SPRITE_VERTEX_CHUNK_SIZE;
+            if (offsets.Capacity() < chunk_count * 2)
+            {
+                offsets.SetCapacity(chunk_count * 2);
+            }
+            offsets.SetSize(chunk_count * 2);
+
+            dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+            uint32_t vertex_count = 0;
+            uint32_t index_count = 0;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if ((i % SPRITE_VERTEX_CHUNK_SIZE) == 0)
                 {
-                    flip_flag |= 2;
+                    offsets[(i / SPRITE_VERTEX_CHUNK_SIZE) * 2 + 0] = vertex_count;
+                    offsets[(i / SPRITE_VERTEX_CHUNK_SIZE) * 2 + 1] = index_count;
                 }
-
-                const int* tex_lookup = &tex_coord_order[flip_flag * 6];
-
-                const Matrix4& w = component->m_World;
-
-                Vector4 p0 = w * Point3(-0.5f, -0.5f, 0.0f);
-                vertices[0].x = p0.getX();
-                vertices[0].y = p0.getY();
-                vertices[0].z = p0.getZ();
-                vertices[0].u = tc[tex_lookup[0] * 2];
-                vertices[0].v = tc[tex_lookup[0] * 2 + 1];
-
-                Vector4 p1 = w * Point3(-0.5f, 0.5f, 0.0f);
-                vertices[1].x = p1.getX();
-                vertices[1].y = p1.getY();
-                vertices[1].z = p1.getZ();
-                vertices[1].u = tc[tex_lookup[1] * 2];
-                vertices[1].v = tc[tex_lookup[1] * 2 + 1];
-
-                Vector4 p2 = w * Point3(0.5f, 0.5f, 0.0f);
-                vertices[2].x = p2.getX();
-                vertices[2].y = p2.getY();
-                vertices[2].z = p2.getZ();
-                vertices[2].u = tc[tex_lookup[2] * 2];
-                vertices[2].v = tc[tex_lookup[2] * 2 + 1];
-
-                Vector4 p3 = w * Point3(0.5f, -0.5f, 0.0f);
-                vertices[3].x = p3.getX();
-                vertices[3].y = p3.getY();
-                vertices[3].z = p3.getZ();
-                vertices[3].u = tc[tex_lookup[4] * 2];
-                vertices[3].v = tc[tex_lookup[4] * 2 + 1];
-
-                // for (int f = 0; f < 4; ++f)
-                //     printf("  %u: %.2f, %.2f\t%.2f, %.2f\n", f, vertices[f].x, vertices[f].y, vertices[f].u, vertices[f].v );
-
-                vertices += 4;
-                indices += 6 * index_type_size;
+                const SpriteComponent* component = (SpriteComponent*) buf[begin[i]].m_UserData;
+                const dmGameSystemDDF::SpriteGeometry* geometry = GetGeometry(component, texture_set_ddf);
+                vertex_count += geometry->m_Vertices.m_Count / 2;
+                index_count += geometry->m_Indices.m_Count;
             }
+            job.m_ChunkOffsets = offsets.Begin();
+
+            *vb_where += vertex_count;
+            *ib_where += index_count * index_type_size;
+        }
+        else
+        {
+            *vb_where += count * 4;
+            *ib_where += count * 6 * index_type_size;
         }
 
-        *vb_where = vertices;
-        *ib_where = indices;
+        dmWorkerPool::ParallelFor(sprite_world->m_WorkerPool, count, SPRITE_VERTEX_CHUNK_SIZE, CreateVertexDataChunk, &job);
     }
 
     static void RenderBatch(SpriteWorld* sprite_world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
@@ -22,6 +22,7 @@
 #include <dlib/math.h>
 #include <dlib/profile.h>
 #include <dlib/time.h>
+#include <dlib/worker_pool.h>
 #include <graphics/graphics.h>
 #include <render/render.h>
 #include <gameobject/gameobject.h>
@@ -109,8 +110,10 @@ namespace dmGameSystem
         }
 
         dmRender::HRenderContext        m_RenderContext;
+        dmWorkerPool::HWorkerPool       m_WorkerPool;
         dmArray<TileGridComponent*>     m_Components;
         dmArray<dmRender::RenderObject> m_RenderObjects;
+        dmArray<uint32_t>               m_RegionTiles;
         dmGraphics::HVertexDeclaration  m_VertexDeclaration;
 
         dmGraphics::HVertexBuffer       m_VertexBuffer;
@@ -146,6 +149,7 @@ namespace dmGameSystem
         TileGridWorld* world = new TileGridWorld;
         TilemapContext* context = (TilemapContext*)params.m_Context;
         world->m_RenderContext = context->m_RenderContext;
+        world->m_WorkerPool = context->m_WorkerPool;
 
         world->m_MaxTilemapCount = context->m_MaxTilemapCount;
         world->m_MaxTileCount = context->m_MaxTileCount;
@@ -505,9 +509,74 @@ namespace dmGameSystem
         region_y = (ptr >> 48) & 0xFFFF;
     }
 
-    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    // Regions per vertex generation job
+    static const uint32_t TILEGRID_VERTEX_CHUNK_SIZE = 2;
+
+    struct TileGridVertexJob
     {
-        DM_PROFILE(TileGrid, "CreateVertexData");
+        TileGridWorld*              m_World;
+        TextureSetResource*         m_TextureSet;
+        dmRender::RenderListEntry*  m_Buf;
+        uint32_t*                   m_Begin;
+        TileGridVertex*             m_Vertices;
+        // Per region in the batch: The tile offset (from m_Vertices) and the tile count
+        uint32_t*                   m_RegionTiles;
+    };
+
+    struct TileGridRegionBounds
+    {
+        const TileGridComponent*    m_Component;
+        uint32_t                    m_Layer;
+        int32_t                     m_MinX, m_MinY, m_MaxX, m_MaxY;
+    };
+
+    static void GetRegionBounds(TileGridWorld* world, uint64_t region_info, TileGridRegionBounds& bounds)
+    {
+        uint32_t index, layer, region_x, region_y;
+        DecodeGridAndLayer(region_info, index, layer, region_x, region_y);
+
+        const TileGridComponent* component = world->m_Components[index];
+        const TileGridResource* resource = component->m_Resource;
+        uint32_t column_count = resource->m_ColumnCount;
+        uint32_t row_count = resource->m_RowCount;
+
+        bounds.m_Component = component;
+        bounds.m_Layer = layer;
+        bounds.m_MinX = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
+        bounds.m_MinY = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
+        bounds.m_MaxX = dmMath::Min(bounds.m_MinX + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
+        bounds.m_MaxY = dmMath::Min(bounds.m_MinY + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
+    }
+
+    static void CountRegionTiles(void* _job, uint32_t begin, uint32_t end)
+    {
+        DM_PROFILE(TileGrid, "CountRegionTiles");
+        TileGridVertexJob* job = (TileGridVertexJob*) _job;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            TileGridRegionBounds bounds;
+            GetRegionBounds(job->m_World, job->m_Buf[job->m_Begin[i]].m_UserData, bounds);
+            const TileGridResource* resource = bounds.m_Component->m_Resource;
+
+            uint32_t count = 0;
+            for (int32_t y = bounds.m_MinY; y < bounds.m_MaxY; ++y)
+            {
+                for (int32_t x = bounds.m_MinX; x < bounds.m_MaxX; ++x)
+                {
+                    uint32_t cell = CalculateCellIndex(bounds.m_Layer, x - resource->m_MinCellX, y - resource->m_MinCellY, resource->m_ColumnCount, resource->m_RowCount);
+                    count += bounds.m_Component->m_Cells[cell] != 0xffff ? 1 : 0;
+                }
+            }
+            job->m_RegionTiles[i * 2 + 1] = count;
+        }
+    }
+
+    // Called from the worker threads
+    static void CreateVertexDataChunk(void* _job, uint32_t begin, uint32_t end)
+    {
+        DM_PROFILE(TileGrid, "CreateVertexDataChunk");
+        DM_COUNTER("TileGridVertexChunks", 1);
+
         static int tex_coord_order[] = {
             0,1,2,2,3,0,
             3,2,1,1,0,3,    //h
@@ -515,21 +584,22 @@ namespace dmGameSystem
             2,3,0,0,1,2     //hv
         };
 
-        dmGameSystemDDF::TextureSet* texture_set_ddf = texture_set->m_TextureSet;
+        TileGridVertexJob* job = (TileGridVertexJob*) _job;
+        dmGameSystemDDF::TextureSet* texture_set_ddf = job->m_TextureSet->m_TextureSet;
         const float* tex_coords = (const float*) texture_set_ddf->m_TexCoords.m_Data;
 
         uint32_t tile_width = texture_set_ddf->m_TileWidth;
         uint32_t tile_height = texture_set_ddf->m_TileHeight;
 
-        for (uint32_t* i = begin; i != end; ++i)
+        for (uint32_t i = begin; i < end; ++i)
         {
-            uint32_t index, layer, region_x, region_y;
-            DecodeGridAndLayer(buf[*i].m_UserData, index, layer, region_x, region_y);
+            TileGridRegionBounds bounds;
+            GetRegionBounds(job->m_World, job->m_Buf[job->m_Begin[i]].m_UserData, bounds);
 
-            const TileGridComponent* component = world->m_Components[index];
+            const TileGridComponent* component = bounds.m_Component;
             const TileGridResource* resource = component->m_Resource;
             dmGameSystemDDF::TileGrid* tile_grid_ddf = resource->m_TileGrid;
-            dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[layer];
+            dmGameSystemDDF::TileLayer* layer_ddf = &tile_grid_ddf->m_Layers[bounds.m_Layer];
 
             const Matrix4& w = component->m_World;
             const float z = layer_ddf->m_Z;
@@ -537,27 +607,21 @@ namespace dmGameSystem
             uint32_t column_count = resource->m_ColumnCount;
             uint32_t row_count = resource->m_RowCount;
 
-            int32_t min_x = resource->m_MinCellX + region_x * TILEGRID_REGION_SIZE;
-            int32_t min_y = resource->m_MinCellY + region_y * TILEGRID_REGION_SIZE;
-            int32_t max_x = dmMath::Min(min_x + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellX + (int32_t)column_count);
-            int32_t max_y = dmMath::Min(min_y + (int32_t)TILEGRID_REGION_SIZE, resource->m_MinCellY + (int32_t)row_count);
+            TileGridVertex* where = job->m_Vertices + job->m_RegionTiles[i * 2] * 6;
+            // Might be less than the number of tiles in the region, if the vertex buffer is full
+            uint32_t tiles_left = job->m_RegionTiles[i * 2 + 1];
 
-            for (int32_t y = min_y; y < max_y; ++y)
+            for (int32_t y = bounds.m_MinY; y < bounds.m_MaxY && tiles_left; ++y)
             {
-                for (int32_t x = min_x; x < max_x; ++x)
+                for (int32_t x = bounds.m_MinX; x < bounds.m_MaxX && tiles_left; ++x)
                 {
-                    uint32_t cell = CalculateCellIndex(layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
+                    uint32_t cell = CalculateCellIndex(bounds.m_Layer, x - resource->m_MinCellX, y - resource->m_MinCellY, column_count, row_count);
                     uint16_t tile = component->m_Cells[cell];
                     if (tile == 0xffff)
                     {
                         continue;
                     }
-
-                    if( where >= world->m_VertexBufferDataEnd )
-                    {
-                        dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
-                        return world->m_VertexBufferDataEnd;
-                    }
+                    --tiles_left;
 
                     float p[4];
                     CalculateCellBounds(x, y, 1, 1, p);
@@ -598,7 +662,53 @@ namespace dmGameSystem
                 }
             }
         }
-        return where;
+    }
+
+    // The tiles of each region are counted first, which gives the output offset of each region.
+    // The regions are then written directly to their final location in the vertex buffer on the worker threads
+    TileGridVertex* CreateVertexData(TileGridWorld* world, TileGridVertex* where, TextureSetResource* texture_set, dmRender::RenderListEntry* buf, uint32_t* begin, uint32_t* end)
+    {
+        DM_PROFILE(TileGrid, "CreateVertexData");
+
+        uint32_t count = end - begin;
+        if (world->m_RegionTiles.Capacity() < count * 2)
+        {
+            world->m_RegionTiles.SetCapacity(count * 2);
+        }
+        world->m_RegionTiles.SetSize(count * 2);
+
+        TileGridVertexJob job;
+        job.m_World = world;
+        job.m_TextureSet = texture_set;
+        job.m_Buf = buf;
+        job.m_Begin = begin;
+        job.m_Vertices = where;
+        job.m_RegionTiles = world->m_RegionTiles.Begin();
+
+        dmWorkerPool::ParallelFor(world->m_WorkerPool, count, TILEGRID_VERTEX_CHUNK_SIZE, CountRegionTiles, &job);
+
+        uint32_t max_tiles = (world->m_VertexBufferDataEnd - where) / 6;
+        uint32_t tile_count = 0;
+        bool out_of_tiles = false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t region_tiles = job.m_RegionTiles[i * 2 + 1];
+            if (tile_count + region_tiles > max_tiles)
+            {
+                if (!out_of_tiles)
+                {
+                    dmLogError("Out of tiles to render (%zu). You can change this with the game.project setting tilemap.max_tile_count", (size_t)((world->m_VertexBufferDataEnd - world->m_VertexBufferData) / 6));
+                    out_of_tiles = true;
+                }
+                region_tiles = max_tiles - tile_count;
+                job.m_RegionTiles[i * 2 + 1] = region_tiles;
+            }
+            job.m_RegionTiles[i * 2] = tile_count;
+            tile_count += region_tiles;
+        }
+
+        dmWorkerPool::ParallelFor(world->m_WorkerPool, count, TILEGRID_VERTEX_CHUNK_SIZE, CreateVertexDataChunk, &job);
+        return where + tile_count * 6;
     }
 
     static void RenderBatch(TileGridWorld* world, dmRender::HRenderContext render_context, dmRender::RenderListEntry *buf, uint32_t* begin, uint32_t* end)
@@ -14,6 +14,7 @@
 #define DM_GAMESYS_H
 
 #include <dlib/configfile.h>
+#include <dlib/worker_pool.h>
 
 #include <script/script.h>
 
@@ -48,6 +49,8 @@ namespace dmGameSystem
             memset(this, 0, sizeof(*this));
         }
         dmRender::HRenderContext    m_RenderContext;
+        /// Used to generate the vertex data in parallel (optional)
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxTilemapCount;
         uint32_t                    m_MaxTileCount;
     };
@@ -63,6 +66,18 @@ namespace dmGameSystem
         uint32_t                    m_Subpixels : 1;
     };
 
+    struct TextureContext
+    {
+        TextureContext()
+        {
+            memset(this, 0, sizeof(*this));
+        }
+        dmGraphics::HContext        m_GraphicsContext;
+        /// Dedicated pool used to decode the mipmaps of WebP compressed textures in parallel (optional).
+        /// Not the shared worker pool, since the decoding runs on the resource loader thread
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
+    };
+
     struct PhysicsContext
     {
         union
@@ -86,6 +101,8 @@ namespace dmGameSystem
         dmRender::HRenderContext m_RenderContext;
         uint32_t m_MaxParticleFXCount;
         uint32_t m_MaxParticleCount;
+        /// Used to simulate the emitters and generate the vertex data in parallel (optional)
+        dmWorkerPool::HWorkerPool m_WorkerPool;
         bool m_Debug;
     };
 
@@ -109,6 +126,8 @@ namespace dmGameSystem
         uint32_t                    m_MaxParticleFXCount;
         uint32_t                    m_MaxParticleCount;
         uint32_t                    m_MaxSpineCount;
+        /// Used to simulate the particle emitters and animate the spine nodes in parallel (optional)
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
     };
 
     struct SpriteContext
@@ -118,6 +137,8 @@ namespace dmGameSystem
             memset(this, 0, sizeof(*this));
         }
         dmRender::HRenderContext    m_RenderContext;
+        /// Used to generate the vertex data in parallel (optional)
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxSpriteCount;
         uint32_t                    m_Subpixels : 1;
     };
@@ -130,6 +151,8 @@ namespace dmGameSystem
         }
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
+        /// Used to animate the rig instances in parallel (optional)
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxSpineModelCount;
     };
 
@@ -141,6 +164,8 @@ namespace dmGameSystem
         }
         dmRender::HRenderContext    m_RenderContext;
         dmResource::HFactory        m_Factory;
+        /// Used to animate the rig instances in parallel (optional)
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint32_t                    m_MaxModelCount;
     };
 
@@ -211,7 +236,8 @@ namespace dmGameSystem
         dmRender::HRenderContext render_context,
         GuiContext* gui_context,
         dmInput::HContext input_context,
-        PhysicsContext* physics_context);
+        PhysicsContext* physics_context,
+        TextureContext* texture_context);
 
     dmGameObject::Result RegisterComponentTypes(dmResource::HFactory factory,
                                                   dmGameObject::HRegister regist,
@@ -93,6 +93,70 @@ namespace dmGameSystem
      * The playback_rate is a non-negative number, a negative value will be clamped to 0.
      */
 
+     /*# [type:number] model lod_update_interval
+     *
+     * The animation level of detail update interval. The model is only animated every n:th frame,
+     * with the time passed since it was last animated, which saves time for models that are far
+     * away or small on screen. The type of the property is [type:number].
+     *
+     * The lod_update_interval is a number that is at least 1 (the default), which animates the model every frame.
+     *
+     * @name lod_update_interval
+     * @property
+     *
+     * @examples
+     *
+     * How to animate the component "model" every third frame:
+     *
+     * ```lua
+     * function init(self)
+     *   go.set("#model", "lod_update_interval", 3)
+     * end
+     * ```
+     */
+
+     /*# [type:number] model lod_bone_count
+     *
+     * The animation level of detail bone count. Only the first lod_bone_count bones of the skeleton
+     * are animated, the remaining bones keep their bind pose. Bones are ordered with a parent before
+     * its children, so the bones closest to the root are the ones animated. The type of the property is [type:number].
+     *
+     * The default value 0 animates all bones.
+     *
+     * @name lod_bone_count
+     * @property
+     *
+     * @examples
+     *
+     * How to only animate the first 8 bones of component "model":
+     *
+     * ```lua
+     * function init(self)
+     *   go.set("#model", "lod_bone_count", 8)
+     * end
+     * ```
+     */
+
+     /*# [type:boolean] model lod_culled
+     *
+     * Whether the model is culled. A culled model is not rendered and its pose (bones and IK)
+     * is not updated, but its animation keeps playing and animation events and completion callbacks
+     * are still sent. The type of the property is [type:boolean].
+     *
+     * @name lod_culled
+     * @property
+     *
+     * @examples
+     *
+     * How to cull the component "model" while it is outside the view:
+     *
+     * ```lua
+     * function update(self, dt)
+     *   go.set("#model", "lod_culled", not self.in_view)
+     * end
+     * ```
+     */
+
      /*# [type:hash] model animation
      *
      * The current animation set on the component. The type of the property is hash.
@@ -99,6 +99,70 @@ namespace dmGameSystem
      * ```
      */
 
+     /*# [type:number] spine lod_update_interval
+     *
+     * The animation level of detail update interval. The spine model is only animated every n:th frame,
+     * with the time passed since it was last animated, which saves time for models that are far
+     * away or small on screen. The type of the property is [type:number].
+     *
+     * The lod_update_interval is a number that is at least 1 (the default), which animates the spine model every frame.
+     *
+     * @name lod_update_interval
+     * @property
+     *
+     * @examples
+     *
+     * How to animate the component "spinemodel" every third frame:
+     *
+     * ```lua
+     * function init(self)
+     *   go.set("#spinemodel", "lod_update_interval", 3)
+     * end
+     * ```
+     */
+
+     /*# [type:number] spine lod_bone_count
+     *
+     * The animation level of detail bone count. Only the first lod_bone_count bones of the skeleton
+     * are animated, the remaining bones keep their bind pose. Bones are ordered with a parent before
+     * its children, so the bones closest to the root are the ones animated. The type of the property is [type:number].
+     *
+     * The default value 0 animates all bones.
+     *
+     * @name lod_bone_count
+     * @property
+     *
+     * @examples
+     *
+     * How to only animate the first 8 bones of component "spinemodel":
+     *
+     * ```lua
+     * function init(self)
+     *   go.set("#spinemodel", "lod_bone_count", 8)
+     * end
+     * ```
+     */
+
+     /*# [type:boolean] spine lod_culled
+     *
+     * Whether the spine model is culled. A culled spine model is not rendered and its pose (bones and IK)
+     * is not updated, but its animation keeps playing and animation events and completion callbacks
+     * are still sent. The type of the property is [type:boolean].
+     *
+     * @name lod_culled
+     * @property
+     *
+     * @examples
+     *
+     * How to cull the component "spinemodel" while it is outside the view:
+     *
+     * ```lua
+     * function update(self, dt)
+     *   go.set("#spinemodel", "lod_culled", not self.in_view)
+     * end
+     * ```
+     */
+
      /*# [type:hash] spine animation
      *
      * [mark:READ ONLY] The current animation set on the component.
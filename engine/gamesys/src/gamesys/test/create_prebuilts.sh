@@ -22,7 +22,7 @@
 # Make sure you have $DYNAMO_HOME setup and built bob-light.jar, then run:
 # ./create_prebuilts.sh
 #
-# It will build the project and copy+rename the Spine files needed by the tests.
+# It will build the projects and copy+rename the Spine, mesh and WebP texture files needed by the tests.
 
 # Move to project directory
 cd spine_prebuilt_project/
@@ -51,3 +51,14 @@ cp build/default/mesh/no_data.bufferc ../mesh/no_data.prebuilt_bufferc
 cp build/default/mesh/no_data.meshc ../mesh/no_data.prebuilt_meshc
 cp build/default/mesh/triangle.bufferc ../mesh/triangle.prebuilt_bufferc
 cp build/default/mesh/triangle.meshc ../mesh/triangle.prebuilt_meshc
+
+cd ..
+
+# Move to texture project directory (WebP compressed through its texture profile)
+cd texture_prebuilt_project/
+
+# Build project using bob-light
+java -jar $DYNAMO_HOME/share/java/bob-light.jar build --texture-compression true
+
+# Copy and rename prebuilt files to test folder
+cp build/default/texture/valid_webp.texturec ../texture/valid_webp.prebuilt_texturec
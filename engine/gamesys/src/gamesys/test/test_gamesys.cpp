@@ -13,6 +13,8 @@
 #include "test_gamesys.h"
 
 #include "../../../../graphics/src/graphics_private.h"
+#include "../../../../graphics/src/null/graphics_null_private.h"
+#include "../../../../render/src/render/render_private.h"
 #include "../../../../resource/src/resource_private.h"
 
 #include "gamesys/resources/res_textureset.h"
@@ -22,6 +24,7 @@
 #include <dlib/dstrings.h>
 #include <dlib/time.h>
 #include <dlib/path.h>
+#include <dlib/worker_pool.h>
 
 #include <ddf/ddf.h>
 #include <gameobject/gameobject_ddf.h>
@@ -126,6 +129,94 @@ TEST_P(ResourceTest, TestPreload)
     dmResource::Release(m_Factory, resource);
 }
 
+// Compares the main thread time spent loading textures synchronously, where both Preload (DDF parsing and
+// decoding of any WebP compressed mipmaps) and Create run on the main thread, with loading them through the
+// preloader, where the main thread only pays for the UpdatePreloader calls.
+TEST_F(ResourceTest, TextureLoadBench)
+{
+    const char* texture_paths[] = {"/texture/valid_png.texturec", "/texture/blank_4096_png.texturec", "/tile/mario_tileset.texturec", "/texture/valid_webp.texturec"};
+    const uint32_t texture_count = sizeof(texture_paths) / sizeof(texture_paths[0]);
+    const uint32_t iterations = 10;
+
+    uint64_t sync_time = 0;
+    uint64_t preload_time = 0;
+    uint64_t preload_main_thread_time = 0;
+    for (uint32_t iter = 0; iter < iterations; ++iter)
+    {
+        for (uint32_t i = 0; i < texture_count; ++i)
+        {
+            void* resource = 0;
+            uint64_t start = dmTime::GetTime();
+            ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, texture_paths[i], &resource));
+            sync_time += dmTime::GetTime() - start;
+            dmResource::Release(m_Factory, resource);
+        }
+
+        for (uint32_t i = 0; i < texture_count; ++i)
+        {
+            uint64_t start = dmTime::GetTime();
+            uint64_t main_thread_time = 0;
+            dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, texture_paths[i]);
+            dmResource::Result r = dmResource::RESULT_PENDING;
+            uint64_t stop_time = start + 30*1e6;
+            while (dmTime::GetTime() < stop_time)
+            {
+                uint64_t update_start = dmTime::GetTime();
+                r = dmResource::UpdatePreloader(pr, 0, 0, 1000);
+                main_thread_time += dmTime::GetTime() - update_start;
+                if (r != dmResource::RESULT_PENDING)
+                    break;
+                dmTime::Sleep(100);
+            }
+            ASSERT_EQ(dmResource::RESULT_OK, r);
+            dmResource::DeletePreloader(pr);
+            preload_time += dmTime::GetTime() - start;
+            preload_main_thread_time += main_thread_time;
+        }
+    }
+
+    printf("Texture load (%u textures x %u): sync get %.3f ms on main thread, preloaded %.3f ms total of which %.3f ms on main thread\n",
+        texture_count, iterations, sync_time / 1000.0, preload_time / 1000.0, preload_main_thread_time / 1000.0);
+}
+
+// The null device keeps the data of the last uploaded mipmap, which for a successfully decoded texture is
+// the 1x1 mipmap of the (opaque) image, and for the blank fallback texture a zeroed 1x1 image.
+static void GetWebPTextureLastMipMap(dmResource::HFactory factory, uint8_t* pixel, uint32_t* resource_size)
+{
+    dmGraphics::HTexture texture = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(factory, "/texture/valid_webp.texturec", (void**) &texture));
+    ASSERT_EQ(128u, dmGraphics::GetTextureWidth(texture));
+    ASSERT_EQ(128u, dmGraphics::GetTextureHeight(texture));
+
+    void* data = 0;
+    ASSERT_EQ(dmGraphics::HANDLE_RESULT_OK, dmGraphics::GetTextureHandle(texture, &data));
+    memcpy(pixel, data, 4);
+    *resource_size = dmGraphics::GetTextureResourceSize(texture);
+    dmResource::Release(factory, texture);
+}
+
+TEST_F(ResourceTest, TextureWebP)
+{
+    uint8_t serial_pixel[4];
+    uint32_t serial_size;
+    GetWebPTextureLastMipMap(m_Factory, serial_pixel, &serial_size);
+    ASSERT_EQ(255u, serial_pixel[3]);
+    ASSERT_NE(0u, serial_pixel[0] + serial_pixel[1] + serial_pixel[2]);
+    // All 8 mipmaps were uploaded, not only the blank texture
+    ASSERT_LT(128u*128u*4u + 64u*64u*4u, serial_size);
+
+    // Decode the mipmaps in parallel
+    m_TextureContext.m_WorkerPool = dmWorkerPool::New(3, "texdecode");
+    uint8_t parallel_pixel[4];
+    uint32_t parallel_size;
+    GetWebPTextureLastMipMap(m_Factory, parallel_pixel, &parallel_size);
+    dmWorkerPool::Delete(m_TextureContext.m_WorkerPool);
+    m_TextureContext.m_WorkerPool = 0;
+
+    ASSERT_EQ(0, memcmp(serial_pixel, parallel_pixel, sizeof(serial_pixel)));
+    ASSERT_EQ(serial_size, parallel_size);
+}
+
 TEST_F(ResourceTest, TestReloadTextureSet)
 {
     const char* texture_set_path_a   = "/textureset/valid_a.texturesetc";
@@ -1120,6 +1211,81 @@ TEST_P(DrawCountTest, DrawCount)
     ASSERT_TRUE(dmGameObject::Final(m_Collection));
 }
 
+/* Vertex Data */
+
+// Spawns the instances in a new collection, draws them and appends the vertex and index buffer data of each render object
+static void RenderVertexData(dmResource::HFactory factory, dmGameObject::HRegister regist, dmRender::HRenderContext render_context, dmGameObject::UpdateContext* update_context,
+                             const char* go_path, uint32_t instance_count, dmArray<uint8_t>& data)
+{
+    dmGameObject::HCollection collection = dmGameObject::NewCollection("vertex_data", factory, regist, 1024);
+    ASSERT_TRUE(dmGameObject::Init(collection));
+
+    for (uint32_t i = 0; i < instance_count; ++i)
+    {
+        char id[32];
+        dmSnPrintf(id, sizeof(id), "/go%u", i);
+        Point3 position((i % 32) * 20.0f, (i / 32) * 20.0f, 0.0f);
+        dmGameObject::HInstance go = Spawn(factory, collection, go_path, dmHashString64(id), 0, 0, position, Quat(0, 0, 0, 1), Vector3(1, 1, 1));
+        ASSERT_NE((void*)0, go);
+    }
+
+    ASSERT_TRUE(dmGameObject::Update(collection, update_context));
+
+    dmRender::RenderListBegin(render_context);
+    dmGameObject::Render(collection);
+    dmRender::RenderListEnd(render_context);
+    dmRender::DrawRenderList(render_context, 0x0, 0x0);
+
+    ASSERT_LT(0u, render_context->m_RenderObjects.Size());
+    for (uint32_t i = 0; i < render_context->m_RenderObjects.Size(); ++i)
+    {
+        const dmRender::RenderObject* ro = render_context->m_RenderObjects[i];
+        const uint32_t range[] = { ro->m_VertexStart, ro->m_VertexCount };
+        const dmGraphics::VertexBuffer* vb = (const dmGraphics::VertexBuffer*) ro->m_VertexBuffer;
+        data.OffsetCapacity(sizeof(range) + vb->m_Size);
+        data.PushArray((const uint8_t*) range, sizeof(range));
+        data.PushArray((const uint8_t*) vb->m_Buffer, vb->m_Size);
+        if (ro->m_IndexBuffer)
+        {
+            const dmGraphics::IndexBuffer* ib = (const dmGraphics::IndexBuffer*) ro->m_IndexBuffer;
+            data.OffsetCapacity(ib->m_Size);
+            data.PushArray((const uint8_t*) ib->m_Buffer, ib->m_Size);
+        }
+    }
+
+    ASSERT_TRUE(dmGameObject::Final(collection));
+    dmGameObject::DeleteCollection(collection);
+    dmGameObject::PostUpdate(regist);
+}
+
+TEST_P(VertexDataTest, ParallelMatchesSerial)
+{
+    const VertexDataParams& p = GetParam();
+
+    // The worlds are created with the collection, so the context settings are picked up by the collections below
+    m_SpriteContext.m_MaxSpriteCount = p.m_InstanceCount;
+    m_TilemapContext.m_MaxTilemapCount = p.m_InstanceCount;
+    m_TilemapContext.m_MaxTileCount = p.m_MaxTileCount;
+
+    dmArray<uint8_t> serial;
+    RenderVertexData(m_Factory, m_Register, m_RenderContext, &m_UpdateContext, p.m_GOPath, p.m_InstanceCount, serial);
+
+    dmWorkerPool::HWorkerPool worker_pool = dmWorkerPool::New(3, "vertexdata");
+    m_SpriteContext.m_WorkerPool = worker_pool;
+    m_TilemapContext.m_WorkerPool = worker_pool;
+
+    dmArray<uint8_t> parallel;
+    RenderVertexData(m_Factory, m_Register, m_RenderContext, &m_UpdateContext, p.m_GOPath, p.m_InstanceCount, parallel);
+
+    m_SpriteContext.m_WorkerPool = 0;
+    m_TilemapContext.m_WorkerPool = 0;
+    dmWorkerPool::Delete(worker_pool);
+
+    ASSERT_LT(0u, serial.Size());
+    ASSERT_EQ(serial.Size(), parallel.Size());
+    ASSERT_EQ(0, memcmp(serial.Begin(), parallel.Begin(), serial.Size()));
+}
+
 /* GUI Box Render */
 
 void AssertVertexEqual(const dmGameSystem::BoxVertex& lhs, const dmGameSystem::BoxVertex& rhs)
@@ -1662,7 +1828,7 @@ INSTANTIATE_TEST_CASE_P(TileSet, ComponentTest, jc_test_values_in(valid_tileset_
 
 /* Texture */
 
-const char* valid_texture_resources[] = {"/texture/valid_png.texturec", "/texture/blank_4096_png.texturec"};
+const char* valid_texture_resources[] = {"/texture/valid_png.texturec", "/texture/blank_4096_png.texturec", "/texture/valid_webp.texturec"};
 INSTANTIATE_TEST_CASE_P(Texture, ResourceTest, jc_test_values_in(valid_texture_resources));
 
 ResourceFailParams invalid_texture_resources[] =
@@ -1828,6 +1994,18 @@ DrawCountParams draw_count_params[] =
 };
 INSTANTIATE_TEST_CASE_P(DrawCount, DrawCountTest, jc_test_values_in(draw_count_params));
 
+/* Compare the vertex data generated on worker threads with the serial output */
+
+VertexDataParams vertex_data_params[] =
+{
+    {"/sprite/valid_sprite.goc", 600, 512},
+    // Sprite geometries, where the chunk offsets are calculated up front
+    {"/sprite/trimmed_sprite.goc", 600, 512},
+    // Runs out of tiles in the middle of a region
+    {"/tile/valid_tilegrid.goc", 64, 202},
+};
+INSTANTIATE_TEST_CASE_P(VertexData, VertexDataTest, jc_test_values_in(vertex_data_params));
+
 /* Validate gui box rendering for different GOs. */
 
 BoxRenderParams box_render_params[] =
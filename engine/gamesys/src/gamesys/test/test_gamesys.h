@@ -64,6 +64,7 @@ protected:
     dmGameSystem::LabelContext m_LabelContext;
     dmGameSystem::TilemapContext m_TilemapContext;
     dmGameSystem::SoundContext m_SoundContext;
+    dmGameSystem::TextureContext m_TextureContext;
     dmRig::HRigContext m_RigContext;
     dmGameObject::ModuleContext m_ModuleContext;
 };
@@ -167,6 +168,19 @@ public:
     virtual ~DrawCountTest() {}
 };
 
+struct VertexDataParams
+{
+    const char* m_GOPath;
+    uint32_t m_InstanceCount;
+    uint32_t m_MaxTileCount;
+};
+
+class VertexDataTest : public GamesysTest<VertexDataParams>
+{
+public:
+    virtual ~VertexDataTest() {}
+};
+
 struct BoxRenderParams
 {
     const static uint8_t MAX_VERTICES_IN_9_SLICED_QUAD = 16;
@@ -328,7 +342,9 @@ void GamesysTest<T>::SetUp()
 
     m_SoundContext.m_MaxComponentCount = 32;
 
-    dmResource::Result r = dmGameSystem::RegisterResourceTypes(m_Factory, m_RenderContext, &m_GuiContext, m_InputContext, &m_PhysicsContext);
+    m_TextureContext.m_GraphicsContext = m_GraphicsContext;
+
+    dmResource::Result r = dmGameSystem::RegisterResourceTypes(m_Factory, m_RenderContext, &m_GuiContext, m_InputContext, &m_PhysicsContext, &m_TextureContext);
     assert(dmResource::RESULT_OK == r);
 
     dmResource::Get(m_Factory, "/input/valid.gamepadsc", (void**)&m_GamepadMapsDDF);
@@ -0,0 +1,4 @@
+components {
+  id: "sprite"
+  component: "/texture/valid_webp.sprite"
+}
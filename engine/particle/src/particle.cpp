@@ -17,6 +17,8 @@
 #include <dlib/hash.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/memory.h>
+#include <dlib/simd.h>
 #include <dlib/vmath.h>
 #include <dlib/profile.h>
 #include <dlib/time.h>
@@ -53,6 +55,140 @@ namespace dmParticle
         memset(this, 0, sizeof(*this));
     }
 
+    void ParticleBuffer::SetCapacity(uint32_t capacity)
+    {
+        float* data = 0x0;
+        uint32_t stride = (capacity + 3) & ~3u;
+        uint32_t size = dmMath::Min(m_Size, capacity);
+        if (capacity > 0)
+        {
+            // The streams are followed by the sort keys (two streams) and one scratch stream
+            uint32_t data_size = (STREAM_COUNT + 3) * stride * sizeof(float);
+            dmMemory::AlignedMalloc((void**)&data, 16, data_size);
+            // Zero the padding, it is processed (and ignored) by the simulation kernels
+            memset(data, 0, data_size);
+            for (uint32_t i = 0; i < STREAM_COUNT; ++i)
+            {
+                memcpy(data + i * stride, m_Data + i * m_Stride, size * sizeof(float));
+            }
+        }
+        if (m_Data)
+        {
+            dmMemory::AlignedFree(m_Data);
+        }
+        m_Data = data;
+        m_Size = size;
+        m_Capacity = capacity;
+        m_Stride = stride;
+    }
+
+    void ParticleBuffer::EraseSwap(uint32_t index)
+    {
+        assert(index < m_Size);
+        uint32_t last = --m_Size;
+        float* stream = m_Data;
+        for (uint32_t i = 0; i < STREAM_COUNT; ++i, stream += m_Stride)
+        {
+            stream[index] = stream[last];
+        }
+    }
+
+    void ParticleBuffer::Get(uint32_t index, Particle* particle) const
+    {
+        particle->SetPosition(GetPosition(index));
+        particle->SetVelocity(GetVelocity(index));
+        particle->SetSourceRotation(GetSourceRotation(index));
+        particle->SetRotation(GetRotation(index));
+        particle->SetScale(GetScale(index));
+        particle->SetSourceColor(GetSourceColor(index));
+        particle->SetColor(GetColor(index));
+        particle->SetTimeLeft(GetTimeLeft(index));
+        particle->SetMaxLifeTime(GetMaxLifeTime(index));
+        particle->SetooMaxLifeTime(GetooMaxLifeTime(index));
+        particle->SetSpreadFactor(GetSpreadFactor(index));
+        particle->SetSourceSize(GetSourceSize(index));
+        particle->m_SourceStretchFactorX = GetStream(STREAM_SOURCE_STRETCH_FACTOR_X)[index];
+        particle->m_SourceStretchFactorY = GetStream(STREAM_SOURCE_STRETCH_FACTOR_Y)[index];
+        particle->m_StretchFactorX = GetStretchFactorX(index);
+        particle->m_StretchFactorY = GetStretchFactorY(index);
+        particle->m_SourceAngularVelocity = GetSourceAngularVelocity(index);
+    }
+
+    void ParticleBuffer::Set(uint32_t index, const Particle& particle)
+    {
+        SetPosition(index, particle.GetPosition());
+        SetVelocity(index, particle.GetVelocity());
+        SetSourceRotation(index, particle.GetSourceRotation());
+        SetRotation(index, particle.GetRotation());
+        SetScale(index, particle.GetScale());
+        SetSourceColor(index, particle.GetSourceColor());
+        SetColor(index, particle.GetColor());
+        SetTimeLeft(index, particle.GetTimeLeft());
+        SetMaxLifeTime(index, particle.GetMaxLifeTime());
+        SetooMaxLifeTime(index, particle.GetooMaxLifeTime());
+        SetSpreadFactor(index, particle.GetSpreadFactor());
+        SetSourceSize(index, particle.GetSourceSize());
+        GetStream(STREAM_SOURCE_STRETCH_FACTOR_X)[index] = particle.m_SourceStretchFactorX;
+        GetStream(STREAM_SOURCE_STRETCH_FACTOR_Y)[index] = particle.m_SourceStretchFactorY;
+        SetStretchFactorX(index, particle.m_StretchFactorX);
+        SetStretchFactorY(index, particle.m_StretchFactorY);
+        SetSourceAngularVelocity(index, particle.m_SourceAngularVelocity);
+    }
+
+    /*
+     * Helpers for the simulation kernels, which process four particles at a time.
+     * The operation order matches the vectormath library, so the results are identical to the scalar code.
+     */
+
+    static inline dmSIMD::Vector4f LoadStream(const ParticleBuffer& particles, ParticleStream stream, uint32_t i)
+    {
+        return dmSIMD::Load(particles.GetStream(stream) + i);
+    }
+
+    static inline void StoreStream(ParticleBuffer& particles, ParticleStream stream, uint32_t i, dmSIMD::Vector4f v)
+    {
+        dmSIMD::Store(particles.GetStream(stream) + i, v);
+    }
+
+    /// rotate(q, v)
+    static inline void Rotate4(dmSIMD::Vector4f qx, dmSIMD::Vector4f qy, dmSIMD::Vector4f qz, dmSIMD::Vector4f qw,
+                               dmSIMD::Vector4f vx, dmSIMD::Vector4f vy, dmSIMD::Vector4f vz, dmSIMD::Vector4f out[3])
+    {
+        using namespace dmSIMD;
+        Vector4f tx = Sub(Add(Mul(qw, vx), Mul(qy, vz)), Mul(qz, vy));
+        Vector4f ty = Sub(Add(Mul(qw, vy), Mul(qz, vx)), Mul(qx, vz));
+        Vector4f tz = Sub(Add(Mul(qw, vz), Mul(qx, vy)), Mul(qy, vx));
+        Vector4f tw = Add(Add(Mul(qx, vx), Mul(qy, vy)), Mul(qz, vz));
+        out[0] = Add(Sub(Add(Mul(tw, qx), Mul(tx, qw)), Mul(ty, qz)), Mul(tz, qy));
+        out[1] = Add(Sub(Add(Mul(tw, qy), Mul(ty, qw)), Mul(tz, qx)), Mul(tx, qz));
+        out[2] = Add(Sub(Add(Mul(tw, qz), Mul(tz, qw)), Mul(tx, qy)), Mul(ty, qx));
+    }
+
+    /// a * b
+    static inline void MulQuat4(dmSIMD::Vector4f ax, dmSIMD::Vector4f ay, dmSIMD::Vector4f az, dmSIMD::Vector4f aw,
+                                dmSIMD::Vector4f bx, dmSIMD::Vector4f by, dmSIMD::Vector4f bz, dmSIMD::Vector4f bw, dmSIMD::Vector4f out[4])
+    {
+        using namespace dmSIMD;
+        out[0] = Sub(Add(Add(Mul(aw, bx), Mul(ax, bw)), Mul(ay, bz)), Mul(az, by));
+        out[1] = Sub(Add(Add(Mul(aw, by), Mul(ay, bw)), Mul(az, bx)), Mul(ax, bz));
+        out[2] = Sub(Add(Add(Mul(aw, bz), Mul(az, bw)), Mul(ax, by)), Mul(ay, bx));
+        out[3] = Sub(Sub(Sub(Mul(aw, bw), Mul(ax, bx)), Mul(ay, by)), Mul(az, bz));
+    }
+
+    static inline dmSIMD::Vector4f LengthSqr4(dmSIMD::Vector4f x, dmSIMD::Vector4f y, dmSIMD::Vector4f z)
+    {
+        return dmSIMD::Add(dmSIMD::Add(dmSIMD::Mul(x, x), dmSIMD::Mul(y, y)), dmSIMD::Mul(z, z));
+    }
+
+    /// normalize(v)
+    static inline void Normalize4(dmSIMD::Vector4f v[3])
+    {
+        dmSIMD::Vector4f len_inv = dmSIMD::Div(dmSIMD::Splat(1.0f), dmSIMD::Sqrt(LengthSqr4(v[0], v[1], v[2])));
+        v[0] = dmSIMD::Mul(v[0], len_inv);
+        v[1] = dmSIMD::Mul(v[1], len_inv);
+        v[2] = dmSIMD::Mul(v[2], len_inv);
+    }
+
     void ResetEmitterStateChangedData(Instance* instance)
     {
         // Deallocate callback data if it is present
@@ -97,6 +233,11 @@ namespace dmParticle
         context->m_MaxParticleCount = max_particle_count;
     }
 
+    void SetWorkerPool(HParticleContext context, dmWorkerPool::HWorkerPool worker_pool)
+    {
+        context->m_WorkerPool = worker_pool;
+    }
+
     static Instance* GetInstance(HParticleContext context, HInstance instance)
     {
         if (instance == INVALID_INSTANCE)
@@ -468,7 +609,7 @@ namespace dmParticle
     static void ResetEmitter(Emitter* emitter)
     {
         // Save particles array and id
-        dmArray<Particle> tmp;
+        ParticleBuffer tmp;
         tmp.Swap(emitter->m_Particles);
         dmhash_t id = emitter->m_Id;
         uint32_t original_seed = emitter->m_OriginalSeed;
@@ -654,12 +795,137 @@ namespace dmParticle
         context->m_Stats.m_Particles = vertex_index / 6; // Debug data for editor playback
     }
 
+    struct EmitterPassContext
+    {
+        Context*                m_Context;
+        EmitterJob*             m_Jobs;
+        float                   m_Dt;
+        void*                   m_VertexBuffer;
+        uint32_t                m_VertexBufferSize;
+        ParticleVertexFormat    m_VertexFormat;
+    };
+
+    static void UpdateParticlesRange(void* ctx, uint32_t begin, uint32_t end)
+    {
+        EmitterPassContext* pass = (EmitterPassContext*)ctx;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            EmitterJob* job = &pass->m_Jobs[i];
+            if (!job->m_Simulate)
+                continue;
+            dmParticleDDF::Emitter* emitter_ddf = &job->m_Instance->m_Prototype->m_DDF->m_Emitters[job->m_EmitterIndex];
+            UpdateParticles(job->m_Instance, job->m_Emitter, emitter_ddf, pass->m_Dt);
+        }
+    }
+
+    static void SimulateRange(void* ctx, uint32_t begin, uint32_t end)
+    {
+        EmitterPassContext* pass = (EmitterPassContext*)ctx;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            EmitterJob* job = &pass->m_Jobs[i];
+            if (!job->m_Simulate)
+                continue;
+            Prototype* prototype = job->m_Instance->m_Prototype;
+            EmitterPrototype* emitter_prototype = &prototype->m_Emitters[job->m_EmitterIndex];
+            dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[job->m_EmitterIndex];
+            GenerateKeys(job->m_Emitter, emitter_prototype->m_MaxParticleLifeTime);
+            SortParticles(job->m_Emitter);
+            Simulate(job->m_Instance, job->m_Emitter, emitter_prototype, emitter_ddf, pass->m_Dt);
+        }
+    }
+
+    static void GenerateVertexDataRange(void* ctx, uint32_t begin, uint32_t end)
+    {
+        EmitterPassContext* pass = (EmitterPassContext*)ctx;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            EmitterJob* job = &pass->m_Jobs[i];
+            dmParticleDDF::Emitter* emitter_ddf = &job->m_Instance->m_Prototype->m_DDF->m_Emitters[job->m_EmitterIndex];
+            UpdateRenderData(pass->m_Context, job->m_Instance, job->m_Emitter, emitter_ddf, job->m_Color, job->m_VertexIndex, pass->m_VertexBuffer, pass->m_VertexBufferSize, pass->m_Dt, pass->m_VertexFormat);
+        }
+    }
+
+    void GenerateVertexDataBatch(HParticleContext context, float dt, const EmitterVertexData* emitters, uint32_t emitter_count, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format)
+    {
+        DM_PROFILE(Particle, "GenerateVertexDataBatch");
+
+        uint32_t vertex_size = sizeof(Vertex);
+
+        if (vertex_format == PARTICLE_GUI)
+        {
+            vertex_size = sizeof(ParticleGuiVertex);
+        }
+
+        uint32_t vertex_index = *out_vertex_buffer_size / vertex_size;
+        uint32_t max_vertex_count = vertex_buffer_size / vertex_size;
+        bool generate = vertex_buffer != 0x0 && vertex_buffer_size > 0;
+
+        // Reserve the same vertex ranges as consecutive calls to GenerateVertexData would use,
+        // so that the emitters can write their vertices independently of each other
+        dmArray<EmitterJob>& jobs = context->m_EmitterJobs;
+        jobs.SetSize(0);
+        if (jobs.Capacity() < emitter_count)
+        {
+            jobs.SetCapacity(emitter_count);
+        }
+
+        for (uint32_t i = 0; i < emitter_count; ++i)
+        {
+            const EmitterVertexData& data = emitters[i];
+            if (data.m_Instance == INVALID_INSTANCE)
+                continue;
+
+            Instance* inst = GetInstance(context, data.m_Instance);
+
+            if (IsSleeping(inst))
+                continue;
+
+            EmitterJob job;
+            job.m_Instance = inst;
+            job.m_Emitter = &inst->m_Emitters[data.m_EmitterIndex];
+            job.m_Color = data.m_Color;
+            job.m_InstanceHandle = data.m_Instance;
+            job.m_VertexIndex = vertex_index;
+            job.m_EmitterIndex = data.m_EmitterIndex;
+            job.m_Simulate = 0;
+            jobs.Push(job);
+
+            if (generate)
+            {
+                uint32_t free_vertex_count = vertex_index < max_vertex_count ? max_vertex_count - vertex_index : 0;
+                vertex_index += dmMath::Min(job.m_Emitter->m_Particles.Size(), free_vertex_count / 6) * 6;
+            }
+        }
+
+        if (jobs.Empty())
+            return;
+
+        if (generate)
+        {
+            EmitterPassContext pass;
+            pass.m_Context = context;
+            pass.m_Jobs = jobs.Begin();
+            pass.m_Dt = dt;
+            pass.m_VertexBuffer = vertex_buffer;
+            pass.m_VertexBufferSize = vertex_buffer_size;
+            pass.m_VertexFormat = vertex_format;
+            dmWorkerPool::ParallelFor(context->m_WorkerPool, jobs.Size(), 1, GenerateVertexDataRange, &pass);
+        }
+
+        *out_vertex_buffer_size = vertex_index * vertex_size;
+
+        context->m_Stats.m_Particles = vertex_index / 6; // Debug data for editor playback
+    }
+
     void Update(HParticleContext context, float dt, FetchAnimationCallback fetch_animation_callback)
     {
         DM_PROFILE(Particle, "Update");
 
+        dmArray<EmitterJob>& jobs = context->m_EmitterJobs;
+        jobs.SetSize(0);
+
         uint32_t size = context->m_Instances.Size();
-        uint32_t TotalAliveParticles = 0;
         for (uint32_t i = 0; i < size; i++)
         {
             Instance* instance = context->m_Instances[i];
@@ -682,25 +948,66 @@ namespace dmParticle
             }
             uint32_t instance_handle = instance->m_VersionNumber << 16 | i;
             instance->m_PlayTime += dt;
-            Prototype* prototype = instance->m_Prototype;
             uint32_t emitter_count = instance->m_Emitters.Size();
+            if (jobs.Remaining() < emitter_count)
+            {
+                jobs.OffsetCapacity(dmMath::Max(emitter_count, jobs.Capacity()));
+            }
             for (uint32_t emitter_i = 0; emitter_i < emitter_count; ++emitter_i)
             {
                 Emitter* emitter = &instance->m_Emitters[emitter_i];
-                EmitterPrototype* emitter_prototype = &prototype->m_Emitters[emitter_i];
-                dmParticleDDF::Emitter* emitter_ddf = &prototype->m_DDF->m_Emitters[emitter_i];
-
+                dmParticleDDF::Emitter* emitter_ddf = &instance->m_Prototype->m_DDF->m_Emitters[emitter_i];
                 UpdateEmitterVelocity(instance, emitter, emitter_ddf, dt);
-                UpdateEmitter(prototype, instance, emitter_prototype, emitter, emitter_ddf, dt);
-                TotalAliveParticles += (uint32_t)emitter->m_Particles.Size();
-                FetchAnimation(emitter, emitter_prototype, fetch_animation_callback);
-                UpdateEmitterRenderData(instance_handle, emitter_i, instance, emitter, emitter_ddf);
 
-                if (emitter->m_ReHash)
-                    ReHashEmitter(emitter);
+                EmitterJob job;
+                job.m_Instance = instance;
+                job.m_Emitter = emitter;
+                job.m_InstanceHandle = instance_handle;
+                job.m_VertexIndex = 0;
+                job.m_EmitterIndex = emitter_i;
+                // Don't update emitter if time is standing still
+                job.m_Simulate = !IsSleeping(emitter) && dt > 0.0f;
+                jobs.Push(job);
             }
         }
 
+        // The emitters only share state when spawning, which also runs the emitter state callbacks.
+        // Step the particles and simulate them in parallel, but spawn on this thread in emitter order.
+        EmitterPassContext pass;
+        memset(&pass, 0, sizeof(pass));
+        pass.m_Context = context;
+        pass.m_Jobs = jobs.Begin();
+        pass.m_Dt = dt;
+        uint32_t job_count = jobs.Size();
+
+        dmWorkerPool::ParallelFor(context->m_WorkerPool, job_count, 1, UpdateParticlesRange, &pass);
+
+        for (uint32_t i = 0; i < job_count; ++i)
+        {
+            EmitterJob* job = &jobs[i];
+            if (!job->m_Simulate)
+                continue;
+            Prototype* prototype = job->m_Instance->m_Prototype;
+            UpdateEmitterState(job->m_Instance, job->m_Emitter, &prototype->m_Emitters[job->m_EmitterIndex], &prototype->m_DDF->m_Emitters[job->m_EmitterIndex], dt);
+        }
+
+        dmWorkerPool::ParallelFor(context->m_WorkerPool, job_count, 1, SimulateRange, &pass);
+
+        uint32_t TotalAliveParticles = 0;
+        for (uint32_t i = 0; i < job_count; ++i)
+        {
+            EmitterJob* job = &jobs[i];
+            Instance* instance = job->m_Instance;
+            Emitter* emitter = job->m_Emitter;
+            Prototype* prototype = instance->m_Prototype;
+            TotalAliveParticles += (uint32_t)emitter->m_Particles.Size();
+            FetchAnimation(emitter, &prototype->m_Emitters[job->m_EmitterIndex], fetch_animation_callback);
+            UpdateEmitterRenderData(job->m_InstanceHandle, job->m_EmitterIndex, instance, emitter, &prototype->m_DDF->m_Emitters[job->m_EmitterIndex]);
+
+            if (emitter->m_ReHash)
+                ReHashEmitter(emitter);
+        }
+
         DM_COUNTER("Particles alive", TotalAliveParticles);
     }
 
@@ -731,14 +1038,21 @@ namespace dmParticle
     {
         DM_PROFILE(Particle, "UpdateParticles");
 
-        // Step particle life, prune dead particles
-        uint32_t particle_count = emitter->m_Particles.Size();
+        // Step particle life
+        ParticleBuffer& particles = emitter->m_Particles;
+        uint32_t particle_count = particles.Size();
+        float* time_left = particles.GetStream(STREAM_TIME_LEFT);
+        dmSIMD::Vector4f dt4 = dmSIMD::Splat(dt);
+        for (uint32_t i = 0; i < particle_count; i += 4)
+        {
+            dmSIMD::Store(time_left + i, dmSIMD::Sub(dmSIMD::Load(time_left + i), dt4));
+        }
+
+        // Prune dead particles
         uint32_t j = 0;
         while (j < particle_count)
         {
-            Particle* p = &emitter->m_Particles[j];
-            p->SetTimeLeft(p->GetTimeLeft() - dt);
-            if (p->GetTimeLeft() < 0.0f)
+            if (time_left[j] < 0.0f)
             {
                 // TODO Handle death-action
                 emitter->m_Particles.EraseSwap(j);
@@ -749,7 +1063,7 @@ namespace dmParticle
         }
     }
 
-    static void SpawnParticle(dmArray<Particle>& particles, uint32_t* seed, dmParticleDDF::Emitter* ddf, const dmTransform::TransformS1& emitter_transform, Vector3 emitter_velocity, float emitter_properties[EMITTER_KEY_COUNT], float dt);
+    static void SpawnParticle(ParticleBuffer& particles, uint32_t* seed, dmParticleDDF::Emitter* ddf, const dmTransform::TransformS1& emitter_transform, Vector3 emitter_velocity, float emitter_properties[EMITTER_KEY_COUNT], float dt);
 
     static void UpdateEmitterState(Instance* instance, Emitter* emitter, EmitterPrototype* emitter_prototype, dmParticleDDF::Emitter* emitter_ddf, float dt)
     {
@@ -828,13 +1142,12 @@ namespace dmParticle
         return particle_count * vertices_per_particle;
     }
 
-    static void SpawnParticle(dmArray<Particle>& particles, uint32_t* seed, dmParticleDDF::Emitter* ddf, const dmTransform::TransformS1& emitter_transform, Vector3 emitter_velocity, float emitter_properties[EMITTER_KEY_COUNT], float dt)
+    static void SpawnParticle(ParticleBuffer& particles, uint32_t* seed, dmParticleDDF::Emitter* ddf, const dmTransform::TransformS1& emitter_transform, Vector3 emitter_velocity, float emitter_properties[EMITTER_KEY_COUNT], float dt)
     {
         DM_PROFILE(Particle, "Spawn");
 
-        uint32_t particle_count = particles.Size();
-        particles.SetSize(particle_count + 1);
-        Particle *particle = &particles[particle_count];
+        Particle new_particle;
+        Particle *particle = &new_particle;
         memset(particle, 0, sizeof(Particle));
 
         // TODO Handle birth-action
@@ -998,6 +1311,10 @@ namespace dmParticle
         particle->m_SourceStretchFactorY = emitter_properties[EMITTER_KEY_PARTICLE_STRETCH_FACTOR_Y];
         particle->m_StretchFactorY = particle->m_SourceStretchFactorY;
         particle->m_SourceAngularVelocity = emitter_properties[EMITTER_KEY_PARTICLE_ANGULAR_VELOCITY];
+
+        uint32_t particle_count = particles.Size();
+        particles.SetSize(particle_count + 1);
+        particles.Set(particle_count, new_particle);
     }
 
     static float unit_tex_coords[] =
@@ -1056,7 +1373,6 @@ namespace dmParticle
 
         // calculate emission space
         dmTransform::TransformS1 emission_transform;
-        dmTransform::Transform particle_transform;
         emission_transform.SetIdentity();
         if (ddf->m_Space == EMISSION_SPACE_EMITTER)
         {
@@ -1084,83 +1400,142 @@ namespace dmParticle
             height_factor *= 0.5f;
         }
 
-        for (j = 0; j < particle_count && vertex_index + 6 <= max_vertex_count; j++)
+        uint32_t flip_flag = 0;
+        if (hFlip)
+        {
+            flip_flag = 1;
+        }
+        if (vFlip)
+        {
+            flip_flag |= 2;
+        }
+        const int* tex_lookup = &tex_coord_order[flip_flag * 6];
+
+        const ParticleBuffer& particles = emitter->m_Particles;
+        const float* time_left = particles.GetStream(STREAM_TIME_LEFT);
+        const float* max_life_time = particles.GetStream(STREAM_MAX_LIFE_TIME);
+        const float* oo_max_life_time = particles.GetStream(STREAM_OO_MAX_LIFE_TIME);
+
+        Quat emission_rotation = emission_transform.GetRotation();
+        Vector3 emission_translation = emission_transform.GetTranslation();
+        dmSIMD::Vector4f erx = dmSIMD::Splat(emission_rotation.getX());
+        dmSIMD::Vector4f ery = dmSIMD::Splat(emission_rotation.getY());
+        dmSIMD::Vector4f erz = dmSIMD::Splat(emission_rotation.getZ());
+        dmSIMD::Vector4f erw = dmSIMD::Splat(emission_rotation.getW());
+        dmSIMD::Vector4f etx = dmSIMD::Splat(emission_translation.getX());
+        dmSIMD::Vector4f ety = dmSIMD::Splat(emission_translation.getY());
+        dmSIMD::Vector4f etz = dmSIMD::Splat(emission_translation.getZ());
+        dmSIMD::Vector4f es = dmSIMD::Splat(emission_transform.GetScale());
+        dmSIMD::Vector4f zero = dmSIMD::Splat(0.0f);
+        dmSIMD::Vector4f one = dmSIMD::Splat(1.0f);
+        dmSIMD::Vector4f tint_r = dmSIMD::Splat(color.getX());
+        dmSIMD::Vector4f tint_g = dmSIMD::Splat(color.getY());
+        dmSIMD::Vector4f tint_b = dmSIMD::Splat(color.getZ());
+        dmSIMD::Vector4f tint_a = dmSIMD::Splat(color.getW());
+
+        // Four particles at a time, the vertices are written per particle
+        for (j = 0; j < particle_count && vertex_index + 6 <= max_vertex_count; )
         {
-            Particle* particle = &emitter->m_Particles[j];
+            uint32_t i = j;
+            uint32_t lane_count = dmMath::Min(particle_count - i, 4u);
+
             // Evaluate anim frame
-            uint32_t tile = 0;
-            Vector3 size;
-            if (anim_playing)
+            float* lane_tex_coords[4];
+            float lane_width_factors[4];
+            float lane_height_factors[4];
+            for (uint32_t k = 0; k < 4; ++k)
             {
-                float anim_cursor = particle->GetMaxLifeTime() - particle->GetTimeLeft() - half_dt;
-                float anim_t = 0.0f;
-                if (anim_once) // stretch over particle life
+                uint32_t tile = 0;
+                if (anim_playing && k < lane_count)
                 {
-                    anim_t = anim_cursor * particle->GetooMaxLifeTime();
-                }
-                else // use anim FPS
-                {
-                    anim_t = anim_cursor * inv_anim_length;
-                }
-                tile = (uint32_t)(tile_count * anim_t);
-                tile = tile % tile_count;
-                if (tile >= interval) {
-                    tile = (interval-1) * 2 - tile;
-                }
-                if (anim_bwd)
-                    tile = tile_count - tile - 1;
+                    float anim_cursor = max_life_time[i + k] - time_left[i + k] - half_dt;
+                    float anim_t = 0.0f;
+                    if (anim_once) // stretch over particle life
+                    {
+                        anim_t = anim_cursor * oo_max_life_time[i + k];
+                    }
+                    else // use anim FPS
+                    {
+                        anim_t = anim_cursor * inv_anim_length;
+                    }
+                    tile = (uint32_t)(tile_count * anim_t);
+                    tile = tile % tile_count;
+                    if (tile >= interval) {
+                        tile = (interval-1) * 2 - tile;
+                    }
+                    if (anim_bwd)
+                        tile = tile_count - tile - 1;
 
-                size = particle->GetScale();
-                if(anim_auto_size)
-                {
-                    const float* td = &tex_dims[(start_tile + tile) << 1];
-                    width_factor = td[0] * 0.5;
-                    height_factor = td[1] * 0.5;
-                }
-                else
-                {
-                    size *= particle->GetSourceSize();
+                    if(anim_auto_size)
+                    {
+                        const float* td = &tex_dims[(start_tile + tile) << 1];
+                        width_factor = td[0] * 0.5;
+                        height_factor = td[1] * 0.5;
+                    }
                 }
+                tile += start_tile;
+                lane_tex_coords[k] = &tex_coords[tile << 3];
+                lane_width_factors[k] = width_factor;
+                lane_height_factors[k] = height_factor;
             }
-            else
-            {
-                size = particle->GetScale() * particle->GetSourceSize();
-            }
-            tile += start_tile;
-            float* tex_coord = &tex_coords[tile << 3];
-
-            particle_transform.SetTranslation(Vector3(particle->GetPosition()));
-            particle_transform.SetRotation(particle->GetRotation());
-            particle_transform.SetScale(size);
-            particle_transform.SetRotation(emission_transform.GetRotation() * particle_transform.GetRotation());
-            particle_transform.SetTranslation(Vector3(Apply(emission_transform, Point3(particle_transform.GetTranslation()))));
-            particle_transform.SetScale(emission_transform.GetScale() * particle_transform.GetScale());
-
-            Vector3 x = dmTransform::Apply(particle_transform, Vector3(width_factor, 0.0f, 0.0f));
-            Vector3 y = dmTransform::Apply(particle_transform, Vector3(0.0f, height_factor, 0.0f));
-
-            Vector3 p0 = -x - y + particle_transform.GetTranslation();
-            Vector3 p1 = -x + y + particle_transform.GetTranslation();
-            Vector3 p2 = x - y + particle_transform.GetTranslation();
-            Vector3 p3 = x + y + particle_transform.GetTranslation();
-
-            uint32_t flip_flag = 0;
-            if (hFlip)
-            {
-                flip_flag = 1;
-            }
-            if (vFlip)
+
+            // The size is the scale, multiplied with the source size unless the animation decides the size
+            dmSIMD::Vector4f source_size = anim_auto_size ? one : LoadStream(particles, STREAM_SOURCE_SIZE, i);
+            dmSIMD::Vector4f sx = dmSIMD::Mul(es, dmSIMD::Mul(LoadStream(particles, STREAM_SCALE_X, i), source_size));
+            dmSIMD::Vector4f sy = dmSIMD::Mul(es, dmSIMD::Mul(LoadStream(particles, STREAM_SCALE_Y, i), source_size));
+            dmSIMD::Vector4f sz = dmSIMD::Mul(es, dmSIMD::Mul(LoadStream(particles, STREAM_SCALE_Z, i), source_size));
+
+            // Particle rotation in emission space
+            dmSIMD::Vector4f r[4];
+            MulQuat4(erx, ery, erz, erw,
+                     LoadStream(particles, STREAM_ROTATION_X, i), LoadStream(particles, STREAM_ROTATION_Y, i),
+                     LoadStream(particles, STREAM_ROTATION_Z, i), LoadStream(particles, STREAM_ROTATION_W, i), r);
+
+            // Particle position in emission space
+            dmSIMD::Vector4f t[3];
+            Rotate4(erx, ery, erz, erw,
+                    dmSIMD::Mul(LoadStream(particles, STREAM_POSITION_X, i), es),
+                    dmSIMD::Mul(LoadStream(particles, STREAM_POSITION_Y, i), es),
+                    dmSIMD::Mul(LoadStream(particles, STREAM_POSITION_Z, i), es), t);
+            t[0] = dmSIMD::Add(t[0], etx);
+            t[1] = dmSIMD::Add(t[1], ety);
+            t[2] = dmSIMD::Add(t[2], etz);
+
+            // Quad extents
+            dmSIMD::Vector4f x[3];
+            dmSIMD::Vector4f y[3];
+            Rotate4(r[0], r[1], r[2], r[3], dmSIMD::Mul(dmSIMD::Load(lane_width_factors), sx), dmSIMD::Mul(zero, sy), dmSIMD::Mul(zero, sz), x);
+            Rotate4(r[0], r[1], r[2], r[3], dmSIMD::Mul(zero, sx), dmSIMD::Mul(dmSIMD::Load(lane_height_factors), sy), dmSIMD::Mul(zero, sz), y);
+
+            float corners[4][3][4];
+            for (uint32_t k = 0; k < 3; ++k)
             {
-                flip_flag |= 2;
+                dmSIMD::Vector4f neg_x = dmSIMD::Neg(x[k]);
+                dmSIMD::Store(corners[0][k], dmSIMD::Add(dmSIMD::Sub(neg_x, y[k]), t[k]));
+                dmSIMD::Store(corners[1][k], dmSIMD::Add(dmSIMD::Add(neg_x, y[k]), t[k]));
+                dmSIMD::Store(corners[2][k], dmSIMD::Add(dmSIMD::Sub(x[k], y[k]), t[k]));
+                dmSIMD::Store(corners[3][k], dmSIMD::Add(dmSIMD::Add(x[k], y[k]), t[k]));
             }
-            const int* tex_lookup = &tex_coord_order[flip_flag * 6];
 
-            Vector4 c = particle->GetColor();
-            c = Vector4(mulPerElem(c.getXYZ(), color.getXYZ()), c.getW() * color.getW());
+            float colors[4][4];
+            dmSIMD::Store(colors[0], dmSIMD::Mul(LoadStream(particles, STREAM_COLOR_R, i), tint_r));
+            dmSIMD::Store(colors[1], dmSIMD::Mul(LoadStream(particles, STREAM_COLOR_G, i), tint_g));
+            dmSIMD::Store(colors[2], dmSIMD::Mul(LoadStream(particles, STREAM_COLOR_B, i), tint_b));
+            dmSIMD::Store(colors[3], dmSIMD::Mul(LoadStream(particles, STREAM_COLOR_A, i), tint_a));
 
-            if (format == PARTICLE_GO)
+            for (uint32_t k = 0; k < lane_count && vertex_index + 6 <= max_vertex_count; ++k, ++j)
             {
-                Vertex* vertex = &((Vertex*)vertex_buffer)[vertex_index];
+                Vector3 p0(corners[0][0][k], corners[0][1][k], corners[0][2][k]);
+                Vector3 p1(corners[1][0][k], corners[1][1][k], corners[1][2][k]);
+                Vector3 p2(corners[2][0][k], corners[2][1][k], corners[2][2][k]);
+                Vector3 p3(corners[3][0][k], corners[3][1][k], corners[3][2][k]);
+                Vector4 c(colors[0][k], colors[1][k], colors[2][k], colors[3][k]);
+                const float* tex_coord = lane_tex_coords[k];
+
+
+                if (format == PARTICLE_GO)
+                {
+                    Vertex* vertex = &((Vertex*)vertex_buffer)[vertex_index];
 
 #define SET_VERTEX_GO(vertex, p, c, u, v)\
     vertex->m_X = p.getX();\
@@ -1173,23 +1548,23 @@ namespace dmParticle
     vertex->m_U = u;\
     vertex->m_V = v;
 
-                SET_VERTEX_GO(vertex, p0, c, tex_coord[tex_lookup[0] * 2], tex_coord[tex_lookup[0] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GO(vertex, p1, c, tex_coord[tex_lookup[1] * 2], tex_coord[tex_lookup[1] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GO(vertex, p3, c, tex_coord[tex_lookup[2] * 2], tex_coord[tex_lookup[2] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GO(vertex, p3, c, tex_coord[tex_lookup[3] * 2], tex_coord[tex_lookup[3] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GO(vertex, p2, c, tex_coord[tex_lookup[4] * 2], tex_coord[tex_lookup[4] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GO(vertex, p0, c, tex_coord[tex_lookup[5] * 2], tex_coord[tex_lookup[5] * 2 + 1])
+                    SET_VERTEX_GO(vertex, p0, c, tex_coord[tex_lookup[0] * 2], tex_coord[tex_lookup[0] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GO(vertex, p1, c, tex_coord[tex_lookup[1] * 2], tex_coord[tex_lookup[1] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GO(vertex, p3, c, tex_coord[tex_lookup[2] * 2], tex_coord[tex_lookup[2] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GO(vertex, p3, c, tex_coord[tex_lookup[3] * 2], tex_coord[tex_lookup[3] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GO(vertex, p2, c, tex_coord[tex_lookup[4] * 2], tex_coord[tex_lookup[4] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GO(vertex, p0, c, tex_coord[tex_lookup[5] * 2], tex_coord[tex_lookup[5] * 2 + 1])
 
 #undef SET_VERTEX_GO
-            }
-            else if (format == PARTICLE_GUI)
-            {
-                ParticleGuiVertex* vertex = &((ParticleGuiVertex*)vertex_buffer)[vertex_index];
+                }
+                else if (format == PARTICLE_GUI)
+                {
+                    ParticleGuiVertex* vertex = &((ParticleGuiVertex*)vertex_buffer)[vertex_index];
 
 #define SET_VERTEX_GUI(vertex, p, c, u, v)\
     vertex->m_Position[0] = p.getX();\
@@ -1202,21 +1577,22 @@ namespace dmParticle
     vertex->m_UV[0] = u;\
     vertex->m_UV[1] = v;
 
-                SET_VERTEX_GUI(vertex, p0, c, tex_coord[tex_lookup[0] * 2], tex_coord[tex_lookup[0] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GUI(vertex, p1, c, tex_coord[tex_lookup[1] * 2], tex_coord[tex_lookup[1] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GUI(vertex, p3, c, tex_coord[tex_lookup[2] * 2], tex_coord[tex_lookup[2] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GUI(vertex, p3, c, tex_coord[tex_lookup[3] * 2], tex_coord[tex_lookup[3] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GUI(vertex, p2, c, tex_coord[tex_lookup[4] * 2], tex_coord[tex_lookup[4] * 2 + 1])
-                ++vertex;
-                SET_VERTEX_GUI(vertex, p0, c, tex_coord[tex_lookup[5] * 2], tex_coord[tex_lookup[5] * 2 + 1])
+                    SET_VERTEX_GUI(vertex, p0, c, tex_coord[tex_lookup[0] * 2], tex_coord[tex_lookup[0] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GUI(vertex, p1, c, tex_coord[tex_lookup[1] * 2], tex_coord[tex_lookup[1] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GUI(vertex, p3, c, tex_coord[tex_lookup[2] * 2], tex_coord[tex_lookup[2] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GUI(vertex, p3, c, tex_coord[tex_lookup[3] * 2], tex_coord[tex_lookup[3] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GUI(vertex, p2, c, tex_coord[tex_lookup[4] * 2], tex_coord[tex_lookup[4] * 2 + 1])
+                    ++vertex;
+                    SET_VERTEX_GUI(vertex, p0, c, tex_coord[tex_lookup[5] * 2], tex_coord[tex_lookup[5] * 2 + 1])
 #undef SET_VERTEX_GUI
-            }
+                }
 
-            vertex_index += 6;
+                vertex_index += 6;
+            }
         }
         if (j < particle_count)
         {
@@ -1235,35 +1611,22 @@ namespace dmParticle
         return emitter->m_VertexCount;
     }
 
-    struct SortPred
-    {
-        inline bool operator () (const Particle& p1, const Particle& p2)
-        {
-            return p1.GetSortKey().m_Key < p2.GetSortKey().m_Key;
-        }
-
-    };
-
     void GenerateKeys(Emitter* emitter, float max_particle_life_time)
     {
-        dmArray<Particle>& particles = emitter->m_Particles;
+        ParticleBuffer& particles = emitter->m_Particles;
         uint32_t n = particles.Size();
+        const float* time_left = particles.GetStream(STREAM_TIME_LEFT);
+        uint64_t* keys = particles.GetSortKeys();
 
         float range = 1.0f / max_particle_life_time;
 
-        Particle* first = particles.Begin();
         for (uint32_t i = 0; i < n; ++i)
         {
-            Particle* p = &particles[i];
-            uint32_t index = p - first;
-
-            float life_time = (1.0f - p->GetTimeLeft() * range) * 65535;
+            float life_time = (1.0f - time_left[i] * range) * 65535;
             life_time = dmMath::Clamp(life_time, 0.0f, 65535.0f);
             uint16_t lt = (uint16_t) life_time;
-            SortKey key;
-            key.m_LifeTime = lt;
-            key.m_Index = index;
-            p->SetSortKey(key);
+            // The index makes the keys unique, which keeps the sort stable
+            keys[i] = ((uint64_t) lt << 32) | i;
         }
     }
 
@@ -1271,7 +1634,34 @@ namespace dmParticle
     {
         DM_PROFILE(Particle, "Sort");
 
-        std::sort(emitter->m_Particles.Begin(), emitter->m_Particles.End(), SortPred());
+        ParticleBuffer& particles = emitter->m_Particles;
+        uint32_t n = particles.Size();
+        uint64_t* keys = particles.GetSortKeys();
+        std::sort(keys, keys + n);
+
+        // Compact the keys into indices, in place since an index never overwrites a key that is not yet read
+        uint32_t* indices = (uint32_t*) keys;
+        bool sorted = true;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            uint32_t index = (uint32_t) keys[i];
+            indices[i] = index;
+            sorted = sorted && index == i;
+        }
+        if (sorted)
+            return;
+
+        // Permute the streams one by one
+        float* scratch = particles.GetScratch();
+        for (uint32_t s = 0; s < STREAM_COUNT; ++s)
+        {
+            float* stream = particles.GetStream((ParticleStream) s);
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                scratch[i] = stream[indices[i]];
+            }
+            memcpy(stream, scratch, n * sizeof(float));
+        }
     }
 
 #define SAMPLE_PROP(segment, x, target)\
@@ -1290,78 +1680,122 @@ namespace dmParticle
         }
     }
 
+    /// SAMPLE_PROP for four particles, with the segment index of each particle
+    static inline dmSIMD::Vector4f SampleProperty4(const LinearSegment* segments, const uint32_t segment_indices[4], dmSIMD::Vector4f x)
+    {
+        const LinearSegment* s0 = &segments[segment_indices[0]];
+        const LinearSegment* s1 = &segments[segment_indices[1]];
+        const LinearSegment* s2 = &segments[segment_indices[2]];
+        const LinearSegment* s3 = &segments[segment_indices[3]];
+        dmSIMD::Vector4f sx = dmSIMD::Set(s0->m_X, s1->m_X, s2->m_X, s3->m_X);
+        dmSIMD::Vector4f sk = dmSIMD::Set(s0->m_K, s1->m_K, s2->m_K, s3->m_K);
+        dmSIMD::Vector4f sy = dmSIMD::Set(s0->m_Y, s1->m_Y, s2->m_Y, s3->m_Y);
+        return dmSIMD::Add(dmSIMD::Mul(dmSIMD::Sub(x, sx), sk), sy);
+    }
+
     void EvaluateParticleProperties(Emitter* emitter, Property* particle_properties, dmParticleDDF::Emitter* emitter_ddf, float dt)
     {
         float properties[PARTICLE_KEY_COUNT];
-        // TODO Optimize this
-        dmArray<Particle>& particles = emitter->m_Particles;
+        ParticleBuffer& particles = emitter->m_Particles;
         uint32_t count = particles.Size();
-        for (uint32_t i = 0; i < count; ++i)
-        {
-            Particle* particle = &particles[i];
-            float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-            uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_SCALE].m_Segments[segment_index], x, properties[PARTICLE_KEY_SCALE])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_RED].m_Segments[segment_index], x, properties[PARTICLE_KEY_RED])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_GREEN].m_Segments[segment_index], x, properties[PARTICLE_KEY_GREEN])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_BLUE].m_Segments[segment_index], x, properties[PARTICLE_KEY_BLUE])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_ALPHA].m_Segments[segment_index], x, properties[PARTICLE_KEY_ALPHA])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_X].m_Segments[segment_index], x, properties[PARTICLE_KEY_STRETCH_FACTOR_X])
-            SAMPLE_PROP(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_Y].m_Segments[segment_index], x, properties[PARTICLE_KEY_STRETCH_FACTOR_Y])
-            Vector4 c = particle->GetSourceColor();
-            particle->SetScale(Vector3(properties[PARTICLE_KEY_SCALE]));
-            particle->SetColor(Vector4(dmMath::Clamp(c.getX() * properties[PARTICLE_KEY_RED], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getY() * properties[PARTICLE_KEY_GREEN], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getZ() * properties[PARTICLE_KEY_BLUE], 0.0f, 1.0f),
-                    dmMath::Clamp(c.getW() * properties[PARTICLE_KEY_ALPHA], 0.0f, 1.0f)));
-            particle->m_StretchFactorX = particle->m_SourceStretchFactorX + (properties[PARTICLE_KEY_STRETCH_FACTOR_X]);
-            particle->m_StretchFactorY = particle->m_SourceStretchFactorY + (properties[PARTICLE_KEY_STRETCH_FACTOR_Y]);
+        const float* time_left = particles.GetStream(STREAM_TIME_LEFT);
+        const float* max_life_time = particles.GetStream(STREAM_MAX_LIFE_TIME);
+        const float* oo_max_life_time = particles.GetStream(STREAM_OO_MAX_LIFE_TIME);
+        bool default_orientation = emitter_ddf->m_ParticleOrientation != PARTICLE_ORIENTATION_MOVEMENT_DIRECTION
+                                && emitter_ddf->m_ParticleOrientation != PARTICLE_ORIENTATION_ANGULAR_VELOCITY;
+
+        dmSIMD::Vector4f zero = dmSIMD::Splat(0.0f);
+        dmSIMD::Vector4f one = dmSIMD::Splat(1.0f);
+        for (uint32_t i = 0; i < count; i += 4)
+        {
+            dmSIMD::Vector4f x = dmSIMD::Select(dmSIMD::Neg(dmSIMD::Load(max_life_time + i)), zero,
+                                                dmSIMD::Sub(one, dmSIMD::Mul(dmSIMD::Load(time_left + i), dmSIMD::Load(oo_max_life_time + i))));
+            float lane_x[4];
+            dmSIMD::Store(lane_x, x);
+            uint32_t segment_indices[4];
+            for (uint32_t k = 0; k < 4; ++k)
+            {
+                // The padding after the last particle is ignored
+                segment_indices[k] = i + k < count ? dmMath::Min((uint32_t)(lane_x[k] * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1) : 0;
+            }
+
+            dmSIMD::Vector4f scale = SampleProperty4(particle_properties[PARTICLE_KEY_SCALE].m_Segments, segment_indices, x);
+            StoreStream(particles, STREAM_SCALE_X, i, scale);
+            StoreStream(particles, STREAM_SCALE_Y, i, scale);
+            StoreStream(particles, STREAM_SCALE_Z, i, scale);
+
+            static const ParticleStream color_streams[] = { STREAM_COLOR_R, STREAM_COLOR_G, STREAM_COLOR_B, STREAM_COLOR_A };
+            static const ParticleStream source_color_streams[] = { STREAM_SOURCE_COLOR_R, STREAM_SOURCE_COLOR_G, STREAM_SOURCE_COLOR_B, STREAM_SOURCE_COLOR_A };
+            static const ParticleKey color_keys[] = { PARTICLE_KEY_RED, PARTICLE_KEY_GREEN, PARTICLE_KEY_BLUE, PARTICLE_KEY_ALPHA };
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                dmSIMD::Vector4f v = SampleProperty4(particle_properties[color_keys[c]].m_Segments, segment_indices, x);
+                v = dmSIMD::Mul(LoadStream(particles, source_color_streams[c], i), v);
+                StoreStream(particles, color_streams[c], i, dmSIMD::Min(dmSIMD::Max(v, zero), one));
+            }
+
+            dmSIMD::Vector4f stretch_x = SampleProperty4(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_X].m_Segments, segment_indices, x);
+            dmSIMD::Vector4f stretch_y = SampleProperty4(particle_properties[PARTICLE_KEY_STRETCH_FACTOR_Y].m_Segments, segment_indices, x);
+            StoreStream(particles, STREAM_STRETCH_FACTOR_X, i, dmSIMD::Add(LoadStream(particles, STREAM_SOURCE_STRETCH_FACTOR_X, i), stretch_x));
+            StoreStream(particles, STREAM_STRETCH_FACTOR_Y, i, dmSIMD::Add(LoadStream(particles, STREAM_SOURCE_STRETCH_FACTOR_Y, i), stretch_y));
+
+            if (default_orientation)
+            {
+                // Rotation around z, source_rotation * QuatFromAngle(2, angle) with the zero terms left out
+                float rotation[4];
+                dmSIMD::Store(rotation, SampleProperty4(particle_properties[PARTICLE_KEY_ROTATION].m_Segments, segment_indices, x));
+                float sin_half[4];
+                float cos_half[4];
+                for (uint32_t k = 0; k < 4; ++k)
+                {
+                    float half_angle = 0.5f * (DEG_RAD * rotation[k]);
+                    sin_half[k] = dmTrigLookup::Sin(half_angle);
+                    cos_half[k] = dmTrigLookup::Cos(half_angle);
+                }
+                dmSIMD::Vector4f s = dmSIMD::Load(sin_half);
+                dmSIMD::Vector4f c = dmSIMD::Load(cos_half);
+                dmSIMD::Vector4f qx = LoadStream(particles, STREAM_SOURCE_ROTATION_X, i);
+                dmSIMD::Vector4f qy = LoadStream(particles, STREAM_SOURCE_ROTATION_Y, i);
+                dmSIMD::Vector4f qz = LoadStream(particles, STREAM_SOURCE_ROTATION_Z, i);
+                dmSIMD::Vector4f qw = LoadStream(particles, STREAM_SOURCE_ROTATION_W, i);
+                StoreStream(particles, STREAM_ROTATION_X, i, dmSIMD::Add(dmSIMD::Mul(qx, c), dmSIMD::Mul(qy, s)));
+                StoreStream(particles, STREAM_ROTATION_Y, i, dmSIMD::Sub(dmSIMD::Mul(qy, c), dmSIMD::Mul(qx, s)));
+                StoreStream(particles, STREAM_ROTATION_Z, i, dmSIMD::Add(dmSIMD::Mul(qw, s), dmSIMD::Mul(qz, c)));
+                StoreStream(particles, STREAM_ROTATION_W, i, dmSIMD::Sub(dmSIMD::Mul(qw, c), dmSIMD::Mul(qz, s)));
+            }
         }
 
         if (emitter_ddf->m_ParticleOrientation == PARTICLE_ORIENTATION_MOVEMENT_DIRECTION) {
             for (uint32_t i = 0; i < count; ++i)
             {
-                Particle* particle = &particles[i];
-                float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
+                float x = dmMath::Select(-max_life_time[i], 0.0f, 1.0f - time_left[i] * oo_max_life_time[i]);
                 uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
                 SAMPLE_PROP(particle_properties[PARTICLE_KEY_ROTATION].m_Segments[segment_index], x, properties[PARTICLE_KEY_ROTATION])
-                particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
-                if (lengthSqr(particle->m_Velocity) > EPSILON)
+                particles.SetRotation(i, particles.GetSourceRotation(i) * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
+                Vector3 velocity = particles.GetVelocity(i);
+                if (lengthSqr(velocity) > EPSILON)
                 {
-                    Vector3 vel_norm = normalize(particle->m_Velocity);
+                    Vector3 vel_norm = normalize(velocity);
                     float y_dot = dot(Vector3::yAxis(), vel_norm);
                     // Corner case, https://gamedev.stackexchange.com/questions/61672/align-a-rotation-to-a-direction
                     Quat q_vel = (dmMath::Abs(y_dot + 1.0f) > EPSILON) ? Quat::rotation(Vector3::yAxis(), vel_norm) : Quat(0.0, 0.0, 1.0, 0.0);
-                    Quat q = particle->GetRotation() * q_vel;
-                    particle->SetRotation(q);
+                    Quat q = particles.GetRotation(i) * q_vel;
+                    particles.SetRotation(i, q);
                 }
             }
 
         } else if (emitter_ddf->m_ParticleOrientation == PARTICLE_ORIENTATION_ANGULAR_VELOCITY) {
             for (uint32_t i = 0; i < count; ++i)
             {
-                Particle* particle = &particles[i];
-                float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
+                float x = dmMath::Select(-max_life_time[i], 0.0f, 1.0f - time_left[i] * oo_max_life_time[i]);
                 uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
                 SAMPLE_PROP(particle_properties[PARTICLE_KEY_ANGULAR_VELOCITY].m_Segments[segment_index], x, properties[PARTICLE_KEY_ANGULAR_VELOCITY])
-                particle->SetRotation(particle->GetRotation() * Quat::rotationZ(DEG_RAD * (particle->m_SourceAngularVelocity * (properties[PARTICLE_KEY_ANGULAR_VELOCITY])) * dt));
-            }
-
-        } else {
-            for (uint32_t i = 0; i < count; ++i)
-            {
-                Particle* particle = &particles[i];
-                float x = dmMath::Select(-particle->GetMaxLifeTime(), 0.0f, 1.0f - particle->GetTimeLeft() * particle->GetooMaxLifeTime());
-                uint32_t segment_index = dmMath::Min((uint32_t)(x * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
-                SAMPLE_PROP(particle_properties[PARTICLE_KEY_ROTATION].m_Segments[segment_index], x, properties[PARTICLE_KEY_ROTATION])
-                particle->SetRotation(particle->GetSourceRotation() * dmVMath::QuatFromAngle(2, DEG_RAD * properties[PARTICLE_KEY_ROTATION]));
+                particles.SetRotation(i, particles.GetRotation(i) * Quat::rotationZ(DEG_RAD * (particles.GetSourceAngularVelocity(i) * (properties[PARTICLE_KEY_ANGULAR_VELOCITY])) * dt));
             }
         }
-
     }
 
-    void ApplyAcceleration(dmArray<Particle>& particles, Property* modifier_properties, const Quat& rotation, float scale, float emitter_t, float dt)
+    void ApplyAcceleration(ParticleBuffer& particles, Property* modifier_properties, const Quat& rotation, float scale, float emitter_t, float dt)
     {
         uint32_t particle_count = particles.Size();
         Vector3 acc_step = rotate(rotation, ACCELERATION_LOCAL_DIR) * dt * scale;
@@ -1369,15 +1803,21 @@ namespace dmParticle
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
         float magnitude;
         SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
-        for (uint32_t i = 0; i < particle_count; ++i)
+        dmSIMD::Vector4f magnitude4 = dmSIMD::Splat(magnitude);
+        dmSIMD::Vector4f mag_spread = dmSIMD::Splat(magnitude_property.m_Spread);
+        dmSIMD::Vector4f acc_x = dmSIMD::Splat(acc_step.getX());
+        dmSIMD::Vector4f acc_y = dmSIMD::Splat(acc_step.getY());
+        dmSIMD::Vector4f acc_z = dmSIMD::Splat(acc_step.getZ());
+        for (uint32_t i = 0; i < particle_count; i += 4)
         {
-            Particle* particle = &particles[i];
-            particle->SetVelocity(particle->GetVelocity() + acc_step * (magnitude + mag_spread * particle->GetSpreadFactor()));
+            dmSIMD::Vector4f m = dmSIMD::Add(magnitude4, dmSIMD::Mul(mag_spread, LoadStream(particles, STREAM_SPREAD_FACTOR, i)));
+            StoreStream(particles, STREAM_VELOCITY_X, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_X, i), dmSIMD::Mul(acc_x, m)));
+            StoreStream(particles, STREAM_VELOCITY_Y, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_Y, i), dmSIMD::Mul(acc_y, m)));
+            StoreStream(particles, STREAM_VELOCITY_Z, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_Z, i), dmSIMD::Mul(acc_z, m)));
         }
     }
 
-    void ApplyDrag(dmArray<Particle>& particles, Property* modifier_properties, dmParticleDDF::Modifier* modifier_ddf, const Quat& rotation, float emitter_t, float dt)
+    void ApplyDrag(ParticleBuffer& particles, Property* modifier_properties, dmParticleDDF::Modifier* modifier_ddf, const Quat& rotation, float emitter_t, float dt)
     {
         uint32_t particle_count = particles.Size();
         Vector3 direction = rotate(rotation, DRAG_LOCAL_DIR);
@@ -1385,35 +1825,39 @@ namespace dmParticle
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
         float magnitude;
         SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
-        for (uint32_t i = 0; i < particle_count; ++i)
-        {
-            Particle* particle = &particles[i];
-            Vector3 v = particle->GetVelocity();
-            if (modifier_ddf->m_UseDirection)
-                v = projection(Point3(particle->GetVelocity()), direction) * direction;
+        dmSIMD::Vector4f magnitude4 = dmSIMD::Splat(magnitude);
+        dmSIMD::Vector4f mag_spread = dmSIMD::Splat(magnitude_property.m_Spread);
+        dmSIMD::Vector4f dir_x = dmSIMD::Splat(direction.getX());
+        dmSIMD::Vector4f dir_y = dmSIMD::Splat(direction.getY());
+        dmSIMD::Vector4f dir_z = dmSIMD::Splat(direction.getZ());
+        dmSIMD::Vector4f dt4 = dmSIMD::Splat(dt);
+        dmSIMD::Vector4f one = dmSIMD::Splat(1.0f);
+        bool use_direction = modifier_ddf->m_UseDirection != 0;
+        for (uint32_t i = 0; i < particle_count; i += 4)
+        {
+            dmSIMD::Vector4f vx = LoadStream(particles, STREAM_VELOCITY_X, i);
+            dmSIMD::Vector4f vy = LoadStream(particles, STREAM_VELOCITY_Y, i);
+            dmSIMD::Vector4f vz = LoadStream(particles, STREAM_VELOCITY_Z, i);
+            dmSIMD::Vector4f dx = vx;
+            dmSIMD::Vector4f dy = vy;
+            dmSIMD::Vector4f dz = vz;
+            if (use_direction)
+            {
+                dmSIMD::Vector4f projection = dmSIMD::Add(dmSIMD::Add(dmSIMD::Mul(vx, dir_x), dmSIMD::Mul(vy, dir_y)), dmSIMD::Mul(vz, dir_z));
+                dx = dmSIMD::Mul(dir_x, projection);
+                dy = dmSIMD::Mul(dir_y, projection);
+                dz = dmSIMD::Mul(dir_z, projection);
+            }
             // Applied drag > 1 means the particle would travel in the reverse direction
-            float applied_drag = dmMath::Min((magnitude + mag_spread * particle->GetSpreadFactor()) * dt, 1.0f);
-            particle->SetVelocity(particle->GetVelocity() - v * applied_drag);
+            dmSIMD::Vector4f m = dmSIMD::Add(magnitude4, dmSIMD::Mul(mag_spread, LoadStream(particles, STREAM_SPREAD_FACTOR, i)));
+            dmSIMD::Vector4f applied_drag = dmSIMD::Min(dmSIMD::Mul(m, dt4), one);
+            StoreStream(particles, STREAM_VELOCITY_X, i, dmSIMD::Sub(vx, dmSIMD::Mul(dx, applied_drag)));
+            StoreStream(particles, STREAM_VELOCITY_Y, i, dmSIMD::Sub(vy, dmSIMD::Mul(dy, applied_drag)));
+            StoreStream(particles, STREAM_VELOCITY_Z, i, dmSIMD::Sub(vz, dmSIMD::Mul(dz, applied_drag)));
         }
     }
 
-    static Vector3 GetParticleDir(Particle* particle)
-    {
-        return rotate(particle->GetRotation(), PARTICLE_LOCAL_BASE_DIR);
-    }
-
-    static Vector3 NonZeroVector3(Vector3 v, float sq_length, Vector3 fallback)
-    {
-        Vector3 result;
-        float neg_sq_length = -sq_length;
-        result.setX(dmMath::Select(neg_sq_length, fallback.getX(), v.getX()));
-        result.setY(dmMath::Select(neg_sq_length, fallback.getY(), v.getY()));
-        result.setZ(dmMath::Select(neg_sq_length, fallback.getZ(), v.getZ()));
-        return result;
-    }
-
-    void ApplyRadial(dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, float scale, float emitter_t, float dt)
+    void ApplyRadial(ParticleBuffer& particles, Property* modifier_properties, const Point3& position, float scale, float emitter_t, float dt)
     {
         uint32_t particle_count = particles.Size();
         const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
@@ -1421,25 +1865,45 @@ namespace dmParticle
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
         float magnitude;
         SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
         // We temporarily only sample the first frame until we have decided what to animate over
         float max_distance = max_distance_property.m_Segments[0].m_Y * scale;
-        float max_sq_distance = max_distance * max_distance;
-        float applied_factor = dt * scale;
-        for (uint32_t i = 0; i < particle_count; ++i)
-        {
-            Particle* particle = &particles[i];
-            Vector3 delta = particle->GetPosition() - position;
-            float delta_sq_len = lengthSqr(delta);
-            float applied_magnitude = magnitude + mag_spread * particle->GetSpreadFactor();
+        dmSIMD::Vector4f magnitude4 = dmSIMD::Splat(magnitude);
+        dmSIMD::Vector4f mag_spread = dmSIMD::Splat(magnitude_property.m_Spread);
+        dmSIMD::Vector4f max_sq_distance = dmSIMD::Splat(max_distance * max_distance);
+        dmSIMD::Vector4f applied_factor = dmSIMD::Splat(dt * scale);
+        dmSIMD::Vector4f position_x = dmSIMD::Splat(position.getX());
+        dmSIMD::Vector4f position_y = dmSIMD::Splat(position.getY());
+        dmSIMD::Vector4f position_z = dmSIMD::Splat(position.getZ());
+        dmSIMD::Vector4f zero = dmSIMD::Splat(0.0f);
+        dmSIMD::Vector4f one = dmSIMD::Splat(1.0f);
+        for (uint32_t i = 0; i < particle_count; i += 4)
+        {
+            dmSIMD::Vector4f delta[3];
+            delta[0] = dmSIMD::Sub(LoadStream(particles, STREAM_POSITION_X, i), position_x);
+            delta[1] = dmSIMD::Sub(LoadStream(particles, STREAM_POSITION_Y, i), position_y);
+            delta[2] = dmSIMD::Sub(LoadStream(particles, STREAM_POSITION_Z, i), position_z);
+            dmSIMD::Vector4f delta_sq_len = LengthSqr4(delta[0], delta[1], delta[2]);
+            dmSIMD::Vector4f applied_magnitude = dmSIMD::Add(magnitude4, dmSIMD::Mul(mag_spread, LoadStream(particles, STREAM_SPREAD_FACTOR, i)));
             // 0 acc delta lies outside max dist
-            float a = dmMath::Select(max_sq_distance - delta_sq_len, applied_magnitude, 0.0f);
-            Vector3 dir = normalize(NonZeroVector3(delta, delta_sq_len, GetParticleDir(particle)));
-            particle->SetVelocity(particle->GetVelocity() + dir * a * applied_factor);
-        }
-    }
-
-    void ApplyVortex(dmArray<Particle>& particles, Property* modifier_properties, const Point3& position, const Quat& rotation, float scale, float emitter_t, float dt)
+            dmSIMD::Vector4f a = dmSIMD::Select(dmSIMD::Sub(max_sq_distance, delta_sq_len), applied_magnitude, zero);
+            // Fall back to the particle direction when the particle is at the modifier position
+            dmSIMD::Vector4f particle_dir[3];
+            Rotate4(LoadStream(particles, STREAM_ROTATION_X, i), LoadStream(particles, STREAM_ROTATION_Y, i),
+                    LoadStream(particles, STREAM_ROTATION_Z, i), LoadStream(particles, STREAM_ROTATION_W, i),
+                    zero, one, zero, particle_dir);
+            dmSIMD::Vector4f neg_sq_length = dmSIMD::Neg(delta_sq_len);
+            dmSIMD::Vector4f dir[3];
+            dir[0] = dmSIMD::Select(neg_sq_length, particle_dir[0], delta[0]);
+            dir[1] = dmSIMD::Select(neg_sq_length, particle_dir[1], delta[1]);
+            dir[2] = dmSIMD::Select(neg_sq_length, particle_dir[2], delta[2]);
+            Normalize4(dir);
+            StoreStream(particles, STREAM_VELOCITY_X, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_X, i), dmSIMD::Mul(dmSIMD::Mul(dir[0], a), applied_factor)));
+            StoreStream(particles, STREAM_VELOCITY_Y, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_Y, i), dmSIMD::Mul(dmSIMD::Mul(dir[1], a), applied_factor)));
+            StoreStream(particles, STREAM_VELOCITY_Z, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_Z, i), dmSIMD::Mul(dmSIMD::Mul(dir[2], a), applied_factor)));
+        }
+    }
+
+    void ApplyVortex(ParticleBuffer& particles, Property* modifier_properties, const Point3& position, const Quat& rotation, float scale, float emitter_t, float dt)
     {
         uint32_t particle_count = particles.Size();
         const Property& magnitude_property = modifier_properties[MODIFIER_KEY_MAGNITUDE];
@@ -1447,30 +1911,54 @@ namespace dmParticle
         uint32_t segment_index = dmMath::Min((uint32_t)(emitter_t * PROPERTY_SAMPLE_COUNT), PROPERTY_SAMPLE_COUNT - 1);
         float magnitude;
         SAMPLE_PROP(magnitude_property.m_Segments[segment_index], emitter_t, magnitude)
-        float mag_spread = magnitude_property.m_Spread;
         // We temporarily only sample the first frame until we have decided what to animate over
         float max_distance = max_distance_property.m_Segments[0].m_Y * scale;
-        float max_sq_distance = max_distance * max_distance;
         Vector3 axis = rotate(rotation, VORTEX_LOCAL_AXIS);
         Vector3 start = rotate(rotation, VORTEX_LOCAL_START_DIR);
-        float applied_factor = dt * scale;
-        for (uint32_t i = 0; i < particle_count; ++i)
+        dmSIMD::Vector4f magnitude4 = dmSIMD::Splat(magnitude);
+        dmSIMD::Vector4f mag_spread = dmSIMD::Splat(magnitude_property.m_Spread);
+        dmSIMD::Vector4f max_sq_distance = dmSIMD::Splat(max_distance * max_distance);
+        dmSIMD::Vector4f applied_factor = dmSIMD::Splat(dt * scale);
+        dmSIMD::Vector4f position_x = dmSIMD::Splat(position.getX());
+        dmSIMD::Vector4f position_y = dmSIMD::Splat(position.getY());
+        dmSIMD::Vector4f position_z = dmSIMD::Splat(position.getZ());
+        dmSIMD::Vector4f axis_x = dmSIMD::Splat(axis.getX());
+        dmSIMD::Vector4f axis_y = dmSIMD::Splat(axis.getY());
+        dmSIMD::Vector4f axis_z = dmSIMD::Splat(axis.getZ());
+        dmSIMD::Vector4f start_x = dmSIMD::Splat(start.getX());
+        dmSIMD::Vector4f start_y = dmSIMD::Splat(start.getY());
+        dmSIMD::Vector4f start_z = dmSIMD::Splat(start.getZ());
+        dmSIMD::Vector4f zero = dmSIMD::Splat(0.0f);
+        for (uint32_t i = 0; i < particle_count; i += 4)
         {
-            Particle* particle = &particles[i];
             // delta from vortex position
-            Vector3 delta = particle->GetPosition() - position;
+            dmSIMD::Vector4f dx = dmSIMD::Sub(LoadStream(particles, STREAM_POSITION_X, i), position_x);
+            dmSIMD::Vector4f dy = dmSIMD::Sub(LoadStream(particles, STREAM_POSITION_Y, i), position_y);
+            dmSIMD::Vector4f dz = dmSIMD::Sub(LoadStream(particles, STREAM_POSITION_Z, i), position_z);
             // normal from vortex axis (non-unit)
-            Vector3 normal = delta - projection(Point3(delta), axis) * axis;
+            dmSIMD::Vector4f projection = dmSIMD::Add(dmSIMD::Add(dmSIMD::Mul(dx, axis_x), dmSIMD::Mul(dy, axis_y)), dmSIMD::Mul(dz, axis_z));
+            dmSIMD::Vector4f nx = dmSIMD::Sub(dx, dmSIMD::Mul(axis_x, projection));
+            dmSIMD::Vector4f ny = dmSIMD::Sub(dy, dmSIMD::Mul(axis_y, projection));
+            dmSIMD::Vector4f nz = dmSIMD::Sub(dz, dmSIMD::Mul(axis_z, projection));
             // tangent is the direction of the vortex acceleration
-            Vector3 tangent = cross(axis, normal);
+            dmSIMD::Vector4f tangent[3];
+            tangent[0] = dmSIMD::Sub(dmSIMD::Mul(axis_y, nz), dmSIMD::Mul(axis_z, ny));
+            tangent[1] = dmSIMD::Sub(dmSIMD::Mul(axis_z, nx), dmSIMD::Mul(axis_x, nz));
+            tangent[2] = dmSIMD::Sub(dmSIMD::Mul(axis_x, ny), dmSIMD::Mul(axis_y, nx));
             // In case the particle is directed along the axis, give it a guaranteed orthogonal start
-            tangent = NonZeroVector3(tangent, lengthSqr(tangent), start);
+            dmSIMD::Vector4f neg_sq_length = dmSIMD::Neg(LengthSqr4(tangent[0], tangent[1], tangent[2]));
+            tangent[0] = dmSIMD::Select(neg_sq_length, start_x, tangent[0]);
+            tangent[1] = dmSIMD::Select(neg_sq_length, start_y, tangent[1]);
+            tangent[2] = dmSIMD::Select(neg_sq_length, start_z, tangent[2]);
             // tangent is now guaranteed to be non-zero
-            tangent = normalize(tangent);
+            Normalize4(tangent);
             // use normal for max distance test
-            float normal_sq_len = lengthSqr(normal);
-            float acceleration = dmMath::Select(max_sq_distance - normal_sq_len, magnitude + mag_spread * particle->GetSpreadFactor(), 0.0f);
-            particle->SetVelocity(particle->GetVelocity() + tangent * acceleration * applied_factor);
+            dmSIMD::Vector4f normal_sq_len = LengthSqr4(nx, ny, nz);
+            dmSIMD::Vector4f m = dmSIMD::Add(magnitude4, dmSIMD::Mul(mag_spread, LoadStream(particles, STREAM_SPREAD_FACTOR, i)));
+            dmSIMD::Vector4f acceleration = dmSIMD::Select(dmSIMD::Sub(max_sq_distance, normal_sq_len), m, zero);
+            StoreStream(particles, STREAM_VELOCITY_X, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_X, i), dmSIMD::Mul(dmSIMD::Mul(tangent[0], acceleration), applied_factor)));
+            StoreStream(particles, STREAM_VELOCITY_Y, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_Y, i), dmSIMD::Mul(dmSIMD::Mul(tangent[1], acceleration), applied_factor)));
+            StoreStream(particles, STREAM_VELOCITY_Z, i, dmSIMD::Add(LoadStream(particles, STREAM_VELOCITY_Z, i), dmSIMD::Mul(dmSIMD::Mul(tangent[2], acceleration), applied_factor)));
         }
     }
 
@@ -1499,7 +1987,7 @@ namespace dmParticle
     {
         DM_PROFILE(Particle, "Simulate");
 
-        dmArray<Particle>& particles = emitter->m_Particles;
+        ParticleBuffer& particles = emitter->m_Particles;
         EvaluateParticleProperties(emitter, prototype->m_ParticleProperties, ddf, dt);
         float emitter_t = dmMath::Select(-ddf->m_Duration, 0.0f, emitter->m_Timer / ddf->m_Duration);
         float scale = 1.0f;
@@ -1541,18 +2029,27 @@ namespace dmParticle
             }
         }
         uint32_t particle_count = particles.Size();
-        for (uint32_t i = 0; i < particle_count; ++i)
+        dmSIMD::Vector4f dt4 = dmSIMD::Splat(dt);
+        dmSIMD::Vector4f stretch_scaling = dmSIMD::Splat(STRETCH_SCALING);
+        bool stretch_with_velocity = ddf->m_StretchWithVelocity != 0;
+        for (uint32_t i = 0; i < particle_count; i += 4)
         {
-            Particle* p = &particles[i];
             // NOTE This velocity integration has a larger error than normal since we don't use the velocity at the
             // beginning of the frame, but it's ok since particle movement does not need to be very exact
-            p->SetPosition(p->GetPosition() + p->m_Velocity * dt);
-
-            p->m_Scale[0] += p->m_Scale[0] * p->m_StretchFactorX;
-            if (!ddf->m_StretchWithVelocity)
-                p->m_Scale[1] += p->m_Scale[1] * p->m_StretchFactorY;
-            else
-                p->m_Scale[1] += p->m_Scale[1] * p->m_StretchFactorY * length(p->m_Velocity) * STRETCH_SCALING;
+            dmSIMD::Vector4f vx = LoadStream(particles, STREAM_VELOCITY_X, i);
+            dmSIMD::Vector4f vy = LoadStream(particles, STREAM_VELOCITY_Y, i);
+            dmSIMD::Vector4f vz = LoadStream(particles, STREAM_VELOCITY_Z, i);
+            StoreStream(particles, STREAM_POSITION_X, i, dmSIMD::Add(LoadStream(particles, STREAM_POSITION_X, i), dmSIMD::Mul(vx, dt4)));
+            StoreStream(particles, STREAM_POSITION_Y, i, dmSIMD::Add(LoadStream(particles, STREAM_POSITION_Y, i), dmSIMD::Mul(vy, dt4)));
+            StoreStream(particles, STREAM_POSITION_Z, i, dmSIMD::Add(LoadStream(particles, STREAM_POSITION_Z, i), dmSIMD::Mul(vz, dt4)));
+
+            dmSIMD::Vector4f scale_x = LoadStream(particles, STREAM_SCALE_X, i);
+            dmSIMD::Vector4f scale_y = LoadStream(particles, STREAM_SCALE_Y, i);
+            StoreStream(particles, STREAM_SCALE_X, i, dmSIMD::Add(scale_x, dmSIMD::Mul(scale_x, LoadStream(particles, STREAM_STRETCH_FACTOR_X, i))));
+            dmSIMD::Vector4f stretch_y = dmSIMD::Mul(scale_y, LoadStream(particles, STREAM_STRETCH_FACTOR_Y, i));
+            if (stretch_with_velocity)
+                stretch_y = dmSIMD::Mul(dmSIMD::Mul(stretch_y, dmSIMD::Sqrt(LengthSqr4(vx, vy, vz))), stretch_scaling);
+            StoreStream(particles, STREAM_SCALE_Y, i, dmSIMD::Add(scale_y, stretch_y));
         }
     }
 
@@ -16,6 +16,7 @@
 #include <dmsdk/vectormath/cpp/vectormath_aos.h>
 #include <dlib/configfile.h>
 #include <dlib/hash.h>
+#include <dlib/worker_pool.h>
 #include <ddf/ddf.h>
 #include "particle/particle_ddf.h"
 
@@ -232,9 +233,42 @@ namespace dmParticle
         // Offset 36
     };
 
+    /**
+     * An emitter to generate vertex data for, see GenerateVertexDataBatch
+     */
+    struct EmitterVertexData
+    {
+        Vector4     m_Color;
+        HInstance   m_Instance;
+        uint32_t    m_EmitterIndex;
+    };
+
     // For tests
     Vector3 GetPosition(HParticleContext context, HInstance instance);
 
+    /**
+     * Set the worker pool used to simulate the emitters and generate their vertex data in parallel.
+     * Spawning and all callbacks still run on the calling thread.
+     * @param context Particle context
+     * @param worker_pool Worker pool, or 0x0 to do all work on the calling thread
+     */
+    void SetWorkerPool(HParticleContext context, dmWorkerPool::HWorkerPool worker_pool);
+
+    /**
+     * Generates vertex data for a batch of emitters. The output is identical to calling GenerateVertexData
+     * for each emitter in order, but each emitter first reserves its vertex range so that the emitters can be
+     * written in parallel by the worker pool of the context. An emitter may only occur once in a batch.
+     * @param context Particle context
+     * @param dt Time step.
+     * @param emitters Emitters to generate vertex data for
+     * @param emitter_count Number of emitters
+     * @param vertex_buffer Vertex buffer into which to store the particle vertex data. If this is 0x0, no data will be generated.
+     * @param vertex_buffer_size Size in bytes of the supplied vertex buffer.
+     * @param out_vertex_buffer_size Size in bytes of the total data written to vertex buffer.
+     * @param vertex_format Which vertex format to use
+     */
+    void GenerateVertexDataBatch(HParticleContext context, float dt, const EmitterVertexData* emitters, uint32_t emitter_count, void* vertex_buffer, uint32_t vertex_buffer_size, uint32_t* out_vertex_buffer_size, ParticleVertexFormat vertex_format);
+
 #define DM_PARTICLE_PROTO(ret, name,  ...) \
     \
     ret name(__VA_ARGS__);\
@@ -17,6 +17,7 @@
 #include <dlib/configfile.h>
 #include <dlib/index_pool.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include "particle/particle_ddf.h"
 
@@ -29,20 +30,8 @@ namespace dmParticle
     struct Prototype;
 
     /**
-     * Key when sorting particles, based on life time with additional index for stable sort
-     */
-    union SortKey
-    {
-        struct
-        {
-            uint32_t m_Index : 16;  // Index is used to ensure stable sort
-            uint32_t m_LifeTime : 16; // Quantified relative life time
-        };
-        uint32_t     m_Key;
-    };
-
-    /**
-     * Representation of a particle.
+     * Representation of a single particle. The particles of an emitter are stored in a ParticleBuffer,
+     * this struct is used when spawning particles and when reading or writing a whole particle.
      *
      * TODO Separate source state from current (chaining modifiers)
      */
@@ -64,7 +53,6 @@ namespace dmParticle
         GET_SET(Scale, Vector3)
         GET_SET(SourceColor, Vector4)
         GET_SET(Color, Vector4)
-        GET_SET(SortKey, SortKey)
 #undef GET_SET
 
         /// Position, which is defined in emitter space or world space depending on how the emitter which spawned the particles is tweaked.
@@ -92,8 +80,6 @@ namespace dmParticle
         Vector4     m_Color;
         /// Particle scale
         Vector3     m_Scale;
-        // Sorting
-        SortKey     m_SortKey;
         /// Particle stretch factor
         float       m_StretchFactorX;
         float       m_StretchFactorY;
@@ -101,6 +87,140 @@ namespace dmParticle
         float       m_SourceAngularVelocity;
     };
 
+    /**
+     * Streams of a ParticleBuffer, one per particle property.
+     * Vectors and quaternions have one stream per component, in x, y, z, w order.
+     */
+    enum ParticleStream
+    {
+        STREAM_POSITION_X,
+        STREAM_POSITION_Y,
+        STREAM_POSITION_Z,
+        STREAM_VELOCITY_X,
+        STREAM_VELOCITY_Y,
+        STREAM_VELOCITY_Z,
+        STREAM_SOURCE_ROTATION_X,
+        STREAM_SOURCE_ROTATION_Y,
+        STREAM_SOURCE_ROTATION_Z,
+        STREAM_SOURCE_ROTATION_W,
+        STREAM_ROTATION_X,
+        STREAM_ROTATION_Y,
+        STREAM_ROTATION_Z,
+        STREAM_ROTATION_W,
+        STREAM_SCALE_X,
+        STREAM_SCALE_Y,
+        STREAM_SCALE_Z,
+        STREAM_SOURCE_COLOR_R,
+        STREAM_SOURCE_COLOR_G,
+        STREAM_SOURCE_COLOR_B,
+        STREAM_SOURCE_COLOR_A,
+        STREAM_COLOR_R,
+        STREAM_COLOR_G,
+        STREAM_COLOR_B,
+        STREAM_COLOR_A,
+        STREAM_TIME_LEFT,
+        STREAM_MAX_LIFE_TIME,
+        STREAM_OO_MAX_LIFE_TIME,
+        STREAM_SPREAD_FACTOR,
+        STREAM_SOURCE_SIZE,
+        STREAM_SOURCE_STRETCH_FACTOR_X,
+        STREAM_SOURCE_STRETCH_FACTOR_Y,
+        STREAM_STRETCH_FACTOR_X,
+        STREAM_STRETCH_FACTOR_Y,
+        STREAM_SOURCE_ANGULAR_VELOCITY,
+        STREAM_COUNT
+    };
+
+    /**
+     * Structure-of-arrays particle storage. Each stream is a 16-byte aligned float array, padded to a
+     * multiple of four particles, so the simulation kernels can process four particles at a time.
+     * The buffer also holds the scratch memory used when sorting.
+     *
+     * Like dmArray, the buffer can be moved with memcpy and the memory is released with SetCapacity(0).
+     */
+    struct ParticleBuffer
+    {
+        ParticleBuffer()
+        {
+            memset(this, 0, sizeof(ParticleBuffer));
+        }
+
+#define GET_SET_FLOAT(property, stream)\
+        inline float Get##property(uint32_t i) const { return GetStream(stream)[i]; }\
+        inline void Set##property(uint32_t i, float v) { GetStream(stream)[i] = v; }\
+
+#define GET_SET_VECTOR3(property, type, stream)\
+        inline type Get##property(uint32_t i) const { return type(GetStream(stream)[i], GetStream((ParticleStream)(stream + 1))[i], GetStream((ParticleStream)(stream + 2))[i]); }\
+        inline void Set##property(uint32_t i, const type& v) { GetStream(stream)[i] = v.getX(); GetStream((ParticleStream)(stream + 1))[i] = v.getY(); GetStream((ParticleStream)(stream + 2))[i] = v.getZ(); }\
+
+#define GET_SET_VECTOR4(property, type, stream)\
+        inline type Get##property(uint32_t i) const { return type(GetStream(stream)[i], GetStream((ParticleStream)(stream + 1))[i], GetStream((ParticleStream)(stream + 2))[i], GetStream((ParticleStream)(stream + 3))[i]); }\
+        inline void Set##property(uint32_t i, const type& v) { GetStream(stream)[i] = v.getX(); GetStream((ParticleStream)(stream + 1))[i] = v.getY(); GetStream((ParticleStream)(stream + 2))[i] = v.getZ(); GetStream((ParticleStream)(stream + 3))[i] = v.getW(); }\
+
+        GET_SET_VECTOR3(Position, Point3, STREAM_POSITION_X)
+        GET_SET_VECTOR3(Velocity, Vector3, STREAM_VELOCITY_X)
+        GET_SET_VECTOR4(SourceRotation, Quat, STREAM_SOURCE_ROTATION_X)
+        GET_SET_VECTOR4(Rotation, Quat, STREAM_ROTATION_X)
+        GET_SET_VECTOR3(Scale, Vector3, STREAM_SCALE_X)
+        GET_SET_VECTOR4(SourceColor, Vector4, STREAM_SOURCE_COLOR_R)
+        GET_SET_VECTOR4(Color, Vector4, STREAM_COLOR_R)
+        GET_SET_FLOAT(TimeLeft, STREAM_TIME_LEFT)
+        GET_SET_FLOAT(MaxLifeTime, STREAM_MAX_LIFE_TIME)
+        GET_SET_FLOAT(ooMaxLifeTime, STREAM_OO_MAX_LIFE_TIME)
+        GET_SET_FLOAT(SpreadFactor, STREAM_SPREAD_FACTOR)
+        GET_SET_FLOAT(SourceSize, STREAM_SOURCE_SIZE)
+        GET_SET_FLOAT(StretchFactorX, STREAM_STRETCH_FACTOR_X)
+        GET_SET_FLOAT(StretchFactorY, STREAM_STRETCH_FACTOR_Y)
+        GET_SET_FLOAT(SourceAngularVelocity, STREAM_SOURCE_ANGULAR_VELOCITY)
+#undef GET_SET_FLOAT
+#undef GET_SET_VECTOR3
+#undef GET_SET_VECTOR4
+
+        inline float* GetStream(ParticleStream stream) { return m_Data + stream * m_Stride; }
+        inline const float* GetStream(ParticleStream stream) const { return m_Data + stream * m_Stride; }
+        /// Sort keys, one 64-bit key per particle
+        inline uint64_t* GetSortKeys() { return (uint64_t*) (m_Data + STREAM_COUNT * m_Stride); }
+        /// One stream of scratch memory
+        inline float* GetScratch() { return m_Data + (STREAM_COUNT + 2) * m_Stride; }
+
+        inline uint32_t Size() const { return m_Size; }
+        inline uint32_t Capacity() const { return m_Capacity; }
+        inline uint32_t Remaining() const { return m_Capacity - m_Size; }
+        inline bool Empty() const { return m_Size == 0; }
+
+        inline void SetSize(uint32_t size)
+        {
+            assert(size <= m_Capacity);
+            m_Size = size;
+        }
+
+        /**
+         * Change the capacity. The particles that fit are kept, like dmArray::SetCapacity.
+         * @param capacity New capacity, 0 frees the memory
+         */
+        void SetCapacity(uint32_t capacity);
+        /// Remove a particle by moving the last particle into its place
+        void EraseSwap(uint32_t index);
+        /// Read a whole particle
+        void Get(uint32_t index, Particle* particle) const;
+        /// Write a whole particle
+        void Set(uint32_t index, const Particle& particle);
+
+        void Swap(ParticleBuffer& other)
+        {
+            ParticleBuffer tmp = *this;
+            *this = other;
+            other = tmp;
+        }
+
+        /// STREAM_COUNT streams, followed by the sort keys (two streams) and a scratch stream
+        float*   m_Data;
+        uint32_t m_Size;
+        uint32_t m_Capacity;
+        /// Number of floats per stream, capacity rounded up to a multiple of four
+        uint32_t m_Stride;
+    };
+
     /**
      * Representation of an emitter.
      */
@@ -113,7 +233,7 @@ namespace dmParticle
 
         AnimationData           m_AnimationData;
         /// Particle buffer.
-        dmArray<Particle>       m_Particles;
+        ParticleBuffer          m_Particles;
         dmArray<RenderConstant> m_RenderConstants;
         Vector3                 m_Velocity;
         Point3                  m_LastPosition;
@@ -181,13 +301,32 @@ namespace dmParticle
         uint16_t                m_ScaleAlongZ : 1;
     };
 
+    /**
+     * An emitter handled by one of the parallel passes in Update or GenerateVertexDataBatch.
+     */
+    struct EmitterJob
+    {
+        Instance*               m_Instance;
+        Emitter*                m_Emitter;
+        Vector4                 m_Color;
+        /// Handle of the instance
+        HInstance               m_InstanceHandle;
+        /// First vertex reserved for the emitter when generating vertex data
+        uint32_t                m_VertexIndex;
+        /// Index of the emitter in the instance
+        uint32_t                m_EmitterIndex;
+        /// Whether the emitter should be simulated this frame
+        uint32_t                m_Simulate : 1;
+    };
+
     /**
      * Representation of a context to hold a set of emitters.
      */
     struct Context
     {
         Context(uint32_t max_instance_count, uint32_t max_particle_count)
-        : m_MaxParticleCount(max_particle_count)
+        : m_WorkerPool(0)
+        , m_MaxParticleCount(max_particle_count)
         , m_NextVersionNumber(1)
         , m_InstanceSeeding(0)
         {
@@ -210,6 +349,10 @@ namespace dmParticle
         dmArray<Instance*>  m_Instances;
         /// Index pool used to index the instance buffer.
         dmIndexPool16       m_InstanceIndexPool;
+        /// Emitters processed by the current parallel pass
+        dmArray<EmitterJob> m_EmitterJobs;
+        /// Used to update the emitters and generate vertex data in parallel (optional)
+        dmWorkerPool::HWorkerPool m_WorkerPool;
         /// Maximum number of particles allowed
         uint32_t            m_MaxParticleCount;
         /// Version number used to create new handles.
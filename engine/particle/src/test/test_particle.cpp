@@ -19,7 +19,9 @@
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
 #include <dlib/math.h>
+#include <dlib/time.h>
 #include <dlib/vmath.h>
+#include <dlib/worker_pool.h>
 
 #include <ddf/ddf.h>
 
@@ -162,6 +164,13 @@ uint32_t ParticleCount(dmParticle::Emitter* emitter)
     return emitter->m_Particles.Size();
 }
 
+// Zeroes the padding so particles can be compared with memcmp
+void GetParticle(dmParticle::Emitter* emitter, uint32_t index, dmParticle::Particle* particle)
+{
+    memset(particle, 0, sizeof(dmParticle::Particle));
+    emitter->m_Particles.Get(index, particle);
+}
+
 bool LoadPrototype(const char* filename, dmParticle::HPrototype* prototype)
 {
     char path[128];
@@ -695,8 +704,8 @@ TEST_F(ParticleTest, EmissionSpace)
     dmParticle::Update(m_Context, dt, 0x0);
 
     dmParticle::Emitter* e = GetEmitter(m_Context, instance, 0);
-    dmParticle::Particle* p = &e->m_Particles[0];
-    ASSERT_EQ(10.0f, p->GetPosition().getX());
+    dmParticle::ParticleBuffer* particles = &e->m_Particles;
+    ASSERT_EQ(10.0f, particles->GetPosition(0).getX());
 
     dmParticle::DestroyInstance(m_Context, instance);
     dmParticle::Particle_DeletePrototype(m_Prototype);
@@ -712,8 +721,8 @@ TEST_F(ParticleTest, EmissionSpace)
     dmParticle::Update(m_Context, dt, 0x0);
 
     e = GetEmitter(m_Context, instance, 0);
-    p = &e->m_Particles[0];
-    ASSERT_EQ(0.0f, p->GetPosition().getX());
+    particles = &e->m_Particles;
+    ASSERT_EQ(0.0f, particles->GetPosition(0).getX());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -742,7 +751,7 @@ TEST_F(ParticleTest, ParticleLife)
 
     dmParticle::Update(m_Context, dt, 0x0);
 
-    ASSERT_EQ(0.0f, e->m_Particles[0].GetTimeLeft());
+    ASSERT_EQ(0.0f, e->m_Particles.GetTimeLeft(0));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -789,10 +798,10 @@ TEST_F(ParticleTest, ParticleVelocityStretch)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_NEAR(3.5f, e->m_Particles[0].m_Scale[1], EPSILON);
+    ASSERT_NEAR(3.5f, e->m_Particles.GetScale(0).getY(), EPSILON);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_NEAR(1.0f, e->m_Particles[0].m_Scale[1], EPSILON);
+    ASSERT_NEAR(1.0f, e->m_Particles.GetScale(0).getY(), EPSILON);
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -811,12 +820,12 @@ TEST_F(ParticleTest, ParticleStretch)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_NEAR(2.f, e->m_Particles[0].m_Scale[0], EPSILON);
-    ASSERT_NEAR(4.f, e->m_Particles[0].m_Scale[1], EPSILON);
+    ASSERT_NEAR(2.f, e->m_Particles.GetScale(0).getX(), EPSILON);
+    ASSERT_NEAR(4.f, e->m_Particles.GetScale(0).getY(), EPSILON);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_NEAR(2.f, e->m_Particles[0].m_Scale[0], EPSILON);
-    ASSERT_NEAR(2.f, e->m_Particles[0].m_Scale[1], EPSILON);
+    ASSERT_NEAR(2.f, e->m_Particles.GetScale(0).getX(), EPSILON);
+    ASSERT_NEAR(2.f, e->m_Particles.GetScale(0).getY(), EPSILON);
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -836,7 +845,7 @@ TEST_F(ParticleTest, ParticleOrientationMovementDirection)
 
     dmParticle::Update(m_Context, dt, 0x0);
 
-    Quat q = e->m_Particles[0].GetRotation();
+    Quat q = e->m_Particles.GetRotation(0);
 
     // Represents an euler rotation of 90 deg around Z
     ASSERT_EQ(0.0f, q.getX());
@@ -863,7 +872,7 @@ TEST_F(ParticleTest, ParticleApplyLifeRotationToMovementDirection)
 
     dmParticle::Update(m_Context, dt, 0x0);
 
-    Quat q = e->m_Particles[0].GetRotation();
+    Quat q = e->m_Particles.GetRotation(0);
 
     // Represents an euler rotation of 90deg particle life rotation combined with 90deg rotation along direction
     ASSERT_EQ(0.0f, q.getX());
@@ -896,7 +905,7 @@ TEST_F(ParticleTest, ParticleMovementDirection)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    Quat q = e->m_Particles[0].GetRotation();
+    Quat q = e->m_Particles.GetRotation(0);
 
     ASSERT_EQ(0.0f, q.getX());
     ASSERT_EQ(0.0f, q.getY());
@@ -904,7 +913,7 @@ TEST_F(ParticleTest, ParticleMovementDirection)
     ASSERT_NEAR(0.70710677, q.getW(), EPSILON);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    q = e->m_Particles[0].GetRotation();
+    q = e->m_Particles.GetRotation(0);
 
     ASSERT_EQ(0.0f, q.getX());
     ASSERT_EQ(0.0f, q.getY());
@@ -929,7 +938,7 @@ TEST_F(ParticleTest, ParticleAngularVelocity)
 
     dmParticle::Update(m_Context, dt, 0x0);
 
-    Quat q = e->m_Particles[0].GetRotation();
+    Quat q = e->m_Particles.GetRotation(0);
 
     Vector3 r = dmVMath::QuatToEuler(q.getX(), q.getY(), q.getZ(), q.getW());
     ASSERT_EQ(0.0f, r.getX());
@@ -937,7 +946,7 @@ TEST_F(ParticleTest, ParticleAngularVelocity)
     ASSERT_EQ(90.0f, r.getZ());
 
     dmParticle::Update(m_Context, dt, 0x0);
-    q = e->m_Particles[0].GetRotation();
+    q = e->m_Particles.GetRotation(0);
 
     r = dmVMath::QuatToEuler(q.getX(), q.getY(), q.getZ(), q.getW());
     ASSERT_EQ(0.0f, r.getX());
@@ -962,7 +971,7 @@ TEST_F(ParticleTest, ParticleAngularVelocityInitialRotation)
 
     dmParticle::Update(m_Context, dt, 0x0);
 
-    Quat q = e->m_Particles[0].GetRotation();
+    Quat q = e->m_Particles.GetRotation(0);
 
     Vector3 r = dmVMath::QuatToEuler(q.getX(), q.getY(), q.getZ(), q.getW());
     ASSERT_EQ(0.0f, r.getX());
@@ -970,7 +979,7 @@ TEST_F(ParticleTest, ParticleAngularVelocityInitialRotation)
     ASSERT_EQ(0.0f, r.getZ());
 
     dmParticle::Update(m_Context, dt, 0x0);
-    q = e->m_Particles[0].GetRotation();
+    q = e->m_Particles.GetRotation(0);
 
     r = dmVMath::QuatToEuler(q.getX(), q.getY(), q.getZ(), q.getW());
     ASSERT_EQ(0.0f, r.getX());
@@ -1146,36 +1155,36 @@ TEST_F(ParticleTest, EvaluateEmitterProperty)
 
     // t = 0.125, size < 0
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &e->m_Particles[0];
-    ASSERT_GT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    dmParticle::ParticleBuffer* particles = &e->m_Particles;
+    ASSERT_GT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.25, size = 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_EQ(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_EQ(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.375, size > 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_LT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_LT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.5, size = 1
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_EQ(1.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_EQ(1.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.625, size > 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_LT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_LT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.75, size = 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_EQ(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_EQ(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.875, size < 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_GT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_GT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 1, size = 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_NEAR(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize(), EPSILON);
+    ASSERT_NEAR(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0), EPSILON);
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1197,10 +1206,10 @@ TEST_F(ParticleTest, EvaluateEmitterPropertySpread)
         dmParticle::StartInstance(m_Context, instance);
 
         dmParticle::Update(m_Context, dt, 0x0);
-        dmParticle::Particle* particle = &emitter->m_Particles[0];
+        dmParticle::ParticleBuffer* particles = &emitter->m_Particles;
         // NOTE size could potentially be 0, but not likely
-        ASSERT_NE(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
-        ASSERT_GE(1.0f, dmMath::Abs(minElem(particle->GetScale()) * particle->GetSourceSize()));
+        ASSERT_NE(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
+        ASSERT_GE(1.0f, dmMath::Abs(minElem(particles->GetScale(0)) * particles->GetSourceSize(0)));
 
         dmParticle::DestroyInstance(m_Context, instance);
     }
@@ -1229,37 +1238,37 @@ TEST_F(ParticleTest, EvaluateParticleProperty)
 
     // t = 0.125, size < 0
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &e->m_Particles[0];
-    ASSERT_GT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    dmParticle::ParticleBuffer* particles = &e->m_Particles;
+    ASSERT_GT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.25, size = 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_EQ(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_EQ(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.375, size > 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_LT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_LT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.5, size = 1
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_EQ(1.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_EQ(1.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.625, size > 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_LT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_LT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.75, size = 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_EQ(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_EQ(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 0.875, size < 0
     // Updating with a full dt here will make the emitter reach its duration
     dmParticle::Update(m_Context, dt - EPSILON, 0x0);
-    ASSERT_GT(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize());
+    ASSERT_GT(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     // t = 1, size = 0
     dmParticle::Update(m_Context, dt, 0x0);
-    ASSERT_NEAR(0.0f, minElem(particle->GetScale()) * particle->GetSourceSize(), EPSILON);
+    ASSERT_NEAR(0.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0), EPSILON);
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1280,8 +1289,8 @@ TEST_F(ParticleTest, ParticleInstanceScale)
     dmParticle::Update(m_Context, dt, 0x0);
 
     dmParticle::Emitter* e = GetEmitter(m_Context, instance, 0);
-    dmParticle::Particle* p = &e->m_Particles[0];
-    ASSERT_EQ(2.0f, minElem(p->GetScale()) * p->GetSourceSize());
+    dmParticle::ParticleBuffer* particles = &e->m_Particles;
+    ASSERT_EQ(2.0f, minElem(particles->GetScale(0)) * particles->GetSourceSize(0));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1467,25 +1476,25 @@ TEST_F(ParticleTest, StableSort)
     ASSERT_EQ(particle_count, i->m_Emitters[0].m_Particles.Size());
 
     float x[particle_count];
-    dmParticle::Particle* p = &i->m_Emitters[0].m_Particles[0];
+    dmParticle::ParticleBuffer* p = &i->m_Emitters[0].m_Particles;
     // Store x-positions
     for (uint32_t pi = 0; pi < particle_count; ++pi)
     {
         float f = (float)pi + 1;
         x[pi] = f;
-        Point3 pos = p[pi].GetPosition();
+        Point3 pos = p->GetPosition(pi);
         pos.setX(f);
-        p[pi].SetPosition(pos);
+        p->SetPosition(pi, pos);
     }
     // Disturb order by altering a few particles
     const uint32_t disturb_count = particle_count / 2;
     for (uint32_t d = 0; d < disturb_count; ++d)
     {
-        p[d].SetTimeLeft(p[d].GetTimeLeft() - dt);
+        p->SetTimeLeft(d, p->GetTimeLeft(d) - dt);
         x[d] += particle_count;
-        Point3 pos = p[d].GetPosition();
+        Point3 pos = p->GetPosition(d);
         pos.setX(x[d]);
-        p[d].SetPosition(pos);
+        p->SetPosition(d, pos);
     }
     // Sort
     dmParticle::Update(m_Context, dt, 0x0);
@@ -1494,7 +1503,7 @@ TEST_F(ParticleTest, StableSort)
     // Verify order of undisturbed
     for (uint32_t pi = 0; pi < particle_count; ++pi)
     {
-        ASSERT_EQ(x[pi], p[pi].GetPosition().getX());
+        ASSERT_EQ(x[pi], p->GetPosition(pi).getX());
     }
 
     dmParticle::DestroyInstance(m_Context, instance);
@@ -1527,7 +1536,7 @@ TEST_F(ParticleTest, ReloadInstance)
     ASSERT_EQ(1u, e->m_Particles.Size());
 
     dmParticle::Particle original_particle;
-    memcpy(&original_particle, &e->m_Particles[0], sizeof(dmParticle::Particle));
+    GetParticle(e, 0, &original_particle);
 
     uint32_t seed = e->m_Seed;
     float timer = e->m_Timer;
@@ -1538,8 +1547,9 @@ TEST_F(ParticleTest, ReloadInstance)
     ASSERT_EQ(timer, e->m_Timer);
     ASSERT_EQ(seed, e->m_Seed);
     ASSERT_EQ(1u, e->m_Particles.Size());
-    dmParticle::Particle* particle = &e->m_Particles[0];
-    ASSERT_EQ(0, memcmp(&original_particle, particle, sizeof(dmParticle::Particle)));
+    dmParticle::Particle particle;
+    GetParticle(e, 0, &particle);
+    ASSERT_EQ(0, memcmp(&original_particle, &particle, sizeof(dmParticle::Particle)));
 
     dmParticle::Emitter* e1 = GetEmitter(m_Context, instance, 1);
     ASSERT_EQ(1u, e1->m_Particles.Size());
@@ -1549,8 +1559,8 @@ TEST_F(ParticleTest, ReloadInstance)
     e = GetEmitter(m_Context, instance, 0);
 
     ASSERT_EQ(1u, e->m_Particles.Size());
-    particle = &e->m_Particles[0];
-    ASSERT_EQ(0, memcmp(&original_particle, particle, sizeof(dmParticle::Particle)));
+    GetParticle(e, 0, &particle);
+    ASSERT_EQ(0, memcmp(&original_particle, &particle, sizeof(dmParticle::Particle)));
 
     // Test reload with max_particle_count changed
     ASSERT_TRUE(ReloadPrototype("reload3.particlefxc", m_Prototype));
@@ -1558,8 +1568,8 @@ TEST_F(ParticleTest, ReloadInstance)
     e = GetEmitter(m_Context, instance, 0);
 
     ASSERT_EQ(2u, e->m_Particles.Size());
-    particle = &e->m_Particles[0];
-    ASSERT_EQ(0, memcmp(&original_particle, particle, sizeof(dmParticle::Particle)));
+    GetParticle(e, 0, &particle);
+    ASSERT_EQ(0, memcmp(&original_particle, &particle, sizeof(dmParticle::Particle)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1587,7 +1597,7 @@ TEST_F(ParticleTest, ReloadInstanceLoop)
     float emitter_timer = e->m_Timer;
 
     dmParticle::Particle original_particle;
-    memcpy(&original_particle, &e->m_Particles[0], sizeof(dmParticle::Particle));
+    GetParticle(e, 0, &original_particle);
 
     ASSERT_TRUE(ReloadPrototype("reload_loop.particlefxc", m_Prototype));
     dmParticle::ReloadInstance(m_Context, instance, true);
@@ -1596,8 +1606,9 @@ TEST_F(ParticleTest, ReloadInstanceLoop)
     ASSERT_EQ(1u, e->m_Particles.Size());
     ASSERT_EQ(emitter_timer, e->m_Timer);
     ASSERT_EQ(1u, e->m_Particles.Size());
-    dmParticle::Particle* particle = &e->m_Particles[0];
-    ASSERT_EQ(0, memcmp(&original_particle, particle, sizeof(dmParticle::Particle)));
+    dmParticle::Particle particle;
+    GetParticle(e, 0, &particle);
+    ASSERT_EQ(0, memcmp(&original_particle, &particle, sizeof(dmParticle::Particle)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1654,19 +1665,18 @@ TEST_F(ParticleTest, AccelerationWorld)
 
     dmParticle::StartInstance(m_Context, instance);
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_EQ(1.0f, particle->GetVelocity().getY());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_EQ(1.0f, particles->GetVelocity(0).getY());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::SetRotation(m_Context, instance, Quat::rotationZ(M_PI * 0.5f));
     dmParticle::ResetInstance(m_Context, instance);
     dmParticle::StartInstance(m_Context, instance);
     dmParticle::Update(m_Context, dt, 0x0);
-    particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_EQ(1.0f, particle->GetVelocity().getY());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_EQ(1.0f, particles->GetVelocity(0).getY());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1690,8 +1700,8 @@ TEST_F(ParticleTest, AccelerationScaledEmitter)
 
         dmParticle::StartInstance(m_Context, instance);
         dmParticle::Update(m_Context, dt, 0x0);
-        dmParticle::Particle* particle = &inst->m_Emitters[0].m_Particles[0];
-        delta[i] = Vector3(particle->GetPosition());
+        dmParticle::ParticleBuffer* particles = &inst->m_Emitters[0].m_Particles;
+        delta[i] = Vector3(particles->GetPosition(0));
 
         dmParticle::DestroyInstance(m_Context, instance);
     }
@@ -1721,8 +1731,8 @@ TEST_F(ParticleTest, AccelerationScaledWorld)
 
         dmParticle::StartInstance(m_Context, instance);
         dmParticle::Update(m_Context, dt, 0x0);
-        dmParticle::Particle* particle = &inst->m_Emitters[0].m_Particles[0];
-        delta[i] = Vector3(particle->GetPosition());
+        dmParticle::ParticleBuffer* particles = &inst->m_Emitters[0].m_Particles;
+        delta[i] = Vector3(particles->GetPosition(0));
 
         dmParticle::DestroyInstance(m_Context, instance);
     }
@@ -1744,19 +1754,18 @@ TEST_F(ParticleTest, AccelerationEmitter)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_NEAR(1.0f, particle->GetVelocity().getY(), EPSILON);
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_NEAR(1.0f, particles->GetVelocity(0).getY(), EPSILON);
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::SetRotation(m_Context, instance, Quat::rotationZ(M_PI));
     dmParticle::ResetInstance(m_Context, instance);
     dmParticle::StartInstance(m_Context, instance);
     dmParticle::Update(m_Context, dt, 0x0);
-    particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_NEAR(1.0f, particle->GetVelocity().getY(), EPSILON);
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_NEAR(1.0f, particles->GetVelocity(0).getY(), EPSILON);
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1772,22 +1781,20 @@ TEST_F(ParticleTest, AccelerationAnimated)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &emitter->m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_LT(0.0f, particle->GetVelocity().getY());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    dmParticle::ParticleBuffer* particles = &emitter->m_Particles;
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_LT(0.0f, particles->GetVelocity(0).getY());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::Update(m_Context, dt, 0x0);
     // New particle at 0 because of sorting
-    particle = &emitter->m_Particles[0];
-    ASSERT_EQ(0.0f, lengthSqr(particle->GetVelocity()));
+    ASSERT_EQ(0.0f, lengthSqr(particles->GetVelocity(0)));
 
     dmParticle::Update(m_Context, dt, 0x0);
     // New particle at 0 because of sorting
-    particle = &emitter->m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_GT(0.0f, particle->GetVelocity().getY());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_GT(0.0f, particles->GetVelocity(0).getY());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1804,8 +1811,8 @@ TEST_F(ParticleTest, DragNoDir)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, lengthSqr(particle->GetVelocity()));
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0.0f, lengthSqr(particles->GetVelocity(0)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1822,8 +1829,8 @@ TEST_F(ParticleTest, DragDir)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    Vector3 velocity = particle->GetVelocity();
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    Vector3 velocity = particles->GetVelocity(0);
     ASSERT_NEAR(0.0f, velocity.getX(), EPSILON);
     ASSERT_LT(0.0f, velocity.getY());
     ASSERT_EQ(0.0f, velocity.getZ());
@@ -1843,8 +1850,8 @@ TEST_F(ParticleTest, DragBigMagnitude)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0u, lengthSqr(particle->GetVelocity()));
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0u, lengthSqr(particles->GetVelocity(0)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1861,9 +1868,9 @@ TEST_F(ParticleTest, Radial)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(1.0f, lengthSqr(particle->GetVelocity()));
-    ASSERT_EQ(-1.0f, particle->GetVelocity().getX());
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(1.0f, lengthSqr(particles->GetVelocity(0)));
+    ASSERT_EQ(-1.0f, particles->GetVelocity(0).getX());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1880,16 +1887,15 @@ TEST_F(ParticleTest, RadialMaxDistance)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, lengthSqr(particle->GetVelocity()));
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0.0f, lengthSqr(particles->GetVelocity(0)));
 
     // Test with instance scale
     dmParticle::ResetInstance(m_Context, instance);
     dmParticle::SetScale(m_Context, instance, 2.0f);
     dmParticle::StartInstance(m_Context, instance);
     dmParticle::Update(m_Context, dt, 0x0);
-    particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, lengthSqr(particle->GetVelocity()));
+    ASSERT_EQ(0.0f, lengthSqr(particles->GetVelocity(0)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1907,8 +1913,8 @@ TEST_F(ParticleTest, RadialEdgeCase)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(1.0f, lengthSqr(particle->GetVelocity()));
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(1.0f, lengthSqr(particles->GetVelocity(0)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1925,10 +1931,10 @@ TEST_F(ParticleTest, Vortex)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, particle->GetVelocity().getX());
-    ASSERT_EQ(-1.0f, particle->GetVelocity().getY());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getX());
+    ASSERT_EQ(-1.0f, particles->GetVelocity(0).getY());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1945,16 +1951,15 @@ TEST_F(ParticleTest, VortexMaxDistance)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, lengthSqr(particle->GetVelocity()));
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(0.0f, lengthSqr(particles->GetVelocity(0)));
 
     // Test with instance scale
     dmParticle::ResetInstance(m_Context, instance);
     dmParticle::SetScale(m_Context, instance, 2.0f);
     dmParticle::StartInstance(m_Context, instance);
     dmParticle::Update(m_Context, dt, 0x0);
-    particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(0.0f, lengthSqr(particle->GetVelocity()));
+    ASSERT_EQ(0.0f, lengthSqr(particles->GetVelocity(0)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -1971,10 +1976,10 @@ TEST_F(ParticleTest, VortexEdgeCase)
     dmParticle::StartInstance(m_Context, instance);
 
     dmParticle::Update(m_Context, dt, 0x0);
-    dmParticle::Particle* particle = &i->m_Emitters[0].m_Particles[0];
-    ASSERT_EQ(-1.0f, particle->GetVelocity().getX());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getY());
-    ASSERT_EQ(0.0f, particle->GetVelocity().getZ());
+    dmParticle::ParticleBuffer* particles = &i->m_Emitters[0].m_Particles;
+    ASSERT_EQ(-1.0f, particles->GetVelocity(0).getX());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getY());
+    ASSERT_EQ(0.0f, particles->GetVelocity(0).getZ());
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -2050,8 +2055,8 @@ TEST_F(ParticleTest, InheritVelocity)
     dmParticle::SetPosition(m_Context, instance, Point3(10, 0, 0));
     dmParticle::Update(m_Context, dt, 0x0);
 
-    ASSERT_EQ(0.0f, lengthSqr(e1->m_Particles[0].GetVelocity()));
-    ASSERT_NE(0.0f, lengthSqr(e2->m_Particles[0].GetVelocity()));
+    ASSERT_EQ(0.0f, lengthSqr(e1->m_Particles.GetVelocity(0)));
+    ASSERT_NE(0.0f, lengthSqr(e2->m_Particles.GetVelocity(0)));
 
     dmParticle::DestroyInstance(m_Context, instance);
 }
@@ -2084,6 +2089,139 @@ TEST_F(ParticleTest, Stats)
     dmParticle::DestroyInstance(m_Context, instance);
 }
 
+static dmParticle::HInstance CreateSeededInstance(dmParticle::HParticleContext context, dmParticle::HPrototype prototype, uint32_t seed, uint32_t max_particle_count)
+{
+    dmParticle::HInstance instance = dmParticle::CreateInstance(context, prototype, 0x0);
+    dmParticle::Instance* inst = context->m_Instances[instance & 0xffff];
+    for (uint32_t i = 0; i < inst->m_Emitters.Size(); ++i)
+    {
+        inst->m_Emitters[i].m_Particles.SetCapacity(max_particle_count);
+        inst->m_Emitters[i].m_OriginalSeed = seed + i;
+        inst->m_Emitters[i].m_Seed = seed + i;
+    }
+    dmParticle::SetPosition(context, instance, Point3((float)seed, 0.0f, 0.0f));
+    dmParticle::StartInstance(context, instance);
+    return instance;
+}
+
+/**
+ * Update the same set of instances with and without a worker pool and verify that the particles and the
+ * vertex data are identical, also when the shared particle budget and vertex buffer run out.
+ */
+TEST_F(ParticleTest, WorkerPool)
+{
+    const uint32_t instance_count = 8;
+    const uint32_t max_particle_count = 4000;
+    const float dt = 1.0f / 60.0f;
+
+    ASSERT_TRUE(LoadPrototype("bench.particlefxc", &m_Prototype));
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(3, "particle_test");
+    dmParticle::HParticleContext contexts[2];
+    dmParticle::HInstance instances[2][instance_count];
+    dmParticle::EmitterVertexData emitters[2][instance_count];
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        contexts[c] = dmParticle::CreateContext(instance_count, max_particle_count);
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            instances[c][i] = CreateSeededInstance(contexts[c], m_Prototype, i * 100, max_particle_count / (instance_count - 2));
+            emitters[c][i].m_Instance = instances[c][i];
+            emitters[c][i].m_EmitterIndex = 0;
+            emitters[c][i].m_Color = Vector4(1.0f, 0.5f, 0.25f, 1.0f);
+        }
+    }
+    dmParticle::SetWorkerPool(contexts[1], pool);
+
+    uint32_t vertex_buffer_size = dmParticle::GetVertexBufferSize(max_particle_count, dmParticle::PARTICLE_GO);
+    uint8_t* vertex_buffers[2] = { new uint8_t[vertex_buffer_size], new uint8_t[vertex_buffer_size] };
+
+    for (uint32_t frame = 0; frame < 90; ++frame)
+    {
+        uint32_t out_vertex_buffer_sizes[2] = { 0, 0 };
+        dmParticle::Update(contexts[0], dt, 0x0);
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            dmParticle::GenerateVertexData(contexts[0], dt, instances[0][i], 0, emitters[0][i].m_Color, vertex_buffers[0], vertex_buffer_size, &out_vertex_buffer_sizes[0], dmParticle::PARTICLE_GO);
+        }
+        dmParticle::Update(contexts[1], dt, 0x0);
+        dmParticle::GenerateVertexDataBatch(contexts[1], dt, emitters[1], instance_count, vertex_buffers[1], vertex_buffer_size, &out_vertex_buffer_sizes[1], dmParticle::PARTICLE_GO);
+
+        ASSERT_EQ(out_vertex_buffer_sizes[0], out_vertex_buffer_sizes[1]);
+        ASSERT_EQ(0, memcmp(vertex_buffers[0], vertex_buffers[1], out_vertex_buffer_sizes[0]));
+        ASSERT_EQ(contexts[0]->m_Stats.m_Particles, contexts[1]->m_Stats.m_Particles);
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            dmParticle::Emitter* e0 = GetEmitter(contexts[0], instances[0][i], 0);
+            dmParticle::Emitter* e1 = GetEmitter(contexts[1], instances[1][i], 0);
+            ASSERT_EQ(ParticleCount(e0), ParticleCount(e1));
+            ASSERT_EQ(e0->m_VertexIndex, e1->m_VertexIndex);
+            ASSERT_EQ(e0->m_VertexCount, e1->m_VertexCount);
+        }
+    }
+    ASSERT_EQ(vertex_buffer_size, contexts[0]->m_Stats.m_Particles * 6 * sizeof(dmParticle::Vertex));
+
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            dmParticle::DestroyInstance(contexts[c], instances[c][i]);
+        }
+        dmParticle::DestroyContext(contexts[c]);
+        delete [] vertex_buffers[c];
+    }
+    dmWorkerPool::Delete(pool);
+}
+
+/**
+ * Simulate a looping effect with 100k live particles and all modifier types, and report the throughput
+ * of the simulation (Update) and the vertex generation separately.
+ */
+TEST_F(ParticleTest, Bench)
+{
+    const uint32_t max_particle_count = 100000;
+    const float dt = 1.0f / 60.0f;
+    dmParticle::HParticleContext context = dmParticle::CreateContext(1, max_particle_count);
+    uint32_t vertex_buffer_size = dmParticle::GetVertexBufferSize(max_particle_count, dmParticle::PARTICLE_GO);
+    uint8_t* vertex_buffer = new uint8_t[vertex_buffer_size];
+
+    ASSERT_TRUE(LoadPrototype("bench.particlefxc", &m_Prototype));
+    dmParticle::HInstance instance = dmParticle::CreateInstance(context, m_Prototype, 0x0);
+    dmParticle::StartInstance(context, instance);
+    dmParticle::Emitter* e = GetEmitter(context, instance, 0);
+
+    // Warm up, particles start dying after one second
+    for (uint32_t i = 0; i < 90; ++i)
+    {
+        dmParticle::Update(context, dt, 0x0);
+    }
+    ASSERT_EQ(max_particle_count, ParticleCount(e));
+
+    const uint32_t frame_count = 60;
+    uint64_t update_time = 0;
+    uint64_t vertex_time = 0;
+    for (uint32_t i = 0; i < frame_count; ++i)
+    {
+        uint64_t start = dmTime::GetTime();
+        dmParticle::Update(context, dt, 0x0);
+        uint64_t mid = dmTime::GetTime();
+        uint32_t out_vertex_buffer_size = 0;
+        dmParticle::GenerateVertexData(context, dt, instance, 0, Vector4(1, 1, 1, 1), vertex_buffer, vertex_buffer_size, &out_vertex_buffer_size, dmParticle::PARTICLE_GO);
+        uint64_t end = dmTime::GetTime();
+        ASSERT_EQ(vertex_buffer_size, out_vertex_buffer_size);
+        update_time += mid - start;
+        vertex_time += end - mid;
+    }
+
+    double particles = (double)max_particle_count * frame_count;
+    printf("\n%u particles: update %.0f particles/ms, vertex data %.0f particles/ms\n", max_particle_count,
+           particles * 1000.0 / update_time, particles * 1000.0 / vertex_time);
+
+    dmParticle::DestroyInstance(context, instance);
+    dmParticle::DestroyContext(context);
+    delete [] vertex_buffer;
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -14,6 +14,7 @@
 #include "physics_private.h"
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <dlib/array.h>
@@ -25,39 +26,49 @@ namespace dmPhysics
     using namespace Vectormath::Aos;
 
     /**
-     * Adds the overlap of an object to a specific entry.
-     * Returns whether the overlap was added (might be out of space).
+     * Finds the overlap of an object in a specific entry.
      */
-    static bool AddOverlap(OverlapEntry* entry, void* object, bool* out_found, const uint32_t trigger_overlap_capacity)
+    static Overlap* FindOverlap(OverlapEntry* entry, void* object)
     {
-        bool found = false;
         for (uint32_t i = 0; i < entry->m_OverlapCount; ++i)
         {
             Overlap& overlap = entry->m_Overlaps[i];
             if (overlap.m_Object == object)
             {
-                ++overlap.m_Count;
-                found = true;
-                break;
+                return &overlap;
             }
         }
+        return 0x0;
+    }
+
+    /**
+     * Adds the overlap of an object to a specific entry, the overlaps of the entry grow when needed.
+     * Returns the overlap.
+     */
+    static Overlap* AddOverlap(OverlapEntry* entry, void* object, bool* out_found, const uint32_t trigger_overlap_capacity)
+    {
+        Overlap* overlap = FindOverlap(entry, object);
         if (out_found != 0x0)
-            *out_found = found;
-        if (!found)
+            *out_found = overlap != 0x0;
+        if (overlap == 0x0)
         {
-            if (entry->m_OverlapCount == trigger_overlap_capacity)
-            {
-                dmLogError("Trigger overlap capacity reached, overlap will not be stored for enter/exit callbacks.");
-                return false;
-            }
-            else
+            if (entry->m_OverlapCount == entry->m_OverlapCapacity)
             {
-                Overlap& overlap = entry->m_Overlaps[entry->m_OverlapCount++];
-                overlap.m_Object = object;
-                overlap.m_Count = 1;
+                uint32_t capacity = entry->m_OverlapCapacity * 2;
+                if (capacity < trigger_overlap_capacity)
+                    capacity = trigger_overlap_capacity;
+                if (capacity == 0)
+                    capacity = 1;
+                entry->m_Overlaps = (Overlap*)realloc(entry->m_Overlaps, capacity * sizeof(Overlap));
+                entry->m_OverlapCapacity = capacity;
             }
+            overlap = &entry->m_Overlaps[entry->m_OverlapCount++];
+            overlap->m_Object = object;
+            overlap->m_Count = 0;
+            overlap->m_Entered = 0;
         }
-        return true;
+        ++overlap->m_Count;
+        return overlap;
     }
 
     /**
@@ -65,48 +76,69 @@ namespace dmPhysics
      */
     static void RemoveOverlap(OverlapEntry* entry, void* object)
     {
-        uint32_t count = entry->m_OverlapCount;
-        for (uint32_t i = 0; i < count; ++i)
+        Overlap* overlap = FindOverlap(entry, object);
+        if (overlap != 0x0)
         {
-            Overlap& overlap = entry->m_Overlaps[i];
-            if (overlap.m_Object == object)
-            {
-                overlap = entry->m_Overlaps[count-1];
-                --entry->m_OverlapCount;
-                return;
-            }
+            *overlap = entry->m_Overlaps[entry->m_OverlapCount-1];
+            --entry->m_OverlapCount;
         }
     }
 
     /**
-     * Add the entry of two overlapping objects to the cache.
-     * Automatically creates the overlap, but is not symmetric.
+     * Add an entry without overlaps for an object to the cache.
+     * Pointers to other entries are invalidated when the cache grows.
      */
-    static void AddEntry(OverlapCache* cache, void* object_a, void* user_data_a, void* object_b, uint16_t group_a)
+    static void AddEntry(OverlapCache* cache, void* object, void* user_data, uint16_t group)
     {
-        // Check if the cache needs to be expanded
-        uint32_t size = cache->m_OverlapCache.Size();
-        uint32_t capacity = cache->m_OverlapCache.Capacity();
-        // Expand when 80% full
-        if (size > 3 * capacity / 4)
-        {
-            capacity += CACHE_EXPANSION;
-            cache->m_OverlapCache.SetCapacity(3 * capacity / 4, capacity);
-        }
         OverlapEntry entry;
         memset(&entry, 0, sizeof(entry));
-        entry.m_Overlaps = (Overlap*)malloc(cache->m_TriggerOverlapCapacity * sizeof(Overlap));
-        entry.m_UserData = user_data_a;
-        entry.m_Group = group_a;
-        // Add overlap to the entry
-        AddOverlap(&entry, object_b, 0x0, cache->m_TriggerOverlapCapacity);
-        // Add the entry
-        cache->m_OverlapCache.Put((uintptr_t)object_a, entry);
+        entry.m_UserData = user_data;
+        entry.m_Group = group;
+        cache->m_OverlapCache.Put((uintptr_t)object, entry);
+    }
+
+    /**
+     * Adds a contact between two objects to the cache, creating entries for previously unrecorded objects.
+     * Returns whether the pair was already overlapping and the overlaps of both objects.
+     */
+    static bool AddPair(OverlapCache* cache, const OverlapCacheAddData& data, Overlap** out_overlap_a, Overlap** out_overlap_b)
+    {
+        if (cache->m_OverlapCache.Get((uintptr_t)data.m_ObjectA) == 0x0)
+            AddEntry(cache, data.m_ObjectA, data.m_UserDataA, data.m_GroupA);
+        if (cache->m_OverlapCache.Get((uintptr_t)data.m_ObjectB) == 0x0)
+            AddEntry(cache, data.m_ObjectB, data.m_UserDataB, data.m_GroupB);
+        // Look up both entries after any insertion since the cache might have grown
+        OverlapEntry* entry_a = cache->m_OverlapCache.Get((uintptr_t)data.m_ObjectA);
+        OverlapEntry* entry_b = cache->m_OverlapCache.Get((uintptr_t)data.m_ObjectB);
+        bool found = false;
+        *out_overlap_a = AddOverlap(entry_a, data.m_ObjectB, &found, cache->m_TriggerOverlapCapacity);
+        *out_overlap_b = AddOverlap(entry_b, data.m_ObjectA, 0x0, cache->m_TriggerOverlapCapacity);
+        return found;
+    }
+
+    static void CallTriggerEntered(TriggerEnteredCallback callback, void* user_data, OverlapEntry* entry_a, OverlapEntry* entry_b)
+    {
+        TriggerEnter enter;
+        enter.m_UserDataA = entry_a->m_UserData;
+        enter.m_UserDataB = entry_b->m_UserData;
+        enter.m_GroupA = entry_a->m_Group;
+        enter.m_GroupB = entry_b->m_Group;
+        callback(enter, user_data);
+    }
+
+    static void CallTriggerExited(TriggerExitedCallback callback, void* user_data, OverlapEntry* entry_a, OverlapEntry* entry_b)
+    {
+        TriggerExit exit;
+        exit.m_UserDataA = entry_a->m_UserData;
+        exit.m_UserDataB = entry_b->m_UserData;
+        exit.m_GroupA = entry_a->m_Group;
+        exit.m_GroupB = entry_b->m_Group;
+        callback(exit, user_data);
     }
 
     void OverlapCacheInit(OverlapCache* cache)
     {
-    	cache->m_OverlapCache.SetCapacity(3 * CACHE_INITIAL_CAPACITY / 4, CACHE_INITIAL_CAPACITY);
+        cache->m_OverlapCache.SetCapacity(CACHE_INITIAL_CAPACITY);
     }
 
     /**
@@ -123,38 +155,16 @@ namespace dmPhysics
 
     void OverlapCacheReset(OverlapCache* cache)
     {
-    	cache->m_OverlapCache.Iterate(ResetOverlap, (void*)0x0);
+        cache->m_OverlapCache.Iterate(ResetOverlap, (void*)0x0);
     }
 
     void OverlapCacheAdd(OverlapCache* cache, const OverlapCacheAddData& data)
     {
-        bool found = false;
-        OverlapEntry* entry_a = cache->m_OverlapCache.Get((uintptr_t)data.m_ObjectA);
-        if (entry_a != 0x0)
-        {
-            if (!AddOverlap(entry_a, data.m_ObjectB, &found, cache->m_TriggerOverlapCapacity))
-            {
-                // The overlap could not be added to entry_a, bail out
-                return;
-            }
-        }
-        OverlapEntry* entry_b = cache->m_OverlapCache.Get((uintptr_t)data.m_ObjectB);
-        if (entry_b != 0x0)
-        {
-            if (!AddOverlap(entry_b, data.m_ObjectA, &found, cache->m_TriggerOverlapCapacity))
-            {
-                // No space in entry_b, clean up entry_a
-                if (entry_a != 0x0)
-                    RemoveOverlap(entry_a, data.m_ObjectB);
-                // Bail out
-                return;
-            }
-        }
-        // Add entries for previously unrecorded objects
-        if (entry_a == 0x0)
-            AddEntry(cache, data.m_ObjectA, data.m_UserDataA, data.m_ObjectB, data.m_GroupA);
-        if (entry_b == 0x0)
-            AddEntry(cache, data.m_ObjectB, data.m_UserDataB, data.m_ObjectA, data.m_GroupB);
+        Overlap* overlap_a;
+        Overlap* overlap_b;
+        bool found = AddPair(cache, data, &overlap_a, &overlap_b);
+        overlap_a->m_Entered = 1;
+        overlap_b->m_Entered = 1;
         // Callback for newly added overlaps
         if (!found && data.m_TriggerEnteredCallback != 0x0)
         {
@@ -183,8 +193,8 @@ namespace dmPhysics
                 }
             }
             // Remove the object from the cache
-            cache->m_OverlapCache.Erase((uintptr_t)object);
             free(entry->m_Overlaps);
+            cache->m_OverlapCache.Erase((uintptr_t)object);
         }
     }
 
@@ -217,14 +227,9 @@ namespace dmPhysics
             {
                 OverlapEntry* entry = cache->m_OverlapCache.Get((uintptr_t)overlap.m_Object);
                 // Trigger exit callback
-                if (callback != 0x0)
+                if (callback != 0x0 && overlap.m_Entered)
                 {
-                    TriggerExit data;
-                    data.m_UserDataA = value->m_UserData;
-                    data.m_UserDataB = entry->m_UserData;
-                    data.m_GroupA = value->m_Group;
-                    data.m_GroupB = entry->m_Group;
-                    callback(data, user_data);
+                    CallTriggerExited(callback, user_data, value, entry);
                 }
                 RemoveOverlap(entry, object_a);
 
@@ -246,4 +251,83 @@ namespace dmPhysics
         context.m_Cache = cache;
         cache->m_OverlapCache.Iterate(PruneOverlap, &context);
     }
+
+    static void AddChangedPair(OverlapCache* cache, void* object_a, void* object_b)
+    {
+        dmArray<OverlapPair>& pairs = cache->m_ChangedPairs;
+        if (pairs.Full())
+        {
+            pairs.OffsetCapacity(pairs.Capacity() > 16 ? pairs.Capacity() : 16);
+        }
+        OverlapPair pair;
+        pair.m_ObjectA = object_a;
+        pair.m_ObjectB = object_b;
+        pairs.Push(pair);
+    }
+
+    void OverlapCacheBeginContact(OverlapCache* cache, const OverlapCacheAddData& data)
+    {
+        Overlap* overlap_a;
+        Overlap* overlap_b;
+        AddPair(cache, data, &overlap_a, &overlap_b);
+        AddChangedPair(cache, data.m_ObjectA, data.m_ObjectB);
+    }
+
+    void OverlapCacheEndContact(OverlapCache* cache, void* object_a, void* object_b)
+    {
+        OverlapEntry* entry_a = cache->m_OverlapCache.Get((uintptr_t)object_a);
+        OverlapEntry* entry_b = cache->m_OverlapCache.Get((uintptr_t)object_b);
+        if (entry_a == 0x0 || entry_b == 0x0)
+        {
+            // One of the objects has been removed, which also removed the overlaps
+            return;
+        }
+        Overlap* overlap_a = FindOverlap(entry_a, object_b);
+        Overlap* overlap_b = FindOverlap(entry_b, object_a);
+        if (overlap_a != 0x0 && overlap_b != 0x0 && overlap_a->m_Count > 0)
+        {
+            --overlap_a->m_Count;
+            --overlap_b->m_Count;
+            AddChangedPair(cache, object_a, object_b);
+        }
+    }
+
+    void OverlapCacheFlush(OverlapCache* cache, const OverlapCacheFlushData& data)
+    {
+        // A pair might occur several times, or refer to removed objects, so the current state of the pair is
+        // compared to what has been reported so far.
+        dmArray<OverlapPair>& pairs = cache->m_ChangedPairs;
+        uint32_t count = pairs.Size();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            void* object_a = pairs[i].m_ObjectA;
+            void* object_b = pairs[i].m_ObjectB;
+            OverlapEntry* entry_a = cache->m_OverlapCache.Get((uintptr_t)object_a);
+            OverlapEntry* entry_b = cache->m_OverlapCache.Get((uintptr_t)object_b);
+            if (entry_a == 0x0 || entry_b == 0x0)
+                continue;
+            Overlap* overlap_a = FindOverlap(entry_a, object_b);
+            Overlap* overlap_b = FindOverlap(entry_b, object_a);
+            if (overlap_a == 0x0 || overlap_b == 0x0)
+                continue;
+            if (overlap_a->m_Count > 0)
+            {
+                if (!overlap_a->m_Entered)
+                {
+                    overlap_a->m_Entered = 1;
+                    overlap_b->m_Entered = 1;
+                    if (data.m_TriggerEnteredCallback != 0x0)
+                        CallTriggerEntered(data.m_TriggerEnteredCallback, data.m_TriggerEnteredUserData, entry_a, entry_b);
+                }
+            }
+            else
+            {
+                if (overlap_a->m_Entered && data.m_TriggerExitedCallback != 0x0)
+                    CallTriggerExited(data.m_TriggerExitedCallback, data.m_TriggerExitedUserData, entry_a, entry_b);
+                RemoveOverlap(entry_a, object_b);
+                RemoveOverlap(entry_b, object_a);
+            }
+        }
+        pairs.SetSize(0);
+    }
 }
@@ -19,6 +19,7 @@
 #include <dlib/hash.h>
 #include <dlib/message.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 template <typename T> class dmArray;
 
@@ -233,12 +234,14 @@ namespace dmPhysics
         float m_ContactImpulseLimit;
         /// Contacts with penetration depths below this limit will not be considered inside a trigger
         float m_TriggerEnterLimit;
-        /// Maximum number of ray casts per frame when using 2D physics
+        /// Initial capacity of the per frame ray cast queue when using 2D physics. The queue grows when needed
         uint32_t m_RayCastLimit2D;
-        /// Maximum number of ray casts per frame when using 3D physics
+        /// Initial capacity of the per frame ray cast queue when using 3D physics. The queue grows when needed
         uint32_t m_RayCastLimit3D;
-        /// Maximum number of overlapping triggers
+        /// Initial number of overlapping triggers tracked per object, more are allocated when needed
         uint32_t m_TriggerOverlapCapacity;
+        /// Worker pool used to perform ray casts in parallel. Zero performs them on the calling thread
+        dmWorkerPool::HWorkerPool m_WorkerPool;
         /// If true, the collision objects will retrieve the position of its game object
         uint8_t m_AllowDynamicTransforms:1;
         uint8_t :7;
@@ -1094,6 +1097,24 @@ namespace dmPhysics
      */
     void RequestRayCast2D(HWorld2D world, const RayCastRequest& request);
 
+    /**
+     * Request a batch of ray casts that will be performed the next time the 3D world is updated
+     *
+     * @param world Physics world in which to perform the ray casts
+     * @param requests Array of requests
+     * @param count Number of requests
+     */
+    void RequestRayCasts3D(HWorld3D world, const RayCastRequest* requests, uint32_t count);
+
+    /**
+     * Request a batch of ray casts that will be performed the next time the 2D world is updated
+     *
+     * @param world Physics world in which to perform the ray casts
+     * @param requests Array of requests
+     * @param count Number of requests
+     */
+    void RequestRayCasts2D(HWorld2D world, const RayCastRequest* requests, uint32_t count);
+
     /**
      * Request a synchronous ray cast
      *
@@ -1114,6 +1135,30 @@ namespace dmPhysics
      */
     void RayCast2D(HWorld2D world, const RayCastRequest& request, dmArray<RayCastResponse>& results);
 
+    /**
+     * Perform a batch of synchronous ray casts, spread over the worker pool of the context.
+     * Only the closest hit of each ray is reported, RayCastRequest::m_ReturnAllResults is ignored.
+     *
+     * @param world Physics world in which to perform the ray casts
+     * @param requests Array of requests
+     * @param responses Array of count responses receiving the closest hit of the corresponding request.
+     * RayCastResponse::m_Hit is zero for rays that did not hit anything and for rays with 0 length
+     * @param count Number of requests
+     */
+    void RayCastBatch3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count);
+
+    /**
+     * Perform a batch of synchronous ray casts, spread over the worker pool of the context.
+     * Only the closest hit of each ray is reported, RayCastRequest::m_ReturnAllResults is ignored.
+     *
+     * @param world Physics world in which to perform the ray casts
+     * @param requests Array of requests
+     * @param responses Array of count responses receiving the closest hit of the corresponding request.
+     * RayCastResponse::m_Hit is zero for rays that did not hit anything and for rays with 0 length
+     * @param count Number of requests
+     */
+    void RayCastBatch2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count);
+
     /**
      * Set the gravity for a 2D physics world.
      *
@@ -38,6 +38,7 @@ namespace dmPhysics
     , m_TriggerEnterLimit(0.0f)
     , m_RayCastLimit(0)
     , m_TriggerOverlapCapacity(0)
+    , m_WorkerPool(0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -48,6 +49,7 @@ namespace dmPhysics
     , m_Context(context)
     , m_World(context->m_Gravity)
     , m_RayCastRequests()
+    , m_RayCastResponses()
     , m_DebugDraw(&context->m_DebugCallbacks)
     , m_ContactListener(this)
     , m_GetWorldTransformCallback(params.m_GetWorldTransformCallback)
@@ -128,12 +130,108 @@ namespace dmPhysics
             return -1.f;
     }
 
+    static inline bool IsZeroLengthRay2D(const RayCastRequest& request)
+    {
+        // We need to remove the z-value before calculating length (DEF-1286)
+        const Vectormath::Aos::Point3 from2d = Vectormath::Aos::Point3(request.m_From.getX(), request.m_From.getY(), 0.0);
+        const Vectormath::Aos::Point3 to2d = Vectormath::Aos::Point3(request.m_To.getX(), request.m_To.getY(), 0.0);
+        return Vectormath::Aos::lengthSqr(to2d - from2d) <= 0.0f;
+    }
+
+    struct RayCastBatchContext2D
+    {
+        HWorld2D                m_World;
+        const RayCastRequest*   m_Requests;
+        RayCastResponse*        m_Responses;
+    };
+
+    // b2World::RayCast only reads the broad-phase and the fixtures, so different rays can be cast concurrently
+    static void RayCastBatchRange2D(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        DM_PROFILE(Physics, "RayCastBatch");
+        RayCastBatchContext2D* ctx = (RayCastBatchContext2D*) _ctx;
+        HWorld2D world = ctx->m_World;
+        float scale = world->m_Context->m_Scale;
+        ProcessRayCastResultCallback2D callback;
+        callback.m_Context = world->m_Context;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const RayCastRequest& request = ctx->m_Requests[i];
+            RayCastResponse& response = ctx->m_Responses[i];
+            if (IsZeroLengthRay2D(request))
+            {
+                response = RayCastResponse();
+                continue;
+            }
+            b2Vec2 from;
+            ToB2(request.m_From, from, scale);
+            b2Vec2 to;
+            ToB2(request.m_To, to, scale);
+            callback.m_IgnoredUserData = request.m_IgnoredUserData;
+            callback.m_CollisionMask = request.m_Mask;
+            callback.m_Response = RayCastResponse();
+            world->m_World.RayCast(&callback, from, to);
+            response = callback.m_Response;
+        }
+    }
+
+    static void RayCastRange2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        RayCastBatchContext2D ctx;
+        ctx.m_World = world;
+        ctx.m_Requests = requests;
+        ctx.m_Responses = responses;
+        dmWorkerPool::ParallelFor(world->m_Context->m_WorkerPool, count, RAY_CAST_BATCH_SIZE, RayCastBatchRange2D, &ctx);
+    }
+
     ContactListener::ContactListener(HWorld2D world)
     : m_World(world)
     {
 
     }
 
+    // Whether the contact is tracked by the trigger overlap cache
+    static bool IsTriggerContact(HContext2D context, b2Contact* contact)
+    {
+        if (!contact->GetFixtureA()->IsSensor() && !contact->GetFixtureB()->IsSensor())
+            return false;
+        float max_distance = 0.0f;
+        b2Manifold* manifold = contact->GetManifold();
+        for (int32 i = 0; i < manifold->pointCount; ++i)
+        {
+            max_distance = dmMath::Max(max_distance, manifold->points[i].distance);
+        }
+        return max_distance >= context->m_TriggerEnterLimit;
+    }
+
+    void ContactListener::BeginContact(b2Contact* contact)
+    {
+        if (IsTriggerContact(m_World->m_Context, contact))
+        {
+            b2Fixture* fixture_a = contact->GetFixtureA();
+            b2Fixture* fixture_b = contact->GetFixtureB();
+            b2Body* body_a = fixture_a->GetBody();
+            b2Body* body_b = fixture_b->GetBody();
+            OverlapCacheAddData add_data;
+            add_data.m_ObjectA = body_a;
+            add_data.m_UserDataA = body_a->GetUserData();
+            add_data.m_ObjectB = body_b;
+            add_data.m_UserDataB = body_b->GetUserData();
+            add_data.m_GroupA = fixture_a->GetFilterData(contact->GetChildIndexA()).categoryBits;
+            add_data.m_GroupB = fixture_b->GetFilterData(contact->GetChildIndexB()).categoryBits;
+            OverlapCacheBeginContact(&m_World->m_TriggerOverlaps, add_data);
+        }
+    }
+
+    // Also called outside of the world step when bodies are disabled or deleted
+    void ContactListener::EndContact(b2Contact* contact)
+    {
+        if (IsTriggerContact(m_World->m_Context, contact))
+        {
+            OverlapCacheEndContact(&m_World->m_TriggerOverlaps, contact->GetFixtureA()->GetBody(), contact->GetFixtureB()->GetBody());
+        }
+    }
+
     void ContactListener::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
     {
         CollisionCallback collision_callback = m_TempStepWorldContext->m_CollisionCallback;
@@ -215,6 +313,7 @@ namespace dmPhysics
         context->m_TriggerEnterLimit = params.m_TriggerEnterLimit * params.m_Scale;
         context->m_RayCastLimit = params.m_RayCastLimit2D;
         context->m_TriggerOverlapCapacity = params.m_TriggerOverlapCapacity;
+        context->m_WorkerPool = params.m_WorkerPool;
         context->m_AllowDynamicTransforms = params.m_AllowDynamicTransforms;
         dmMessage::Result result = dmMessage::NewSocket(PHYSICS_SOCKET_NAME, &context->m_Socket);
         if (result != dmMessage::RESULT_OK)
@@ -267,7 +366,7 @@ namespace dmPhysics
         delete world;
     }
 
-    static void UpdateOverlapCache(OverlapCache* cache, HContext2D context, b2Contact* contact_list, const StepWorldContext& step_context);
+    static void UpdateOverlapCache(OverlapCache* cache, const StepWorldContext& step_context);
 
     static inline b2Vec2 FlipPoint(b2Vec2 p, float horizontal, float vertical)
     {
@@ -462,20 +561,16 @@ namespace dmPhysics
         if (size > 0)
         {
             DM_PROFILE(Physics, "RayCasts");
-            ProcessRayCastResultCallback2D callback;
-            callback.m_Context = world->m_Context;
+            // The rays are cast in parallel, but the responses are reported in request order
+            if (world->m_RayCastResponses.Capacity() < size)
+            {
+                world->m_RayCastResponses.SetCapacity(world->m_RayCastRequests.Capacity());
+            }
+            world->m_RayCastResponses.SetSize(size);
+            RayCastRange2D(world, world->m_RayCastRequests.Begin(), world->m_RayCastResponses.Begin(), size);
             for (uint32_t i = 0; i < size; ++i)
             {
-                RayCastRequest& request = world->m_RayCastRequests[i];
-                b2Vec2 from;
-                ToB2(request.m_From, from, scale);
-                b2Vec2 to;
-                ToB2(request.m_To, to, scale);
-                callback.m_IgnoredUserData = request.m_IgnoredUserData;
-                callback.m_CollisionMask = request.m_Mask;
-                callback.m_Response.m_Hit = 0;
-                world->m_World.RayCast(&callback, from, to);
-                (*step_context.m_RayCastCallback)(callback.m_Response, request, step_context.m_RayCastUserData);
+                (*step_context.m_RayCastCallback)(world->m_RayCastResponses[i], world->m_RayCastRequests[i], step_context.m_RayCastUserData);
             }
             world->m_RayCastRequests.SetSize(0);
         }
@@ -499,50 +594,21 @@ namespace dmPhysics
                 }
             }
         }
-        UpdateOverlapCache(&world->m_TriggerOverlaps, context, world->m_World.GetContactList(), step_context);
+        UpdateOverlapCache(&world->m_TriggerOverlaps, step_context);
 
         world->m_World.DrawDebugData();
     }
 
-    void UpdateOverlapCache(OverlapCache* cache, HContext2D context, b2Contact* contact_list, const StepWorldContext& step_context)
+    // The cache is kept up to date by the contact listener, only the pairs that changed are visited
+    void UpdateOverlapCache(OverlapCache* cache, const StepWorldContext& step_context)
     {
         DM_PROFILE(Physics, "TriggerCallbacks");
-        OverlapCacheReset(cache);
-        OverlapCacheAddData add_data;
-        add_data.m_TriggerEnteredCallback = step_context.m_TriggerEnteredCallback;
-        add_data.m_TriggerEnteredUserData = step_context.m_TriggerEnteredUserData;
-        for (b2Contact* contact = contact_list; contact; contact = contact->GetNext())
-        {
-            b2Fixture* fixture_a = contact->GetFixtureA();
-            b2Fixture* fixture_b = contact->GetFixtureB();
-            if (contact->IsTouching() && (fixture_a->IsSensor() || fixture_b->IsSensor()))
-            {
-                float max_distance = 0.0f;
-                b2Manifold* manifold = contact->GetManifold();
-                for (int32 i = 0; i < manifold->pointCount; ++i)
-                {
-                    max_distance = dmMath::Max(max_distance, manifold->points[i].distance);
-                }
-                if (max_distance >= context->m_TriggerEnterLimit)
-                {
-                    b2Body* body_a = fixture_a->GetBody();
-                    b2Body* body_b = fixture_b->GetBody();
-                    add_data.m_ObjectA = body_a;
-                    add_data.m_UserDataA = body_a->GetUserData();
-                    add_data.m_ObjectB = body_b;
-                    add_data.m_UserDataB = body_b->GetUserData();
-                    int32_t index_a = contact->GetChildIndexA();
-                    int32_t index_b = contact->GetChildIndexB();
-                    add_data.m_GroupA = fixture_a->GetFilterData(index_a).categoryBits;
-                    add_data.m_GroupB = fixture_b->GetFilterData(index_b).categoryBits;
-                    OverlapCacheAdd(cache, add_data);
-                }
-            }
-        }
-        OverlapCachePruneData prune_data;
-        prune_data.m_TriggerExitedCallback = step_context.m_TriggerExitedCallback;
-        prune_data.m_TriggerExitedUserData = step_context.m_TriggerExitedUserData;
-        OverlapCachePrune(cache, prune_data);
+        OverlapCacheFlushData flush_data;
+        flush_data.m_TriggerEnteredCallback = step_context.m_TriggerEnteredCallback;
+        flush_data.m_TriggerEnteredUserData = step_context.m_TriggerEnteredUserData;
+        flush_data.m_TriggerExitedCallback = step_context.m_TriggerExitedCallback;
+        flush_data.m_TriggerExitedUserData = step_context.m_TriggerExitedUserData;
+        OverlapCacheFlush(cache, flush_data);
     }
 
     void SetDrawDebug2D(HWorld2D world, bool draw_debug)
@@ -1124,25 +1190,36 @@ namespace dmPhysics
 
     void RequestRayCast2D(HWorld2D world, const RayCastRequest& request)
     {
-        if (!world->m_RayCastRequests.Full())
+        // Verify that the ray is not 0-length
+        if (IsZeroLengthRay2D(request))
         {
-            // Verify that the ray is not 0-length
-            // We need to remove the z-value before calculating length (DEF-1286)
-            const Vectormath::Aos::Point3 from2d = Vectormath::Aos::Point3(request.m_From.getX(), request.m_From.getY(), 0.0);
-            const Vectormath::Aos::Point3 to2d = Vectormath::Aos::Point3(request.m_To.getX(), request.m_To.getY(), 0.0);
-            if (Vectormath::Aos::lengthSqr(to2d - from2d) <= 0.0f)
-            {
-                dmLogWarning("Ray had 0 length when ray casting, ignoring request.");
-            }
-            else
-            {
-                world->m_RayCastRequests.Push(request);
-            }
+            dmLogWarning("Ray had 0 length when ray casting, ignoring request.");
+            return;
         }
-        else
+        if (world->m_RayCastRequests.Full())
         {
-            dmLogWarning("Ray cast query buffer is full (%d), ignoring request.", world->m_RayCastRequests.Capacity());
+            world->m_RayCastRequests.OffsetCapacity(dmMath::Max(world->m_RayCastRequests.Capacity(), 16U));
         }
+        world->m_RayCastRequests.Push(request);
+    }
+
+    void RequestRayCasts2D(HWorld2D world, const RayCastRequest* requests, uint32_t count)
+    {
+        dmArray<RayCastRequest>& queue = world->m_RayCastRequests;
+        if (queue.Remaining() < count)
+        {
+            queue.SetCapacity(dmMath::Max(queue.Size() + count, queue.Capacity() * 2));
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            RequestRayCast2D(world, requests[i]);
+        }
+    }
+
+    void RayCastBatch2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        DM_PROFILE(Physics, "RayCasts");
+        RayCastRange2D(world, requests, responses, count);
     }
 
     static int Sort_RayCastResponse(const dmPhysics::RayCastResponse* a, const dmPhysics::RayCastResponse* b)
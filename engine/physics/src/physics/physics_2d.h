@@ -27,6 +27,8 @@ namespace dmPhysics
     public:
         ContactListener(HWorld2D world);
 
+        virtual void BeginContact(b2Contact* contact);
+        virtual void EndContact(b2Contact* contact);
         virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse);
 
         void SetStepWorldContext(const StepWorldContext* context);
@@ -45,6 +47,7 @@ namespace dmPhysics
         HContext2D                  m_Context;
         b2World                     m_World;
         dmArray<RayCastRequest>     m_RayCastRequests;
+        dmArray<RayCastResponse>    m_RayCastResponses;
         DebugDraw2D                 m_DebugDraw;
         ContactListener             m_ContactListener;
         GetWorldTransformCallback   m_GetWorldTransformCallback;
@@ -67,6 +70,7 @@ namespace dmPhysics
         float                       m_TriggerEnterLimit;
         int                         m_RayCastLimit;
         int                         m_TriggerOverlapCapacity;
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint8_t                     m_AllowDynamicTransforms:1;
         uint8_t                     :7;
     };
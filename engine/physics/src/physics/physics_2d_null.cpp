@@ -226,6 +226,18 @@ namespace dmPhysics
     {
     }
 
+    void RequestRayCasts2D(HWorld2D world, const RayCastRequest* requests, uint32_t count)
+    {
+    }
+
+    void RayCastBatch2D(HWorld2D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            responses[i] = RayCastResponse();
+        }
+    }
+
     void SetGravity2D(HWorld2D world, const Vectormath::Aos::Vector3& gravity)
     {
     }
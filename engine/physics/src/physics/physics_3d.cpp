@@ -120,6 +120,7 @@ namespace dmPhysics
     , m_TriggerEnterLimit(0.0f)
     , m_RayCastLimit(0)
     , m_TriggerOverlapCapacity(0)
+    , m_WorkerPool(0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -267,6 +268,57 @@ namespace dmPhysics
         void* m_IgnoredUserData;
     };
 
+    struct RayCastBatchContext3D
+    {
+        HWorld3D                m_World;
+        const RayCastRequest*   m_Requests;
+        RayCastResponse*        m_Responses;
+    };
+
+    // rayTest only reads the broad-phase and the collision objects, so different rays can be cast concurrently
+    static void RayCastBatchRange3D(void* _ctx, uint32_t begin, uint32_t end)
+    {
+        DM_PROFILE(Physics, "RayCastBatch");
+        RayCastBatchContext3D* ctx = (RayCastBatchContext3D*) _ctx;
+        HWorld3D world = ctx->m_World;
+        float scale = world->m_Context->m_Scale;
+        float inv_scale = world->m_Context->m_InvScale;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const RayCastRequest& request = ctx->m_Requests[i];
+            RayCastResponse& response = ctx->m_Responses[i];
+            response = RayCastResponse();
+            if (Vectormath::Aos::lengthSqr(request.m_To - request.m_From) <= 0.0f)
+            {
+                continue;
+            }
+            btVector3 from;
+            ToBt(request.m_From, from, scale);
+            btVector3 to;
+            ToBt(request.m_To, to, scale);
+            RayCastResultClosestCallback3D result_callback(from, to, request.m_Mask, request.m_IgnoredUserData);
+            world->m_DynamicsWorld->rayTest(from, to, result_callback);
+            response.m_Hit = result_callback.hasHit() ? 1 : 0;
+            response.m_Fraction = result_callback.m_closestHitFraction;
+            FromBt(result_callback.m_hitPointWorld, response.m_Position, inv_scale);
+            FromBt(result_callback.m_hitNormalWorld, response.m_Normal, 1.0f); // don't scale normal
+            if (result_callback.m_collisionObject != 0x0)
+            {
+                response.m_CollisionObjectUserData = result_callback.m_collisionObject->getUserPointer();
+                response.m_CollisionObjectGroup = result_callback.m_collisionObject->getBroadphaseHandle()->m_collisionFilterGroup;
+            }
+        }
+    }
+
+    static void RayCastRange3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        RayCastBatchContext3D ctx;
+        ctx.m_World = world;
+        ctx.m_Requests = requests;
+        ctx.m_Responses = responses;
+        dmWorkerPool::ParallelFor(world->m_Context->m_WorkerPool, count, RAY_CAST_BATCH_SIZE, RayCastBatchRange3D, &ctx);
+    }
+
     HContext3D NewContext3D(const NewContextParams& params)
     {
         if (params.m_Scale < MIN_SCALE || params.m_Scale > MAX_SCALE)
@@ -283,6 +335,7 @@ namespace dmPhysics
         context->m_TriggerEnterLimit = params.m_TriggerEnterLimit * params.m_Scale;
         context->m_RayCastLimit = params.m_RayCastLimit3D;
         context->m_TriggerOverlapCapacity = params.m_TriggerOverlapCapacity;
+        context->m_WorkerPool = params.m_WorkerPool;
         context->m_AllowDynamicTransforms = params.m_AllowDynamicTransforms;
         dmMessage::Result result = dmMessage::NewSocket(PHYSICS_SOCKET_NAME, &context->m_Socket);
         if (result != dmMessage::RESULT_OK)
@@ -430,33 +483,23 @@ namespace dmPhysics
         if (size > 0)
         {
             DM_PROFILE(Physics, "RayCasts");
-            for (uint32_t i = 0; i < size; ++i)
+            if (step_context.m_RayCastCallback == 0x0)
+            {
+                dmLogWarning("Ray cast requested without any response callback, skipped.");
+            }
+            else
             {
-                const RayCastRequest& request = world->m_RayCastRequests[i];
-                if (step_context.m_RayCastCallback == 0x0)
+                // The rays are cast in parallel, but the responses are reported in request order
+                if (world->m_RayCastResponses.Capacity() < size)
                 {
-                    dmLogWarning("Ray cast requested without any response callback, skipped.");
-                    continue;
+                    world->m_RayCastResponses.SetCapacity(world->m_RayCastRequests.Capacity());
                 }
-                float scale = world->m_Context->m_Scale;
-                btVector3 from;
-                ToBt(request.m_From, from, scale);
-                btVector3 to;
-                ToBt(request.m_To, to, scale);
-                RayCastResultClosestCallback3D result_callback(from, to, request.m_Mask, request.m_IgnoredUserData);
-                world->m_DynamicsWorld->rayTest(from, to, result_callback);
-                RayCastResponse response;
-                response.m_Hit = result_callback.hasHit() ? 1 : 0;
-                response.m_Fraction = result_callback.m_closestHitFraction;
-                float inv_scale = world->m_Context->m_InvScale;
-                FromBt(result_callback.m_hitPointWorld, response.m_Position, inv_scale);
-                FromBt(result_callback.m_hitNormalWorld, response.m_Normal, 1.0f); // don't scale normal
-                if (result_callback.m_collisionObject != 0x0)
+                world->m_RayCastResponses.SetSize(size);
+                RayCastRange3D(world, world->m_RayCastRequests.Begin(), world->m_RayCastResponses.Begin(), size);
+                for (uint32_t i = 0; i < size; ++i)
                 {
-                    response.m_CollisionObjectUserData = result_callback.m_collisionObject->getUserPointer();
-                    response.m_CollisionObjectGroup = result_callback.m_collisionObject->getBroadphaseHandle()->m_collisionFilterGroup;
+                    step_context.m_RayCastCallback(world->m_RayCastResponses[i], world->m_RayCastRequests[i], step_context.m_RayCastUserData);
                 }
-                step_context.m_RayCastCallback(response, request, step_context.m_RayCastUserData);
             }
             world->m_RayCastRequests.SetSize(0);
         }
@@ -1073,22 +1116,36 @@ namespace dmPhysics
 
     void RequestRayCast3D(HWorld3D world, const RayCastRequest& request)
     {
-        if (!world->m_RayCastRequests.Full())
+        // Verify that the ray is not 0-length
+        if (Vectormath::Aos::lengthSqr(request.m_To - request.m_From) <= 0.0f)
         {
-            // Verify that the ray is not 0-length
-            if (Vectormath::Aos::lengthSqr(request.m_To - request.m_From) <= 0.0f)
-            {
-                dmLogWarning("Ray had 0 length when ray casting, ignoring request.");
-            }
-            else
-            {
-                world->m_RayCastRequests.Push(request);
-            }
+            dmLogWarning("Ray had 0 length when ray casting, ignoring request.");
+            return;
         }
-        else
+        if (world->m_RayCastRequests.Full())
         {
-            dmLogWarning("Ray cast query buffer is full (%d), ignoring request.", world->m_RayCastRequests.Capacity());
+            world->m_RayCastRequests.OffsetCapacity(dmMath::Max(world->m_RayCastRequests.Capacity(), 16U));
         }
+        world->m_RayCastRequests.Push(request);
+    }
+
+    void RequestRayCasts3D(HWorld3D world, const RayCastRequest* requests, uint32_t count)
+    {
+        dmArray<RayCastRequest>& queue = world->m_RayCastRequests;
+        if (queue.Remaining() < count)
+        {
+            queue.SetCapacity(dmMath::Max(queue.Size() + count, queue.Capacity() * 2));
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            RequestRayCast3D(world, requests[i]);
+        }
+    }
+
+    void RayCastBatch3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        DM_PROFILE(Physics, "RayCasts");
+        RayCastRange3D(world, requests, responses, count);
     }
 
     static int Sort_RayCastResponse(const dmPhysics::RayCastResponse* a, const dmPhysics::RayCastResponse* b)
@@ -28,6 +28,7 @@ namespace dmPhysics
 
         OverlapCache                            m_TriggerOverlaps;
         dmArray<RayCastRequest>                 m_RayCastRequests;
+        dmArray<RayCastResponse>                m_RayCastResponses;
         DebugDraw3D                             m_DebugDraw;
         HContext3D                              m_Context;
         btDefaultCollisionConfiguration*        m_CollisionConfiguration;
@@ -55,6 +56,7 @@ namespace dmPhysics
         float                       m_TriggerEnterLimit;
         int                         m_RayCastLimit;
         int                         m_TriggerOverlapCapacity;
+        dmWorkerPool::HWorkerPool   m_WorkerPool;
         uint8_t                     m_AllowDynamicTransforms:1;
         uint8_t                     :7;
     };
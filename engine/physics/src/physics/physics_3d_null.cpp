@@ -194,6 +194,18 @@ namespace dmPhysics
     {
     }
 
+    void RequestRayCasts3D(HWorld3D world, const RayCastRequest* requests, uint32_t count)
+    {
+    }
+
+    void RayCastBatch3D(HWorld3D world, const RayCastRequest* requests, RayCastResponse* responses, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            responses[i] = RayCastResponse();
+        }
+    }
+
     void SetGravity3D(HWorld3D world, const Vectormath::Aos::Vector3& gravity)
     {
     }
@@ -13,6 +13,7 @@
 #include "physics.h"
 #include "physics_private.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 namespace dmPhysics
@@ -30,6 +31,7 @@ namespace dmPhysics
     , m_RayCastLimit2D(0)
     , m_RayCastLimit3D(0)
     , m_TriggerOverlapCapacity(0)
+    , m_WorkerPool(0)
     , m_AllowDynamicTransforms(0)
     {
 
@@ -73,6 +75,7 @@ namespace dmPhysics
     , m_IgnoredUserData((void*)~0) // unlikely user data to ignore
     , m_UserData(0x0)
     , m_Mask(~0)
+    , m_ReturnAllResults(0)
     , m_UserId(0)
     {
 
@@ -102,11 +105,22 @@ namespace dmPhysics
 
     OverlapCache::OverlapCache(uint32_t trigger_overlap_capacity)
     : m_OverlapCache()
+    , m_ChangedPairs()
     , m_TriggerOverlapCapacity(trigger_overlap_capacity)
     {
 
     }
 
+    static void FreeOverlaps(void* context, const uintptr_t* key, OverlapEntry* value)
+    {
+        free(value->m_Overlaps);
+    }
+
+    OverlapCache::~OverlapCache()
+    {
+        m_OverlapCache.Iterate(FreeOverlaps, (void*)0x0);
+    }
+
     OverlapCacheAddData::OverlapCacheAddData()
     {
         memset(this, 0, sizeof(*this));
@@ -117,4 +131,9 @@ namespace dmPhysics
         memset(this, 0, sizeof(*this));
     }
 
+    OverlapCacheFlushData::OverlapCacheFlushData()
+    {
+        memset(this, 0, sizeof(*this));
+    }
+
 }
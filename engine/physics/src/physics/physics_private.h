@@ -13,59 +13,76 @@
 #ifndef PHYSICS_PRIVATE_H
 #define PHYSICS_PRIVATE_H
 
-#include <dlib/hashtable.h>
+#include <dlib/array.h>
+#include <dlib/open_hashtable.h>
 
 namespace dmPhysics
 {
     /**
      * Used to track the overlapping of an object.
      * Count defines how many overlap-contacts are known.
+     * Entered is set when the trigger entered callback has been called for the overlap.
      */
     struct Overlap
     {
         void* m_Object;
-        uint32_t m_Count;
+        uint32_t m_Count : 31;
+        uint32_t m_Entered : 1;
     };
 
     /**
      * Initial capacity of the cache.
-     * The cache is a hash table with 75% as many buckets as capacity.
      */
     const uint32_t CACHE_INITIAL_CAPACITY = 128;
 
     /**
-     * Count of elements to expand the cache with when it's 75% full.
+     * Number of rays cast per worker pool job when performing ray casts in parallel.
      */
-    const uint32_t CACHE_EXPANSION = 16;
+    const uint32_t RAY_CAST_BATCH_SIZE = 64;
 
     /**
      * Used to track all overlaps given an object.
+     * The overlap array grows when needed.
      */
     struct OverlapEntry
     {
         void* m_UserData;
         Overlap* m_Overlaps;
         uint32_t m_OverlapCount;
+        uint32_t m_OverlapCapacity;
         uint16_t m_Group;
     };
 
+    /**
+     * Pair of objects whose overlap count has changed since the last flush.
+     */
+    struct OverlapPair
+    {
+        void* m_ObjectA;
+        void* m_ObjectB;
+    };
+
     /**
      * Stores every set of overlaps for each object.
      */
     struct OverlapCache {
     	OverlapCache(uint32_t triggerOverlapCapacity);
+        ~OverlapCache();
+
+    	dmOpenHashTable<uintptr_t, OverlapEntry> m_OverlapCache;
 
-    	dmHashTable<uintptr_t, OverlapEntry> m_OverlapCache;
+        /// Pairs changed by OverlapCacheBeginContact/OverlapCacheEndContact, processed by OverlapCacheFlush
+        dmArray<OverlapPair> m_ChangedPairs;
 
         /**
-         * Max count of tracked overlaps per object.
-         * Exceeding this limit is safe and results in warnings.
+         * Initial count of tracked overlaps per object.
+         * More overlaps are allocated when needed.
          */
     	uint32_t m_TriggerOverlapCapacity;
     };
 
     /**
-     * Initialize the cache with CACHE_INITIAL_CAPACITY and 75% as many buckets.
+     * Initialize the cache with CACHE_INITIAL_CAPACITY.
      */
     void OverlapCacheInit(OverlapCache* cache);
 
@@ -123,6 +140,39 @@ namespace dmPhysics
      * if it is the last known occurrence of overlap.
      */
     void OverlapCachePrune(OverlapCache* cache, const OverlapCachePruneData& data);
+
+    /**
+     * Registers a new contact between two objects, to be used when the physics engine reports when contacts begin and end.
+     * Only the counts are updated, the trigger entered callback is called by OverlapCacheFlush.
+     * The callback members of the data are ignored.
+     */
+    void OverlapCacheBeginContact(OverlapCache* cache, const OverlapCacheAddData& data);
+
+    /**
+     * Unregisters a contact between two objects previously registered by OverlapCacheBeginContact.
+     * Objects removed from the cache are ignored.
+     */
+    void OverlapCacheEndContact(OverlapCache* cache, void* object_a, void* object_b);
+
+    struct OverlapCacheFlushData
+    {
+        OverlapCacheFlushData();
+
+        /// Trigger entered callback
+        TriggerEnteredCallback  m_TriggerEnteredCallback;
+        /// Trigger entered callback user data
+        void*                   m_TriggerEnteredUserData;
+        /// Trigger exited callback
+        TriggerExitedCallback   m_TriggerExitedCallback;
+        /// Trigger exited callback user data
+        void*                   m_TriggerExitedUserData;
+    };
+
+    /**
+     * Calls the trigger entered and exited callbacks for the pairs changed since the last flush.
+     * Only the changed pairs are visited, the cost is independent of the total number of overlaps.
+     */
+    void OverlapCacheFlush(OverlapCache* cache, const OverlapCacheFlushData& data);
 }
 
 #endif // PHYSICS_PRIVATE_H
@@ -15,6 +15,7 @@
 
 #include "test_physics.h"
 #include <dlib/math.h>
+#include <dlib/time.h>
 
 
 using namespace Vectormath::Aos;
@@ -125,6 +126,8 @@ Test3D::Test3D()
 , m_GetMassFunc(dmPhysics::GetMass3D)
 , m_RequestRayCastFunc(dmPhysics::RequestRayCast3D)
 , m_RayCastFunc(dmPhysics::RayCast3D)
+, m_RequestRayCastsFunc(dmPhysics::RequestRayCasts3D)
+, m_RayCastBatchFunc(dmPhysics::RayCastBatch3D)
 , m_SetDebugCallbacksFunc(dmPhysics::SetDebugCallbacks3D)
 , m_ReplaceShapeFunc(dmPhysics::ReplaceShape3D)
 , m_SetGravityFunc(dmPhysics::SetGravity3D)
@@ -182,6 +185,8 @@ Test2D::Test2D()
 , m_GetMassFunc(dmPhysics::GetMass2D)
 , m_RequestRayCastFunc(dmPhysics::RequestRayCast2D)
 , m_RayCastFunc(dmPhysics::RayCast2D)
+, m_RequestRayCastsFunc(dmPhysics::RequestRayCasts2D)
+, m_RayCastBatchFunc(dmPhysics::RayCastBatch2D)
 , m_SetDebugCallbacksFunc(dmPhysics::SetDebugCallbacks2D)
 , m_ReplaceShapeFunc(dmPhysics::ReplaceShape2D)
 , m_SetGravityFunc(dmPhysics::SetGravity2D)
@@ -1282,6 +1287,198 @@ TYPED_TEST(PhysicsTest, FilteredRayCasting)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape_b);
 }
 
+TYPED_TEST(PhysicsTest, RayCastQueueGrows)
+{
+    float box_half_ext = 0.5f;
+    VisualObject vo;
+    dmPhysics::CollisionObjectData data;
+    typename TypeParam::CollisionShapeType shape = (*TestFixture::m_Test.m_NewBoxShapeFunc)(TestFixture::m_Context, Vector3(box_half_ext, box_half_ext, box_half_ext));
+    data.m_Mass = 0.0f;
+    data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_KINEMATIC;
+    data.m_UserData = &vo;
+    typename TypeParam::CollisionObjectType box_co = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+
+    // Well above the ray cast limits of the context, every other ray hits the box
+    const uint32_t count = 500;
+    RayCastResult* result = new RayCastResult[count];
+    memset(result, 0, sizeof(RayCastResult) * count);
+    dmPhysics::RayCastRequest* requests = new dmPhysics::RayCastRequest[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        float x = (i & 1) ? 2.0f : 0.0f;
+        requests[i].m_From = Vectormath::Aos::Point3(x, 1.0f, 0.0f);
+        requests[i].m_To = Vectormath::Aos::Point3(x, 0.0f, 0.0f);
+        requests[i].m_UserId = i;
+        requests[i].m_UserData = result;
+    }
+
+    (*TestFixture::m_Test.m_RequestRayCastsFunc)(TestFixture::m_World, requests, count / 2);
+    for (uint32_t i = count / 2; i < count; ++i)
+    {
+        (*TestFixture::m_Test.m_RequestRayCastFunc)(TestFixture::m_World, requests[i]);
+    }
+
+    TestFixture::m_StepWorldContext.m_RayCastCallback = RayCastCallback;
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ((void*)result, result[i].m_UserData);
+        ASSERT_EQ((i & 1) == 0, (bool)result[i].m_Response.m_Hit);
+        if (result[i].m_Response.m_Hit)
+        {
+            ASSERT_NEAR(0.5f, result[i].m_Response.m_Position.getY(), 0.00001f);
+            ASSERT_EQ((void*)&vo, result[i].m_Response.m_CollisionObjectUserData);
+        }
+    }
+
+    delete [] requests;
+    delete [] result;
+
+    (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, box_co);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
+}
+
+// A grid of static boxes, used by the batched ray cast tests
+template<typename T>
+struct RayCastScene
+{
+    static const uint32_t GRID_SIZE = 30;
+    static const float    SPACING;
+
+    RayCastScene(T& test, typename T::ContextType context, typename T::WorldType world)
+    : m_Test(test)
+    , m_World(world)
+    {
+        m_Shape = (*test.m_NewBoxShapeFunc)(context, Vector3(0.5f, 0.5f, 0.5f));
+        m_VisualObjects = new VisualObject[GRID_SIZE * GRID_SIZE];
+        m_CollisionObjects = new typename T::CollisionObjectType[GRID_SIZE * GRID_SIZE];
+        for (uint32_t i = 0; i < GRID_SIZE * GRID_SIZE; ++i)
+        {
+            m_VisualObjects[i].m_Position = Point3((i % GRID_SIZE) * SPACING, (i / GRID_SIZE) * SPACING, 0.0f);
+            dmPhysics::CollisionObjectData data;
+            data.m_Mass = 0.0f;
+            data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_STATIC;
+            data.m_UserData = &m_VisualObjects[i];
+            m_CollisionObjects[i] = (*test.m_NewCollisionObjectFunc)(world, data, &m_Shape, 1u);
+        }
+    }
+
+    ~RayCastScene()
+    {
+        for (uint32_t i = 0; i < GRID_SIZE * GRID_SIZE; ++i)
+        {
+            (*m_Test.m_DeleteCollisionObjectFunc)(m_World, m_CollisionObjects[i]);
+        }
+        (*m_Test.m_DeleteCollisionShapeFunc)(m_Shape);
+        delete [] m_CollisionObjects;
+        delete [] m_VisualObjects;
+    }
+
+    // Deterministic random number in [0, 1)
+    static float Random(uint32_t* seed)
+    {
+        *seed = *seed * 1664525u + 1013904223u;
+        return (*seed >> 8) / (float) (1 << 24);
+    }
+
+    // Short rays in random directions over the grid, like line of sight checks
+    static void MakeRays(dmPhysics::RayCastRequest* requests, uint32_t count)
+    {
+        uint32_t seed = 1234;
+        const float extent = GRID_SIZE * SPACING;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            float x = extent * Random(&seed);
+            float y = extent * Random(&seed);
+            float angle = 2.0f * (float) M_PI * Random(&seed);
+            float length = 1.0f + 10.0f * Random(&seed);
+            requests[i].m_From = Point3(x, y, 0.0f);
+            requests[i].m_To = Point3(x + cosf(angle) * length, y + sinf(angle) * length, 0.0f);
+            requests[i].m_UserId = i;
+        }
+    }
+
+    T&                                  m_Test;
+    typename T::WorldType               m_World;
+    typename T::CollisionShapeType      m_Shape;
+    VisualObject*                       m_VisualObjects;
+    typename T::CollisionObjectType*    m_CollisionObjects;
+};
+
+template<typename T>
+const float RayCastScene<T>::SPACING = 2.0f;
+
+TYPED_TEST(PhysicsTest, RayCastBatch)
+{
+    RayCastScene<TypeParam> scene(TestFixture::m_Test, TestFixture::m_Context, TestFixture::m_World);
+
+    const uint32_t count = 1000;
+    dmPhysics::RayCastRequest* requests = new dmPhysics::RayCastRequest[count];
+    dmPhysics::RayCastResponse* responses = new dmPhysics::RayCastResponse[count];
+    RayCastScene<TypeParam>::MakeRays(requests, count);
+    // A 0-length ray is reported as a miss
+    requests[count - 1].m_To = requests[count - 1].m_From;
+
+    (*TestFixture::m_Test.m_RayCastBatchFunc)(TestFixture::m_World, requests, responses, count);
+
+    // Compare with one synchronous ray cast at a time
+    dmArray<dmPhysics::RayCastResponse> hits;
+    uint32_t hit_count = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        hits.SetSize(0);
+        (*TestFixture::m_Test.m_RayCastFunc)(TestFixture::m_World, requests[i], hits);
+        ASSERT_EQ(hits.Size(), (uint32_t)responses[i].m_Hit);
+        if (responses[i].m_Hit)
+        {
+            ASSERT_EQ(hits[0].m_Fraction, responses[i].m_Fraction);
+            ASSERT_EQ(hits[0].m_CollisionObjectUserData, responses[i].m_CollisionObjectUserData);
+            ASSERT_NEAR(hits[0].m_Position.getX(), responses[i].m_Position.getX(), 0.00001f);
+            ASSERT_NEAR(hits[0].m_Position.getY(), responses[i].m_Position.getY(), 0.00001f);
+            ++hit_count;
+        }
+    }
+    // Make sure the test covers both hits and misses
+    ASSERT_LT(0u, hit_count);
+    ASSERT_GT(count, hit_count);
+
+    delete [] responses;
+    delete [] requests;
+}
+
+TYPED_TEST(PhysicsTest, RayCastBatchBench)
+{
+    RayCastScene<TypeParam> scene(TestFixture::m_Test, TestFixture::m_Context, TestFixture::m_World);
+
+    const uint32_t count = 20000;
+    dmPhysics::RayCastRequest* requests = new dmPhysics::RayCastRequest[count];
+    dmPhysics::RayCastResponse* responses = new dmPhysics::RayCastResponse[count];
+    RayCastScene<TypeParam>::MakeRays(requests, count);
+
+    dmArray<dmPhysics::RayCastResponse> hits;
+    hits.SetCapacity(1);
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        hits.SetSize(0);
+        (*TestFixture::m_Test.m_RayCastFunc)(TestFixture::m_World, requests[i], hits);
+    }
+    uint64_t single_time = dmTime::GetTime() - start;
+
+    start = dmTime::GetTime();
+    (*TestFixture::m_Test.m_RayCastBatchFunc)(TestFixture::m_World, requests, responses, count);
+    uint64_t batch_time = dmTime::GetTime() - start;
+
+    printf("\n%u rays against %u boxes, %u worker threads:\n", count,
+        RayCastScene<TypeParam>::GRID_SIZE * RayCastScene<TypeParam>::GRID_SIZE, dmWorkerPool::GetWorkerCount(TestFixture::m_WorkerPool));
+    printf("  RayCast:      %8.1f rays/ms\n", count * 1000.0f / single_time);
+    printf("  RayCastBatch: %8.1f rays/ms\n", count * 1000.0f / batch_time);
+
+    delete [] responses;
+    delete [] requests;
+}
+
 TYPED_TEST(PhysicsTest, GravityChange)
 {
     float box_half_ext = 0.5f;
@@ -1962,7 +2159,7 @@ TYPED_TEST(PhysicsTest, TriggerEnterExitDelete)
     (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape_b);
 }
 
-// Verify that there is no overflow when more objects interacts with a trigger than is supported (16).
+// Verify that more objects than the initial overlap capacity (16) can interact with a trigger.
 TYPED_TEST(PhysicsTest, TriggerEnterExitOverflow)
 {
     float radius = 0.5f;
@@ -1984,7 +2181,7 @@ TYPED_TEST(PhysicsTest, TriggerEnterExitOverflow)
     TestFixture::m_StepWorldContext.m_TriggerExitedCallback = TriggerExited;
     TestFixture::m_StepWorldContext.m_TriggerExitedUserData = &ud;
 
-    const uint32_t it_count = 17; // max overlaps is currently set to 16
+    const uint32_t it_count = 40; // initial overlap capacity is currently set to 16
 
     typename TypeParam::CollisionObjectType bodies[it_count];
     typename TypeParam::CollisionShapeType shapes[it_count];
@@ -2009,7 +2206,16 @@ TYPED_TEST(PhysicsTest, TriggerEnterExitOverflow)
 
     (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
 
-    ASSERT_EQ((int32_t)(it_count - 1), ud.m_Count);
+    ASSERT_EQ((int32_t)it_count, ud.m_Count);
+
+    // Move all objects outside, assert exits
+    for (uint32_t i = 0; i < it_count; ++i)
+    {
+        vo[i].m_Position.setX(10.0f + i * 2.0f);
+    }
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+
+    ASSERT_EQ(0, ud.m_Count);
 
     for (uint32_t i = 0; i < it_count; ++i)
     {
@@ -2093,6 +2299,86 @@ TYPED_TEST(PhysicsTest, TriggerEnterExitExpansion)
     }
 }
 
+// Dense field of triggers, each overlapped by a kinematic object. A few objects move in and out of their triggers every frame.
+TYPED_TEST(PhysicsTest, TriggerOverlapBench)
+{
+    const uint32_t grid_size = 20;
+    const uint32_t obj_count = grid_size * grid_size;
+    const uint32_t frame_count = 200;
+    const float spacing = 2.0f;
+
+    typename TypeParam::CollisionShapeType trigger_shape = (*TestFixture::m_Test.m_NewSphereShapeFunc)(TestFixture::m_Context, 0.5f);
+    typename TypeParam::CollisionShapeType shape = (*TestFixture::m_Test.m_NewSphereShapeFunc)(TestFixture::m_Context, 0.4f);
+    typename TypeParam::CollisionObjectType* trigger_bodies = new typename TypeParam::CollisionObjectType[obj_count];
+    typename TypeParam::CollisionObjectType* bodies = new typename TypeParam::CollisionObjectType[obj_count];
+    VisualObject* trigger_vos = new VisualObject[obj_count];
+    VisualObject* vos = new VisualObject[obj_count];
+
+    for (uint32_t i = 0; i < obj_count; ++i)
+    {
+        float x = (i % grid_size) * spacing;
+        float y = (i / grid_size) * spacing;
+        dmPhysics::CollisionObjectData data;
+        data.m_Group = 1;
+        data.m_Mask = 1;
+        data.m_Mass = 0.0f;
+
+        trigger_vos[i].m_Position = Point3(x, y, 0.0f);
+        data.m_UserData = &trigger_vos[i];
+        data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_TRIGGER;
+        trigger_bodies[i] = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &trigger_shape, 1u);
+
+        vos[i].m_Position = Point3(x, y, 0.0f);
+        data.m_UserData = &vos[i];
+        data.m_Type = dmPhysics::COLLISION_OBJECT_TYPE_KINEMATIC;
+        bodies[i] = (*TestFixture::m_Test.m_NewCollisionObjectFunc)(TestFixture::m_World, data, &shape, 1u);
+    }
+
+    TriggerUserData ud = {0, 0, 0};
+    TestFixture::m_StepWorldContext.m_TriggerEnteredCallback = TriggerEntered;
+    TestFixture::m_StepWorldContext.m_TriggerEnteredUserData = &ud;
+    TestFixture::m_StepWorldContext.m_TriggerExitedCallback = TriggerExited;
+    TestFixture::m_StepWorldContext.m_TriggerExitedUserData = &ud;
+
+    (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    ASSERT_EQ((int32_t)obj_count, ud.m_Count);
+
+    uint64_t start = dmTime::GetTime();
+    for (uint32_t frame = 0; frame < frame_count; ++frame)
+    {
+        // Every 16th object moves between its trigger and the empty space next to it
+        for (uint32_t i = frame % 16; i < obj_count; i += 16)
+        {
+            float x = (i % grid_size) * spacing;
+            vos[i].m_Position.setX(vos[i].m_Position.getX() == x ? x + spacing * 0.5f : x);
+        }
+        (*TestFixture::m_Test.m_StepWorldFunc)(TestFixture::m_World, TestFixture::m_StepWorldContext);
+    }
+    uint64_t time = dmTime::GetTime() - start;
+
+    // Only the objects that were moved an odd number of times are outside their triggers
+    int32_t outside = 0;
+    for (uint32_t i = 0; i < obj_count; ++i)
+    {
+        outside += vos[i].m_Position.getX() != (i % grid_size) * spacing;
+    }
+    ASSERT_EQ((int32_t)obj_count - outside, ud.m_Count);
+
+    printf("\n%u triggers, %u frames: %.1f us/frame\n", obj_count, frame_count, time / (float) frame_count);
+
+    for (uint32_t i = 0; i < obj_count; ++i)
+    {
+        (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, bodies[i]);
+        (*TestFixture::m_Test.m_DeleteCollisionObjectFunc)(TestFixture::m_World, trigger_bodies[i]);
+    }
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(shape);
+    (*TestFixture::m_Test.m_DeleteCollisionShapeFunc)(trigger_shape);
+    delete [] vos;
+    delete [] trigger_vos;
+    delete [] bodies;
+    delete [] trigger_bodies;
+}
+
 TYPED_TEST(PhysicsTest, LockedRotation)
 {
     float ground_height_half_ext = 1.0f;
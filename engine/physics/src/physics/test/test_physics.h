@@ -14,6 +14,7 @@
 #define PHYSICS_TEST_PHYSICS_H
 
 #include <stdint.h>
+#include <dlib/worker_pool.h>
 #include "../physics.h"
 #include "../physics_2d.h"
 #include "../physics_3d.h"
@@ -51,6 +52,8 @@ protected:
         context_params.m_RayCastLimit2D = 64;
         context_params.m_RayCastLimit3D = 128;
         context_params.m_TriggerOverlapCapacity = 16;
+        m_WorkerPool = dmWorkerPool::New(3, "physics_test");
+        context_params.m_WorkerPool = m_WorkerPool;
         m_Context = (*m_Test.m_NewContextFunc)(context_params);
         dmPhysics::NewWorldParams world_params;
         world_params.m_GetWorldTransformCallback = GetWorldTransform;
@@ -69,11 +72,13 @@ protected:
     {
         (*m_Test.m_DeleteWorldFunc)(m_Context, m_World);
         (*m_Test.m_DeleteContextFunc)(m_Context);
+        dmWorkerPool::Delete(m_WorkerPool);
     }
 
     typename T::ContextType m_Context;
     typename T::WorldType m_World;
     T m_Test;
+    dmWorkerPool::HWorkerPool m_WorkerPool;
     dmPhysics::StepWorldContext m_StepWorldContext;
     int m_CollisionCount;
     int m_ContactPointCount;
@@ -120,6 +125,8 @@ struct Funcs
     typedef float (*GetMassFunc)(typename T::CollisionObjectType collision_object);
     typedef void (*RequestRayCastFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest& request);
     typedef void (*RayCastFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest& request, dmArray<dmPhysics::RayCastResponse>& results);
+    typedef void (*RequestRayCastsFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest* requests, uint32_t count);
+    typedef void (*RayCastBatchFunc)(typename T::WorldType world, const dmPhysics::RayCastRequest* requests, dmPhysics::RayCastResponse* responses, uint32_t count);
     typedef void (*SetDebugCallbacks)(typename T::ContextType context, const dmPhysics::DebugCallbacks& callbacks);
     typedef void (*ReplaceShapeFunc)(typename T::ContextType context, typename T::CollisionShapeType old_shape, typename T::CollisionShapeType new_shape);
     typedef void (*SetGravityFunc)(typename T::WorldType world, const Vectormath::Aos::Vector3& gravity);
@@ -174,6 +181,8 @@ struct Test3D
     Funcs<Test3D>::GetMassFunc                      m_GetMassFunc;
     Funcs<Test3D>::RequestRayCastFunc               m_RequestRayCastFunc;
     Funcs<Test3D>::RayCastFunc                      m_RayCastFunc;
+    Funcs<Test3D>::RequestRayCastsFunc              m_RequestRayCastsFunc;
+    Funcs<Test3D>::RayCastBatchFunc                 m_RayCastBatchFunc;
     Funcs<Test3D>::SetDebugCallbacks                m_SetDebugCallbacksFunc;
     Funcs<Test3D>::ReplaceShapeFunc                 m_ReplaceShapeFunc;
     Funcs<Test3D>::SetGravityFunc                   m_SetGravityFunc;
@@ -231,6 +240,8 @@ struct Test2D
     Funcs<Test2D>::GetMassFunc                      m_GetMassFunc;
     Funcs<Test2D>::RequestRayCastFunc               m_RequestRayCastFunc;
     Funcs<Test2D>::RayCastFunc                      m_RayCastFunc;
+    Funcs<Test2D>::RequestRayCastsFunc              m_RequestRayCastsFunc;
+    Funcs<Test2D>::RayCastBatchFunc                 m_RayCastBatchFunc;
     Funcs<Test2D>::SetDebugCallbacks                m_SetDebugCallbacksFunc;
     Funcs<Test2D>::ReplaceShapeFunc                 m_ReplaceShapeFunc;
     Funcs<Test2D>::SetGravityFunc                   m_SetGravityFunc;
@@ -113,6 +113,9 @@ namespace dmRender
 
         context->m_Material = 0;
 
+        context->m_StateChangesIssued = 0;
+        context->m_StateChangesElided = 0;
+
         context->m_View = Matrix4::identity();
         context->m_Projection = Matrix4::identity();
         context->m_ViewProj = context->m_Projection * context->m_View;
@@ -135,6 +138,10 @@ namespace dmRender
 
         context->m_StencilBufferCleared = 0;
 
+        context->m_RenderListSortBufferValid = 0;
+        context->m_RenderListSortBufferTagMask = 0;
+        context->m_RenderListSortBufferViewProj = Matrix4::identity();
+
         context->m_RenderListDispatch.SetCapacity(255);
 
         dmMessage::Result r = dmMessage::NewSocket(RENDER_SOCKET_NAME, &context->m_Socket);
@@ -229,17 +236,6 @@ namespace dmRender
         render_context->m_RenderListRanges.SetSize(0);
     }
 
-    struct RenderListSorter
-    {
-        bool operator()(uint32_t a, uint32_t b) const
-        {
-            const RenderListSortValue& u = values[a];
-            const RenderListSortValue& v = values[b];
-            return u.m_SortKey < v.m_SortKey;
-        }
-        RenderListSortValue* values;
-    };
-
     void RenderListEnd(HRenderContext render_context)
     {
         // Unflushed leftovers are assumed to be the debug rendering
@@ -378,6 +374,73 @@ namespace dmRender
         return false;
     }
 
+    // LSD radix sort, 8 bits per pass. All histograms are built up front, so that the passes where
+    // every key has the same byte (e.g. the upper bytes of the tag masks, or the minor order) can be skipped.
+    void RadixSort(uint64_t* keys, uint32_t* values, uint64_t* keys_tmp, uint32_t* values_tmp, uint32_t count)
+    {
+        if (count <= 1)
+            return;
+
+        uint32_t histograms[8][256];
+        memset(histograms, 0, sizeof(histograms));
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint64_t key = keys[i];
+            for (uint32_t pass = 0; pass < 8; ++pass)
+            {
+                histograms[pass][(key >> (pass * 8)) & 0xff]++;
+            }
+        }
+
+        uint64_t* src_keys = keys;
+        uint32_t* src_values = values;
+        uint64_t* dst_keys = keys_tmp;
+        uint32_t* dst_values = values_tmp;
+        for (uint32_t pass = 0; pass < 8; ++pass)
+        {
+            const uint32_t shift = pass * 8;
+            uint32_t* histogram = histograms[pass];
+            if (histogram[(src_keys[0] >> shift) & 0xff] == count)
+                continue;
+
+            uint32_t offset = 0;
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t n = histogram[i];
+                histogram[i] = offset;
+                offset += n;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint64_t key = src_keys[i];
+                uint32_t dst = histogram[(key >> shift) & 0xff]++;
+                dst_keys[dst] = key;
+                dst_values[dst] = src_values[i];
+            }
+
+            uint64_t* tmp_keys = src_keys; src_keys = dst_keys; dst_keys = tmp_keys;
+            uint32_t* tmp_values = src_values; src_values = dst_values; dst_values = tmp_values;
+        }
+
+        if (src_keys != keys)
+        {
+            memcpy(keys, src_keys, sizeof(uint64_t) * count);
+            memcpy(values, src_values, sizeof(uint32_t) * count);
+        }
+    }
+
+    static void PrepareSortScratch(HRenderContext context, uint32_t count)
+    {
+        const uint32_t required_capacity = context->m_RenderListSortIndices.Capacity();
+        context->m_RenderListSortKeys.SetCapacity(required_capacity);
+        context->m_RenderListSortKeys.SetSize(count);
+        context->m_RenderListSortKeysTmp.SetCapacity(required_capacity);
+        context->m_RenderListSortKeysTmp.SetSize(count);
+        context->m_RenderListSortTmp.SetCapacity(required_capacity);
+        context->m_RenderListSortTmp.SetSize(count);
+    }
+
     // Compute new sort values for everything that matches tag_mask
     static void MakeSortBuffer(HRenderContext context, uint32_t tag_mask)
     {
@@ -389,6 +452,8 @@ namespace dmRender
         context->m_RenderListSortBuffer.SetSize(0);
         context->m_RenderListSortValues.SetCapacity(required_capacity);
         context->m_RenderListSortValues.SetSize(context->m_RenderListSortIndices.Size());
+        // The keys are written in the same order as the sort buffer
+        PrepareSortScratch(context, 0);
 
         RenderListSortValue* sort_values = context->m_RenderListSortValues.Begin();
         RenderListEntry* entries = context->m_RenderList.Begin();
@@ -453,6 +518,7 @@ namespace dmRender
                 sort_values[idx].m_BatchKey = entry->m_BatchKey & 0x00ffffff;
                 sort_values[idx].m_Dispatch = entry->m_Dispatch;
                 context->m_RenderListSortBuffer.Push(idx);
+                context->m_RenderListSortKeys.Push(sort_values[idx].m_SortKey);
             }
         }
     }
@@ -501,9 +567,16 @@ namespace dmRender
 
         // First sort on the tag masks
         {
-            RenderListEntrySorter sort;
-            sort.m_Base = context->m_RenderList.Begin();
-            std::stable_sort(context->m_RenderListSortIndices.Begin(), context->m_RenderListSortIndices.End(), sort);
+            RenderListEntry* entries = context->m_RenderList.Begin();
+            uint32_t* indices = context->m_RenderListSortIndices.Begin();
+            uint32_t count = context->m_RenderListSortIndices.Size();
+            PrepareSortScratch(context, count);
+            uint64_t* keys = context->m_RenderListSortKeys.Begin();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                keys[i] = entries[indices[i]].m_TagMask;
+            }
+            RadixSort(keys, indices, context->m_RenderListSortKeysTmp.Begin(), context->m_RenderListSortTmp.Begin(), count);
         }
         // Now find the ranges of tag masks
         {
@@ -527,24 +600,32 @@ namespace dmRender
         if (predicate != 0x0)
             tag_mask = ConvertMaterialTagsToMask(&predicate->m_Tags[0], predicate->m_TagCount);
 
-        // Cleared once per frame
+        // Cleared once per frame (and when entries are submitted in the middle of the frame)
         if (context->m_RenderListRanges.Empty())
         {
             SortRenderList(context);
+            context->m_RenderListSortBufferValid = 0;
         }
 
-        MakeSortBuffer(context, tag_mask);
-
-        if (context->m_RenderListSortBuffer.Empty())
-            return RESULT_OK;
-
+        // Consecutive predicates with the same tags (and view projection) reuse the sorted buffer
+        if (!context->m_RenderListSortBufferValid || context->m_RenderListSortBufferTagMask != tag_mask ||
+            memcmp(&context->m_RenderListSortBufferViewProj, &context->m_ViewProj, sizeof(Matrix4)) != 0)
         {
+            MakeSortBuffer(context, tag_mask);
+
             DM_PROFILE(Render, "DrawRenderList_SORT");
-            RenderListSorter sort;
-            sort.values = context->m_RenderListSortValues.Begin();
-            std::stable_sort(context->m_RenderListSortBuffer.Begin(), context->m_RenderListSortBuffer.End(), sort);
+            uint32_t count = context->m_RenderListSortBuffer.Size();
+            PrepareSortScratch(context, count);
+            RadixSort(context->m_RenderListSortKeys.Begin(), context->m_RenderListSortBuffer.Begin(), context->m_RenderListSortKeysTmp.Begin(), context->m_RenderListSortTmp.Begin(), count);
+
+            context->m_RenderListSortBufferValid = 1;
+            context->m_RenderListSortBufferTagMask = tag_mask;
+            context->m_RenderListSortBufferViewProj = context->m_ViewProj;
         }
 
+        if (context->m_RenderListSortBuffer.Empty())
+            return RESULT_OK;
+
         // Construct render objects
         context->m_RenderObjects.SetSize(0);
 
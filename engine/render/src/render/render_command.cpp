@@ -11,7 +11,9 @@
 // specific language governing permissions and limitations under the License.
 
 #include <stdio.h>
+#include <string.h>
 #include <dlib/log.h>
+#include <dlib/profile.h>
 #include "render_command.h"
 #include "render_private.h"
 
@@ -52,148 +54,324 @@ namespace dmRender
         m_Operands[3] = op3;
     }
 
+    static void ExecuteCommand(dmRender::HRenderContext render_context, dmGraphics::HContext context, Command* c)
+    {
+        switch (c->m_Type)
+        {
+            case COMMAND_TYPE_ENABLE_STATE:
+            {
+                dmGraphics::EnableState(context, (dmGraphics::State)c->m_Operands[0]);
+                break;
+            }
+            case COMMAND_TYPE_DISABLE_STATE:
+            {
+                dmGraphics::DisableState(context, (dmGraphics::State)c->m_Operands[0]);
+                break;
+            }
+            case COMMAND_TYPE_SET_RENDER_TARGET:
+            {
+                dmGraphics::SetRenderTarget(context, (dmGraphics::HRenderTarget)c->m_Operands[0], c->m_Operands[1] );
+                break;
+            }
+            case COMMAND_TYPE_ENABLE_TEXTURE:
+            {
+                render_context->m_Textures[c->m_Operands[0]] = (dmGraphics::HTexture)c->m_Operands[1];
+                break;
+            }
+            case COMMAND_TYPE_DISABLE_TEXTURE:
+            {
+                render_context->m_Textures[c->m_Operands[0]] = 0;
+                break;
+            }
+            case COMMAND_TYPE_CLEAR:
+            {
+                uint8_t r = (c->m_Operands[1] >> 0) & 0xff;
+                uint8_t g = (c->m_Operands[1] >> 8) & 0xff;
+                uint8_t b = (c->m_Operands[1] >> 16) & 0xff;
+                uint8_t a = (c->m_Operands[1] >> 24) & 0xff;
+                union float_to_uint32_t {float f; uint32_t i;};
+                float_to_uint32_t ftoi;
+                ftoi.i = c->m_Operands[2];
+                dmGraphics::Clear(context, c->m_Operands[0], r, g, b, a, ftoi.f, c->m_Operands[3]);
+                render_context->m_StencilBufferCleared = (c->m_Operands[0] & dmGraphics::BUFFER_TYPE_STENCIL_BIT) != 0;
+                break;
+            }
+            case COMMAND_TYPE_SET_VIEWPORT:
+            {
+                dmGraphics::SetViewport(context, c->m_Operands[0], c->m_Operands[1], c->m_Operands[2], c->m_Operands[3]);
+                break;
+            }
+            case COMMAND_TYPE_SET_VIEW:
+            {
+                Vectormath::Aos::Matrix4* matrix = (Vectormath::Aos::Matrix4*)c->m_Operands[0];
+                dmRender::SetViewMatrix(render_context, *matrix);
+                delete matrix;
+                break;
+            }
+            case COMMAND_TYPE_SET_PROJECTION:
+            {
+                Vectormath::Aos::Matrix4* matrix = (Vectormath::Aos::Matrix4*)c->m_Operands[0];
+                dmRender::SetProjectionMatrix(render_context, *matrix);
+                delete matrix;
+                break;
+            }
+            case COMMAND_TYPE_SET_BLEND_FUNC:
+            {
+                dmGraphics::SetBlendFunc(context, (dmGraphics::BlendFactor)c->m_Operands[0], (dmGraphics::BlendFactor)c->m_Operands[1]);
+                break;
+            }
+            case COMMAND_TYPE_SET_COLOR_MASK:
+            {
+                dmGraphics::SetColorMask(context, c->m_Operands[0] != 0, c->m_Operands[1] != 0, c->m_Operands[2] != 0, c->m_Operands[3] != 0);
+                break;
+            }
+            case COMMAND_TYPE_SET_DEPTH_MASK:
+            {
+                dmGraphics::SetDepthMask(context, (bool) c->m_Operands[0]);
+                break;
+            }
+            case COMMAND_TYPE_SET_DEPTH_FUNC:
+            {
+                dmGraphics::SetDepthFunc(context, (dmGraphics::CompareFunc)c->m_Operands[0]);
+                break;
+            }
+            case COMMAND_TYPE_SET_STENCIL_MASK:
+            {
+                dmGraphics::SetStencilMask(context, c->m_Operands[0]);
+                break;
+            }
+            case COMMAND_TYPE_SET_STENCIL_FUNC:
+            {
+                dmGraphics::SetStencilFunc(context, (dmGraphics::CompareFunc)c->m_Operands[0], c->m_Operands[1], c->m_Operands[2]);
+                break;
+            }
+            case COMMAND_TYPE_SET_STENCIL_OP:
+            {
+                dmGraphics::SetStencilOp(context, (dmGraphics::StencilOp)c->m_Operands[0], (dmGraphics::StencilOp)c->m_Operands[1], (dmGraphics::StencilOp)c->m_Operands[2]);
+                break;
+            }
+            case COMMAND_TYPE_SET_CULL_FACE:
+            {
+                dmGraphics::SetCullFace(context, (dmGraphics::FaceType)c->m_Operands[0]);
+                break;
+            }
+            case COMMAND_TYPE_SET_POLYGON_OFFSET:
+            {
+                dmGraphics::SetPolygonOffset(context, (float)c->m_Operands[0], (float)c->m_Operands[1]);
+                break;
+            }
+            case COMMAND_TYPE_DRAW:
+            {
+                dmRender::DrawRenderList(render_context, (dmRender::Predicate*)c->m_Operands[0], (dmRender::HNamedConstantBuffer)c->m_Operands[1]);
+                break;
+            }
+            case COMMAND_TYPE_DRAW_DEBUG3D:
+            {
+                dmRender::DrawDebug3d(render_context);
+                break;
+            }
+            case COMMAND_TYPE_DRAW_DEBUG2D:
+            {
+                dmRender::DrawDebug2d(render_context);
+                break;
+            }
+            case COMMAND_TYPE_ENABLE_MATERIAL:
+            {
+                render_context->m_Material = (HMaterial)c->m_Operands[0];
+                break;
+            }
+            case COMMAND_TYPE_DISABLE_MATERIAL:
+            {
+                render_context->m_Material = 0;
+                break;
+            }
+            default:
+            {
+                dmLogError("No such render command (%d).", c->m_Type);
+            }
+        }
+    }
+
+    // Graphics state set by the render commands that is tracked, one slot per state
+    enum StateSlot
+    {
+        STATE_SLOT_ENABLE_STATE_FIRST   = 0, // One slot per dmGraphics::State
+        STATE_SLOT_ENABLE_STATE_LAST    = dmGraphics::STATE_ALPHA_TEST_SUPPORTED,
+        STATE_SLOT_BLEND_FUNC,
+        STATE_SLOT_COLOR_MASK,
+        STATE_SLOT_DEPTH_MASK,
+        STATE_SLOT_DEPTH_FUNC,
+        STATE_SLOT_STENCIL_MASK,
+        STATE_SLOT_STENCIL_FUNC,
+        STATE_SLOT_STENCIL_OP,
+        STATE_SLOT_CULL_FACE,
+        STATE_SLOT_POLYGON_OFFSET,
+        STATE_SLOT_VIEWPORT,
+        STATE_SLOT_COUNT,
+        STATE_SLOT_NONE = STATE_SLOT_COUNT
+    };
+
+    // Shadow of the graphics state set by the render commands. State commands are deferred until a command
+    // that depends on them (clear, draw etc) and are only sent to the graphics adapter if they differ from
+    // what was last sent. The state is unknown at the start of each ParseCommands since it can be changed
+    // by others between frames.
+    struct CommandState
+    {
+        Command* m_Current[STATE_SLOT_COUNT];
+        Command* m_Pending[STATE_SLOT_COUNT];
+        uint32_t m_CurrentKnown;
+        uint32_t m_PendingMask;
+        uint32_t m_Issued;
+        uint32_t m_Elided;
+    };
+
+    // Render objects may set the blend function, color mask and stencil state while drawing
+    static const uint32_t DRAW_MODIFIED_STATE_MASK = (1 << STATE_SLOT_BLEND_FUNC) | (1 << STATE_SLOT_COLOR_MASK) |
+                                                     (1 << STATE_SLOT_STENCIL_MASK) | (1 << STATE_SLOT_STENCIL_FUNC) | (1 << STATE_SLOT_STENCIL_OP);
+
+    static StateSlot GetStateSlot(const Command* c)
+    {
+        switch (c->m_Type)
+        {
+            case COMMAND_TYPE_ENABLE_STATE:
+            case COMMAND_TYPE_DISABLE_STATE:
+                if (c->m_Operands[0] > (uintptr_t)STATE_SLOT_ENABLE_STATE_LAST)
+                    return STATE_SLOT_NONE;
+                return (StateSlot)(STATE_SLOT_ENABLE_STATE_FIRST + c->m_Operands[0]);
+            case COMMAND_TYPE_SET_BLEND_FUNC:       return STATE_SLOT_BLEND_FUNC;
+            case COMMAND_TYPE_SET_COLOR_MASK:       return STATE_SLOT_COLOR_MASK;
+            case COMMAND_TYPE_SET_DEPTH_MASK:       return STATE_SLOT_DEPTH_MASK;
+            case COMMAND_TYPE_SET_DEPTH_FUNC:       return STATE_SLOT_DEPTH_FUNC;
+            case COMMAND_TYPE_SET_STENCIL_MASK:     return STATE_SLOT_STENCIL_MASK;
+            case COMMAND_TYPE_SET_STENCIL_FUNC:     return STATE_SLOT_STENCIL_FUNC;
+            case COMMAND_TYPE_SET_STENCIL_OP:       return STATE_SLOT_STENCIL_OP;
+            case COMMAND_TYPE_SET_CULL_FACE:        return STATE_SLOT_CULL_FACE;
+            case COMMAND_TYPE_SET_POLYGON_OFFSET:   return STATE_SLOT_POLYGON_OFFSET;
+            case COMMAND_TYPE_SET_VIEWPORT:         return STATE_SLOT_VIEWPORT;
+            default:                                return STATE_SLOT_NONE;
+        }
+    }
+
+    static bool IsStateEqual(const Command* a, const Command* b)
+    {
+        if (a->m_Type != b->m_Type)
+            return false;
+        uint32_t operand_count;
+        switch (a->m_Type)
+        {
+            case COMMAND_TYPE_ENABLE_STATE:
+            case COMMAND_TYPE_DISABLE_STATE:
+            case COMMAND_TYPE_SET_DEPTH_MASK:
+            case COMMAND_TYPE_SET_DEPTH_FUNC:
+            case COMMAND_TYPE_SET_STENCIL_MASK:
+            case COMMAND_TYPE_SET_CULL_FACE:        operand_count = 1; break;
+            case COMMAND_TYPE_SET_BLEND_FUNC:
+            case COMMAND_TYPE_SET_POLYGON_OFFSET:   operand_count = 2; break;
+            case COMMAND_TYPE_SET_STENCIL_FUNC:
+            case COMMAND_TYPE_SET_STENCIL_OP:       operand_count = 3; break;
+            default:                                operand_count = 4; break;
+        }
+        return memcmp(a->m_Operands, b->m_Operands, operand_count * sizeof(uintptr_t)) == 0;
+    }
+
+    // Send the pending state changes that differ from the current state to the graphics adapter
+    static void FlushState(dmRender::HRenderContext render_context, dmGraphics::HContext context, CommandState& state)
+    {
+        for (uint32_t slot = 0; slot < STATE_SLOT_COUNT && state.m_PendingMask >> slot; ++slot)
+        {
+            if ((state.m_PendingMask & (1 << slot)) == 0)
+                continue;
+
+            Command* c = state.m_Pending[slot];
+            if ((state.m_CurrentKnown & (1 << slot)) && IsStateEqual(c, state.m_Current[slot]))
+            {
+                ++state.m_Elided;
+                continue;
+            }
+            ExecuteCommand(render_context, context, c);
+            state.m_Current[slot] = c;
+            state.m_CurrentKnown |= 1 << slot;
+            ++state.m_Issued;
+        }
+        state.m_PendingMask = 0;
+    }
+
+    // The view and projection only affect the render context, skip them if they are unchanged
+    static bool IsMatrixCommandRedundant(dmRender::HRenderContext render_context, const Command* c)
+    {
+        const Vectormath::Aos::Matrix4* matrix = (const Vectormath::Aos::Matrix4*)c->m_Operands[0];
+        const Vectormath::Aos::Matrix4* current = c->m_Type == COMMAND_TYPE_SET_VIEW ? &render_context->m_View : &render_context->m_Projection;
+        return memcmp(matrix, current, sizeof(Vectormath::Aos::Matrix4)) == 0;
+    }
+
     void ParseCommands(dmRender::HRenderContext render_context, Command* commands, uint32_t command_count)
     {
+        DM_PROFILE(Render, "ParseCommands");
         dmGraphics::HContext context = dmRender::GetGraphicsContext(render_context);
 
+        CommandState state;
+        state.m_CurrentKnown = 0;
+        state.m_PendingMask = 0;
+        state.m_Issued = 0;
+        state.m_Elided = 0;
+
         for (uint32_t i=0; i<command_count; i++)
         {
             Command* c = &commands[i];
-            switch (c->m_Type)
+
+            StateSlot slot = GetStateSlot(c);
+            if (slot != STATE_SLOT_NONE)
             {
-                case COMMAND_TYPE_ENABLE_STATE:
-                {
-                    dmGraphics::EnableState(context, (dmGraphics::State)c->m_Operands[0]);
-                    break;
-                }
-                case COMMAND_TYPE_DISABLE_STATE:
+                // Only the last change of a state before it is used is sent
+                if (state.m_PendingMask & (1 << slot))
                 {
-                    dmGraphics::DisableState(context, (dmGraphics::State)c->m_Operands[0]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_RENDER_TARGET:
-                {
-                    dmGraphics::SetRenderTarget(context, (dmGraphics::HRenderTarget)c->m_Operands[0], c->m_Operands[1] );
-                    break;
+                    ++state.m_Elided;
                 }
+                state.m_Pending[slot] = c;
+                state.m_PendingMask |= 1 << slot;
+                continue;
+            }
+
+            switch (c->m_Type)
+            {
+                // Commands that don't touch the graphics adapter
                 case COMMAND_TYPE_ENABLE_TEXTURE:
-                {
-                    render_context->m_Textures[c->m_Operands[0]] = (dmGraphics::HTexture)c->m_Operands[1];
-                    break;
-                }
                 case COMMAND_TYPE_DISABLE_TEXTURE:
-                {
-                    render_context->m_Textures[c->m_Operands[0]] = 0;
-                    break;
-                }
-                case COMMAND_TYPE_CLEAR:
-                {
-                    uint8_t r = (c->m_Operands[1] >> 0) & 0xff;
-                    uint8_t g = (c->m_Operands[1] >> 8) & 0xff;
-                    uint8_t b = (c->m_Operands[1] >> 16) & 0xff;
-                    uint8_t a = (c->m_Operands[1] >> 24) & 0xff;
-                    union float_to_uint32_t {float f; uint32_t i;};
-                    float_to_uint32_t ftoi;
-                    ftoi.i = c->m_Operands[2];
-                    dmGraphics::Clear(context, c->m_Operands[0], r, g, b, a, ftoi.f, c->m_Operands[3]);
-                    render_context->m_StencilBufferCleared = (c->m_Operands[0] & dmGraphics::BUFFER_TYPE_STENCIL_BIT) != 0;
-                    break;
-                }
-                case COMMAND_TYPE_SET_VIEWPORT:
-                {
-                    dmGraphics::SetViewport(context, c->m_Operands[0], c->m_Operands[1], c->m_Operands[2], c->m_Operands[3]);
+                case COMMAND_TYPE_ENABLE_MATERIAL:
+                case COMMAND_TYPE_DISABLE_MATERIAL:
                     break;
-                }
                 case COMMAND_TYPE_SET_VIEW:
-                {
-                    Vectormath::Aos::Matrix4* matrix = (Vectormath::Aos::Matrix4*)c->m_Operands[0];
-                    dmRender::SetViewMatrix(render_context, *matrix);
-                    delete matrix;
-                    break;
-                }
                 case COMMAND_TYPE_SET_PROJECTION:
                 {
-                    Vectormath::Aos::Matrix4* matrix = (Vectormath::Aos::Matrix4*)c->m_Operands[0];
-                    dmRender::SetProjectionMatrix(render_context, *matrix);
-                    delete matrix;
-                    break;
-                }
-                case COMMAND_TYPE_SET_BLEND_FUNC:
-                {
-                    dmGraphics::SetBlendFunc(context, (dmGraphics::BlendFactor)c->m_Operands[0], (dmGraphics::BlendFactor)c->m_Operands[1]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_COLOR_MASK:
-                {
-                    dmGraphics::SetColorMask(context, c->m_Operands[0] != 0, c->m_Operands[1] != 0, c->m_Operands[2] != 0, c->m_Operands[3] != 0);
-                    break;
-                }
-                case COMMAND_TYPE_SET_DEPTH_MASK:
-                {
-                    dmGraphics::SetDepthMask(context, (bool) c->m_Operands[0]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_DEPTH_FUNC:
-                {
-                    dmGraphics::SetDepthFunc(context, (dmGraphics::CompareFunc)c->m_Operands[0]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_STENCIL_MASK:
-                {
-                    dmGraphics::SetStencilMask(context, c->m_Operands[0]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_STENCIL_FUNC:
-                {
-                    dmGraphics::SetStencilFunc(context, (dmGraphics::CompareFunc)c->m_Operands[0], c->m_Operands[1], c->m_Operands[2]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_STENCIL_OP:
-                {
-                    dmGraphics::SetStencilOp(context, (dmGraphics::StencilOp)c->m_Operands[0], (dmGraphics::StencilOp)c->m_Operands[1], (dmGraphics::StencilOp)c->m_Operands[2]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_CULL_FACE:
-                {
-                    dmGraphics::SetCullFace(context, (dmGraphics::FaceType)c->m_Operands[0]);
-                    break;
-                }
-                case COMMAND_TYPE_SET_POLYGON_OFFSET:
-                {
-                    dmGraphics::SetPolygonOffset(context, (float)c->m_Operands[0], (float)c->m_Operands[1]);
-                    break;
-                }
-                case COMMAND_TYPE_DRAW:
-                {
-                    dmRender::DrawRenderList(render_context, (dmRender::Predicate*)c->m_Operands[0], (dmRender::HNamedConstantBuffer)c->m_Operands[1]);
-                    break;
-                }
-                case COMMAND_TYPE_DRAW_DEBUG3D:
-                {
-                    dmRender::DrawDebug3d(render_context);
-                    break;
-                }
-                case COMMAND_TYPE_DRAW_DEBUG2D:
-                {
-                    dmRender::DrawDebug2d(render_context);
-                    break;
-                }
-                case COMMAND_TYPE_ENABLE_MATERIAL:
-                {
-                    render_context->m_Material = (HMaterial)c->m_Operands[0];
-                    break;
-                }
-                case COMMAND_TYPE_DISABLE_MATERIAL:
-                {
-                    render_context->m_Material = 0;
+                    if (IsMatrixCommandRedundant(render_context, c))
+                    {
+                        delete (Vectormath::Aos::Matrix4*)c->m_Operands[0];
+                        ++state.m_Elided;
+                        continue;
+                    }
+                    ++state.m_Issued;
                     break;
                 }
                 default:
-                {
-                    dmLogError("No such render command (%d).", c->m_Type);
-                }
+                    FlushState(render_context, context, state);
+                    break;
+            }
+
+            ExecuteCommand(render_context, context, c);
+
+            if (c->m_Type == COMMAND_TYPE_DRAW || c->m_Type == COMMAND_TYPE_DRAW_DEBUG3D || c->m_Type == COMMAND_TYPE_DRAW_DEBUG2D)
+            {
+                state.m_CurrentKnown &= ~DRAW_MODIFIED_STATE_MASK;
             }
         }
+
+        // The state set at the end of the buffer remains for the next frame and other renderers
+        FlushState(render_context, context, state);
+
+        render_context->m_StateChangesIssued = state.m_Issued;
+        render_context->m_StateChangesElided = state.m_Elided;
+        DM_COUNTER("RenderStateChanges", state.m_Issued);
+        DM_COUNTER("RenderStateChangesElided", state.m_Elided);
     }
 
 }
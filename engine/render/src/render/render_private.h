@@ -217,6 +217,11 @@ namespace dmRender
         dmArray<uint32_t>           m_RenderListSortBuffer;
         dmArray<uint32_t>           m_RenderListSortIndices;
         dmArray<RenderListRange>    m_RenderListRanges;         // Maps tagmask to a range in the (sorted) render list
+        dmArray<uint64_t>           m_RenderListSortKeys;       // Radix sort keys, and scratch buffers
+        dmArray<uint64_t>           m_RenderListSortKeysTmp;
+        dmArray<uint32_t>           m_RenderListSortTmp;
+        Matrix4                     m_RenderListSortBufferViewProj; // The view projection the sort buffer was made with
+        uint32_t                    m_RenderListSortBufferTagMask;
 
         HFontMap                    m_SystemFontMap;
 
@@ -228,10 +233,15 @@ namespace dmRender
 
         HMaterial                   m_Material;
 
+        // Render command state changes sent to the graphics adapter, and dropped as redundant, by the last ParseCommands
+        uint32_t                    m_StateChangesIssued;
+        uint32_t                    m_StateChangesElided;
+
         dmMessage::HSocket          m_Socket;
 
         uint32_t                    m_OutOfResources : 1;
         uint32_t                    m_StencilBufferCleared : 1;
+        uint32_t                    m_RenderListSortBufferValid : 1;
     };
 
     void RenderTypeTextBegin(HRenderContext rendercontext, void* user_context);
@@ -258,6 +268,9 @@ namespace dmRender
         RenderListEntry* m_Base;
     };
 
+    // Stable sort of the keys (and the values along with them). Exposed here for unit testing
+    void RadixSort(uint64_t* keys, uint32_t* values, uint64_t* keys_tmp, uint32_t* values_tmp, uint32_t count);
+
     struct FindRangeComparator
     {
         RenderListEntry* m_Entries;
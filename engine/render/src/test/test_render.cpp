@@ -317,6 +317,74 @@ TEST_F(dmRenderTest, TestRenderListDraw)
     ASSERT_EQ(ctx.m_Z, orders[1]);
 }
 
+struct TestSortReuseDispatchCtx
+{
+    uint32_t m_Drawn[8];
+    uint32_t m_DrawnCount;
+};
+
+static void TestSortReuseDispatch(dmRender::RenderListDispatchParams const & params)
+{
+    TestSortReuseDispatchCtx *ctx = (TestSortReuseDispatchCtx*) params.m_UserData;
+    if (params.m_Operation != dmRender::RENDER_LIST_OPERATION_BATCH)
+        return;
+    for (uint32_t* i = params.m_Begin; i != params.m_End; ++i)
+    {
+        ctx->m_Drawn[ctx->m_DrawnCount++] = *i;
+    }
+}
+
+TEST_F(dmRenderTest, TestRenderListSortReuse)
+{
+    TestSortReuseDispatchCtx ctx;
+    Vectormath::Aos::Matrix4 proj = Vectormath::Aos::Matrix4::orthographic(0.0f, WIDTH, HEIGHT, 0.0f, 0.1f, 1.0f);
+    dmRender::SetViewMatrix(m_Context, Vectormath::Aos::Matrix4::identity());
+    dmRender::SetProjectionMatrix(m_Context, proj);
+
+    dmRender::RenderListBegin(m_Context);
+    uint8_t dispatch = dmRender::RenderListMakeDispatch(m_Context, TestSortReuseDispatch, &ctx);
+
+    const uint32_t n = 8;
+    const float z[n] = { 4, 1, 7, 3, 0, 6, 2, 5 };
+    dmRender::RenderListEntry* out = dmRender::RenderListAlloc(m_Context, n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        dmRender::RenderListEntry& entry = out[i];
+        entry.m_WorldPosition = Point3(0, 0, z[i]);
+        entry.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        entry.m_MinorOrder = 0;
+        entry.m_TagMask = 0;
+        entry.m_Order = 0;
+        entry.m_BatchKey = i; // one batch per entry
+        entry.m_Dispatch = dispatch;
+        entry.m_UserData = 0;
+    }
+    dmRender::RenderListSubmit(m_Context, out, out + n);
+    dmRender::RenderListEnd(m_Context);
+
+    // Same predicate twice, the second draw reuses the sorted buffer
+    for (uint32_t iteration = 0; iteration < 2; ++iteration)
+    {
+        ctx.m_DrawnCount = 0;
+        dmRender::DrawRenderList(m_Context, 0, 0);
+        ASSERT_EQ(n, ctx.m_DrawnCount);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ((float) i, z[ctx.m_Drawn[i]]);
+        }
+    }
+
+    // A new view projection invalidates the sorted buffer
+    dmRender::SetViewMatrix(m_Context, Vectormath::Aos::Matrix4::scale(Vector3(1.0f, 1.0f, -1.0f)));
+    ctx.m_DrawnCount = 0;
+    dmRender::DrawRenderList(m_Context, 0, 0);
+    ASSERT_EQ(n, ctx.m_DrawnCount);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ((float) (n - 1 - i), z[ctx.m_Drawn[i]]);
+    }
+}
+
 struct TestRenderListOrderDispatchCtx
 {
     int m_BeginCalls;
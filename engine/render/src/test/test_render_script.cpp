@@ -22,6 +22,8 @@
 
 #include "render/render_ddf.h"
 
+#include "../../../graphics/src/null/graphics_null_private.h"
+
 using namespace Vectormath::Aos;
 
 namespace
@@ -373,6 +375,79 @@ TEST_F(dmRenderScriptTest, TestLuaState)
     dmRender::DeleteRenderScript(m_Context, render_script);
 }
 
+TEST_F(dmRenderScriptTest, TestRedundantStateElided)
+{
+    const char* script =
+    "function init(self)\n"
+    "    self.test_pred = render.predicate({\"one\"})\n"
+    "    render.enable_state(render.STATE_DEPTH_TEST)\n"
+    "    render.set_depth_mask(false)\n"
+    "    render.set_depth_mask(true)\n"
+    "    render.set_blend_func(render.BLEND_ONE, render.BLEND_ONE)\n"
+    "    render.draw(self.test_pred)\n"
+    "    render.enable_state(render.STATE_DEPTH_TEST)\n"
+    "    render.set_depth_mask(true)\n"
+    "    render.set_blend_func(render.BLEND_ONE, render.BLEND_ONE)\n"
+    "    render.set_view(vmath.matrix4())\n"
+    "    render.draw(self.test_pred)\n"
+    "    render.disable_state(render.STATE_DEPTH_TEST)\n"
+    "end\n";
+    dmRender::HRenderScript render_script = dmRender::NewRenderScript(m_Context, LuaSourceFromString(script));
+    dmRender::HRenderScriptInstance render_script_instance = dmRender::NewRenderScriptInstance(m_Context, render_script);
+
+    ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::InitRenderScriptInstance(render_script_instance));
+
+    dmArray<dmRender::Command>& commands = render_script_instance->m_CommandBuffer;
+    ASSERT_EQ(11u, commands.Size());
+
+    // The overwritten depth mask, the repeated depth test and depth mask, and the unchanged view are dropped.
+    // The blend func is sent again since drawing may change it.
+    dmRender::ParseCommands(m_Context, &commands[0], commands.Size());
+    ASSERT_EQ(5u, m_Context->m_StateChangesIssued);
+    ASSERT_EQ(4u, m_Context->m_StateChangesElided);
+
+    dmRender::DeleteRenderScriptInstance(render_script_instance);
+    dmRender::DeleteRenderScript(m_Context, render_script);
+}
+
+TEST_F(dmRenderScriptTest, TestElidedStateReachesGraphics)
+{
+    const char* script =
+    "function init(self)\n"
+    "    render.set_depth_mask(false)\n"
+    "    render.set_depth_mask(true)\n"
+    "    render.set_color_mask(false, true, true, true)\n"
+    "    render.set_depth_mask(false)\n"
+    "end\n";
+    dmRender::HRenderScript render_script = dmRender::NewRenderScript(m_Context, LuaSourceFromString(script));
+    dmRender::HRenderScriptInstance render_script_instance = dmRender::NewRenderScriptInstance(m_Context, render_script);
+
+    ASSERT_EQ(dmRender::RENDER_SCRIPT_RESULT_OK, dmRender::InitRenderScriptInstance(render_script_instance));
+
+    dmArray<dmRender::Command>& commands = render_script_instance->m_CommandBuffer;
+    ASSERT_EQ(4u, commands.Size());
+
+    // The last depth mask is sent when the commands end, even without a draw
+    dmRender::ParseCommands(m_Context, &commands[0], commands.Size());
+    ASSERT_EQ(2u, m_Context->m_StateChangesIssued);
+    ASSERT_EQ(2u, m_Context->m_StateChangesElided);
+    ASSERT_EQ(0u, m_GraphicsContext->m_DepthMask);
+    ASSERT_EQ(0u, m_GraphicsContext->m_RedMask);
+    ASSERT_EQ(1u, m_GraphicsContext->m_GreenMask);
+
+    // Something else changed the state between the frames, so the same commands must be sent again
+    dmGraphics::SetDepthMask(m_GraphicsContext, true);
+    dmGraphics::SetColorMask(m_GraphicsContext, true, true, true, true);
+    dmRender::ParseCommands(m_Context, &commands[0], commands.Size());
+    ASSERT_EQ(2u, m_Context->m_StateChangesIssued);
+    ASSERT_EQ(2u, m_Context->m_StateChangesElided);
+    ASSERT_EQ(0u, m_GraphicsContext->m_DepthMask);
+    ASSERT_EQ(0u, m_GraphicsContext->m_RedMask);
+
+    dmRender::DeleteRenderScriptInstance(render_script_instance);
+    dmRender::DeleteRenderScript(m_Context, render_script);
+}
+
 TEST_F(dmRenderScriptTest, TestLuaRenderTargetTooLarge)
 {
     const char* script =
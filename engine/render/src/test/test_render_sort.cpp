@@ -0,0 +1,211 @@
+// Copyright 2020 The Defold Foundation
+// Licensed under the Defold License version 1.0 (the "License"); you may not use
+// this file except in compliance with the License.
+//
+// You may obtain a copy of the License, together with FAQs at
+// https://www.defold.com/license
+//
+// Unless required by applicable law or agreed to in writing, software distributed
+// under the License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+// CONDITIONS OF ANY KIND, either express or implied. See the License for the
+// specific language governing permissions and limitations under the License.
+
+#include <stdint.h>
+#include <stdio.h>
+#define JC_TEST_IMPLEMENTATION
+#include <jc_test/jc_test.h>
+#include <dlib/array.h>
+#include <dlib/time.h>
+#include <algorithm> // std::stable_sort
+
+#include "render/render.h"
+#include "render/render_private.h"
+
+struct SortKeyComparator
+{
+    bool operator()(uint32_t a, uint32_t b) const
+    {
+        return m_Keys[a] < m_Keys[b];
+    }
+    const uint64_t* m_Keys;
+};
+
+// Simple xorshift, to get the same sequence on all platforms
+static uint64_t NextRandom(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Keys resembling the render list sort keys: few distinct minor/major orders and dispatches,
+// a spread out order (depth) and some distinct batch keys
+static void MakeRenderKeys(uint64_t* keys, uint32_t count, uint64_t seed)
+{
+    uint64_t state = seed;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint64_t r = NextRandom(state);
+        dmRender::RenderListSortValue value;
+        value.m_SortKey = 0;
+        value.m_BatchKey = (uint32_t) (r & 0x3f);
+        value.m_Dispatch = (uint32_t) ((r >> 8) & 0x3);
+        value.m_Order = (uint32_t) ((r >> 16) & 0xffffff);
+        value.m_MajorOrder = dmRender::RENDER_ORDER_WORLD;
+        value.m_MinorOrder = 0;
+        keys[i] = value.m_SortKey;
+    }
+}
+
+static void VerifyRadixSort(const uint64_t* keys, uint32_t count)
+{
+    dmArray<uint32_t> expected;
+    expected.SetCapacity(count);
+    for (uint32_t i = 0; i < count; ++i)
+        expected.Push(i);
+    SortKeyComparator comp;
+    comp.m_Keys = keys;
+    std::stable_sort(expected.Begin(), expected.End(), comp);
+
+    dmArray<uint64_t> sorted_keys;
+    dmArray<uint64_t> keys_tmp;
+    dmArray<uint32_t> values;
+    dmArray<uint32_t> values_tmp;
+    sorted_keys.SetCapacity(count);
+    sorted_keys.SetSize(count);
+    keys_tmp.SetCapacity(count);
+    keys_tmp.SetSize(count);
+    values.SetCapacity(count);
+    values.SetSize(count);
+    values_tmp.SetCapacity(count);
+    values_tmp.SetSize(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        sorted_keys[i] = keys[i];
+        values[i] = i;
+    }
+
+    dmRender::RadixSort(sorted_keys.Begin(), values.Begin(), keys_tmp.Begin(), values_tmp.Begin(), count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        ASSERT_EQ(expected[i], values[i]);
+        ASSERT_EQ(keys[expected[i]], sorted_keys[i]);
+    }
+}
+
+TEST(RadixSort, Empty)
+{
+    uint64_t key = 1;
+    uint32_t value = 0;
+    dmRender::RadixSort(&key, &value, 0, 0, 0);
+    dmRender::RadixSort(&key, &value, 0, 0, 1);
+    ASSERT_EQ(1u, key);
+    ASSERT_EQ(0u, value);
+}
+
+TEST(RadixSort, Stable)
+{
+    const uint32_t count = 1000;
+    uint64_t keys[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys[i] = i % 5; // Like the tag masks, only a few distinct keys
+    }
+    VerifyRadixSort(keys, count);
+}
+
+TEST(RadixSort, AllBytes)
+{
+    const uint32_t count = 4096;
+    uint64_t keys[count];
+    uint64_t state = 0x9e3779b97f4a7c15ULL;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys[i] = NextRandom(state);
+        if (i & 1)
+            keys[i] = keys[i - 1]; // Duplicates
+    }
+    VerifyRadixSort(keys, count);
+}
+
+TEST(RadixSort, SameKeys)
+{
+    const uint32_t count = 100;
+    uint64_t keys[count];
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys[i] = 0x0123456789abcdefULL;
+    }
+    VerifyRadixSort(keys, count);
+}
+
+TEST(RadixSort, RenderKeys)
+{
+    const uint32_t count = 10000;
+    uint64_t keys[count];
+    MakeRenderKeys(keys, count, 1234);
+    VerifyRadixSort(keys, count);
+}
+
+TEST(RadixSort, Bench)
+{
+    const uint32_t counts[] = {1000, 10000, 50000, 100000, 200000};
+    const uint32_t iterations = 10;
+    const uint32_t max_count = counts[sizeof(counts)/sizeof(counts[0]) - 1];
+
+    dmArray<uint64_t> source;
+    dmArray<uint64_t> keys;
+    dmArray<uint64_t> keys_tmp;
+    dmArray<uint32_t> values;
+    dmArray<uint32_t> values_tmp;
+    source.SetCapacity(max_count);
+    source.SetSize(max_count);
+    keys.SetCapacity(max_count);
+    keys_tmp.SetCapacity(max_count);
+    values.SetCapacity(max_count);
+    values_tmp.SetCapacity(max_count);
+    MakeRenderKeys(source.Begin(), max_count, 5678);
+
+    printf("Render list sort, time per sort\n");
+    for (uint32_t c = 0; c < sizeof(counts)/sizeof(counts[0]); ++c)
+    {
+        uint32_t count = counts[c];
+        keys.SetSize(count);
+        keys_tmp.SetSize(count);
+        values.SetSize(count);
+        values_tmp.SetSize(count);
+
+        uint64_t stable_sort_time = 0;
+        uint64_t radix_sort_time = 0;
+        for (uint32_t it = 0; it < iterations; ++it)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                values[i] = i;
+            SortKeyComparator comp;
+            comp.m_Keys = source.Begin();
+            uint64_t start = dmTime::GetTime();
+            std::stable_sort(values.Begin(), values.End(), comp);
+            stable_sort_time += dmTime::GetTime() - start;
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                keys[i] = source[i];
+                values[i] = i;
+            }
+            start = dmTime::GetTime();
+            dmRender::RadixSort(keys.Begin(), values.Begin(), keys_tmp.Begin(), values_tmp.Begin(), count);
+            radix_sort_time += dmTime::GetTime() - start;
+        }
+
+        printf("  %6u entries: std::stable_sort %f ms, radix sort %f ms\n", count,
+                stable_sort_time / (1000.0f * iterations), radix_sort_time / (1000.0f * iterations));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    jc_test_init(&argc, argv);
+    return jc_test_run_all();
+}
@@ -35,6 +35,8 @@ namespace dmLoadQueue
         dmResource::FResourcePreload m_Function;
         dmResource::PreloadHintInfo m_HintInfo;
         void* m_Context;
+        // The resource may be loaded as a read-only view into a memory mapped archive
+        bool m_BufferViews;
     };
 
     struct LoadResult
@@ -42,11 +44,30 @@ namespace dmLoadQueue
         dmResource::Result m_LoadResult;
         dmResource::Result m_PreloadResult;
         void* m_PreloadData;
+        // The buffer is a read-only view into a memory mapped archive, valid for as long as the archive is mounted
+        bool m_IsBufferView;
     };
 
+    struct LoaderParams
+    {
+        // Number of threads loading requests from all queues
+        uint32_t m_ThreadCount;
+        // Max number of requests in flight per queue
+        uint32_t m_QueueSlots;
+        // Once a queue has this amount of loaded data not picked up, it will stop loading more
+        uint32_t m_MaxPendingData;
+    };
+
+    // The loader is shared between all queues of a factory, and is created/deleted with the factory
+    HLoader NewLoader(dmResource::HFactory factory, const LoaderParams* params);
+    void DeleteLoader(HLoader loader);
+
     HQueue CreateQueue(dmResource::HFactory factory);
     void DeleteQueue(HQueue queue);
 
+    // Requests from queues with higher priority are loaded before any requests with lower priority
+    void SetPriority(HQueue queue, dmResource::LoadPriority priority);
+
     // If the queue does not want to accept any more requests at the moment, it returns 0
     // The name and canonical_path provided must have a lifetime that lasts until EndLoad is called
     HRequest BeginLoad(HQueue queue, const char* name, const char* canonical_path, PreloadInfo* info);
@@ -36,6 +36,20 @@ namespace dmLoadQueue
         Request* m_ActiveRequest;
     };
 
+    struct Loader
+    {
+    };
+
+    HLoader NewLoader(dmResource::HFactory factory, const LoaderParams* params)
+    {
+        return new Loader();
+    }
+
+    void DeleteLoader(HLoader loader)
+    {
+        delete loader;
+    }
+
     HQueue CreateQueue(dmResource::HFactory factory)
     {
         Queue* q           = new Queue();
@@ -49,6 +63,11 @@ namespace dmLoadQueue
         delete queue;
     }
 
+    void SetPriority(HQueue queue, dmResource::LoadPriority priority)
+    {
+        // Only one request is loaded at a time
+    }
+
     HRequest BeginLoad(HQueue queue, const char* name, const char* canonical_path, PreloadInfo* info)
     {
         if (queue->m_ActiveRequest != 0)
@@ -70,7 +89,9 @@ namespace dmLoadQueue
             return RESULT_INVALID_PARAM;
         }
 
-        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size);
+        load_result->m_IsBufferView  = false;
+        load_result->m_LoadResult    = dmResource::LoadResource(queue->m_Factory, request->m_CanonicalPath, request->m_Name, buf, size,
+                                                                request->m_PreloadInfo.m_BufferViews ? &load_result->m_IsBufferView : 0);
         load_result->m_PreloadResult = dmResource::RESULT_PENDING;
         load_result->m_PreloadData   = 0;
 
@@ -17,180 +17,303 @@
 #include <dlib/dstrings.h>
 #include <dlib/log.h>
 #include <dlib/array.h>
+#include <dlib/math.h>
 #include <dlib/thread.h>
 #include <dlib/mutex.h>
 #include <dlib/time.h>
+#include <dlib/profile.h>
 #include <dlib/condition_variable.h>
 
 namespace dmLoadQueue
 {
-    // Implementation of dmLoadQueue with a thread that loads items in the order they are supplied,
+    // Implementation of dmLoadQueue with a pool of threads, shared by all queues of a factory.
+    // Each queue's requests are picked up in the order they are supplied, and the threads serve
+    // the queues with the highest priority first, round-robin between queues of the same priority.
 
     // Default to small buffers since a lot of what is loaded are just small objects anyway.
     // That way we can have more in flight, but throttle when max pending data grows too large anyway
     const uint64_t DEFAULT_CAPACITY = 5 * 1024;
 
-    // Once the loader has this amount not picked up, it will stop loading more.
-    // This sets the bandwidth of the loader.
-    const uint64_t MAX_PENDING_DATA = 4 * 1024 * 1024;
-    const uint32_t QUEUE_SLOTS      = 16;
-
     struct Request
     {
         const char* m_Name;
         const char* m_CanonicalPath;
         dmResource::LoadBufferType m_Buffer;
+        // Set instead of m_Buffer when loaded as a view into a memory mapped archive
+        const void* m_View;
+        uint32_t m_ViewSize;
         PreloadInfo m_PreloadInfo;
         LoadResult m_Result;
     };
 
     struct Queue
     {
-        dmResource::HFactory m_Factory;
-        dmMutex::HMutex m_Mutex;
-        dmConditionVariable::HConditionVariable m_WakeupCond;
-        dmThread::Thread m_Thread;
-        Request m_Request[QUEUE_SLOTS];
-        uint32_t m_Front, m_Back, m_Loaded;
+        struct Loader* m_Loader;
+        Request* m_Request;
+        uint32_t m_Front, m_Back, m_Next;
+        // Number of requests currently being loaded by the loader threads
+        uint32_t m_Loading;
         uint64_t m_BytesWaiting;
-        bool m_Shutdown;
+        dmResource::LoadPriority m_Priority;
 
         // Circular queue with indexing as follow (exclusive end)
         //
-        //          m_Back           m_Loaded   m_Front
-        // [N/A]   [loaded] [loaded] [to-load]  [N/A]
+        //          m_Back                m_Next      m_Front
+        // [N/A]   [loaded] [loading]     [to-load]   [N/A]
         //
     };
 
-    static Request* GetNextRequest(Queue* queue)
+    struct Loader
+    {
+        dmResource::HFactory m_Factory;
+        // Protects the loader and all of its queues
+        dmMutex::HMutex m_Mutex;
+        dmConditionVariable::HConditionVariable m_WakeupCond;
+        // Signalled when a queue has no more requests being loaded
+        dmConditionVariable::HConditionVariable m_IdleCond;
+        dmArray<dmThread::Thread> m_Threads;
+        dmArray<Queue*> m_Queues;
+        uint32_t m_NextQueue;
+        uint32_t m_QueueSlots;
+        // Once a queue has this amount not picked up, it will stop loading more.
+        // This sets the bandwidth of the loader.
+        uint64_t m_MaxPendingData;
+        bool m_Shutdown;
+    };
+
+    static bool HasWork(Loader* loader, Queue* queue)
     {
         // Since we can be loading many things at once, track the total Capacity() for buffers
         // that are waiting to be picked up by the preloader. In the case of the queue being filled
         // with only large requests (say only 4Mb textures), this throttles a bit so memory consumption
         // does not run away.
-        if (queue->m_BytesWaiting >= MAX_PENDING_DATA)
+        return queue->m_Next != queue->m_Front && queue->m_BytesWaiting < loader->m_MaxPendingData;
+    }
+
+    // Assumes m_Mutex is held
+    static Request* GetNextRequest(Loader* loader, Queue** out_queue)
+    {
+        uint32_t queue_count = loader->m_Queues.Size();
+        for (uint32_t priority = 0; priority < dmResource::LOAD_PRIORITY_COUNT; ++priority)
         {
-            return 0x0;
+            for (uint32_t i = 0; i < queue_count; ++i)
+            {
+                uint32_t index = (loader->m_NextQueue + i) % queue_count;
+                Queue* queue = loader->m_Queues[index];
+                if (queue->m_Priority != (dmResource::LoadPriority) priority || !HasWork(loader, queue))
+                {
+                    continue;
+                }
+
+                loader->m_NextQueue = index + 1;
+                queue->m_Loading++;
+                *out_queue = queue;
+                return &queue->m_Request[(queue->m_Next++) % loader->m_QueueSlots];
+            }
         }
+        return 0x0;
+    }
 
-        if (queue->m_Loaded == queue->m_Front)
+    // Assumes m_Mutex is held
+    static void FreeUnusedBuffers(Loader* loader)
+    {
+        // Reset any buffers of inactive requests that are not at default capacity
+        for (uint32_t q = 0; q < loader->m_Queues.Size(); ++q)
         {
-            return 0x0;
+            Queue* queue = loader->m_Queues[q];
+            for (uint32_t i = 0; i < loader->m_QueueSlots; ++i)
+            {
+                Request* r = &queue->m_Request[i];
+                if (r->m_Name == 0x0 && r->m_Buffer.Size() == 0 && r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
+                {
+                    // Just free the memory here, no need to allocate while holding the mutex
+                    r->m_Buffer.SetCapacity(0);
+                }
+            }
         }
-
-        return &queue->m_Request[queue->m_Loaded % QUEUE_SLOTS];
     }
 
     static void LoadThread(void* arg)
     {
-        Queue* queue     = (Queue*)arg;
+        Loader* loader   = (Loader*)arg;
+        Queue* queue     = 0;
         Request* current = 0;
         LoadResult result;
+        // Compressed data is read here, and decompressed into the request buffer
+        dmResource::LoadBufferType scratch;
         while (true)
         {
             {
-                dmMutex::ScopedLock lk(queue->m_Mutex);
+                dmMutex::ScopedLock lk(loader->m_Mutex);
                 if (current != 0)
                 {
-                    // Just finished one (from previous iteratino)
+                    // Just finished one (from previous iteration)
                     queue->m_BytesWaiting += current->m_Buffer.Capacity();
-                    queue->m_Loaded++;
                     current->m_Result = result;
                     current           = 0;
-                }
-                if (queue->m_Shutdown)
-                {
-                    return;
+                    if (--queue->m_Loading == 0)
+                    {
+                        dmConditionVariable::Broadcast(loader->m_IdleCond);
+                    }
                 }
 
-                current = GetNextRequest(queue);
-                if (current == 0x0)
+                while (!loader->m_Shutdown && (current = GetNextRequest(loader, &queue)) == 0x0)
                 {
-                    // Nothing to do, reset any buffers of inactive requests that are not at default capacity
-                    for (uint32_t i = 0; i < QUEUE_SLOTS; ++i)
+                    // Nothing to do
+                    FreeUnusedBuffers(loader);
+                    if (scratch.Capacity() > DEFAULT_CAPACITY)
                     {
-                        Request* r = &queue->m_Request[i];
-                        if (r->m_Buffer.Size() == 0)
-                        {
-                            if (r->m_Buffer.Capacity() > DEFAULT_CAPACITY)
-                            {
-                                // Just free the memory here, no need to allocate while holding the mutex
-                                r->m_Buffer.SetCapacity(0);
-                            }
-                        }
+                        scratch.SetCapacity(0);
                     }
-                    dmConditionVariable::Wait(queue->m_WakeupCond, queue->m_Mutex);
-                    current = GetNextRequest(queue);
+                    dmConditionVariable::Wait(loader->m_WakeupCond, loader->m_Mutex);
+                }
+
+                if (loader->m_Shutdown)
+                {
+                    return;
                 }
             }
 
-            if (current)
-            {
-                // We use the temporary result object here to fill in the data so it can be written with the mutex held.
-                uint32_t size;
+            // We use the temporary result object here to fill in the data so it can be written with the mutex held.
+            uint32_t size;
 
-                assert(current->m_Buffer.Size() == 0);
-                if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+            assert(current->m_Buffer.Size() == 0);
+            if (current->m_Buffer.Capacity() != DEFAULT_CAPACITY)
+            {
+                current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+            }
+            current->m_View        = 0;
+            result.m_LoadResult    = DoLoadResource(loader->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer, &scratch,
+                                                    current->m_PreloadInfo.m_BufferViews ? &current->m_View : 0);
+            result.m_PreloadResult = dmResource::RESULT_PENDING;
+            result.m_PreloadData   = 0;
+            result.m_IsBufferView  = current->m_View != 0;
+
+            if (result.m_LoadResult == dmResource::RESULT_OK)
+            {
+                if (current->m_View)
                 {
-                    current->m_Buffer.SetCapacity(DEFAULT_CAPACITY);
+                    current->m_ViewSize = size;
                 }
-                result.m_LoadResult    = DoLoadResource(queue->m_Factory, current->m_CanonicalPath, current->m_Name, &size, &current->m_Buffer);
-                result.m_PreloadResult = dmResource::RESULT_PENDING;
-                result.m_PreloadData   = 0;
-
-                if (result.m_LoadResult == dmResource::RESULT_OK)
+                else
                 {
                     assert(current->m_Buffer.Size() == size);
-                    if (current->m_PreloadInfo.m_Function)
-                    {
-                        dmResource::ResourcePreloadParams params;
-                        params.m_Factory       = queue->m_Factory;
-                        params.m_Context       = current->m_PreloadInfo.m_Context;
-                        params.m_Buffer        = current->m_Buffer.Begin();
-                        params.m_BufferSize    = current->m_Buffer.Size();
-                        params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
-                        params.m_PreloadData   = &result.m_PreloadData;
-                        result.m_PreloadResult = current->m_PreloadInfo.m_Function(params);
-                    }
-                    else
-                    {
-                        result.m_PreloadResult = dmResource::RESULT_OK;
-                    }
+                }
+                if (current->m_PreloadInfo.m_Function)
+                {
+                    dmResource::ResourcePreloadParams params;
+                    params.m_Factory       = loader->m_Factory;
+                    params.m_Context       = current->m_PreloadInfo.m_Context;
+                    params.m_Buffer        = current->m_View ? current->m_View : current->m_Buffer.Begin();
+                    params.m_BufferSize    = size;
+                    params.m_HintInfo      = &current->m_PreloadInfo.m_HintInfo;
+                    params.m_PreloadData   = &result.m_PreloadData;
+                    result.m_PreloadResult = current->m_PreloadInfo.m_Function(params);
+                }
+                else
+                {
+                    result.m_PreloadResult = dmResource::RESULT_OK;
                 }
             }
         }
     }
 
+    HLoader NewLoader(dmResource::HFactory factory, const LoaderParams* params)
+    {
+        Loader* loader           = new Loader();
+        loader->m_Factory        = factory;
+        loader->m_Mutex          = dmMutex::New();
+        loader->m_WakeupCond     = dmConditionVariable::New();
+        loader->m_IdleCond       = dmConditionVariable::New();
+        loader->m_NextQueue      = 0;
+        loader->m_QueueSlots     = dmMath::Max(1u, params->m_QueueSlots);
+        loader->m_MaxPendingData = params->m_MaxPendingData;
+        loader->m_Shutdown       = false;
+
+        uint32_t thread_count = dmMath::Max(1u, params->m_ThreadCount);
+        loader->m_Threads.SetCapacity(thread_count);
+        for (uint32_t i = 0; i < thread_count; ++i)
+        {
+            loader->m_Threads.Push(dmThread::New(&LoadThread, 65536, loader, "AsyncLoad"));
+        }
+        return loader;
+    }
+
+    void DeleteLoader(HLoader loader)
+    {
+        {
+            dmMutex::ScopedLock lk(loader->m_Mutex);
+            assert(loader->m_Queues.Empty());
+            loader->m_Shutdown = true;
+            // Wake up the workers so they can exit and allow us to join
+            dmConditionVariable::Broadcast(loader->m_WakeupCond);
+        }
+        for (uint32_t i = 0; i < loader->m_Threads.Size(); ++i)
+        {
+            dmThread::Join(loader->m_Threads[i]);
+        }
+        dmConditionVariable::Delete(loader->m_IdleCond);
+        dmConditionVariable::Delete(loader->m_WakeupCond);
+        dmMutex::Delete(loader->m_Mutex);
+        delete loader;
+    }
+
     HQueue CreateQueue(dmResource::HFactory factory)
     {
+        Loader* loader    = dmResource::GetLoader(factory);
         Queue* q          = new Queue();
-        q->m_Factory      = factory;
+        q->m_Loader       = loader;
+        q->m_Request      = new Request[loader->m_QueueSlots];
         q->m_Front        = 0;
         q->m_Back         = 0;
-        q->m_Loaded       = 0;
-        q->m_Shutdown     = false;
+        q->m_Next         = 0;
+        q->m_Loading      = 0;
         q->m_BytesWaiting = 0;
-        q->m_Mutex        = dmMutex::New();
-        q->m_WakeupCond   = dmConditionVariable::New();
-        q->m_Thread       = dmThread::New(&LoadThread, 65536, q, "AsyncLoad");
+        q->m_Priority     = dmResource::LOAD_PRIORITY_NORMAL;
+        for (uint32_t i = 0; i < loader->m_QueueSlots; ++i)
+        {
+            q->m_Request[i].m_Name          = 0x0;
+            q->m_Request[i].m_CanonicalPath = 0x0;
+        }
 
+        dmMutex::ScopedLock lk(loader->m_Mutex);
+        if (loader->m_Queues.Full())
+        {
+            loader->m_Queues.OffsetCapacity(8);
+        }
+        loader->m_Queues.Push(q);
         return q;
     }
 
     void DeleteQueue(HQueue queue)
     {
+        Loader* loader = queue->m_Loader;
         {
-            dmMutex::ScopedLock lk(queue->m_Mutex);
-            queue->m_Shutdown = true;
-            // Wake up the worker so it can exit and allow us to join
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            dmMutex::ScopedLock lk(loader->m_Mutex);
+            for (uint32_t i = 0; i < loader->m_Queues.Size(); ++i)
+            {
+                if (loader->m_Queues[i] == queue)
+                {
+                    loader->m_Queues.EraseSwap(i);
+                    break;
+                }
+            }
+            // Wait for any loads in progress
+            while (queue->m_Loading > 0)
+            {
+                dmConditionVariable::Wait(loader->m_IdleCond, loader->m_Mutex);
+            }
         }
-        dmThread::Join(queue->m_Thread);
-        dmConditionVariable::Delete(queue->m_WakeupCond);
-        dmMutex::Delete(queue->m_Mutex);
+        delete[] queue->m_Request;
         delete queue;
     }
 
+    void SetPriority(HQueue queue, dmResource::LoadPriority priority)
+    {
+        dmMutex::ScopedLock lk(queue->m_Loader->m_Mutex);
+        queue->m_Priority = priority;
+    }
+
     HRequest BeginLoad(HQueue queue, const char* name, const char* canonical_path, PreloadInfo* info)
     {
         assert(name != 0);
@@ -198,36 +321,43 @@ namespace dmLoadQueue
         assert(canonical_path != 0);
         assert(canonical_path[0] != 0);
 
-        dmMutex::ScopedLock lk(queue->m_Mutex);
+        Loader* loader = queue->m_Loader;
+        dmMutex::ScopedLock lk(loader->m_Mutex);
 
         // Refuse more if full.
-        if ((queue->m_Front - queue->m_Back) == QUEUE_SLOTS)
+        if ((queue->m_Front - queue->m_Back) == loader->m_QueueSlots)
             return 0;
 
-        if (queue->m_Loaded == queue->m_Front)
-        {
-            // The worker is sleeping waiting for request, wake it up
-            dmConditionVariable::Signal(queue->m_WakeupCond);
-        }
-
-        Request* req         = &queue->m_Request[(queue->m_Front++) % QUEUE_SLOTS];
+        Request* req         = &queue->m_Request[(queue->m_Front++) % loader->m_QueueSlots];
         req->m_Name          = name;
         req->m_CanonicalPath = canonical_path;
+        req->m_View          = 0;
 
         req->m_PreloadInfo         = *info;
         req->m_Result.m_LoadResult = dmResource::RESULT_PENDING;
 
+        // Wake up a worker, in case they're all sleeping waiting for requests
+        dmConditionVariable::Signal(loader->m_WakeupCond);
+
         return req;
     }
 
     Result EndLoad(HQueue queue, HRequest request, void** buf, uint32_t* size, LoadResult* load_result)
     {
-        dmMutex::ScopedLock lk(queue->m_Mutex);
+        dmMutex::ScopedLock lk(queue->m_Loader->m_Mutex);
         if (request->m_Result.m_LoadResult == dmResource::RESULT_PENDING)
             return RESULT_PENDING;
 
-        *buf         = request->m_Buffer.Begin();
-        *size        = request->m_Buffer.Size();
+        if (request->m_View)
+        {
+            *buf     = (void*) request->m_View;
+            *size    = request->m_ViewSize;
+        }
+        else
+        {
+            *buf     = request->m_Buffer.Begin();
+            *size    = request->m_Buffer.Size();
+        }
         *load_result = request->m_Result;
 
         return RESULT_OK;
@@ -235,28 +365,33 @@ namespace dmLoadQueue
 
     void FreeLoad(HQueue queue, HRequest request)
     {
-        dmMutex::ScopedLock lk(queue->m_Mutex);
+        Loader* loader = queue->m_Loader;
+        dmMutex::ScopedLock lk(loader->m_Mutex);
 
-        uint32_t old_bytes_waiting = queue->m_BytesWaiting;
+        uint64_t old_bytes_waiting = queue->m_BytesWaiting;
 
         // Make sure we don't copy any data if we reallocate the buffer
         request->m_Buffer.SetSize(0);
+        request->m_View = 0;
 
         uint32_t buffer_capacity = request->m_Buffer.Capacity();
         queue->m_BytesWaiting -= buffer_capacity;
-        // If we either have blocked further processing by exceeding MAX_PENDING_DATA or
-        // the buffer has a non-default capacity, we want to wake up the worker
-        if (buffer_capacity != DEFAULT_CAPACITY || (old_bytes_waiting >= MAX_PENDING_DATA && queue->m_BytesWaiting < MAX_PENDING_DATA))
+        if (old_bytes_waiting >= loader->m_MaxPendingData && queue->m_BytesWaiting < loader->m_MaxPendingData)
+        {
+            // Wake up the threads, we can now fit new requests
+            dmConditionVariable::Broadcast(loader->m_WakeupCond);
+        }
+        else if (buffer_capacity != DEFAULT_CAPACITY)
         {
-            // Wake up thread, we can now fit a new request
-            dmConditionVariable::Signal(queue->m_WakeupCond);
+            // Wake up a thread so it can free the buffer
+            dmConditionVariable::Signal(loader->m_WakeupCond);
         }
 
         // Clean up picked up requests
         request->m_Name          = 0x0;
         request->m_CanonicalPath = 0x0;
 
-        while (queue->m_Back != queue->m_Loaded && queue->m_Request[queue->m_Back % QUEUE_SLOTS].m_Name == 0x0)
+        while (queue->m_Back != queue->m_Next && queue->m_Request[queue->m_Back % loader->m_QueueSlots].m_Name == 0x0)
         {
             queue->m_Back++;
         }
@@ -51,6 +51,7 @@
 #include "resource.h"
 #include "resource_ddf.h"
 #include "resource_private.h"
+#include "async/load_queue.h"
 
 /*
  * TODO:
@@ -75,6 +76,10 @@ const int DEFAULT_BUFFER_SIZE = 1024 * 1024;
 #define LIVEUPDATE_BUNDLE_VER_FILENAME "bundle.ver"
 
 const char* MAX_RESOURCES_KEY = "resource.max_resources";
+const char* LOADER_THREADS_KEY = "resource.loader_threads";
+const char* LOADER_QUEUE_SLOTS_KEY = "resource.loader_queue_slots";
+const char* LOADER_MAX_PENDING_KB_KEY = "resource.loader_max_pending_kb";
+const char* PRELOADER_MAX_REQUESTS_KEY = "resource.preloader_max_requests";
 
 struct ResourceReloadedCallbackPair
 {
@@ -127,6 +132,12 @@ struct SResourceFactory
     // Resource manifest
     Manifest*                                    m_Manifest;
     void*                                        m_ArchiveMountInfo;
+
+    // Loader threads shared by all async load queues (preloaders)
+    dmLoadQueue::HLoader                         m_Loader;
+    uint32_t                                     m_PreloaderMaxRequests;
+    // Live preloaders, their profile counters are reported once per frame in UpdateFactory
+    dmArray<HPreloader>                          m_Preloaders;
 };
 
 SResourceType* FindResourceType(SResourceFactory* factory, const char* extension)
@@ -187,6 +198,10 @@ void SetDefaultNewFactoryParams(struct NewFactoryParams* params)
 {
     params->m_MaxResources = 1024;
     params->m_Flags = RESOURCE_FACTORY_FLAGS_EMPTY;
+    params->m_LoaderThreadCount = 1;
+    params->m_LoaderQueueSlots = 16;
+    params->m_LoaderMaxPendingData = 4 * 1024 * 1024;
+    params->m_PreloaderMaxRequests = 8192;
 
     params->m_ArchiveManifest.m_Data = 0;
     params->m_ArchiveManifest.m_Size = 0;
@@ -835,11 +850,23 @@ HFactory NewFactory(NewFactoryParams* params, const char* uri)
     }
 
     factory->m_LoadMutex = dmMutex::New();
+
+    dmLoadQueue::LoaderParams loader_params;
+    loader_params.m_ThreadCount = params->m_LoaderThreadCount;
+    loader_params.m_QueueSlots = params->m_LoaderQueueSlots;
+    loader_params.m_MaxPendingData = params->m_LoaderMaxPendingData;
+    factory->m_Loader = dmLoadQueue::NewLoader(factory, &loader_params);
+    factory->m_PreloaderMaxRequests = params->m_PreloaderMaxRequests;
     return factory;
 }
 
 void DeleteFactory(HFactory factory)
 {
+    if (factory->m_Loader)
+    {
+        dmLoadQueue::DeleteLoader(factory->m_Loader);
+        factory->m_Loader = 0;
+    }
     if (factory->m_Socket)
     {
         dmMessage::DeleteSocket(factory->m_Socket);
@@ -929,6 +956,11 @@ static void Dispatch(dmMessage::Message* message, void* user_ptr)
 void UpdateFactory(HFactory factory)
 {
     dmMessage::Dispatch(factory->m_Socket, &Dispatch, factory);
+
+    for (uint32_t i = 0; i < factory->m_Preloaders.Size(); ++i)
+    {
+        ReportPreloaderCounters(factory->m_Preloaders[i]);
+    }
 }
 
 Result RegisterType(HFactory factory,
@@ -968,6 +1000,15 @@ Result RegisterType(HFactory factory,
     return RESULT_OK;
 }
 
+Result SetTypeBufferViews(HFactory factory, const char* extension, bool enable)
+{
+    SResourceType* resource_type = FindResourceType(factory, extension);
+    if (resource_type == 0)
+        return RESULT_UNKNOWN_RESOURCE_TYPE;
+    resource_type->m_BufferViews = enable;
+    return RESULT_OK;
+}
+
 // Finds the specific entry in a sorted list of entries
 static int FindEntryIndex(const Manifest* manifest, dmhash_t path_hash)
 {
@@ -1025,7 +1066,7 @@ Result VerifyResourcesBundled(HFactory factory, Manifest* manifest)
     return VerifyResourcesBundled(entries, entry_count, factory->m_Manifest->m_ArchiveIndex);
 }
 
-static Result LoadFromManifest(const Manifest* manifest, const char* path, uint32_t* resource_size, LoadBufferType* buffer)
+static Result FindManifestEntry(const Manifest* manifest, const char* path, dmResourceArchive::EntryData* entry_data)
 {
     dmhash_t path_hash = dmHashString64(path);
 
@@ -1035,26 +1076,9 @@ static Result LoadFromManifest(const Manifest* manifest, const char* path, uint3
     }
 
     dmLiveUpdateDDF::ResourceEntry* entries = manifest->m_DDFData->m_Resources.m_Data;
-    dmResourceArchive::EntryData ed;
-    dmResourceArchive::Result res = dmResourceArchive::FindEntry(manifest->m_ArchiveIndex, entries[index].m_Hash.m_Data.m_Data, &ed);
+    dmResourceArchive::Result res = dmResourceArchive::FindEntry(manifest->m_ArchiveIndex, entries[index].m_Hash.m_Data.m_Data, entry_data);
     if (res == dmResourceArchive::RESULT_OK)
     {
-        uint32_t file_size = ed.m_ResourceSize;
-        if (buffer->Capacity() < file_size)
-        {
-            buffer->SetCapacity(file_size);
-        }
-
-        buffer->SetSize(0);
-        dmResourceArchive::Result read_result = dmResourceArchive::Read(manifest->m_ArchiveIndex, &ed, buffer->Begin());
-        if (read_result != dmResourceArchive::RESULT_OK)
-        {
-            return RESULT_IO_ERROR;
-        }
-
-        buffer->SetSize(file_size);
-        *resource_size = file_size;
-
         return RESULT_OK;
     }
     else if (res == dmResourceArchive::RESULT_NOT_FOUND)
@@ -1066,13 +1090,82 @@ static Result LoadFromManifest(const Manifest* manifest, const char* path, uint3
     return RESULT_IO_ERROR;
 }
 
+// If view is set and the resource is stored uncompressed in a memory mapped archive, the data isn't copied to the buffer
+static Result LoadFromManifest(const Manifest* manifest, const char* path, uint32_t* resource_size, LoadBufferType* buffer, const void** view)
+{
+    dmResourceArchive::EntryData ed;
+    Result r = FindManifestEntry(manifest, path, &ed);
+    if (r != RESULT_OK)
+    {
+        return r;
+    }
+
+    uint32_t file_size = ed.m_ResourceSize;
+    if (view && (*view = dmResourceArchive::GetView(manifest->m_ArchiveIndex, &ed)) != 0)
+    {
+        *resource_size = file_size;
+        return RESULT_OK;
+    }
+
+    if (buffer->Capacity() < file_size)
+    {
+        buffer->SetCapacity(file_size);
+    }
+
+    buffer->SetSize(0);
+    dmResourceArchive::Result read_result = dmResourceArchive::Read(manifest->m_ArchiveIndex, &ed, buffer->Begin());
+    if (read_result != dmResourceArchive::RESULT_OK)
+    {
+        return RESULT_IO_ERROR;
+    }
+
+    buffer->SetSize(file_size);
+    *resource_size = file_size;
+
+    return RESULT_OK;
+}
+
+// Load over local file system. Doesn't touch the factory, so no need to hold m_LoadMutex
+static Result LoadFromFile(const char* factory_path, uint32_t* resource_size, LoadBufferType* buffer)
+{
+    uint32_t file_size;
+    dmSys::Result r = dmSys::ResourceSize(factory_path, &file_size);
+    if (r != dmSys::RESULT_OK) {
+        if (r == dmSys::RESULT_NOENT)
+            return RESULT_RESOURCE_NOT_FOUND;
+        else
+            return RESULT_IO_ERROR;
+    }
+
+    if (buffer->Capacity() < file_size) {
+        buffer->SetCapacity(file_size);
+    }
+    buffer->SetSize(0);
+
+    r = dmSys::LoadResource(factory_path, buffer->Begin(), file_size, &file_size);
+    if (r == dmSys::RESULT_OK) {
+        buffer->SetSize(file_size);
+        *resource_size = file_size;
+        return RESULT_OK;
+    } else {
+        if (r == dmSys::RESULT_NOENT)
+            return RESULT_RESOURCE_NOT_FOUND;
+        else
+            return RESULT_IO_ERROR;
+    }
+}
+
 // Assumes m_LoadMutex is already held
-static Result DoLoadResourceLocked(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
+static Result DoLoadResourceLocked(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, const void** view)
 {
     DM_PROFILE(Resource, "LoadResource");
+    if (view)
+    {
+        *view = 0;
+    }
     if (factory->m_BuiltinsManifest)
     {
-        if (LoadFromManifest(factory->m_BuiltinsManifest, original_name, resource_size, buffer) == RESULT_OK)
+        if (LoadFromManifest(factory->m_BuiltinsManifest, original_name, resource_size, buffer, view) == RESULT_OK)
         {
             return RESULT_OK;
         }
@@ -1126,60 +1219,127 @@ static Result DoLoadResourceLocked(HFactory factory, const char* path, const cha
     }
     else if (factory->m_Manifest)
     {
-        Result r = LoadFromManifest(factory->m_Manifest, original_name, resource_size, buffer);
+        Result r = LoadFromManifest(factory->m_Manifest, original_name, resource_size, buffer, view);
         return r;
     }
     else
     {
-        // Load over local file system
-        uint32_t file_size;
-        dmSys::Result r = dmSys::ResourceSize(factory_path, &file_size);
-        if (r != dmSys::RESULT_OK) {
-            if (r == dmSys::RESULT_NOENT)
-                return RESULT_RESOURCE_NOT_FOUND;
-            else
-                return RESULT_IO_ERROR;
+        return LoadFromFile(factory_path, resource_size, buffer);
+    }
+}
+
+// Takes the lock.
+Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, LoadBufferType* scratch, const void** view)
+{
+    // Called from async queue (possibly from several loader threads) so we wrap around a lock.
+    // Resources in an archive are only read while holding the lock, the decryption and
+    // decompression is done after releasing it so that loader threads can decode concurrently.
+    // Loads from the local file system don't need the lock at all.
+    dmResourceArchive::EntryData ed;
+    void* raw_buffer = 0;
+    char factory_path[RESOURCE_PATH_MAX];
+    factory_path[0] = 0;
+    if (view)
+    {
+        *view = 0;
+    }
+    {
+        dmMutex::ScopedLock lk(factory->m_LoadMutex);
+
+        const Manifest* manifest = 0;
+        if (factory->m_BuiltinsManifest && FindManifestEntry(factory->m_BuiltinsManifest, original_name, &ed) == RESULT_OK)
+        {
+            manifest = factory->m_BuiltinsManifest;
+        }
+        else if (!factory->m_HttpClient && factory->m_Manifest)
+        {
+            Result r = FindManifestEntry(factory->m_Manifest, original_name, &ed);
+            if (r != RESULT_OK)
+            {
+                return r;
+            }
+            manifest = factory->m_Manifest;
         }
 
-        if (buffer->Capacity() < file_size) {
-            buffer->SetCapacity(file_size);
+        if (!scratch || (!manifest && factory->m_HttpClient))
+        {
+            return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer, view);
         }
-        buffer->SetSize(0);
 
-        r = dmSys::LoadResource(factory_path, buffer->Begin(), file_size, &file_size);
-        if (r == dmSys::RESULT_OK) {
-            buffer->SetSize(file_size);
-            *resource_size = file_size;
-            return RESULT_OK;
-        } else {
-            if (r == dmSys::RESULT_NOENT)
-                return RESULT_RESOURCE_NOT_FOUND;
-            else
+        if (view && manifest)
+        {
+            *view = dmResourceArchive::GetView(manifest->m_ArchiveIndex, &ed);
+            if (*view)
+            {
+                *resource_size = ed.m_ResourceSize;
+                return RESULT_OK;
+            }
+        }
+
+        if (manifest)
+        {
+            DM_PROFILE(Resource, "LoadResourceRaw");
+            if (buffer->Capacity() < ed.m_ResourceSize)
+            {
+                buffer->SetCapacity(ed.m_ResourceSize);
+            }
+            buffer->SetSize(0);
+
+            // Uncompressed data is decrypted in place
+            raw_buffer = buffer->Begin();
+            if (ed.m_ResourceCompressedSize != 0xFFFFFFFF)
+            {
+                uint32_t stored_size = dmResourceArchive::GetStoredSize(&ed);
+                if (scratch->Capacity() < stored_size)
+                {
+                    scratch->SetCapacity(stored_size);
+                }
+                scratch->SetSize(stored_size);
+                raw_buffer = scratch->Begin();
+            }
+
+            if (dmResourceArchive::ReadRaw(manifest->m_ArchiveIndex, &ed, raw_buffer) != dmResourceArchive::RESULT_OK)
+            {
                 return RESULT_IO_ERROR;
+            }
+        }
+        else
+        {
+            GetCanonicalPathFromBase(factory->m_UriParts.m_Path, path, factory_path);
         }
     }
-}
 
-// Takes the lock.
-Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer)
-{
-    // Called from async queue so we wrap around a lock
-    dmMutex::ScopedLock lk(factory->m_LoadMutex);
-    return DoLoadResourceLocked(factory, path, original_name, resource_size, buffer);
+    if (!raw_buffer)
+    {
+        DM_PROFILE(Resource, "LoadResource");
+        return LoadFromFile(factory_path, resource_size, buffer);
+    }
+
+    DM_PROFILE(Resource, "DecodeResource");
+    if (dmResourceArchive::DecodeRaw(&ed, raw_buffer, buffer->Begin()) != dmResourceArchive::RESULT_OK)
+    {
+        return RESULT_IO_ERROR;
+    }
+    buffer->SetSize(ed.m_ResourceSize);
+    *resource_size = ed.m_ResourceSize;
+    return RESULT_OK;
 }
 
 // Assumes m_LoadMutex is already held
-Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size)
+Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size, bool* is_view)
 {
     if (factory->m_Buffer.Capacity() != DEFAULT_BUFFER_SIZE) {
         factory->m_Buffer.SetCapacity(DEFAULT_BUFFER_SIZE);
     }
     factory->m_Buffer.SetSize(0);
-    Result r = DoLoadResourceLocked(factory, path, original_name, resource_size, &factory->m_Buffer);
+    const void* view = 0;
+    Result r = DoLoadResourceLocked(factory, path, original_name, resource_size, &factory->m_Buffer, is_view ? &view : 0);
     if (r == RESULT_OK)
-        *buffer = factory->m_Buffer.Begin();
+        *buffer = view ? (void*) view : factory->m_Buffer.Begin();
     else
         *buffer = 0;
+    if (is_view)
+        *is_view = view != 0;
     return r;
 }
 
@@ -1244,7 +1404,8 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
 
         void *buffer;
         uint32_t file_size;
-        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+        bool is_view;
+        Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, resource_type->m_BufferViews ? &is_view : 0);
         if (result != RESULT_OK) {
             if (result == RESULT_RESOURCE_NOT_FOUND) {
                 dmLogWarning("Resource not found: %s", name);
@@ -1252,7 +1413,7 @@ static Result DoGet(HFactory factory, const char* name, void** resource)
             return result;
         }
 
-        assert(buffer == factory->m_Buffer.Begin());
+        assert(resource_type->m_BufferViews || buffer == factory->m_Buffer.Begin());
 
         // TODO: We should *NOT* allocate SResource dynamically...
         SResourceDescriptor tmp_resource;
@@ -1444,7 +1605,7 @@ Result GetRaw(HFactory factory, const char* name, void** resource, uint32_t* res
 
     void* buffer;
     uint32_t file_size;
-    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, 0);
     if (result == RESULT_OK) {
         *resource = malloc(file_size);
         assert(buffer == factory->m_Buffer.Begin());
@@ -1475,7 +1636,7 @@ static Result DoReloadResource(HFactory factory, const char* name, SResourceDesc
 
     void* buffer;
     uint32_t file_size;
-    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size);
+    Result result = LoadResource(factory, canonical_path, name, &buffer, &file_size, 0);
     if (result != RESULT_OK)
         return result;
 
@@ -1880,6 +2041,37 @@ Result GetPath(HFactory factory, const void* resource, uint64_t* hash)
     return RESULT_RESOURCE_NOT_FOUND;
 }
 
+dmLoadQueue::HLoader GetLoader(HFactory factory)
+{
+    return factory->m_Loader;
+}
+
+uint32_t GetPreloaderMaxRequests(HFactory factory)
+{
+    return factory->m_PreloaderMaxRequests;
+}
+
+void RegisterPreloader(HFactory factory, HPreloader preloader)
+{
+    if (factory->m_Preloaders.Full())
+    {
+        factory->m_Preloaders.OffsetCapacity(4);
+    }
+    factory->m_Preloaders.Push(preloader);
+}
+
+void UnregisterPreloader(HFactory factory, HPreloader preloader)
+{
+    for (uint32_t i = 0; i < factory->m_Preloaders.Size(); ++i)
+    {
+        if (factory->m_Preloaders[i] == preloader)
+        {
+            factory->m_Preloaders.EraseSwap(i);
+            return;
+        }
+    }
+}
+
 dmMutex::HMutex GetLoadMutex(const dmResource::HFactory factory)
 {
     return factory->m_LoadMutex;
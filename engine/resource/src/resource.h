@@ -33,6 +33,26 @@ namespace dmResource
      */
     extern const char* MAX_RESOURCES_KEY;
 
+    /**
+     * Configuration key used to set the number of resource loader threads.
+     */
+    extern const char* LOADER_THREADS_KEY;
+
+    /**
+     * Configuration key used to set the number of in-flight loads per preloader.
+     */
+    extern const char* LOADER_QUEUE_SLOTS_KEY;
+
+    /**
+     * Configuration key used to limit the amount of loaded data (in kilobytes) waiting to be created per preloader.
+     */
+    extern const char* LOADER_MAX_PENDING_KB_KEY;
+
+    /**
+     * Configuration key used to limit the number of resources in a preloader's dependency tree.
+     */
+    extern const char* PRELOADER_MAX_REQUESTS_KEY;
+
     /**
      * Empty flags
      */
@@ -349,7 +369,19 @@ namespace dmResource
         EmbeddedResource m_ArchiveData;
         EmbeddedResource m_ArchiveManifest;
 
-        uint32_t m_Reserved[5];
+        /// Number of threads loading resources for the preloaders. Default is 1
+        uint32_t m_LoaderThreadCount;
+
+        /// Maximum number of in-flight loads per preloader. Default is 16
+        uint32_t m_LoaderQueueSlots;
+
+        /// Maximum amount of loaded data (bytes) waiting to be created, per preloader. Default is 4MB
+        uint32_t m_LoaderMaxPendingData;
+
+        /// Maximum number of resources in a preloader's dependency tree. Resources beyond this are loaded synchronously. Default is 8192
+        uint32_t m_PreloaderMaxRequests;
+
+        uint32_t m_Reserved[1];
 
         NewFactoryParams()
         {
@@ -398,6 +430,18 @@ namespace dmResource
                                FResourceDestroy destroy_function,
                                FResourceRecreate recreate_function);
 
+    /**
+     * Let a resource type be loaded as read-only views into memory mapped archives. Resources stored
+     * uncompressed and unencrypted are then passed to the preload and create functions as a pointer
+     * straight into the archive instead of a copy. The buffer must not be modified, and as with a
+     * copied buffer it must not be referenced after the functions return.
+     * @param factory Factory handle
+     * @param extension File extension of the resource type
+     * @param enable true to use views when possible, false to always copy the data (default)
+     * @return RESULT_OK on success, RESULT_UNKNOWN_RESOURCE_TYPE if the type isn't registered
+     */
+    Result SetTypeBufferViews(HFactory factory, const char* extension, bool enable);
+
     /**
      * Get a resource from factory
      * @param factory Factory handle
@@ -551,6 +595,25 @@ namespace dmResource
      */
     HPreloader NewPreloader(HFactory factory, const dmArray<const char*>& names);
 
+    /**
+     * Resource load priority. The loader threads serve loads with higher priority before
+     * any loads with lower priority.
+     */
+    enum LoadPriority
+    {
+        LOAD_PRIORITY_HIGH   = 0, //!< Resources needed as soon as possible, e.g. spawned by factories
+        LOAD_PRIORITY_NORMAL = 1, //!< Default
+        LOAD_PRIORITY_LOW    = 2, //!< Background loading
+        LOAD_PRIORITY_COUNT  = 3,
+    };
+
+    /**
+     * Set the priority of the loads of a preloader. Affects pending loads as well.
+     * @param preloader Preloader
+     * @param priority Load priority. Default is LOAD_PRIORITY_NORMAL
+     */
+    void SetPreloaderPriority(HPreloader preloader, LoadPriority priority);
+
     /**
      * Perform one update tick of the preloader, with a soft time limit for
      * how much time to spend.
@@ -570,6 +633,34 @@ namespace dmResource
      */
     void DeletePreloader(HPreloader preloader);
 
+    /**
+     * Preloader statistics
+     */
+    struct PreloaderStats
+    {
+        /// Number of resources currently in the dependency tree, including the root
+        uint32_t m_RequestCount;
+        /// Highest number of resources in the dependency tree at the same time
+        uint32_t m_PeakRequestCount;
+        /// Number of resources the dependency tree has room for without growing
+        uint32_t m_RequestCapacity;
+        /// Number of times a load couldn't be issued because the load queue was full
+        uint32_t m_Stalls;
+        /// Number of hinted resources dropped because the preloader was full. These are loaded synchronously instead.
+        uint32_t m_DroppedRequests;
+        /// Loaded data (bytes) kept while waiting for the resource's dependencies to be created
+        uint32_t m_BytesInFlight;
+        /// Highest value of m_BytesInFlight
+        uint32_t m_PeakBytesInFlight;
+    };
+
+    /**
+     * Get preloader statistics. The current values are also reported as profiler counters by UpdatePreloader.
+     * @param preloader Preloader
+     * @param stats Statistics (out)
+     */
+    void GetPreloaderStats(HPreloader preloader, PreloaderStats* stats);
+
     /**
      * Hint the preloader what to load before Create is called on the resource.
      * The resources are not guaranteed to be loaded before Create is called.
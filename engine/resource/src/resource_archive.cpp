@@ -785,144 +785,121 @@ namespace dmResourceArchive
         return RESULT_NOT_FOUND;
     }
 
-    Result Read(HArchiveIndexContainer archive, EntryData* entry_data, void* buffer)
+    uint32_t GetStoredSize(const EntryData* entry_data)
     {
-        uint32_t size = entry_data->m_ResourceSize;
-        uint32_t compressed_size = entry_data->m_ResourceCompressedSize;
+        return entry_data->m_ResourceCompressedSize != 0xFFFFFFFF ? entry_data->m_ResourceCompressedSize : entry_data->m_ResourceSize;
+    }
 
+    // Returns the stored resource data if it's memory mapped, otherwise 0x0
+    static const void* GetMappedData(HArchiveIndexContainer archive, const EntryData* entry_data)
+    {
         bool loaded_with_liveupdate = (entry_data->m_Flags & ENTRY_FLAG_LIVEUPDATE_DATA);
-        bool resource_memmapped = false;
-
-        if (loaded_with_liveupdate)
-            resource_memmapped = archive->m_LiveUpdateResourcesMemMapped;
-        else
-            resource_memmapped = archive->m_ResourcesMemMapped;
-
+        bool resource_memmapped = loaded_with_liveupdate ? archive->m_LiveUpdateResourcesMemMapped : archive->m_ResourcesMemMapped;
         if (!resource_memmapped)
         {
-            FILE* resource_file;
+            return 0x0;
+        }
+        const uint8_t* data = loaded_with_liveupdate ? archive->m_LiveUpdateResourceData : archive->m_ResourceData;
+        return (const void*) (data + entry_data->m_ResourceDataOffset);
+    }
 
-            if (loaded_with_liveupdate)
-            {
-                resource_file = archive->m_LiveUpdateFileResourceData;
-            }
-            else
-            {
-                resource_file = archive->m_FileResourceData;
-            }
+    Result ReadRaw(HArchiveIndexContainer archive, const EntryData* entry_data, void* buffer)
+    {
+        uint32_t size = GetStoredSize(entry_data);
+        bool loaded_with_liveupdate = (entry_data->m_Flags & ENTRY_FLAG_LIVEUPDATE_DATA);
+        bool resource_memmapped = loaded_with_liveupdate ? archive->m_LiveUpdateResourcesMemMapped : archive->m_ResourcesMemMapped;
 
+        if (!resource_memmapped)
+        {
+            FILE* resource_file = loaded_with_liveupdate ? archive->m_LiveUpdateFileResourceData : archive->m_FileResourceData;
             fseek(resource_file, entry_data->m_ResourceDataOffset, SEEK_SET);
-            if (compressed_size != 0xFFFFFFFF) // resource is compressed
-            {
-                char *compressed_buf = (char*)malloc(compressed_size);
-                if (!compressed_buf)
-                {
-                    return RESULT_MEM_ERROR;
-                }
-
-                if (fread(compressed_buf, 1, compressed_size, resource_file) != compressed_size)
-                {
-                    free(compressed_buf);
-                    return RESULT_IO_ERROR;
-                }
-
-                if(entry_data->m_Flags & ENTRY_FLAG_ENCRYPTED)
-                {
-                    dmCrypt::Result cr = dmCrypt::Decrypt(dmCrypt::ALGORITHM_XTEA, (uint8_t*) compressed_buf, compressed_size, (const uint8_t*) KEY, strlen(KEY));
-                    if (cr != dmCrypt::RESULT_OK)
-                    {
-                        free(compressed_buf);
-                        return RESULT_UNKNOWN;
-                    }
-                }
-
-                dmLZ4::Result r = dmLZ4::DecompressBufferFast(compressed_buf, compressed_size, buffer, size);
-                free(compressed_buf);
-
-                if (r == dmLZ4::RESULT_OK)
-                {
-                    return RESULT_OK;
-                }
-                else
-                {
-                    return RESULT_OUTBUFFER_TOO_SMALL;
-                }
-            }
-            else
+            if (fread(buffer, 1, size, resource_file) != size)
             {
-                // Entry is uncompressed
-                if (fread(buffer, 1, size, resource_file) == size)
-                {
-                    dmCrypt::Result cr = dmCrypt::RESULT_OK;
-                    if (entry_data->m_Flags & ENTRY_FLAG_ENCRYPTED)
-                    {
-                        cr = dmCrypt::Decrypt(dmCrypt::ALGORITHM_XTEA, (uint8_t*) buffer, size, (const uint8_t*) KEY, strlen(KEY));
-                    }
-                    return (cr == dmCrypt::RESULT_OK) ? RESULT_OK : RESULT_UNKNOWN;
-                }
-                else
-                {
-                    return RESULT_OUTBUFFER_TOO_SMALL;
-                }
+                return RESULT_IO_ERROR;
             }
         }
         else
         {
-            void* r = 0x0;
-            if (loaded_with_liveupdate)
-            {
-                r = (void*) (((uintptr_t)archive->m_LiveUpdateResourceData + entry_data->m_ResourceDataOffset));
-            }
-            else
+            memcpy(buffer, GetMappedData(archive, entry_data), size);
+        }
+        return RESULT_OK;
+    }
+
+    Result DecodeRaw(const EntryData* entry_data, void* raw_buffer, void* buffer)
+    {
+        if (entry_data->m_Flags & ENTRY_FLAG_ENCRYPTED)
+        {
+            dmCrypt::Result cr = dmCrypt::Decrypt(dmCrypt::ALGORITHM_XTEA, (uint8_t*) raw_buffer, GetStoredSize(entry_data), (const uint8_t*) KEY, strlen(KEY));
+            if (cr != dmCrypt::RESULT_OK)
             {
-                r = (void*) (((uintptr_t)archive->m_ResourceData + entry_data->m_ResourceDataOffset));
+                return RESULT_UNKNOWN;
             }
+        }
 
-            Result ret;
+        if (entry_data->m_ResourceCompressedSize != 0xFFFFFFFF)
+        {
+            dmLZ4::Result r = dmLZ4::DecompressBufferFast(raw_buffer, entry_data->m_ResourceCompressedSize, buffer, entry_data->m_ResourceSize);
+            return r == dmLZ4::RESULT_OK ? RESULT_OK : RESULT_OUTBUFFER_TOO_SMALL;
+        }
 
-            void* decrypted = r;
+        if (raw_buffer != buffer)
+        {
+            memcpy(buffer, raw_buffer, entry_data->m_ResourceSize);
+        }
+        return RESULT_OK;
+    }
 
-            if (entry_data->m_Flags & ENTRY_FLAG_ENCRYPTED)
-            {
-                uint32_t bufsize = (compressed_size != 0xFFFFFFFF) ? compressed_size : size;
-                decrypted = (uint8_t*) malloc(bufsize);
-                memcpy(decrypted, r, bufsize);
-                dmCrypt::Result cr = dmCrypt::Decrypt(dmCrypt::ALGORITHM_XTEA, (uint8_t*) decrypted, bufsize, (const uint8_t*) KEY, strlen(KEY));
-                if (cr != dmCrypt::RESULT_OK)
-                {
-                    free(decrypted);
-                    return RESULT_UNKNOWN;
-                }
-            }
+    Result Read(HArchiveIndexContainer archive, EntryData* entry_data, void* buffer)
+    {
+        bool compressed = entry_data->m_ResourceCompressedSize != 0xFFFFFFFF;
+        bool encrypted = entry_data->m_Flags & ENTRY_FLAG_ENCRYPTED;
 
-            if (compressed_size != 0xFFFFFFFF)
+        // Memory mapped data that isn't decrypted in place is decompressed without a copy
+        void* raw_buffer = 0x0;
+        if (compressed && !encrypted)
+        {
+            raw_buffer = (void*) GetMappedData(archive, entry_data);
+        }
+
+        bool allocated = false;
+        if (!raw_buffer)
+        {
+            if (compressed)
             {
-                // Entry is compressed
-                dmLZ4::Result result = dmLZ4::DecompressBufferFast(decrypted, compressed_size, buffer, size);
-                if (result == dmLZ4::RESULT_OK)
+                raw_buffer = malloc(entry_data->m_ResourceCompressedSize);
+                if (!raw_buffer)
                 {
-                    ret = RESULT_OK;
-                }
-                else
-                {
-                    ret = RESULT_OUTBUFFER_TOO_SMALL;
+                    return RESULT_MEM_ERROR;
                 }
+                allocated = true;
             }
             else
             {
-                // Entry is uncompressed
-                memcpy(buffer, decrypted, size);
-                ret = RESULT_OK;
+                raw_buffer = buffer;
             }
 
-            // if needed aux buffer
-            if (decrypted != r)
+            Result r = ReadRaw(archive, entry_data, raw_buffer);
+            if (r != RESULT_OK)
             {
-                free(decrypted);
+                if (allocated)
+                    free(raw_buffer);
+                return r;
             }
+        }
 
-            return ret;
+        Result r = DecodeRaw(entry_data, raw_buffer, buffer);
+        if (allocated)
+            free(raw_buffer);
+        return r;
+    }
+
+    const void* GetView(HArchiveIndexContainer archive, const EntryData* entry_data)
+    {
+        if (entry_data->m_ResourceCompressedSize != 0xFFFFFFFF || (entry_data->m_Flags & ENTRY_FLAG_ENCRYPTED))
+        {
+            return 0x0;
         }
+        return GetMappedData(archive, entry_data);
     }
 
     uint32_t GetEntryCount(HArchiveIndexContainer archive)
@@ -134,6 +134,42 @@ namespace dmResourceArchive
      */
     Result Read(HArchiveIndexContainer archive, EntryData* entry_data, void* buffer);
 
+    /**
+     * Get the size of the resource data as stored in the archive, i.e. compressed size if compressed
+     * @param entry_data entry data
+     * @return stored size in bytes
+     */
+    uint32_t GetStoredSize(const EntryData* entry_data);
+
+    /**
+     * Read the resource data as stored in the archive (possibly compressed and/or encrypted).
+     * Use with DecodeRaw, that doesn't touch the archive, to split Read in two steps.
+     * @param archive archive index handle
+     * @param entry_data entry data
+     * @param buffer buffer to load to, of at least GetStoredSize() bytes
+     * @return RESULT_OK on success
+     */
+    Result ReadRaw(HArchiveIndexContainer archive, const EntryData* entry_data, void* buffer);
+
+    /**
+     * Decrypt (in place) and decompress resource data read with ReadRaw
+     * @param entry_data entry data
+     * @param raw_buffer data read with ReadRaw
+     * @param buffer buffer to decode to, of at least m_ResourceSize bytes. May be the raw_buffer if the entry isn't compressed
+     * @return RESULT_OK on success
+     */
+    Result DecodeRaw(const EntryData* entry_data, void* raw_buffer, void* buffer);
+
+    /**
+     * Get a read-only view of the resource data, without copying it. Only possible for resources
+     * stored uncompressed and unencrypted in memory mapped resource data.
+     * The view is valid as long as the archive is mounted.
+     * @param archive archive index handle
+     * @param entry_data entry data
+     * @return pointer to m_ResourceSize bytes of resource data, or 0 if the resource has to be read with Read()
+     */
+    const void* GetView(HArchiveIndexContainer archive, const EntryData* entry_data);
+
     /**
      * Delete archive index. Only required for archives created with LoadArchive function
      * @param archive archive index handle
@@ -23,6 +23,7 @@
 #include <dlib/hash.h>
 #include <dlib/hashtable.h>
 #include <dlib/log.h>
+#include <dlib/math.h>
 #include <dlib/uri.h>
 #include <dlib/time.h>
 #include <dlib/spinlock.h>
@@ -71,8 +72,10 @@ namespace dmResource
     // to each request item. The path cache is also syncronized with the same spinlock as the new preloader hints array.
     // The path cache is not touched by the UpdatePreloader code, we keep the internalized pointers in the item.
 
-    // If max number of preload items is reached or the path cache is full new items added to the preloader will
-    // be thrown away and can potentially cause synced loading of those resources.
+    // The request tree and the path cache grow on demand, in fixed size chunks allocated from block allocators so
+    // that request pointers and internalized paths stay valid as the preloader grows. Only if the max number of
+    // preload requests is reached new items added to the preloader will be thrown away and can potentially cause
+    // synced loading of those resources.
 
     struct PathDescriptor
     {
@@ -83,7 +86,7 @@ namespace dmResource
         dmhash_t m_CanonicalPathHash;
     };
 
-    typedef int16_t TRequestIndex;
+    typedef int32_t TRequestIndex;
 
     struct PreloadRequest
     {
@@ -92,7 +95,7 @@ namespace dmResource
         TRequestIndex m_Parent;
         TRequestIndex m_FirstChild;
         TRequestIndex m_NextSibling;
-        uint16_t m_PendingChildCount;
+        uint32_t m_PendingChildCount;
 
         // Set once resources have started loading, they have a load request
         dmLoadQueue::HRequest m_LoadRequest;
@@ -100,6 +103,8 @@ namespace dmResource
         // Set for items that are pending and waiting for children to complete
         void* m_Buffer;
         uint32_t m_BufferSize;
+        // m_Buffer is a read-only view into a memory mapped archive, and isn't owned by the preloader
+        bool m_IsBufferView;
 
         // Set once preload function has run
         void* m_PreloadData;
@@ -118,24 +123,23 @@ namespace dmResource
     };
 
 
-    // The preloader will function even down to a value of 1 here (the root object)
-    // and sets the limit of how large a dependencies tree can be stored. Since nodes
-    // are always present with all their children inserted (unless there was not room)
+    // The max request count (NewFactoryParams::m_PreloaderMaxRequests) sets the limit of how large a
+    // dependencies tree can be stored. The preloader will function even down to a value of 1 here (the root object).
+    // Since nodes are always present with all their children inserted (unless there was not room)
     // the required size is something the sum of all children on each level down along
     // the largest branch.
 
-    typedef dmHashTable<dmhash_t, uint32_t> TPathHashTable;
+    typedef dmHashTable<dmhash_t, const char*> TPathHashTable;
     typedef dmHashTable<dmhash_t, bool> TPathInProgressTable;
 
-    static const uint32_t MAX_PRELOADER_REQUESTS         = 1024;
-    static const uint32_t PATH_IN_PROGRESS_TABLE_SIZE    = MAX_PRELOADER_REQUESTS / 3;
-    static const uint32_t PATH_IN_PROGRESS_CAPACITY      = MAX_PRELOADER_REQUESTS;
-    static const uint32_t PATH_IN_PROGRESS_HASHDATA_SIZE = (PATH_IN_PROGRESS_TABLE_SIZE * sizeof(uint32_t)) + (PATH_IN_PROGRESS_CAPACITY * sizeof(TPathInProgressTable::Entry));
-    static const uint32_t PATH_AVERAGE_LENGTH            = 40;
-    static const uint32_t MAX_PRELOADER_PATHS            = 1536;
-    static const uint32_t PATH_BUFFER_TABLE_SIZE         = 509;
-    static const uint32_t PATH_BUFFER_TABLE_CAPACITY     = MAX_PRELOADER_PATHS;
-    static const uint32_t PATH_BUFFER_HASHDATA_SIZE      = (PATH_BUFFER_TABLE_SIZE * sizeof(uint32_t)) + (PATH_BUFFER_TABLE_CAPACITY * sizeof(TPathHashTable::Entry));
+    // Requests are allocated in chunks small enough to be served from a single allocator block
+    static const uint32_t REQUEST_CHUNK_SHIFT            = 6;
+    static const uint32_t REQUEST_CHUNK_SIZE             = 1 << REQUEST_CHUNK_SHIFT;
+    static const uint32_t REQUEST_CHUNK_MASK             = REQUEST_CHUNK_SIZE - 1;
+    // Internalized paths are stored in pages, each one fits at least one path of max length
+    static const uint32_t PATH_PAGE_SIZE                 = 4096;
+    static const uint32_t PATH_TABLE_CAPACITY_INCREMENT  = 256;
+    static const uint32_t POST_CREATE_CAPACITY_INCREMENT = 128;
 
     struct PendingHint
     {
@@ -145,39 +149,48 @@ namespace dmResource
 
     struct ResourcePreloader
     {
-        ResourcePreloader()
-            : m_InProgress(&m_PathInProgressData, PATH_IN_PROGRESS_TABLE_SIZE, PATH_IN_PROGRESS_CAPACITY)
-        {
-        }
         struct SyncedData
         {
             SyncedData()
-                : m_PathLookup(m_LookupData, PATH_BUFFER_TABLE_SIZE, PATH_BUFFER_TABLE_CAPACITY)
-                , m_PathDataUsed(0)
+                : m_PathPageUsed(PATH_PAGE_SIZE)
+                , m_MaxPathCount(0)
+                , m_DroppedPaths(0)
             {
             }
             dmArray<PendingHint> m_NewHints;
             TPathHashTable m_PathLookup;
-            uint8_t m_LookupData[PATH_BUFFER_HASHDATA_SIZE];
-            char m_PathData[MAX_PRELOADER_PATHS * PATH_AVERAGE_LENGTH];
-            uint32_t m_PathDataUsed;
+            // Path pages are allocated from a separate allocator, PreloadHint is called from the loader threads
+            dmBlockAllocator::HContext m_PathAllocator;
+            dmArray<char*> m_PathPages;
+            uint32_t m_PathPageUsed;
+            uint32_t m_MaxPathCount;
+            uint32_t m_DroppedPaths;
         } m_SyncedData;
 
         dmSpinlock::lock_t m_SyncedDataSpinlock;
 
-        PreloadRequest m_Request[MAX_PRELOADER_REQUESTS];
+        // Requests are stored in chunks so they don't move when the tree grows. The chunks are allocated
+        // with new[] since the block allocator only guarantees 2 byte alignment
+        dmArray<PreloadRequest*> m_RequestChunks;
+        uint32_t m_MaxRequestCount;
 
         // list of free nodes
-        TRequestIndex m_Freelist[MAX_PRELOADER_REQUESTS];
-        uint32_t m_FreelistSize;
+        dmArray<TRequestIndex> m_Freelist;
         dmLoadQueue::HQueue m_LoadQueue;
         HFactory m_Factory;
         TPathInProgressTable m_InProgress;
-        uint8_t m_PathInProgressData[PATH_IN_PROGRESS_HASHDATA_SIZE];
 
         // used instead of dynamic allocs as far as it lasts.
         dmBlockAllocator::HContext m_BlockAllocator;
 
+        // Statistics, see PreloaderStats
+        uint32_t m_RequestCount;
+        uint32_t m_PeakRequestCount;
+        uint32_t m_Stalls;
+        uint32_t m_DroppedRequests;
+        uint32_t m_BytesInFlight;
+        uint32_t m_PeakBytesInFlight;
+
         // post create state
         bool m_LoadQueueFull;
         bool m_CreateComplete;
@@ -190,25 +203,43 @@ namespace dmResource
         dmArray<void*> m_PersistedResources;
     };
 
+    static inline PreloadRequest* GetRequest(ResourcePreloader* preloader, TRequestIndex index)
+    {
+        return &preloader->m_RequestChunks[index >> REQUEST_CHUNK_SHIFT][index & REQUEST_CHUNK_MASK];
+    }
+
     const char* InternalizePath(ResourcePreloader::SyncedData* preloader_synced_data, dmhash_t path_hash, const char* path, uint32_t path_len)
     {
-        uint32_t* path_lookup = preloader_synced_data->m_PathLookup.Get(path_hash);
+        const char** path_lookup = preloader_synced_data->m_PathLookup.Get(path_hash);
         if (path_lookup != 0x0)
         {
-            return &preloader_synced_data->m_PathData[*path_lookup];
+            return *path_lookup;
         }
-        if (preloader_synced_data->m_PathLookup.Full())
+        TPathHashTable& path_table = preloader_synced_data->m_PathLookup;
+        if (path_table.Full())
         {
-            return 0x0;
+            if (path_table.Capacity() >= preloader_synced_data->m_MaxPathCount)
+            {
+                ++preloader_synced_data->m_DroppedPaths;
+                return 0x0;
+            }
+            uint32_t capacity = dmMath::Min(path_table.Capacity() + PATH_TABLE_CAPACITY_INCREMENT, preloader_synced_data->m_MaxPathCount);
+            path_table.SetCapacity(dmMath::Max(1u, capacity / 3), capacity);
         }
-        if (preloader_synced_data->m_PathDataUsed + path_len + 1 > sizeof(preloader_synced_data->m_PathData))
+        assert(path_len < PATH_PAGE_SIZE);
+        if (preloader_synced_data->m_PathPageUsed + path_len + 1 > PATH_PAGE_SIZE)
         {
-            return 0x0;
+            if (preloader_synced_data->m_PathPages.Full())
+            {
+                preloader_synced_data->m_PathPages.OffsetCapacity(16);
+            }
+            preloader_synced_data->m_PathPages.Push((char*)dmBlockAllocator::Allocate(preloader_synced_data->m_PathAllocator, PATH_PAGE_SIZE));
+            preloader_synced_data->m_PathPageUsed = 0;
         }
-        char* result = &preloader_synced_data->m_PathData[preloader_synced_data->m_PathDataUsed];
+        char* result = &preloader_synced_data->m_PathPages.Back()[preloader_synced_data->m_PathPageUsed];
         dmStrlCpy(result, path, path_len + 1);
-        preloader_synced_data->m_PathLookup.Put(path_hash, preloader_synced_data->m_PathDataUsed);
-        preloader_synced_data->m_PathDataUsed += path_len + 1;
+        path_table.Put(path_hash, result);
+        preloader_synced_data->m_PathPageUsed += path_len + 1;
         return result;
     }
 
@@ -290,6 +321,11 @@ namespace dmResource
     {
         dmhash_t path_hash = path_descriptor->m_CanonicalPathHash;
         assert(preloader->m_InProgress.Get(path_hash) == 0x0);
+        if (preloader->m_InProgress.Full())
+        {
+            uint32_t capacity = preloader->m_InProgress.Capacity() + REQUEST_CHUNK_SIZE;
+            preloader->m_InProgress.SetCapacity(capacity / 3, capacity);
+        }
         preloader->m_InProgress.Put(path_hash, true);
     }
 
@@ -302,44 +338,74 @@ namespace dmResource
 
     static void PreloaderTreeInsert(ResourcePreloader* preloader, TRequestIndex index, TRequestIndex parent)
     {
-        PreloadRequest* reqs      = &preloader->m_Request[0];
-        reqs[index].m_NextSibling = reqs[parent].m_FirstChild;
-        reqs[index].m_Parent      = parent;
-        reqs[parent].m_FirstChild = index;
-        reqs[parent].m_PendingChildCount += 1;
+        PreloadRequest* req        = GetRequest(preloader, index);
+        PreloadRequest* parent_req = GetRequest(preloader, parent);
+        req->m_NextSibling         = parent_req->m_FirstChild;
+        req->m_Parent              = parent;
+        parent_req->m_FirstChild   = index;
+        parent_req->m_PendingChildCount += 1;
+    }
+
+    // Adds a chunk of requests to the free list, returns false if the max request count is reached
+    static bool GrowRequests(ResourcePreloader* preloader)
+    {
+        uint32_t capacity = preloader->m_RequestChunks.Size() * REQUEST_CHUNK_SIZE;
+        if (capacity >= preloader->m_MaxRequestCount)
+        {
+            return false;
+        }
+        if (preloader->m_RequestChunks.Full())
+        {
+            preloader->m_RequestChunks.OffsetCapacity(16);
+        }
+        preloader->m_RequestChunks.Push(new PreloadRequest[REQUEST_CHUNK_SIZE]);
+
+        // Only hand out indices up to the max count, lowest index first
+        uint32_t new_capacity = dmMath::Min(capacity + REQUEST_CHUNK_SIZE, preloader->m_MaxRequestCount);
+        preloader->m_Freelist.SetCapacity(new_capacity);
+        for (uint32_t i = new_capacity; i > capacity; --i)
+        {
+            preloader->m_Freelist.Push((TRequestIndex)(i - 1));
+        }
+        return true;
     }
 
     static void RemoveFromParentPendingCount(ResourcePreloader* preloader, PreloadRequest* req)
     {
         if (req->m_Parent != -1)
         {
-            assert(preloader->m_Request[req->m_Parent].m_PendingChildCount > 0);
-            preloader->m_Request[req->m_Parent].m_PendingChildCount -= 1;
+            assert(GetRequest(preloader, req->m_Parent)->m_PendingChildCount > 0);
+            GetRequest(preloader, req->m_Parent)->m_PendingChildCount -= 1;
         }
     }
 
     static Result PreloadPathDescriptor(HPreloader preloader, TRequestIndex parent, const PathDescriptor& path_descriptor)
     {
         // Quick deduplication, check if the child is already listed under the current parent
-        TRequestIndex child = preloader->m_Request[parent].m_FirstChild;
+        TRequestIndex child = GetRequest(preloader, parent)->m_FirstChild;
         while (child != -1)
         {
-            if (preloader->m_Request[child].m_PathDescriptor.m_NameHash == path_descriptor.m_NameHash)
+            if (GetRequest(preloader, child)->m_PathDescriptor.m_NameHash == path_descriptor.m_NameHash)
             {
                 return RESULT_ALREADY_REGISTERED;
             }
-            child = preloader->m_Request[child].m_NextSibling;
+            child = GetRequest(preloader, child)->m_NextSibling;
         }
 
-        if (!preloader->m_FreelistSize)
+        if (preloader->m_Freelist.Empty() && !GrowRequests(preloader))
         {
             // Preload queue is exhausted; this is not fatal, it just means the resource will be loaded
             // inside the main thread which may cause stuttering
+            ++preloader->m_DroppedRequests;
             return RESULT_OUT_OF_MEMORY;
         }
 
-        TRequestIndex new_req = preloader->m_Freelist[--preloader->m_FreelistSize];
-        PreloadRequest* req   = &preloader->m_Request[new_req];
+        TRequestIndex new_req = preloader->m_Freelist.Back();
+        preloader->m_Freelist.Pop();
+        PreloadRequest* req   = GetRequest(preloader, new_req);
+
+        preloader->m_RequestCount++;
+        preloader->m_PeakRequestCount = dmMath::Max(preloader->m_PeakRequestCount, preloader->m_RequestCount);
         memset(req, 0, sizeof(PreloadRequest));
         req->m_PathDescriptor    = path_descriptor;
         req->m_FirstChild        = -1;
@@ -353,15 +419,15 @@ namespace dmResource
         TRequestIndex go_up = parent;
         while (go_up != -1)
         {
-            if (preloader->m_Request[go_up].m_PathDescriptor.m_CanonicalPathHash == path_descriptor.m_CanonicalPathHash)
+            if (GetRequest(preloader, go_up)->m_PathDescriptor.m_CanonicalPathHash == path_descriptor.m_CanonicalPathHash)
             {
                 req->m_LoadResult = RESULT_RESOURCE_LOOP_ERROR;
                 assert(parent != -1);
-                assert(preloader->m_Request[parent].m_PendingChildCount > 0);
-                preloader->m_Request[parent].m_PendingChildCount -= 1;
+                assert(GetRequest(preloader, parent)->m_PendingChildCount > 0);
+                GetRequest(preloader, parent)->m_PendingChildCount -= 1;
                 break;
             }
-            go_up = preloader->m_Request[go_up].m_Parent;
+            go_up = GetRequest(preloader, go_up)->m_Parent;
         }
         return RESULT_OK;
     }
@@ -404,12 +470,12 @@ namespace dmResource
     // Only supports removing the first child, which is all the preloader uses anyway.
     static void PreloaderRemoveLeaf(ResourcePreloader* preloader, TRequestIndex index)
     {
-        assert(preloader->m_FreelistSize < MAX_PRELOADER_REQUESTS);
+        assert(preloader->m_RequestCount > 1);
 
-        PreloadRequest* me = &preloader->m_Request[index];
+        PreloadRequest* me = GetRequest(preloader, index);
         assert(me->m_FirstChild == -1);
         assert(me->m_PendingChildCount == 0);
-        PreloadRequest* parent = &preloader->m_Request[me->m_Parent];
+        PreloadRequest* parent = GetRequest(preloader, me->m_Parent);
         assert(parent->m_FirstChild == index);
 
         if (me->m_Resource)
@@ -431,7 +497,8 @@ namespace dmResource
             RemoveFromParentPendingCount(preloader, me);
         }
 
-        preloader->m_Freelist[preloader->m_FreelistSize++] = index;
+        preloader->m_Freelist.Push(index);
+        preloader->m_RequestCount--;
     }
 
     static void RemoveChildren(ResourcePreloader* preloader, PreloadRequest* req)
@@ -446,23 +513,36 @@ namespace dmResource
     HPreloader NewPreloader(HFactory factory, const dmArray<const char*>& names)
     {
         ResourcePreloader* preloader = new ResourcePreloader();
-        // root is always allocated so we don't add index zero in the free list
-        for (uint32_t i = 0; i < MAX_PRELOADER_REQUESTS - 1; i++)
-        {
-            preloader->m_Freelist[i] = MAX_PRELOADER_REQUESTS - i - 1;
-        }
-
-        preloader->m_FreelistSize = MAX_PRELOADER_REQUESTS - 1;
 
         preloader->m_Factory         = factory;
         preloader->m_LoadQueue       = dmLoadQueue::CreateQueue(factory);
+        preloader->m_BlockAllocator  = dmBlockAllocator::CreateContext();
         dmSpinlock::Init(&preloader->m_SyncedDataSpinlock);
 
+        preloader->m_MaxRequestCount     = dmMath::Max(1u, GetPreloaderMaxRequests(factory));
+        preloader->m_RequestCount        = 1;
+        preloader->m_PeakRequestCount    = 1;
+        preloader->m_Stalls              = 0;
+        preloader->m_DroppedRequests     = 0;
+        preloader->m_BytesInFlight       = 0;
+        preloader->m_PeakBytesInFlight   = 0;
+
+        // root is always allocated so we don't keep index zero in the free list
+        GrowRequests(preloader);
+        preloader->m_Freelist.Pop();
+
+        preloader->m_InProgress.SetCapacity(REQUEST_CHUNK_SIZE / 3, REQUEST_CHUNK_SIZE);
+
+        // Each request needs at most two paths, its name and canonical path
+        preloader->m_SyncedData.m_PathAllocator = dmBlockAllocator::CreateContext();
+        preloader->m_SyncedData.m_PathLookup.SetCapacity(PATH_TABLE_CAPACITY_INCREMENT / 3, PATH_TABLE_CAPACITY_INCREMENT);
+        preloader->m_SyncedData.m_MaxPathCount = dmMath::Max(PATH_TABLE_CAPACITY_INCREMENT, preloader->m_MaxRequestCount * 2);
+
         preloader->m_PersistResourceCount = 0;
         preloader->m_PersistedResources.SetCapacity(names.Size());
 
         // Insert root.
-        PreloadRequest* root = &preloader->m_Request[0];
+        PreloadRequest* root = GetRequest(preloader, 0);
         memset(root, 0x00, sizeof(PreloadRequest));
 
         root->m_LoadResult        = MakePathDescriptor(preloader, names[0], root->m_PathDescriptor);
@@ -472,13 +552,11 @@ namespace dmResource
         preloader->m_PersistResourceCount++;
 
         // Post create setup
-        preloader->m_PostCreateCallbacks.SetCapacity(MAX_PRELOADER_REQUESTS / 8);
+        preloader->m_PostCreateCallbacks.SetCapacity(POST_CREATE_CAPACITY_INCREMENT);
         preloader->m_LoadQueueFull           = false;
         preloader->m_CreateComplete          = false;
         preloader->m_PostCreateCallbackIndex = 0;
 
-        preloader->m_BlockAllocator = dmBlockAllocator::CreateContext();
-
         if (root->m_LoadResult == RESULT_OK)
         {
             root->m_LoadResult = RESULT_PENDING;
@@ -496,6 +574,7 @@ namespace dmResource
             }
         }
 
+        RegisterPreloader(factory, preloader);
         return preloader;
     }
 
@@ -506,6 +585,11 @@ namespace dmResource
         return NewPreloader(factory, names);
     }
 
+    void SetPreloaderPriority(HPreloader preloader, LoadPriority priority)
+    {
+        dmLoadQueue::SetPriority(preloader->m_LoadQueue, priority);
+    }
+
     // CreateResource operation ends either with
     //   1) Having created the resource and free:d all buffers => RESULT_OK + m_Resource
     //   2) Having failed, (or created and destroyed), leaving => RESULT_SOME_ERROR + everything free:d
@@ -543,9 +627,14 @@ namespace dmResource
             params.m_BufferSize               = req->m_BufferSize;
             req->m_LoadResult                 = resource_type->m_CreateFunction(params);
 
-            dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
+            if (!req->m_IsBufferView)
+            {
+                dmBlockAllocator::Free(preloader->m_BlockAllocator, req->m_Buffer, req->m_BufferSize);
+                preloader->m_BytesInFlight -= req->m_BufferSize;
+            }
 
             req->m_Buffer = 0;
+            req->m_IsBufferView = false;
         }
         else
         {
@@ -561,7 +650,7 @@ namespace dmResource
             {
                 if (preloader->m_PostCreateCallbacks.Full())
                 {
-                    preloader->m_PostCreateCallbacks.OffsetCapacity(MAX_PRELOADER_REQUESTS / 8);
+                    preloader->m_PostCreateCallbacks.OffsetCapacity(POST_CREATE_CAPACITY_INCREMENT);
                 }
                 preloader->m_PostCreateCallbacks.SetSize(preloader->m_PostCreateCallbacks.Size() + 1);
                 ResourcePostCreateParamsInternal& ip = preloader->m_PostCreateCallbacks.Back();
@@ -675,7 +764,7 @@ namespace dmResource
         {
             return false;
         }
-        PreloadRequest* parent_req = &preloader->m_Request[parent];
+        PreloadRequest* parent_req = GetRequest(preloader, parent);
         if (parent_req->m_PendingChildCount > 0)
         {
             return false;
@@ -734,10 +823,20 @@ namespace dmResource
         }
         else
         {
-            // Keep the loaded bytes until we have loaded all children
-            req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
-            memcpy(req->m_Buffer, buffer, buffer_size);
+            // Keep the loaded bytes until we have loaded all children. A view into the archive stays valid, so it is kept as is
+            if (load_result.m_IsBufferView)
+            {
+                req->m_Buffer = buffer;
+            }
+            else
+            {
+                req->m_Buffer = dmBlockAllocator::Allocate(preloader->m_BlockAllocator, buffer_size);
+                memcpy(req->m_Buffer, buffer, buffer_size);
+                preloader->m_BytesInFlight += buffer_size;
+                preloader->m_PeakBytesInFlight = dmMath::Max(preloader->m_PeakBytesInFlight, preloader->m_BytesInFlight);
+            }
             req->m_BufferSize = buffer_size;
+            req->m_IsBufferView = load_result.m_IsBufferView;
             dmLoadQueue::FreeLoad(preloader->m_LoadQueue, req->m_LoadRequest);
             req->m_LoadRequest = 0;
         }
@@ -753,7 +852,7 @@ namespace dmResource
         DM_PROFILE(Resource, "PreloaderUpdateOneItem");
         while (index >= 0)
         {
-            PreloadRequest* req = &preloader->m_Request[index];
+            PreloadRequest* req = GetRequest(preloader, index);
             switch (req->m_LoadResult)
             {
                 case RESULT_PENDING:
@@ -859,6 +958,7 @@ namespace dmResource
         info.m_HintInfo.m_Parent    = index;
         info.m_Function             = req->m_PathDescriptor.m_ResourceType->m_PreloadFunction;
         info.m_Context              = req->m_PathDescriptor.m_ResourceType->m_Context;
+        info.m_BufferViews          = req->m_PathDescriptor.m_ResourceType->m_BufferViews;
 
         // If we can't add the request to the load queue it is because the queue is full
         // We will try again once we completed loading of an item via dmLoadQueue::EndLoad
@@ -869,6 +969,7 @@ namespace dmResource
         }
 
         preloader->m_LoadQueueFull = true;
+        preloader->m_Stalls++;
         return false;
     }
 
@@ -909,6 +1010,15 @@ namespace dmResource
         return ret;
     }
 
+    // Called once per frame from UpdateFactory, since UpdatePreloader may run several times per frame
+    void ReportPreloaderCounters(HPreloader preloader)
+    {
+        DM_COUNTER("Preloader.Requests", preloader->m_RequestCount);
+        DM_COUNTER("Preloader.PeakRequests", preloader->m_PeakRequestCount);
+        DM_COUNTER("Preloader.Stalls", preloader->m_Stalls);
+        DM_COUNTER("Preloader.BytesInFlight", preloader->m_BytesInFlight);
+    }
+
     Result UpdatePreloader(HPreloader preloader, FPreloaderCompleteCallback complete_callback, PreloaderCompleteCallbackParams* complete_callback_params, uint32_t soft_time_limit)
     {
         DM_PROFILE(Resource, "UpdatePreloader");
@@ -919,7 +1029,7 @@ namespace dmResource
 
         do
         {
-            Result root_result        = preloader->m_Request[0].m_LoadResult;
+            Result root_result        = GetRequest(preloader, 0)->m_LoadResult;
             Result post_create_result = RESULT_OK;
             if (preloader->m_PostCreateCallbackIndex < preloader->m_PostCreateCallbacks.Size())
             {
@@ -932,7 +1042,7 @@ namespace dmResource
                         // Just waiting for the post-create functions to complete
                         // If main result is RESULT_OK pick up any errors from
                         // post create function
-                        preloader->m_Request[0].m_LoadResult = post_create_result;
+                        GetRequest(preloader, 0)->m_LoadResult = post_create_result;
                     }
                     continue;
                 }
@@ -958,7 +1068,7 @@ namespace dmResource
                     {
                         if (!complete_callback(complete_callback_params))
                         {
-                            preloader->m_Request[0].m_LoadResult = RESULT_NOT_LOADED;
+                            GetRequest(preloader, 0)->m_LoadResult = RESULT_NOT_LOADED;
                         }
                         empty_runs = 0;
                         // We need to continue to do all post create functions
@@ -1022,7 +1132,7 @@ namespace dmResource
         }
 
         // Release root and persisted resources
-        preloader->m_PersistedResources.Push(preloader->m_Request[0].m_Resource);
+        preloader->m_PersistedResources.Push(GetRequest(preloader, 0)->m_Resource);
         for (uint32_t i = 0; i < preloader->m_PersistedResources.Size(); ++i)
         {
             void* resource = preloader->m_PersistedResources[i];
@@ -1031,14 +1141,37 @@ namespace dmResource
             Release(preloader->m_Factory, resource);
         }
 
-        assert(preloader->m_FreelistSize == (MAX_PRELOADER_REQUESTS - 1));
+        assert(preloader->m_RequestCount == 1);
+        UnregisterPreloader(preloader->m_Factory, preloader);
         dmLoadQueue::DeleteQueue(preloader->m_LoadQueue);
 
+        for (uint32_t i = 0; i < preloader->m_RequestChunks.Size(); ++i)
+        {
+            delete[] preloader->m_RequestChunks[i];
+        }
         dmBlockAllocator::DeleteContext(preloader->m_BlockAllocator);
 
+        for (uint32_t i = 0; i < preloader->m_SyncedData.m_PathPages.Size(); ++i)
+        {
+            dmBlockAllocator::Free(preloader->m_SyncedData.m_PathAllocator, preloader->m_SyncedData.m_PathPages[i], PATH_PAGE_SIZE);
+        }
+        dmBlockAllocator::DeleteContext(preloader->m_SyncedData.m_PathAllocator);
+
         delete preloader;
     }
 
+    void GetPreloaderStats(HPreloader preloader, PreloaderStats* stats)
+    {
+        stats->m_RequestCount      = preloader->m_RequestCount;
+        stats->m_PeakRequestCount  = preloader->m_PeakRequestCount;
+        stats->m_RequestCapacity   = dmMath::Min(preloader->m_RequestChunks.Size() * REQUEST_CHUNK_SIZE, preloader->m_MaxRequestCount);
+        stats->m_Stalls            = preloader->m_Stalls;
+        stats->m_BytesInFlight     = preloader->m_BytesInFlight;
+        stats->m_PeakBytesInFlight = preloader->m_PeakBytesInFlight;
+        DM_SPINLOCK_SCOPED_LOCK(preloader->m_SyncedDataSpinlock)
+        stats->m_DroppedRequests   = preloader->m_DroppedRequests + preloader->m_SyncedData.m_DroppedPaths;
+    }
+
     bool PreloadHint(HPreloadHintInfo info, const char* name)
     {
         if (!info || !name)
@@ -23,6 +23,11 @@
 
 // Internal API that preloader needs to use.
 
+namespace dmLoadQueue
+{
+    typedef struct Loader* HLoader;
+}
+
 namespace dmResource
 {
     // This is both for the total resource path, ie m_UriParts.X concatenated with relative path
@@ -44,6 +49,8 @@ namespace dmResource
         FResourcePostCreate m_PostCreateFunction;
         FResourceDestroy    m_DestroyFunction;
         FResourceRecreate   m_RecreateFunction;
+        /// Set with SetTypeBufferViews
+        bool                m_BufferViews;
     };
 
     typedef dmArray<char> LoadBufferType;
@@ -53,9 +60,22 @@ namespace dmResource
     Result CheckSuppliedResourcePath(const char* name);
 
     // load with default internal buffer and its management, returns buffer ptr in 'buffer'
-    Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size);
-    // load with own buffer
-    Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer);
+    // If is_view is set (optional), the returned buffer may be a read-only view into a memory mapped archive, and is_view tells if it is
+    Result LoadResource(HFactory factory, const char* path, const char* original_name, void** buffer, uint32_t* resource_size, bool* is_view);
+    // load with own buffer. The scratch buffer (optional) is used for the compressed data, to decompress outside of the load lock
+    // If view is set (optional) and the resource can be viewed in a memory mapped archive, 'view' is set and the buffer is left empty
+    Result DoLoadResource(HFactory factory, const char* path, const char* original_name, uint32_t* resource_size, LoadBufferType* buffer, LoadBufferType* scratch, const void** view);
+
+    // The loader threads serving the preloaders' load queues
+    dmLoadQueue::HLoader GetLoader(HFactory factory);
+
+    // Max number of requests in a preloader's dependency tree
+    uint32_t GetPreloaderMaxRequests(HFactory factory);
+
+    // Preloaders register with their factory so their profile counters are reported once per frame (in UpdateFactory)
+    void RegisterPreloader(HFactory factory, HPreloader preloader);
+    void UnregisterPreloader(HFactory factory, HPreloader preloader);
+    void ReportPreloaderCounters(HPreloader preloader);
 
     Result InsertResource(HFactory factory, const char* path, uint64_t canonical_path_hash, SResourceDescriptor* descriptor);
     uint32_t GetCanonicalPath(const char* relative_dir, char* buf);
@@ -23,6 +23,7 @@
 #include "resource_ddf.h"
 #include "../resource.h"
 #include "../resource_private.h"
+#include "../async/load_queue.h"
 #include "test/test_resource_ddf.h"
 
 #define JC_TEST_IMPLEMENTATION
@@ -789,13 +790,15 @@ TEST_P(GetResourceTest, PreloadGetParallell)
 
 TEST_P(GetResourceTest, PreloadGetManyRefs)
 {
-    // this has more references than the preloader can fit into its tree
+    // this has more references than the preloader initially has room for in its tree
     dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, "/many_refs.cont");
 
     dmResource::Result r;
     for (uint32_t i=0;i<1000;i++)
     {
         r = dmResource::UpdatePreloader(pr, 0, 0, 30*1000);
+        // Reports the preloader profile counters, once per frame
+        dmResource::UpdateFactory(m_Factory);
         if (r == dmResource::RESULT_PENDING)
             dmTime::Sleep(30000);
         else
@@ -803,6 +806,96 @@ TEST_P(GetResourceTest, PreloadGetManyRefs)
     }
 
     ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, r);
+
+    dmResource::PreloaderStats stats;
+    dmResource::GetPreloaderStats(pr, &stats);
+    ASSERT_EQ(1u, stats.m_RequestCount);
+    ASSERT_LT(1024u, stats.m_PeakRequestCount);
+    ASSERT_LE(stats.m_PeakRequestCount, stats.m_RequestCapacity);
+    ASSERT_EQ(0u, stats.m_DroppedRequests);
+    ASSERT_EQ(0u, stats.m_BytesInFlight);
+    ASSERT_LT(0u, stats.m_PeakBytesInFlight);
+
+    dmResource::DeletePreloader(pr);
+}
+
+TEST_P(GetResourceTest, PreloadGetViews)
+{
+    // A resource waiting for its children keeps its view into the archive instead of a copy
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetTypeBufferViews(m_Factory, "cont", true));
+
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, m_ResourceName);
+
+    dmResource::Result r;
+    for (uint32_t i=0;i<33;i++)
+    {
+        r = dmResource::UpdatePreloader(pr, 0, 0, 30*1000);
+        if (r == dmResource::RESULT_PENDING)
+            dmTime::Sleep(30000);
+        else
+            break;
+    }
+
+    ASSERT_EQ(dmResource::RESULT_OK, r);
+
+    dmResource::PreloaderStats stats;
+    dmResource::GetPreloaderStats(pr, &stats);
+    ASSERT_EQ(0u, stats.m_BytesInFlight);
+    if (strstr(GetParam(), "dmanif:") == GetParam())
+    {
+        ASSERT_EQ(0u, stats.m_PeakBytesInFlight);
+    }
+    else
+    {
+        ASSERT_LT(0u, stats.m_PeakBytesInFlight);
+    }
+
+    TestResourceContainer* resource = 0;
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::Get(m_Factory, m_ResourceName, (void**) &resource));
+    ASSERT_EQ(2u, resource->m_Resources.size());
+    ASSERT_EQ((uint32_t) 123, resource->m_Resources[0]->m_X);
+    ASSERT_EQ((uint32_t) 456, resource->m_Resources[1]->m_X);
+
+    dmResource::DeletePreloader(pr);
+    dmResource::Release(m_Factory, resource);
+}
+
+TEST_P(GetResourceTest, PreloadGetManyRefsMaxRequests)
+{
+    // Hints that don't fit within the max request count are dropped and the resources are loaded synchronously
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_PreloaderMaxRequests = 100;
+    m_Factory = dmResource::NewFactory(&params, GetParam());
+    ASSERT_NE((void*) 0, m_Factory);
+
+    dmResource::Result e;
+    e = dmResource::RegisterType(m_Factory, "cont", this, &ResourceContainerPreload, &ResourceContainerCreate, 0, &ResourceContainerDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    e = dmResource::RegisterType(m_Factory, "foo", this, 0, &FooResourceCreate, &FooResourcePostCreate, &FooResourceDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+
+    dmResource::HPreloader pr = dmResource::NewPreloader(m_Factory, "/many_refs.cont");
+
+    dmResource::Result r;
+    for (uint32_t i=0;i<1000;i++)
+    {
+        r = dmResource::UpdatePreloader(pr, 0, 0, 30*1000);
+        if (r == dmResource::RESULT_PENDING)
+            dmTime::Sleep(30000);
+        else
+            break;
+    }
+
+    ASSERT_EQ(dmResource::RESULT_RESOURCE_NOT_FOUND, r);
+
+    dmResource::PreloaderStats stats;
+    dmResource::GetPreloaderStats(pr, &stats);
+    ASSERT_EQ(100u, stats.m_PeakRequestCount);
+    ASSERT_EQ(100u, stats.m_RequestCapacity);
+    ASSERT_LT(0u, stats.m_DroppedRequests);
+
     dmResource::DeletePreloader(pr);
 }
 
@@ -820,6 +913,229 @@ TEST_P(GetResourceTest, PreloadGetAbort)
 }
 
 
+TEST_P(GetResourceTest, PreloadGetLoaderThreads)
+{
+    // Several loader threads, and few slots per preloader
+    dmResource::DeleteFactory(m_Factory);
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+    params.m_LoaderThreadCount = 4;
+    params.m_LoaderQueueSlots = 2;
+    m_Factory = dmResource::NewFactory(&params, GetParam());
+    ASSERT_NE((void*) 0, m_Factory);
+
+    dmResource::Result e;
+    e = dmResource::RegisterType(m_Factory, "cont", this, &ResourceContainerPreload, &ResourceContainerCreate, 0, &ResourceContainerDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    e = dmResource::RegisterType(m_Factory, "foo", this, 0, &FooResourceCreate, &FooResourcePostCreate, &FooResourceDestroy, 0);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+
+    const uint32_t n = 8;
+    dmResource::HPreloader pr[n];
+    for (uint32_t j=0;j<n;j++)
+    {
+        pr[j] = dmResource::NewPreloader(m_Factory, m_ResourceName);
+        dmResource::SetPreloaderPriority(pr[j], (dmResource::LoadPriority) (j % dmResource::LOAD_PRIORITY_COUNT));
+    }
+
+    bool done = false;
+    for (uint32_t j=0;j<100 && !done;j++)
+    {
+        done = true;
+        for (uint32_t k=0;k<n;k++)
+        {
+            dmResource::Result r = dmResource::UpdatePreloader(pr[k], 0, 0, 2000);
+            if (r == dmResource::RESULT_PENDING)
+            {
+                done = false;
+                continue;
+            }
+            ASSERT_EQ(dmResource::RESULT_OK, r);
+        }
+    }
+    ASSERT_TRUE(done);
+
+    TestResourceContainer* resource = 0;
+    e = dmResource::Get(m_Factory, m_ResourceName, (void**) &resource);
+    ASSERT_EQ(dmResource::RESULT_OK, e);
+    ASSERT_EQ(1U, m_ResourceContainerCreateCallCount);
+    ASSERT_EQ(2U, m_FooResourceCreateCallCount);
+
+    for (uint32_t j=0;j<n;j++)
+    {
+        dmResource::DeletePreloader(pr[j]);
+    }
+    dmResource::Release(m_Factory, resource);
+}
+
+struct LoadOrder
+{
+    const char* m_Names[8];
+    uint32_t    m_Count;
+};
+
+struct RecordedLoad
+{
+    LoadOrder*            m_Order;
+    const char*           m_Name;
+    dmLoadQueue::HQueue   m_Queue;
+    dmLoadQueue::HRequest m_Request;
+};
+
+static dmResource::Result RecordLoadOrderPreload(const dmResource::ResourcePreloadParams& params)
+{
+    RecordedLoad* load = (RecordedLoad*) params.m_Context;
+    load->m_Order->m_Names[load->m_Order->m_Count++] = load->m_Name;
+    return dmResource::RESULT_OK;
+}
+
+static void BeginRecordedLoad(RecordedLoad* load, dmLoadQueue::HQueue queue, const char* name, LoadOrder* order)
+{
+    load->m_Order = order;
+    load->m_Name = name;
+    load->m_Queue = queue;
+
+    dmLoadQueue::PreloadInfo info;
+    memset(&info, 0, sizeof(info));
+    info.m_Function = RecordLoadOrderPreload;
+    info.m_Context = load;
+    load->m_Request = dmLoadQueue::BeginLoad(queue, name, name, &info);
+}
+
+static dmLoadQueue::LoadResult EndRecordedLoad(RecordedLoad* load)
+{
+    void* buf;
+    uint32_t size;
+    dmLoadQueue::LoadResult result;
+    while (dmLoadQueue::EndLoad(load->m_Queue, load->m_Request, &buf, &size, &result) == dmLoadQueue::RESULT_PENDING)
+    {
+        dmTime::Sleep(1000);
+    }
+    dmLoadQueue::FreeLoad(load->m_Queue, load->m_Request);
+    return result;
+}
+
+TEST_P(GetResourceTest, LoadQueuePriority)
+{
+    LoadOrder order;
+    order.m_Count = 0;
+
+    dmLoadQueue::HQueue low = dmLoadQueue::CreateQueue(m_Factory);
+    dmLoadQueue::HQueue high = dmLoadQueue::CreateQueue(m_Factory);
+    dmLoadQueue::SetPriority(low, dmResource::LOAD_PRIORITY_LOW);
+    dmLoadQueue::SetPriority(high, dmResource::LOAD_PRIORITY_HIGH);
+
+    RecordedLoad loads[3];
+    {
+        // Stall the (single) loader thread, so all requests are queued before it can pick the next one
+        dmMutex::ScopedLock lk(dmResource::GetLoadMutex(m_Factory));
+        BeginRecordedLoad(&loads[0], low, "/test01.foo", &order);
+        BeginRecordedLoad(&loads[1], low, "/test02.foo", &order);
+        BeginRecordedLoad(&loads[2], high, "/test.cont", &order);
+    }
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        ASSERT_NE((dmLoadQueue::HRequest) 0, loads[i].m_Request);
+    }
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        dmLoadQueue::LoadResult result = EndRecordedLoad(&loads[i]);
+        ASSERT_EQ(dmResource::RESULT_OK, result.m_LoadResult);
+        ASSERT_EQ(dmResource::RESULT_OK, result.m_PreloadResult);
+    }
+
+    // The first low priority request might have been picked up before the others were queued,
+    // but the high priority request must be loaded before the second one
+    ASSERT_EQ(3U, order.m_Count);
+    ASSERT_STREQ("/test02.foo", order.m_Names[2]);
+
+    dmLoadQueue::DeleteQueue(low);
+    dmLoadQueue::DeleteQueue(high);
+}
+
+TEST_P(GetResourceTest, LoadQueueBench)
+{
+    // Raw load throughput (load + decompress) with different number of loader threads.
+    // Each load queue keeps loading the same small set of resources over and over again
+    const char* names[] = {"/test.cont", "/test01.foo", "/test02.foo", "/many_refs.cont", "/self_referring.cont"};
+    const uint32_t name_count = sizeof(names) / sizeof(names[0]);
+    const uint32_t queue_count = 8;
+    const uint32_t loads_per_queue = 512;
+    const uint32_t thread_counts[] = {1, 2, 4};
+
+    if (strstr(GetParam(), "http") == GetParam())
+    {
+        return; // Loads over http are serialized
+    }
+
+    printf("Load queue, %u loads from '%s'\n", queue_count * loads_per_queue, GetParam());
+    for (uint32_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); ++t)
+    {
+        dmResource::DeleteFactory(m_Factory);
+        dmResource::NewFactoryParams params;
+        params.m_MaxResources = 16;
+        params.m_LoaderThreadCount = thread_counts[t];
+        m_Factory = dmResource::NewFactory(&params, GetParam());
+        ASSERT_NE((void*) 0, m_Factory);
+
+        dmLoadQueue::HQueue queues[queue_count];
+        uint32_t issued[queue_count];
+        uint32_t completed[queue_count];
+        dmLoadQueue::HRequest requests[queue_count][2];
+        for (uint32_t q = 0; q < queue_count; ++q)
+        {
+            queues[q] = dmLoadQueue::CreateQueue(m_Factory);
+            issued[q] = 0;
+            completed[q] = 0;
+        }
+
+        uint64_t start = dmTime::GetTime();
+        bool done = false;
+        while (!done)
+        {
+            done = true;
+            for (uint32_t q = 0; q < queue_count; ++q)
+            {
+                // Two requests in flight per queue
+                while (issued[q] < loads_per_queue && issued[q] - completed[q] < 2)
+                {
+                    const char* name = names[issued[q] % name_count];
+                    dmLoadQueue::PreloadInfo info;
+                    memset(&info, 0, sizeof(info));
+                    dmLoadQueue::HRequest request = dmLoadQueue::BeginLoad(queues[q], name, name, &info);
+                    ASSERT_NE((dmLoadQueue::HRequest) 0, request);
+                    requests[q][issued[q] % 2] = request;
+                    issued[q]++;
+                }
+
+                if (completed[q] < issued[q])
+                {
+                    void* buf;
+                    uint32_t size;
+                    dmLoadQueue::LoadResult result;
+                    dmLoadQueue::HRequest request = requests[q][completed[q] % 2];
+                    if (dmLoadQueue::EndLoad(queues[q], request, &buf, &size, &result) == dmLoadQueue::RESULT_OK)
+                    {
+                        ASSERT_EQ(dmResource::RESULT_OK, result.m_LoadResult);
+                        dmLoadQueue::FreeLoad(queues[q], request);
+                        completed[q]++;
+                    }
+                }
+                done = done && completed[q] == loads_per_queue;
+            }
+        }
+        uint64_t elapsed = dmTime::GetTime() - start;
+
+        for (uint32_t q = 0; q < queue_count; ++q)
+        {
+            dmLoadQueue::DeleteQueue(queues[q]);
+        }
+        printf("  %u loader thread(s): %f ms\n", thread_counts[t], elapsed / 1000.0f);
+    }
+}
+
+
 dmResource::Result RecreateResourceCreate(const dmResource::ResourceCreateParams& params)
 {
     const int TMP_BUFFER_SIZE = 64;
@@ -936,6 +1252,66 @@ TEST(dmResource, Builtins)
     dmResource::DeleteFactory(factory);
 }
 
+static dmResource::Result AdViewResourceCreate(const dmResource::ResourceCreateParams& params)
+{
+    // Count the buffers that point straight into the archive data
+    uint32_t* view_count = (uint32_t*) params.m_Context;
+    const uint8_t* buffer = (const uint8_t*) params.m_Buffer;
+    if (buffer >= RESOURCES_ARCD && buffer + params.m_BufferSize <= RESOURCES_ARCD + RESOURCES_ARCD_SIZE)
+    {
+        ++*view_count;
+    }
+    return AdResourceCreate(params);
+}
+
+TEST(dmResource, BuiltinsViews)
+{
+    dmResource::NewFactoryParams params;
+    params.m_MaxResources = 16;
+
+    params.m_ArchiveIndex.m_Data    = (const void*) RESOURCES_ARCI;
+    params.m_ArchiveIndex.m_Size    = RESOURCES_ARCI_SIZE;
+
+    params.m_ArchiveData.m_Data     = (const void*) RESOURCES_ARCD;
+    params.m_ArchiveData.m_Size     = RESOURCES_ARCD_SIZE;
+
+    params.m_ArchiveManifest.m_Data = (const void*) RESOURCES_DMANIFEST;
+    params.m_ArchiveManifest.m_Size = RESOURCES_DMANIFEST_SIZE;
+
+    dmResource::HFactory factory = dmResource::NewFactory(&params, ".");
+    ASSERT_NE((void*) 0, factory);
+
+    ASSERT_EQ(dmResource::RESULT_UNKNOWN_RESOURCE_TYPE, dmResource::SetTypeBufferViews(factory, "adc", true));
+
+    uint32_t view_count = 0;
+    dmResource::RegisterType(factory, "adc", &view_count, 0, AdViewResourceCreate, 0, AdResourceDestroy, 0);
+
+    const char* path_name[] = { "/archive_data/file1.adc", "/archive_data/file3.adc" };
+    const char* content[]   = { "file1_datafile1_datafile1_data", "file3_data" };
+
+    // Copied by default
+    void* resource;
+    dmResource::Result result = dmResource::Get(factory, path_name[0], &resource);
+    ASSERT_EQ(dmResource::RESULT_OK, result);
+    ASSERT_STREQ(content[0], (const char*) resource);
+    dmResource::Release(factory, resource);
+    ASSERT_EQ(0u, view_count);
+
+    ASSERT_EQ(dmResource::RESULT_OK, dmResource::SetTypeBufferViews(factory, "adc", true));
+
+    for (uint32_t i = 0; i < (sizeof(path_name) / sizeof(path_name[0])); ++i)
+    {
+        result = dmResource::Get(factory, path_name[i], &resource);
+        ASSERT_EQ(dmResource::RESULT_OK, result);
+        ASSERT_STREQ(content[i], (const char*) resource);
+
+        dmResource::Release(factory, resource);
+    }
+    ASSERT_EQ(2u, view_count);
+
+    dmResource::DeleteFactory(factory);
+}
+
 struct ReloadData {
     ReloadData(): m_Old(0), m_New(0) {}
     int m_Old;
@@ -717,6 +717,96 @@ TEST(dmResourceArchive, LoadFromDisk_Compressed)
     dmResourceArchive::Delete(archive);
 }
 
+static void VerifyReadRaw(dmResourceArchive::HArchiveIndexContainer archive)
+{
+    dmResourceArchive::EntryData entry;
+    for (uint32_t i = 0; i < sizeof(path_name)/sizeof(path_name[0]); ++i)
+    {
+        if (IsLiveUpdateResource(path_hash[i])) continue;
+
+        dmResourceArchive::Result result = dmResourceArchive::FindEntry(archive, compressed_content_hash[i], &entry);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        char raw_buffer[1024] = { 0 };
+        char buffer[1024] = { 0 };
+        ASSERT_GE(sizeof(raw_buffer), dmResourceArchive::GetStoredSize(&entry));
+        result = dmResourceArchive::ReadRaw(archive, &entry, raw_buffer);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        result = dmResourceArchive::DecodeRaw(&entry, raw_buffer, buffer);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        ASSERT_EQ(strlen(content[i]), strlen(buffer));
+        ASSERT_STREQ(content[i], buffer);
+    }
+}
+
+TEST(dmResourceArchive, ReadRaw_Compressed)
+{
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_COMPRESSED_ARCI, (void*) RESOURCES_COMPRESSED_ARCD, 0x0, 0x0, 0x0, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    VerifyReadRaw(archive);
+    dmResourceArchive::Delete(archive);
+
+    const char* archive_path = "build/default/src/test/resources_compressed.arci";
+    const char* resource_path = "build/default/src/test/resources_compressed.arcd";
+    result = dmResourceArchive::LoadArchive(archive_path, resource_path, 0x0, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    VerifyReadRaw(archive);
+    dmResourceArchive::Delete(archive);
+}
+
+static void VerifyView(dmResourceArchive::HArchiveIndexContainer archive, const uint8_t (*hashes)[20], const void* resource_data, uint32_t* view_count)
+{
+    *view_count = 0;
+    dmResourceArchive::EntryData entry;
+    for (uint32_t i = 0; i < sizeof(path_name)/sizeof(path_name[0]); ++i)
+    {
+        if (IsLiveUpdateResource(path_hash[i])) continue;
+
+        dmResourceArchive::Result result = dmResourceArchive::FindEntry(archive, hashes[i], &entry);
+        ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+
+        const char* view = (const char*) dmResourceArchive::GetView(archive, &entry);
+        bool viewable = resource_data != 0 && entry.m_ResourceCompressedSize == 0xFFFFFFFF && !(entry.m_Flags & dmResourceArchive::ENTRY_FLAG_ENCRYPTED);
+        ASSERT_EQ(viewable, view != 0);
+        if (view)
+        {
+            // The view points straight into the archive data
+            ASSERT_EQ((const char*) resource_data + entry.m_ResourceDataOffset, view);
+            ASSERT_EQ(strlen(content[i]), entry.m_ResourceSize);
+            ASSERT_EQ(0, memcmp(content[i], view, entry.m_ResourceSize));
+            ++*view_count;
+        }
+    }
+}
+
+TEST(dmResourceArchive, GetView)
+{
+    dmResourceArchive::HArchiveIndexContainer archive = 0;
+    dmResourceArchive::Result result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_ARCI, RESOURCES_ARCD, 0x0, 0x0, 0x0, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    uint32_t view_count;
+    VerifyView(archive, content_hash, RESOURCES_ARCD, &view_count);
+    ASSERT_EQ(4U, view_count); // The .adc files, the script is encrypted
+    dmResourceArchive::Delete(archive);
+
+    result = dmResourceArchive::WrapArchiveBuffer((void*) RESOURCES_COMPRESSED_ARCI, (void*) RESOURCES_COMPRESSED_ARCD, 0x0, 0x0, 0x0, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    VerifyView(archive, compressed_content_hash, RESOURCES_COMPRESSED_ARCD, &view_count);
+    dmResourceArchive::Delete(archive);
+
+    // Archives loaded from file are not memory mapped, the resources must be read
+    const char* archive_path = "build/default/src/test/resources.arci";
+    const char* resource_path = "build/default/src/test/resources.arcd";
+    result = dmResourceArchive::LoadArchive(archive_path, resource_path, 0x0, &archive);
+    ASSERT_EQ(dmResourceArchive::RESULT_OK, result);
+    VerifyView(archive, content_hash, 0, &view_count);
+    ASSERT_EQ(0U, view_count);
+    dmResourceArchive::Delete(archive);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -14,6 +14,7 @@
 
 #include <dlib/log.h>
 #include <dlib/profile.h>
+#include <dlib/simd.h>
 
 namespace dmRig
 {
@@ -23,10 +24,11 @@ namespace dmRig
     static const float CURSOR_EPSILON = 0.0001f;
     static const int SIGNAL_DELTA_UNCHANGED = 0x10cced; // Used to indicate if a draw order was unchanged for a certain slot
     static const uint32_t INVALID_ATTACHMENT_INDEX = 0xffffffffu;
+    static const uint32_t ANIMATE_BATCH_SIZE = 8;
 
     static const float white[] = {1.0f, 1.0f, 1.0, 1.0f};
 
-    static void DoAnimate(HRigContext context, RigInstance* instance, float dt);
+    static void DoAnimate(RigInstance* instance, float dt);
     static bool DoPostUpdate(RigInstance* instance);
     static void UpdateSlotDrawOrder(dmArray<int32_t>& draw_order, dmArray<int32_t>& deltas, int changed, dmArray<int32_t>& unchanged);
 
@@ -39,8 +41,7 @@ namespace dmRig
         }
 
         context->m_Instances.SetCapacity(params.m_MaxRigInstanceCount);
-        context->m_ScratchPoseTransformBuffer.SetCapacity(0);
-        context->m_ScratchPoseMatrixBuffer.SetCapacity(0);
+        context->m_WorkerPool = params.m_WorkerPool;
 
         return dmRig::RESULT_OK;
     }
@@ -127,6 +128,8 @@ namespace dmRig
             player->m_Playing = 0;
         }
 
+        instance->m_AnimationVersion++;
+
         RigPlayer* player = SwitchPlayer(instance);
         player->m_Initial = 1;
         player->m_BlendFinished = blend_duration > 0.0f ? 0 : 1;
@@ -152,6 +155,7 @@ namespace dmRig
     {
         RigPlayer* player = GetPlayer(instance);
         player->m_Playing = 0;
+        instance->m_AnimationVersion++;
 
         return dmRig::RESULT_OK;
     }
@@ -270,6 +274,22 @@ namespace dmRig
         return duration;
     }
 
+    // Queue an event on the instance, it is posted to the event callback once all instances have been animated
+    static RigEvent* QueueEvent(HRigInstance instance, RigEventType type)
+    {
+        dmArray<RigEvent>& events = instance->m_Events;
+        if (events.Full())
+        {
+            events.OffsetCapacity(dmMath::Max(4U, events.Capacity()));
+        }
+        events.SetSize(events.Size() + 1);
+        RigEvent* event = &events.Back();
+        event->m_Instance = instance;
+        event->m_AnimationVersion = instance->m_AnimationVersion;
+        event->m_Type = type;
+        return event;
+    }
+
     static void PostEventsInterval(HRigInstance instance, const dmRigDDF::RigAnimation* animation, float start_cursor, float end_cursor, float duration, bool backwards, float blend_weight)
     {
         const uint32_t track_count = animation->m_EventTracks.m_Count;
@@ -285,7 +305,7 @@ namespace dmRig
                     cursor = duration - cursor;
                 if (start_cursor <= cursor && cursor < end_cursor)
                 {
-                    RigKeyframeEventData event_data;
+                    RigKeyframeEventData& event_data = QueueEvent(instance, RIG_EVENT_TYPE_KEYFRAME)->m_Keyframe;
                     event_data.m_EventId = track->m_EventId;
                     event_data.m_AnimationId = animation->m_Id;
                     event_data.m_BlendWeight = blend_weight;
@@ -293,8 +313,6 @@ namespace dmRig
                     event_data.m_Integer = key->m_Integer;
                     event_data.m_Float = key->m_Float;
                     event_data.m_String = key->m_String;
-
-                    instance->m_EventCallback(RIG_EVENT_TYPE_KEYFRAME, (void*)&event_data, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
                 }
             }
         }
@@ -405,11 +423,9 @@ namespace dmRig
             // Only report completeness for the primary player
             if (player == GetPlayer(instance) && instance->m_EventCallback)
             {
-                RigCompletedEventData event_data;
+                RigCompletedEventData& event_data = QueueEvent(instance, RIG_EVENT_TYPE_COMPLETED)->m_Completed;
                 event_data.m_AnimationId = player->m_AnimationId;
                 event_data.m_Playback = player->m_Playback;
-
-                instance->m_EventCallback(RIG_EVENT_TYPE_COMPLETED, (void*)&event_data, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
             }
         }
 
@@ -511,7 +527,7 @@ namespace dmRig
         child_t.SetRotation( dmVMath::QuatFromAngle(2, childRotation) );
     }
 
-    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
+    static void ApplyAnimation(RigPlayer* player, dmArray<dmTransform::Transform>& pose, uint32_t bone_count, const dmArray<uint32_t>& track_idx_to_pose, dmArray<IKAnimation>& ik_animation, dmArray<MeshSlotPose>& mesh_slot_pose, bool update_draw_order, dmArray<int32_t>& draw_order, int& slot_changed, float blend_weight)
     {
         const dmRigDDF::RigAnimation* animation = player->m_Animation;
         if (animation == 0x0)
@@ -533,6 +549,9 @@ namespace dmRig
                 continue;
             }
             uint32_t pose_index = track_idx_to_pose[bone_index];
+            if (pose_index >= bone_count) {
+                continue;
+            }
             dmTransform::Transform& transform = pose[pose_index];
             if (track->m_Positions.m_Count > 0)
             {
@@ -598,31 +617,129 @@ namespace dmRig
         }
     }
 
+    struct AnimateJob
+    {
+        RigInstance* const* m_Instances;
+        float               m_DT;
+    };
+
+    static void AnimateInstances(void* _job, uint32_t begin, uint32_t end)
+    {
+        AnimateJob* job = (AnimateJob*)_job;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            RigInstance* instance = job->m_Instances[i];
+            float dt = job->m_DT + instance->m_SkippedDT;
+            if (instance->m_UpdateInterval > 1 && ++instance->m_UpdateCounter < instance->m_UpdateInterval)
+            {
+                instance->m_SkippedDT = dt;
+                instance->m_PoseSkipped = 1;
+                continue;
+            }
+            instance->m_UpdateCounter = 0;
+            instance->m_SkippedDT = 0.0f;
+            DoAnimate(instance, dt);
+        }
+    }
+
+    static void FlushEvents(HRigContext context)
+    {
+        DM_PROFILE(Rig, "FlushEvents");
+
+        // Gather the events before posting any of them, since the callbacks might create or destroy instances
+        dmArray<RigEvent>& events = context->m_Events;
+        events.SetSize(0);
+        const dmArray<RigInstance*>& instances = context->m_Instances.m_Objects;
+        uint32_t n = instances.Size();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            dmArray<RigEvent>& instance_events = instances[i]->m_Events;
+            uint32_t count = instance_events.Size();
+            if (count == 0)
+                continue;
+            if (events.Remaining() < count)
+            {
+                events.OffsetCapacity(dmMath::Max(count - events.Remaining(), events.Capacity()));
+            }
+            events.PushArray(instance_events.Begin(), count);
+            instance_events.SetSize(0);
+        }
+
+        // A callback might destroy an instance (see DestroyInstance), change its event callback or play another
+        // animation on it, so the callback is resolved per event and events of a previous animation are dropped
+        uint32_t event_count = events.Size();
+        for (uint32_t i = 0; i < event_count; ++i)
+        {
+            RigEvent& event = events[i];
+            RigInstance* instance = event.m_Instance;
+            if (!instance || !instance->m_EventCallback || instance->m_AnimationVersion != event.m_AnimationVersion)
+                continue;
+            void* event_data = event.m_Type == RIG_EVENT_TYPE_KEYFRAME ? (void*)&event.m_Keyframe : (void*)&event.m_Completed;
+            instance->m_EventCallback(event.m_Type, event_data, instance->m_EventCBUserData1, instance->m_EventCBUserData2);
+        }
+        events.SetSize(0);
+    }
+
     static void Animate(HRigContext context, float dt)
     {
         DM_PROFILE(Rig, "Animate");
 
+        // The instances are animated independently of each other, possibly on the worker threads.
+        // Any events raised are queued on the instances and posted afterwards on the calling thread.
         const dmArray<RigInstance*>& instances = context->m_Instances.m_Objects;
         uint32_t n = instances.Size();
-        for (uint32_t i = 0; i < n; ++i)
+        if (n == 0)
+            return;
+
+        AnimateJob job;
+        job.m_Instances = &instances[0];
+        job.m_DT = dt;
+        dmWorkerPool::ParallelFor(context->m_WorkerPool, n, ANIMATE_BATCH_SIZE, AnimateInstances, &job);
+
+        FlushEvents(context);
+    }
+
+    // Advance the players of a culled instance, i.e. the cursors, blending and events, without evaluating the pose
+    static void UpdatePlayers(RigInstance* instance, float dt)
+    {
+        UpdateBlend(instance, dt);
+
+        RigPlayer* player = GetPlayer(instance);
+        if (instance->m_Blending)
         {
-            RigInstance* instance = instances[i];
-            DoAnimate(context, instance, dt);
+            float fade_rate = instance->m_BlendTimer / instance->m_BlendDuration;
+            for (uint32_t pi = 0; pi < 2; ++pi)
+            {
+                RigPlayer* p = &instance->m_Players[pi];
+                UpdatePlayer(instance, p, dt, player == p ? fade_rate : 1.0f - fade_rate);
+            }
+        }
+        else
+        {
+            UpdatePlayer(instance, player, dt, 1.0f);
         }
     }
 
-    static void DoAnimate(HRigContext context, RigInstance* instance, float dt)
+    static void DoAnimate(RigInstance* instance, float dt)
     {
             // NOTE we previously checked for (!instance->m_Enabled || !instance->m_AddedToUpdate) here also
             if (instance->m_Pose.Empty() || !instance->m_Enabled)
                 return;
 
+            instance->m_PoseSkipped = instance->m_Culled;
+            if (instance->m_Culled)
+            {
+                UpdatePlayers(instance, dt);
+                return;
+            }
+
             const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
             const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
             const dmArray<uint32_t>& track_idx_to_pose = *instance->m_TrackIdxToPose;
             dmArray<dmTransform::Transform>& pose = instance->m_Pose;
             // Reset pose
             uint32_t bone_count = pose.Size();
+            uint32_t lod_bone_count = instance->m_LODBoneCount == 0 ? bone_count : dmMath::Min(instance->m_LODBoneCount, bone_count);
             for (uint32_t bi = 0; bi < bone_count; ++bi)
             {
                 pose[bi].SetIdentity();
@@ -650,15 +767,16 @@ namespace dmRig
             // Make sure we have enough space in the draw order deltas scratch buffer.
             uint32_t slot_count = instance->m_MeshSet->m_SlotCount;
             int slot_changed = 0;
-            if (context->m_ScratchDrawOrderDeltas.Capacity() < slot_count) {
-                context->m_ScratchDrawOrderDeltas.OffsetCapacity(slot_count - context->m_ScratchDrawOrderDeltas.Capacity());
+            dmArray<int32_t>& draw_order_deltas = instance->m_DrawOrderDeltas;
+            if (draw_order_deltas.Capacity() < slot_count) {
+                draw_order_deltas.OffsetCapacity(slot_count - draw_order_deltas.Capacity());
             }
-            context->m_ScratchDrawOrderDeltas.SetSize(slot_count);
+            draw_order_deltas.SetSize(slot_count);
 
             // Reset draw order deltas to "unchanged" constant.
             for (uint32_t i = 0; i < slot_count; i++) {
                 instance->m_DrawOrder[i] = i;
-                context->m_ScratchDrawOrderDeltas[i] = SIGNAL_DELTA_UNCHANGED;
+                draw_order_deltas[i] = SIGNAL_DELTA_UNCHANGED;
             }
 
             if (instance->m_Blending)
@@ -685,7 +803,7 @@ namespace dmRig
 
                     UpdatePlayer(instance, p, dt, blend_weight);
                     bool draw_order = player == p ? fade_rate >= 0.5f : fade_rate < 0.5f;
-                    ApplyAnimation(p, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, context->m_ScratchDrawOrderDeltas, slot_changed, alpha);
+                    ApplyAnimation(p, pose, lod_bone_count, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, draw_order, draw_order_deltas, slot_changed, alpha);
                     if (player == p)
                     {
                         alpha = 1.0f - fade_rate;
@@ -699,12 +817,12 @@ namespace dmRig
             else
             {
                 UpdatePlayer(instance, player, dt, 1.0f);
-                ApplyAnimation(player, pose, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, context->m_ScratchDrawOrderDeltas, slot_changed, 1.0f);
+                ApplyAnimation(player, pose, lod_bone_count, track_idx_to_pose, ik_animation, instance->m_MeshSlotPose, true, draw_order_deltas, slot_changed, 1.0f);
             }
 
             // Update draw order after animation
             if (slot_changed > 0) {
-                UpdateSlotDrawOrder(instance->m_DrawOrder, context->m_ScratchDrawOrderDeltas, slot_changed, context->m_ScratchDrawOrderUnchanged);
+                UpdateSlotDrawOrder(instance->m_DrawOrder, draw_order_deltas, slot_changed, instance->m_DrawOrderUnchanged);
             }
 
             for (uint32_t bi = 0; bi < bone_count; ++bi)
@@ -732,6 +850,9 @@ namespace dmRig
 
                 for (uint32_t i = 0; i < count; ++i) {
                     const dmRigDDF::IK* ik = &skeleton->m_Iks[i];
+                    // Skip constraints involving bones that aren't sampled at the current level of detail
+                    if (ik->m_Parent >= lod_bone_count || ik->m_Child >= lod_bone_count || ik->m_Target >= lod_bone_count)
+                        continue;
 
                     // transform local space hiearchy for pose
                     dmTransform::Transform parent_t = GetPoseTransform(bind_pose, pose, pose[ik->m_Parent], ik->m_Parent);
@@ -798,7 +919,7 @@ namespace dmRig
     {
             // If pose is empty, there are no bones to update
             dmArray<dmTransform::Transform>& pose = instance->m_Pose;
-            if (pose.Empty())
+            if (pose.Empty() || instance->m_PoseSkipped)
                 return false;
 
             // Notify any listener that the pose has been recalculated
@@ -1013,7 +1134,7 @@ namespace dmRig
 
     uint32_t GetVertexCount(HRigInstance instance)
     {
-        if (!instance->m_MeshEntry || !instance->m_DoRender) {
+        if (!instance->m_MeshEntry || !instance->m_DoRender || instance->m_Culled) {
             return 0;
         }
 
@@ -1039,26 +1160,60 @@ namespace dmRig
         return vertex_count;
     }
 
+    // Loads the columns of a matrix
+    static inline void LoadMatrix(const Matrix4& m, dmSIMD::Vector4f* c)
+    {
+        const float* p = (const float*) &m;
+        c[0] = dmSIMD::Load(p + 0);
+        c[1] = dmSIMD::Load(p + 4);
+        c[2] = dmSIMD::Load(p + 8);
+        c[3] = dmSIMD::Load(p + 12);
+    }
+
+    // c0..c3 * Point3(x, y, z), same operation order as Matrix4 * Point3 (and Matrix4 * Vector4 with w = 1)
+    static inline dmSIMD::Vector4f MulPoint(const dmSIMD::Vector4f* c, dmSIMD::Vector4f x, dmSIMD::Vector4f y, dmSIMD::Vector4f z)
+    {
+        using namespace dmSIMD;
+        return Add(Add(Add(Mul(c[0], x), Mul(c[1], y)), Mul(c[2], z)), c[3]);
+    }
+
+    // c0..c3 * Vector3(x, y, z), same operation order as Matrix4 * Vector3
+    static inline dmSIMD::Vector4f MulVector(const dmSIMD::Vector4f* c, dmSIMD::Vector4f x, dmSIMD::Vector4f y, dmSIMD::Vector4f z)
+    {
+        using namespace dmSIMD;
+        return Add(Add(Mul(c[0], x), Mul(c[1], y)), Mul(c[2], z));
+    }
+
+    static inline float* StoreXYZ(float* out, dmSIMD::Vector4f v)
+    {
+        float tmp[4];
+        dmSIMD::Store(tmp, v);
+        out[0] = tmp[0];
+        out[1] = tmp[1];
+        out[2] = tmp[2];
+        return out + 3;
+    }
+
+    // The vertex influences are blended four floats at a time, with the same operation order as the vectormath code.
+    // The bone weights are sorted in descending order, so the blending stops at the first zero weight.
+    // NOTE: The normals are not renormalized
     static float* GenerateNormalData(const dmRigDDF::Mesh* mesh, const Matrix4& normal_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
     {
+        using namespace dmSIMD;
         const float* normals_in = mesh->m_Normals.m_Data;
         const uint32_t* normal_indices = mesh->m_NormalsIndices.m_Data;
         uint32_t index_count = mesh->m_PositionIndices.m_Count;
-        Vector4 v;
+
+        Vector4f n[4];
+        LoadMatrix(normal_matrix, n);
 
         if (!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
         {
             for (uint32_t ii = 0; ii < index_count; ++ii)
             {
-                uint32_t ni = normal_indices[ii];
-                Vector3 normal_in(normals_in[ni*3+0], normals_in[ni*3+1], normals_in[ni*3+2]);
-                v = normal_matrix * normal_in;
-                if (lengthSqr(v) > 0.0f) {
-                    normalize(v);
-                }
-                *out_buffer++ = v[0];
-                *out_buffer++ = v[1];
-                *out_buffer++ = v[2];
+                const float* normal_in = &normals_in[normal_indices[ii]*3];
+                Vector4f v = MulVector(n, Splat(normal_in[0]), Splat(normal_in[1]), Splat(normal_in[2]));
+                out_buffer = StoreXYZ(out_buffer, v);
             }
             return out_buffer;
         }
@@ -1066,40 +1221,29 @@ namespace dmRig
         const uint32_t* indices = mesh->m_BoneIndices.m_Data;
         const float* weights = mesh->m_Weights.m_Data;
         const uint32_t* vertex_indices = mesh->m_PositionIndices.m_Data;
+        const Matrix4* matrices = &pose_matrices[0];
+        Vector4f zero = Splat(0.0f);
+        Vector4f c[4];
         for (uint32_t ii = 0; ii < index_count; ++ii)
         {
-            const uint32_t ni = normal_indices[ii]*3;
-            const Vector3 normal_in(normals_in[ni+0], normals_in[ni+1], normals_in[ni+2]);
-            Vector4 normal_out(0.0f, 0.0f, 0.0f, 0.0f);
+            const float* normal_in = &normals_in[normal_indices[ii]*3];
+            Vector4f x = Splat(normal_in[0]);
+            Vector4f y = Splat(normal_in[1]);
+            Vector4f z = Splat(normal_in[2]);
 
             const uint32_t bi_offset = vertex_indices[ii] << 2;
             const uint32_t* bone_indices = &indices[bi_offset];
             const float* bone_weights = &weights[bi_offset];
 
-            if (bone_weights[0])
+            Vector4f normal_out = zero;
+            for (uint32_t i = 0; i < 4 && bone_weights[i]; ++i)
             {
-                normal_out += (pose_matrices[bone_indices[0]] * normal_in) * bone_weights[0];
-                if (bone_weights[1])
-                {
-                    normal_out += (pose_matrices[bone_indices[1]] * normal_in) * bone_weights[1];
-                    if (bone_weights[2])
-                    {
-                        normal_out += (pose_matrices[bone_indices[2]] * normal_in) * bone_weights[2];
-                        if (bone_weights[3])
-                        {
-                            normal_out += (pose_matrices[bone_indices[3]] * normal_in) * bone_weights[3];
-                        }
-                    }
-                }
+                LoadMatrix(matrices[bone_indices[i]], c);
+                normal_out = Add(normal_out, Mul(MulVector(c, x, y, z), Splat(bone_weights[i])));
             }
 
-            v = normal_matrix * Vector3(normal_out.getX(), normal_out.getY(), normal_out.getZ());
-            if (lengthSqr(v) > 0.0f) {
-                normalize(v);
-            }
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+            Vector4f v = MulVector(n, SplatX(normal_out), SplatY(normal_out), SplatZ(normal_out));
+            out_buffer = StoreXYZ(out_buffer, v);
         }
 
         return out_buffer;
@@ -1107,121 +1251,143 @@ namespace dmRig
 
     static float* GeneratePositionData(const dmRigDDF::Mesh* mesh, const Matrix4& model_matrix, const dmArray<Matrix4>& pose_matrices, float* out_buffer)
     {
+        using namespace dmSIMD;
         const float *positions = mesh->m_Positions.m_Data;
         const size_t vertex_count = mesh->m_Positions.m_Count / 3;
-        Point3 in_p;
-        Vector4 v;
+
+        Vector4f m[4];
+        LoadMatrix(model_matrix, m);
+
         if(!mesh->m_BoneIndices.m_Count || pose_matrices.Size() == 0)
         {
-            for (uint32_t i = 0; i < vertex_count; ++i)
+            for (uint32_t i = 0; i < vertex_count; ++i, positions += 3)
             {
-                in_p[0] = *positions++;
-                in_p[1] = *positions++;
-                in_p[2] = *positions++;
-                v = model_matrix * in_p;
-                *out_buffer++ = v[0];
-                *out_buffer++ = v[1];
-                *out_buffer++ = v[2];
+                Vector4f v = MulPoint(m, Splat(positions[0]), Splat(positions[1]), Splat(positions[2]));
+                out_buffer = StoreXYZ(out_buffer, v);
             }
             return out_buffer;
         }
 
         const uint32_t* indices = mesh->m_BoneIndices.m_Data;
         const float* weights = mesh->m_Weights.m_Data;
-        for (uint32_t i = 0; i < vertex_count; ++i)
+        const Matrix4* matrices = &pose_matrices[0];
+        Vector4f zero = Splat(0.0f);
+        Vector4f c[4];
+        for (uint32_t i = 0; i < vertex_count; ++i, positions += 3)
         {
-            Vector4 in_v;
-            in_v.setX(*positions++);
-            in_v.setY(*positions++);
-            in_v.setZ(*positions++);
-            in_v.setW(1.0f);
+            Vector4f x = Splat(positions[0]);
+            Vector4f y = Splat(positions[1]);
+            Vector4f z = Splat(positions[2]);
 
-            Vector4 out_p(0.0f, 0.0f, 0.0f, 0.0f);
             const uint32_t bi_offset = i << 2;
             const uint32_t* bone_indices = &indices[bi_offset];
             const float* bone_weights = &weights[bi_offset];
 
-            if(bone_weights[0])
+            Vector4f out_p = zero;
+            for (uint32_t j = 0; j < 4 && bone_weights[j]; ++j)
             {
-                out_p += pose_matrices[bone_indices[0]] * in_v * bone_weights[0];
-                if(bone_weights[1])
-                {
-                    out_p += pose_matrices[bone_indices[1]] * in_v * bone_weights[1];
-                    if(bone_weights[2])
-                    {
-                        out_p += pose_matrices[bone_indices[2]] * in_v * bone_weights[2];
-                        if(bone_weights[3])
-                        {
-                            out_p += pose_matrices[bone_indices[3]] * in_v * bone_weights[3];
-                        }
-                    }
-                }
+                LoadMatrix(matrices[bone_indices[j]], c);
+                out_p = Add(out_p, Mul(MulPoint(c, x, y, z), Splat(bone_weights[j])));
             }
 
-            v = model_matrix * Point3(out_p.getX(), out_p.getY(), out_p.getZ());
-            *out_buffer++ = v[0];
-            *out_buffer++ = v[1];
-            *out_buffer++ = v[2];
+            Vector4f v = MulPoint(m, SplatX(out_p), SplatY(out_p), SplatZ(out_p));
+            out_buffer = StoreXYZ(out_buffer, v);
         }
         return out_buffer;
     }
 
-    static void PoseToMatrix(const dmArray<dmTransform::Transform>& pose, dmArray<Matrix4>& out_matrices)
+    static inline bool IsEqual(const dmTransform::Transform& a, const dmTransform::Transform& b)
     {
-        uint32_t bone_count = pose.Size();
-        for (uint32_t bi = 0; bi < bone_count; ++bi)
-        {
-            out_matrices[bi] = dmTransform::ToMatrix4(pose[bi]);
-        }
-    }
-
-    static void PoseToModelSpace(const dmRigDDF::Skeleton* skeleton, const dmArray<dmTransform::Transform>& pose, dmArray<dmTransform::Transform>& out_pose)
+        Vector3 ta = a.GetTranslation();
+        Vector3 tb = b.GetTranslation();
+        Quat ra = a.GetRotation();
+        Quat rb = b.GetRotation();
+        Vector3 sa = a.GetScale();
+        Vector3 sb = b.GetScale();
+        return ta.getX() == tb.getX() && ta.getY() == tb.getY() && ta.getZ() == tb.getZ() &&
+               ra.getX() == rb.getX() && ra.getY() == rb.getY() && ra.getZ() == rb.getZ() && ra.getW() == rb.getW() &&
+               sa.getX() == sb.getX() && sa.getY() == sb.getY() && sa.getZ() == sb.getZ();
+    }
+
+    // Updates the skinning matrices of the instance, i.e. the model space pose premultiplied with the inverse bind pose,
+    // so they can be directly used to transform each vertex.
+    // The matrices are cached in the instance, and a bone is only recalculated if its local transform,
+    // or the local transform of any of its ancestors, changed since the last update.
+    static void UpdateSkinMatrices(HRigContext context, HRigInstance instance)
     {
+        DM_PROFILE(Rig, "UpdateSkinMatrices");
+        const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
         const dmRigDDF::Bone* bones = skeleton->m_Bones.m_Data;
+        const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
+        const dmArray<dmTransform::Transform>& pose = instance->m_Pose;
+        dmArray<dmTransform::Transform>& cached_pose = instance->m_CachedPose;
+        dmArray<dmTransform::Transform>& model_pose = instance->m_ModelPose;
+        dmArray<Matrix4>& model_pose_matrices = instance->m_ModelPoseMatrices;
+        dmArray<Matrix4>& skin_matrices = instance->m_SkinMatrices;
         uint32_t bone_count = skeleton->m_Bones.m_Count;
-        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        bool local_bone_scaling = skeleton->m_LocalBoneScaling;
+
+        bool valid = skin_matrices.Size() == bone_count;
+        if (!valid)
         {
-            const dmTransform::Transform& transform = pose[bi];
-            dmTransform::Transform& out_transform = out_pose[bi];
-            out_transform = transform;
-            if (bi > 0) {
-                const dmRigDDF::Bone* bone = &bones[bi];
-                if (bone->m_InheritScale)
-                {
-                    out_transform = dmTransform::Mul(out_pose[bone->m_Parent], transform);
-                }
-                else
-                {
-                    Vector3 scale = transform.GetScale();
-                    out_transform = dmTransform::Mul(out_pose[bone->m_Parent], transform);
-                    out_transform.SetScale(scale);
-                }
+            cached_pose.SetCapacity(bone_count);
+            cached_pose.SetSize(bone_count);
+            skin_matrices.SetCapacity(bone_count);
+            skin_matrices.SetSize(bone_count);
+            // Only one of the model space representations is used, depending on the skeleton
+            if (local_bone_scaling) {
+                model_pose.SetCapacity(bone_count);
+                model_pose.SetSize(bone_count);
+            } else {
+                model_pose_matrices.SetCapacity(bone_count);
+                model_pose_matrices.SetSize(bone_count);
             }
         }
-    }
 
-    static void PoseToModelSpace(const dmRigDDF::Skeleton* skeleton, const dmArray<Matrix4>& pose, dmArray<Matrix4>& out_pose)
-    {
-        const dmRigDDF::Bone* bones = skeleton->m_Bones.m_Data;
-        uint32_t bone_count = skeleton->m_Bones.m_Count;
+        dmArray<uint8_t>& changed = context->m_ScratchBoneChanged;
+        if (changed.Capacity() < bone_count) {
+            changed.OffsetCapacity(bone_count - changed.Capacity());
+        }
+        changed.SetSize(bone_count);
+
+        // The bones are sorted so that a parent always comes before its children
         for (uint32_t bi = 0; bi < bone_count; ++bi)
         {
-            const Matrix4& transform = pose[bi];
-            Matrix4& out_transform = out_pose[bi];
-            out_transform = transform;
-            if (bi > 0) {
-                const dmRigDDF::Bone* bone = &bones[bi];
-                if (bone->m_InheritScale)
-                {
-                    out_transform = out_pose[bone->m_Parent] * transform;
+            const dmTransform::Transform& transform = pose[bi];
+            const dmRigDDF::Bone* bone = &bones[bi];
+            bool c = !valid || !IsEqual(transform, cached_pose[bi]) || (bi > 0 && changed[bone->m_Parent]);
+            changed[bi] = c;
+            if (!c) {
+                continue;
+            }
+            cached_pose[bi] = transform;
+
+            Matrix4 model_matrix;
+            if (local_bone_scaling) {
+                dmTransform::Transform& out_transform = model_pose[bi];
+                out_transform = transform;
+                if (bi > 0) {
+                    out_transform = dmTransform::Mul(model_pose[bone->m_Parent], transform);
+                    if (!bone->m_InheritScale)
+                    {
+                        out_transform.SetScale(transform.GetScale());
+                    }
                 }
-                else
-                {
-                    Vector3 scale = dmTransform::ExtractScale(out_pose[bone->m_Parent]);
-                    out_transform.setUpper3x3(Matrix3::scale(Vector3(1.0f/scale.getX(), 1.0f/scale.getY(), 1.0f/scale.getZ())) * transform.getUpper3x3());
-                    out_transform = out_pose[bone->m_Parent] * transform;
+                model_matrix = dmTransform::ToMatrix4(out_transform);
+            } else {
+                model_matrix = dmTransform::ToMatrix4(transform);
+                if (bi > 0) {
+                    const Matrix4& parent_matrix = model_pose_matrices[bone->m_Parent];
+                    if (!bone->m_InheritScale)
+                    {
+                        Vector3 scale = dmTransform::ExtractScale(parent_matrix);
+                        model_matrix.setUpper3x3(Matrix3::scale(Vector3(1.0f/scale.getX(), 1.0f/scale.getY(), 1.0f/scale.getZ())) * model_matrix.getUpper3x3());
+                    }
+                    model_matrix = parent_matrix * model_matrix;
                 }
+                model_pose_matrices[bi] = model_matrix;
             }
+            skin_matrices[bi] = model_matrix * bind_pose[bi].m_ModelToLocal;
         }
     }
 
@@ -1316,7 +1482,7 @@ namespace dmRig
     void* GenerateVertexData(dmRig::HRigContext context, dmRig::HRigInstance instance, const Matrix4& model_matrix, const Matrix4& normal_matrix, const Vector4 color, RigVertexFormat vertex_format, void* vertex_data_out)
     {
         const dmRigDDF::MeshEntry* mesh_entry = instance->m_MeshEntry;
-        if (!instance->m_MeshEntry || !instance->m_DoRender) {
+        if (!instance->m_MeshEntry || !instance->m_DoRender || instance->m_Culled) {
             return vertex_data_out;
         }
 
@@ -1332,7 +1498,6 @@ namespace dmRig
             }
         }
 
-        dmArray<Matrix4>& pose_matrices      = context->m_ScratchPoseMatrixBuffer;
         dmArray<Matrix4>& influence_matrices = context->m_ScratchInfluenceMatrixBuffer;
         dmArray<Vector3>& positions          = context->m_ScratchPositionBuffer;
         dmArray<Vector3>& normals            = context->m_ScratchNormalBuffer;
@@ -1342,13 +1507,6 @@ namespace dmRig
         influence_matrices.SetSize(0);
         if (bone_count && instance->m_PoseIdxToInfluence->Size() > 0) {
 
-            // Make sure pose scratch buffers have enough space
-            if (pose_matrices.Capacity() < bone_count) {
-                uint32_t size_offset = bone_count - pose_matrices.Capacity();
-                pose_matrices.OffsetCapacity(size_offset);
-            }
-            pose_matrices.SetSize(bone_count);
-
             // Make sure influence scratch buffers have enough space sufficient for max bones to be indexed
             uint32_t max_bone_count = instance->m_MaxBoneCount;
             if (influence_matrices.Capacity() < max_bone_count) {
@@ -1361,34 +1519,10 @@ namespace dmRig
             }
             influence_matrices.SetSize(max_bone_count);
 
-            const dmArray<dmTransform::Transform>& pose = instance->m_Pose;
-            const dmRigDDF::Skeleton* skeleton = instance->m_Skeleton;
-            if (skeleton->m_LocalBoneScaling) {
-
-                dmArray<dmTransform::Transform>& pose_transforms = context->m_ScratchPoseTransformBuffer;
-                if (pose_transforms.Capacity() < bone_count) {
-                    pose_transforms.OffsetCapacity(bone_count - pose_transforms.Capacity());
-                }
-                pose_transforms.SetSize(bone_count);
-
-                PoseToModelSpace(skeleton, pose, pose_transforms);
-                PoseToMatrix(pose_transforms, pose_matrices);
-            } else {
-                PoseToMatrix(pose, pose_matrices);
-                PoseToModelSpace(skeleton, pose_matrices, pose_matrices);
-            }
-
-            // Premultiply pose matrices with the bind pose inverse so they
-            // can be directly be used to transform each vertex.
-            const dmArray<RigBone>& bind_pose = *instance->m_BindPose;
-            for (uint32_t bi = 0; bi < pose_matrices.Size(); ++bi)
-            {
-                Matrix4& pose_matrix = pose_matrices[bi];
-                pose_matrix = pose_matrix * bind_pose[bi].m_ModelToLocal;
-            }
+            UpdateSkinMatrices(context, instance);
 
             // Rearrange pose matrices to indices that the mesh vertices understand.
-            PoseToInfluence(*instance->m_PoseIdxToInfluence, pose_matrices, influence_matrices);
+            PoseToInfluence(*instance->m_PoseIdxToInfluence, instance->m_SkinMatrices, influence_matrices);
         }
 
         // Loop that generates actual vertex data for current mesh entry.
@@ -1500,6 +1634,38 @@ namespace dmRig
         return instance->m_Enabled;
     }
 
+    void SetUpdateInterval(HRigInstance instance, uint32_t update_interval)
+    {
+        instance->m_UpdateInterval = (uint16_t)dmMath::Clamp(update_interval, 1U, 0xffffU);
+        // Spread the updates of instances with the same interval over the frames
+        instance->m_UpdateCounter = (uint16_t)(instance->m_Index % instance->m_UpdateInterval);
+    }
+
+    uint32_t GetUpdateInterval(HRigInstance instance)
+    {
+        return dmMath::Max((uint32_t)instance->m_UpdateInterval, 1U);
+    }
+
+    void SetLODBoneCount(HRigInstance instance, uint32_t bone_count)
+    {
+        instance->m_LODBoneCount = bone_count;
+    }
+
+    uint32_t GetLODBoneCount(HRigInstance instance)
+    {
+        return instance->m_LODBoneCount;
+    }
+
+    void SetCulled(HRigInstance instance, bool culled)
+    {
+        instance->m_Culled = culled;
+    }
+
+    bool GetCulled(HRigInstance instance)
+    {
+        return instance->m_Culled;
+    }
+
     bool IsValid(HRigInstance instance)
     {
         return (instance->m_MeshEntry != 0x0);
@@ -1574,10 +1740,26 @@ namespace dmRig
     static void DestroyInstance(HRigContext context, uint32_t index)
     {
         RigInstance* instance = context->m_Instances.Get(index);
+        // Drop the events of the instance that are still to be posted, if destroyed from an event callback
+        dmArray<RigEvent>& events = context->m_Events;
+        for (uint32_t i = 0; i < events.Size(); ++i)
+        {
+            if (events[i].m_Instance == instance)
+            {
+                events[i].m_Instance = 0;
+            }
+        }
         // If we're going to use memset, then we should explicitly clear pose and instance arrays.
         instance->m_Pose.SetCapacity(0);
+        instance->m_CachedPose.SetCapacity(0);
+        instance->m_ModelPose.SetCapacity(0);
+        instance->m_ModelPoseMatrices.SetCapacity(0);
+        instance->m_SkinMatrices.SetCapacity(0);
         instance->m_IKTargets.SetCapacity(0);
         instance->m_MeshSlotPose.SetCapacity(0);
+        instance->m_DrawOrderDeltas.SetCapacity(0);
+        instance->m_DrawOrderUnchanged.SetCapacity(0);
+        instance->m_Events.SetCapacity(0);
         delete instance;
         context->m_Instances.Free(index, true);
     }
@@ -1639,7 +1821,7 @@ namespace dmRig
         // before that happens, for example cloning a GUI spine node happens in script update,
         // which comes after the regular dmRig::Update.
         if (params.m_ForceAnimatePose) {
-            DoAnimate(context, instance, 0.0f);
+            DoAnimate(instance, 0.0f);
         }
 
         return dmRig::RESULT_OK;
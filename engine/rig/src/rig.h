@@ -20,6 +20,7 @@
 #include <dlib/vmath.h>
 #include <dlib/align.h>
 #include <dlib/transform.h>
+#include <dlib/worker_pool.h>
 
 #include <render/render.h>
 
@@ -169,6 +170,26 @@ namespace dmRig
         uint64_t  m_String;
     };
 
+    typedef void (*RigEventCallback)(RigEventType, void*, void*, void*);
+    typedef void (*RigPoseCallback)(void*, void*);
+
+    // Event raised while animating an instance. Events are queued on the instance during the
+    // animate phase (which may run on worker threads) and posted serially in instance order afterwards.
+    // The event callback is looked up when the event is posted, since an earlier callback might have changed it.
+    struct RigEvent
+    {
+        // Zero if the instance was destroyed before the event was posted
+        HRigInstance                  m_Instance;
+        // The instance animation version when the event was raised, see RigInstance::m_AnimationVersion
+        uint32_t                      m_AnimationVersion;
+        RigEventType                  m_Type;
+        union
+        {
+            RigCompletedEventData     m_Completed;
+            RigKeyframeEventData      m_Keyframe;
+        };
+    };
+
     // NOTE: We expose two different vertex format that GenerateVertexData can output.
     // This is a temporary fix until we have better support for custom vertex formats.
     enum RigVertexFormat
@@ -205,28 +226,27 @@ namespace dmRig
     struct RigContext
     {
         dmObjectPool<HRigInstance>      m_Instances;
-        // Temporary scratch buffers used for store pose as transform and matrices
-        // (avoids modifying the real pose transform data during rendering).
-        dmArray<dmTransform::Transform> m_ScratchPoseTransformBuffer;
+        // Temporary scratch buffer used to store the skinning matrices in the order of the mesh bone indices
         dmArray<Matrix4>                m_ScratchInfluenceMatrixBuffer;
-        dmArray<Matrix4>                m_ScratchPoseMatrixBuffer;
+        // Temporary scratch buffer used to flag the bones that changed since the skinning matrices were last updated
+        dmArray<uint8_t>                m_ScratchBoneChanged;
         // Temporary scratch buffers used when transforming the vertex buffer,
         // used to creating primitives from indices.
         dmArray<Vector3>                m_ScratchPositionBuffer;
         dmArray<Vector3>                m_ScratchNormalBuffer;
-        // Temporary scratch buffers to handle draw order changes.
-        dmArray<int32_t>                m_ScratchDrawOrderDeltas;
-        dmArray<int32_t>                m_ScratchDrawOrderUnchanged;
+        // Events gathered from all instances after the animate phase, in the order they are posted
+        dmArray<RigEvent>               m_Events;
+        /// Used to animate the instances in parallel (optional)
+        dmWorkerPool::HWorkerPool       m_WorkerPool;
     };
 
     struct NewContextParams {
-        HRigContext* m_Context;
-        uint32_t     m_MaxRigInstanceCount;
+        HRigContext*              m_Context;
+        uint32_t                  m_MaxRigInstanceCount;
+        /// Used to animate the instances in parallel (optional)
+        dmWorkerPool::HWorkerPool m_WorkerPool;
     };
 
-    typedef void (*RigEventCallback)(RigEventType, void*, void*, void*);
-    typedef void (*RigPoseCallback)(void*, void*);
-
     struct RigInstance
     {
         RigPlayer                     m_Players[2];
@@ -242,12 +262,25 @@ namespace dmRig
         void*                         m_PoseCBUserData1;
         void*                         m_PoseCBUserData2;
         dmArray<int32_t>              m_DrawOrder;
+        /// Scratch buffers to handle draw order changes, per instance since instances can be animated in parallel
+        dmArray<int32_t>              m_DrawOrderDeltas;
+        dmArray<int32_t>              m_DrawOrderUnchanged;
         /// Event handling
         RigEventCallback              m_EventCallback;
         void*                         m_EventCBUserData1;
         void*                         m_EventCBUserData2;
+        /// Events raised while animating, not yet posted to the event callback
+        dmArray<RigEvent>             m_Events;
+        /// Bumped when an animation is played or cancelled, queued events of a previous animation are dropped
+        uint32_t                      m_AnimationVersion;
         /// Animated pose, every transform is local-to-model-space and describes the delta between bind pose and animation
         dmArray<dmTransform::Transform> m_Pose;
+        /// Skinning matrices (model space pose premultiplied with the inverse bind pose), and the local pose
+        /// and model space pose they were calculated from, used to only recalculate the bones that changed
+        dmArray<dmTransform::Transform> m_CachedPose;
+        dmArray<dmTransform::Transform> m_ModelPose;
+        dmArray<Matrix4>              m_ModelPoseMatrices;
+        dmArray<Matrix4>              m_SkinMatrices;
         /// Animated IK
         dmArray<IKAnimation>          m_IKAnimation;
         /// User IK constraint targets
@@ -259,6 +292,13 @@ namespace dmRig
         dmhash_t                      m_MeshId;
         float                         m_BlendDuration;
         float                         m_BlendTimer;
+        /// Animation level of detail, time passed during the updates the instance wasn't animated
+        float                         m_SkippedDT;
+        /// Number of bones that are sampled, zero for all bones
+        uint32_t                      m_LODBoneCount;
+        /// Animate every n:th update, zero or one for every update
+        uint16_t                      m_UpdateInterval;
+        uint16_t                      m_UpdateCounter;
         /// Mesh type indicate how vertex data will be filled
         RigMeshType                   m_MeshType;
         // Max bone count used by skeleton (if it is used) and meshset
@@ -269,6 +309,10 @@ namespace dmRig
         uint8_t                       m_Blending : 1;
         uint8_t                       m_Enabled : 1;
         uint8_t                       m_DoRender : 1;
+        /// Whether the instance is culled, only the players are updated
+        uint8_t                       m_Culled : 1;
+        /// Whether the pose was left as is during the last update because of the level of detail
+        uint8_t                       m_PoseSkipped : 1;
     };
 
     struct InstanceCreateParams
@@ -336,6 +380,17 @@ namespace dmRig
     uint32_t GetMaxBoneCount(HRigInstance instance);
     void SetEventCallback(HRigInstance instance, RigEventCallback event_callback, void* user_data1, void* user_data2);
 
+    // Animation level of detail. The instance is animated every update_interval:th update, with the time
+    // accumulated since it was last animated. Only the first bone_count bones of the skeleton are sampled
+    // (parents precede their children), the remaining bones keep their bind pose. A bone count of zero samples all bones.
+    // A culled instance only advances its animation cursors and posts events, the pose, IK and vertex data are not updated.
+    void SetUpdateInterval(HRigInstance instance, uint32_t update_interval);
+    uint32_t GetUpdateInterval(HRigInstance instance);
+    void SetLODBoneCount(HRigInstance instance, uint32_t bone_count);
+    uint32_t GetLODBoneCount(HRigInstance instance);
+    void SetCulled(HRigInstance instance, bool culled);
+    bool GetCulled(HRigInstance instance);
+
     // Util function used to fill a bind pose array from skeleton data
     // used in rig tests and loading rig resources.
     void CreateBindPose(dmRigDDF::Skeleton& skeleton, dmArray<RigBone>& bind_pose);
@@ -13,6 +13,8 @@
 #define JC_TEST_IMPLEMENTATION
 #include <jc_test/jc_test.h>
 #include <dlib/log.h>
+#include <dlib/time.h>
+#include <dlib/worker_pool.h>
 
 #include <../rig.h>
 
@@ -69,6 +71,16 @@ static void DeleteRigAnimation(dmRigDDF::RigAnimation& anim)
     if (anim.m_MeshTracks.m_Count) {
         delete [] anim.m_MeshTracks.m_Data;
     }
+
+    for (uint32_t t = 0; t < anim.m_EventTracks.m_Count; ++t) {
+        dmRigDDF::EventTrack& anim_eventtrack = anim.m_EventTracks.m_Data[t];
+        if (anim_eventtrack.m_Keys.m_Count) {
+            delete [] anim_eventtrack.m_Keys.m_Data;
+        }
+    }
+    if (anim.m_EventTracks.m_Count) {
+        delete [] anim.m_EventTracks.m_Data;
+    }
 }
 
 // Helper function to clean up / delete MeshSet, Skeleton and AnimationSet data
@@ -1000,6 +1012,147 @@ void SetUpSimpleRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skel
         dmRig::FillBoneListArrays(*mesh_set, *animation_set, *skeleton, track_idx_to_pose, pose_idx_to_influence);
 }
 
+// Sets up a rig with a binary tree skeleton and a single mesh where every vertex has four influences,
+// resembling typical exported model meshes. Used to verify and benchmark the skinning.
+static void SetUpSkinnedRig(dmArray<dmRig::RigBone>& bind_pose, dmRigDDF::Skeleton* skeleton, dmRigDDF::MeshSet* mesh_set, dmRigDDF::AnimationSet* animation_set, dmArray<uint32_t>& pose_idx_to_influence, dmArray<uint32_t>& track_idx_to_pose, uint32_t bone_count, uint32_t vert_count)
+{
+    // A parent always has a lower index than its children
+    skeleton->m_Bones.m_Data = new dmRigDDF::Bone[bone_count];
+    skeleton->m_Bones.m_Count = bone_count;
+    skeleton->m_LocalBoneScaling = false;
+    for (uint32_t i = 0; i < bone_count; ++i)
+    {
+        dmRigDDF::Bone& bone = skeleton->m_Bones.m_Data[i];
+        bone.m_Parent       = i == 0 ? 0xffff : (i - 1) / 2;
+        bone.m_Id           = i;
+        bone.m_Position     = i == 0 ? Point3(0.0f) : Point3(1.0f, 0.0f, 0.0f);
+        bone.m_Rotation     = Quat::rotationZ(0.1f * (i % 7));
+        bone.m_Scale        = Vector3(1.0f, 1.0f, 1.0f);
+        bone.m_InheritScale = true;
+        bone.m_Length       = 1.0f;
+    }
+    bind_pose.SetCapacity(bone_count);
+    bind_pose.SetSize(bone_count);
+    dmRig::CreateBindPose(*skeleton, bind_pose);
+
+    mesh_set->m_SlotCount = 1;
+    mesh_set->m_MeshEntries.m_Data = new dmRigDDF::MeshEntry[1];
+    mesh_set->m_MeshEntries.m_Count = 1;
+    dmRigDDF::MeshEntry& mesh_entry = mesh_set->m_MeshEntries.m_Data[0];
+    mesh_entry.m_Id = dmHashString64("test");
+    mesh_entry.m_MeshSlots.m_Data = new dmRigDDF::MeshSlot[1];
+    mesh_entry.m_MeshSlots.m_Count = 1;
+    dmRigDDF::MeshSlot& mesh_slot = mesh_entry.m_MeshSlots.m_Data[0];
+    mesh_slot.m_Id = 0;
+    mesh_slot.m_MeshAttachments.m_Data = new uint32_t[1];
+    mesh_slot.m_MeshAttachments.m_Count = 1;
+    mesh_slot.m_MeshAttachments.m_Data[0] = 0;
+    mesh_slot.m_ActiveIndex = 0;
+    mesh_slot.m_SlotColor.m_Count = 0;
+    mesh_set->m_MaxBoneCount = bone_count;
+
+    mesh_set->m_MeshAttachments.m_Data = new dmRigDDF::Mesh[1];
+    mesh_set->m_MeshAttachments.m_Count = 1;
+    dmRigDDF::Mesh& mesh = mesh_set->m_MeshAttachments.m_Data[0];
+    memset(&mesh, 0, sizeof(mesh));
+    mesh.m_Positions.m_Data = new float[vert_count*3];
+    mesh.m_Positions.m_Count = vert_count*3;
+    mesh.m_Normals.m_Data = new float[vert_count*3];
+    mesh.m_Normals.m_Count = vert_count*3;
+    mesh.m_Texcoord0.m_Data = new float[vert_count*2];
+    mesh.m_Texcoord0.m_Count = vert_count*2;
+    mesh.m_PositionIndices.m_Data = new uint32_t[vert_count];
+    mesh.m_PositionIndices.m_Count = vert_count;
+    mesh.m_NormalsIndices.m_Data = new uint32_t[vert_count];
+    mesh.m_NormalsIndices.m_Count = vert_count;
+    mesh.m_BoneIndices.m_Data = new uint32_t[vert_count*4];
+    mesh.m_BoneIndices.m_Count = vert_count*4;
+    mesh.m_Weights.m_Data = new float[vert_count*4];
+    mesh.m_Weights.m_Count = vert_count*4;
+    for (uint32_t i = 0; i < vert_count; ++i)
+    {
+        mesh.m_Positions[i*3+0] = (float)(i % 17);
+        mesh.m_Positions[i*3+1] = (float)(i % 13) * 0.5f;
+        mesh.m_Positions[i*3+2] = (float)(i % 11) * 0.25f;
+        mesh.m_Normals[i*3+0] = 0.0f;
+        mesh.m_Normals[i*3+1] = 1.0f;
+        mesh.m_Normals[i*3+2] = 0.0f;
+        mesh.m_Texcoord0[i*2+0] = 0.0f;
+        mesh.m_Texcoord0[i*2+1] = 0.0f;
+        mesh.m_PositionIndices[i] = i;
+        mesh.m_NormalsIndices[i] = i;
+        mesh.m_BoneIndices[i*4+0] = i % bone_count;
+        mesh.m_BoneIndices[i*4+1] = (i * 7 + 1) % bone_count;
+        mesh.m_BoneIndices[i*4+2] = (i * 13 + 2) % bone_count;
+        mesh.m_BoneIndices[i*4+3] = (i * 31 + 3) % bone_count;
+        mesh.m_Weights[i*4+0] = 0.4f;
+        mesh.m_Weights[i*4+1] = 0.3f;
+        mesh.m_Weights[i*4+2] = 0.2f;
+        mesh.m_Weights[i*4+3] = 0.1f;
+    }
+
+    mesh_set->m_BoneList.m_Data = new uint64_t[bone_count];
+    mesh_set->m_BoneList.m_Count = bone_count;
+    for (uint32_t i = 0; i < bone_count; ++i)
+    {
+        mesh_set->m_BoneList.m_Data[i] = i;
+    }
+
+    // A looping animation that rotates and moves every bone, with an event track
+    const uint32_t sample_count = 11;
+    const uint32_t event_count = 3;
+    animation_set->m_Animations.m_Data = new dmRigDDF::RigAnimation[1];
+    animation_set->m_Animations.m_Count = 1;
+    dmRigDDF::RigAnimation& anim = animation_set->m_Animations.m_Data[0];
+    anim.m_Id = dmHashString64("loop");
+    anim.m_Duration = 1.0f;
+    anim.m_SampleRate = (float)(sample_count - 1);
+    anim.m_MeshTracks.m_Count = 0;
+    anim.m_IkTracks.m_Count = 0;
+    anim.m_Tracks.m_Data = new dmRigDDF::AnimationTrack[bone_count];
+    anim.m_Tracks.m_Count = bone_count;
+    for (uint32_t i = 0; i < bone_count; ++i)
+    {
+        dmRigDDF::AnimationTrack& track = anim.m_Tracks.m_Data[i];
+        track.m_BoneIndex = i;
+        track.m_Positions.m_Data = new float[sample_count*3];
+        track.m_Positions.m_Count = sample_count*3;
+        track.m_Rotations.m_Data = new float[sample_count*4];
+        track.m_Rotations.m_Count = sample_count*4;
+        track.m_Scale.m_Count = 0;
+        for (uint32_t s = 0; s < sample_count; ++s)
+        {
+            Quat q = Quat::rotationZ(0.1f * s + 0.01f * i);
+            track.m_Positions.m_Data[s*3+0] = 0.0f;
+            track.m_Positions.m_Data[s*3+1] = 0.1f * s;
+            track.m_Positions.m_Data[s*3+2] = 0.0f;
+            track.m_Rotations.m_Data[s*4+0] = q.getX();
+            track.m_Rotations.m_Data[s*4+1] = q.getY();
+            track.m_Rotations.m_Data[s*4+2] = q.getZ();
+            track.m_Rotations.m_Data[s*4+3] = q.getW();
+        }
+    }
+    anim.m_EventTracks.m_Data = new dmRigDDF::EventTrack[1];
+    anim.m_EventTracks.m_Count = 1;
+    dmRigDDF::EventTrack& event_track = anim.m_EventTracks.m_Data[0];
+    event_track.m_EventId = dmHashString64("event");
+    event_track.m_Keys.m_Data = new dmRigDDF::EventKey[event_count];
+    event_track.m_Keys.m_Count = event_count;
+    for (uint32_t i = 0; i < event_count; ++i)
+    {
+        dmRigDDF::EventKey& key = event_track.m_Keys.m_Data[i];
+        key.m_T = 0.25f * i;
+        key.m_Integer = i;
+        key.m_Float = 0.0f;
+        key.m_String = 0;
+    }
+
+    animation_set->m_BoneList.m_Data = mesh_set->m_BoneList.m_Data;
+    animation_set->m_BoneList.m_Count = bone_count;
+
+    dmRig::FillBoneListArrays(*mesh_set, *animation_set, *skeleton, track_idx_to_pose, pose_idx_to_influence);
+}
+
 class RigContextTest : public jc_test_base_class
 {
 public:
@@ -2500,6 +2653,559 @@ INSTANTIATE_TEST_CASE_P(Rig, PlaybackCursorTest, jc_test_values_in(playback_curs
 #undef ASSERT_VERT_NORM
 #undef ASSERT_VERT_COLOR
 
+class RigSkinningTest : public RigContextTest
+{
+public:
+    dmArray<dmRig::RigBone> m_BindPose;
+    dmRigDDF::Skeleton*     m_Skeleton;
+    dmRigDDF::MeshSet*      m_MeshSet;
+    dmRigDDF::AnimationSet* m_AnimationSet;
+    dmArray<uint32_t>       m_PoseIdxToInfluence;
+    dmArray<uint32_t>       m_TrackIdxToPose;
+
+protected:
+    void SetUpRig(uint32_t bone_count, uint32_t vert_count)
+    {
+        m_Skeleton     = new dmRigDDF::Skeleton();
+        m_MeshSet      = new dmRigDDF::MeshSet();
+        m_AnimationSet = new dmRigDDF::AnimationSet();
+        SetUpSkinnedRig(m_BindPose, m_Skeleton, m_MeshSet, m_AnimationSet, m_PoseIdxToInfluence, m_TrackIdxToPose, bone_count, vert_count);
+    }
+
+    dmRig::HRigInstance CreateInstance()
+    {
+        return CreateInstance(m_Context, 0x0, 0x0, 0x0);
+    }
+
+    dmRig::HRigInstance CreateInstance(dmRig::HRigContext context, dmRig::RigEventCallback event_callback, void* event_user_data1, void* event_user_data2)
+    {
+        dmRig::HRigInstance instance = 0x0;
+        dmRig::InstanceCreateParams create_params = {0};
+        create_params.m_Context            = context;
+        create_params.m_Instance           = &instance;
+        create_params.m_BindPose           = &m_BindPose;
+        create_params.m_Skeleton           = m_Skeleton;
+        create_params.m_MeshSet            = m_MeshSet;
+        create_params.m_AnimationSet       = m_AnimationSet;
+        create_params.m_TrackIdxToPose     = &m_TrackIdxToPose;
+        create_params.m_PoseIdxToInfluence = &m_PoseIdxToInfluence;
+        create_params.m_MeshId             = dmHashString64((const char*)"test");
+        create_params.m_DefaultAnimation   = dmHashString64((const char*)"");
+        create_params.m_EventCallback      = event_callback;
+        create_params.m_EventCBUserData1   = event_user_data1;
+        create_params.m_EventCBUserData2   = event_user_data2;
+        if (dmRig::RESULT_OK != dmRig::InstanceCreate(create_params)) {
+            return 0x0;
+        }
+        return instance;
+    }
+
+    void DestroyInstance(dmRig::HRigInstance instance)
+    {
+        DestroyInstance(m_Context, instance);
+    }
+
+    void DestroyInstance(dmRig::HRigContext context, dmRig::HRigInstance instance)
+    {
+        dmRig::InstanceDestroyParams destroy_params = {0};
+        destroy_params.m_Context = context;
+        destroy_params.m_Instance = instance;
+        dmRig::InstanceDestroy(destroy_params);
+    }
+
+    virtual void TearDown()
+    {
+        DeleteRigData(m_MeshSet, m_Skeleton, m_AnimationSet);
+        RigContextTest::TearDown();
+    }
+};
+
+static void AnimatePose(dmArray<dmTransform::Transform>& pose, uint32_t begin, uint32_t end, float t)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        pose[i].SetRotation(Quat::rotationZ(t + 0.01f * i));
+        pose[i].SetTranslation(Vector3(0.0f, 0.1f * t, 0.0f));
+    }
+}
+
+// The skinning matrices are cached per instance and only recalculated for bones whose local transform, or
+// any ancestor's local transform, changed. Compare against a new instance that has to calculate all of them.
+TEST_F(RigSkinningTest, PoseCache)
+{
+    const uint32_t bone_count = 31;
+    const uint32_t vert_count = 64;
+    SetUpRig(bone_count, vert_count);
+
+    dmRig::HRigInstance cached_instance = CreateInstance();
+    ASSERT_NE((dmRig::HRigInstance)0x0, cached_instance);
+
+    dmRig::RigModelVertex cached_data[vert_count];
+    dmRig::RigModelVertex data[vert_count];
+    Matrix4 model_matrix = Matrix4::translation(Vector3(1.0f, 2.0f, 3.0f));
+
+    dmArray<dmTransform::Transform>& cached_pose = *dmRig::GetPose(cached_instance);
+    // Animate all bones, the root, a subtree, a single leaf and finally nothing
+    uint32_t ranges[][2] = {{0, bone_count}, {0, 1}, {2, 3}, {bone_count - 1, bone_count}, {0, 0}};
+    for (uint32_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r)
+    {
+        AnimatePose(cached_pose, ranges[r][0], ranges[r][1], 0.5f + r);
+        ASSERT_EQ((void*)(cached_data + vert_count), dmRig::GenerateVertexData(m_Context, cached_instance, model_matrix, Matrix4::identity(), Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)cached_data));
+
+        dmRig::HRigInstance instance = CreateInstance();
+        ASSERT_NE((dmRig::HRigInstance)0x0, instance);
+        dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(instance);
+        for (uint32_t i = 0; i < bone_count; ++i)
+        {
+            pose[i] = cached_pose[i];
+        }
+        ASSERT_EQ((void*)(data + vert_count), dmRig::GenerateVertexData(m_Context, instance, model_matrix, Matrix4::identity(), Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)data));
+        DestroyInstance(instance);
+
+        ASSERT_ARRAY_EQ_LEN(data, cached_data, vert_count);
+    }
+
+    DestroyInstance(cached_instance);
+}
+
+// Measures the vertex generation throughput of a typical four influence mesh,
+// with all bones animated every frame and with a static pose
+TEST_F(RigSkinningTest, SkinningBench)
+{
+    const uint32_t bone_count = 64;
+    const uint32_t vert_count = 4096;
+    const uint32_t iterations = 200;
+    SetUpRig(bone_count, vert_count);
+
+    dmRig::HRigInstance instance = CreateInstance();
+    ASSERT_NE((dmRig::HRigInstance)0x0, instance);
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(instance);
+
+    dmRig::RigModelVertex* model_data = new dmRig::RigModelVertex[vert_count];
+    dmRig::RigSpineModelVertex* spine_data = new dmRig::RigSpineModelVertex[vert_count];
+
+    for (uint32_t static_pose = 0; static_pose < 2; ++static_pose)
+    {
+        uint64_t model_time = 0;
+        uint64_t spine_time = 0;
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            if (!static_pose)
+            {
+                AnimatePose(pose, 0, bone_count, 0.01f * i);
+            }
+            uint64_t start = dmTime::GetTime();
+            dmRig::GenerateVertexData(m_Context, instance, Matrix4::identity(), Matrix4::identity(), Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)model_data);
+            uint64_t mid = dmTime::GetTime();
+            dmRig::GenerateVertexData(m_Context, instance, Matrix4::identity(), Matrix4::identity(), Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_SPINE, (void*)spine_data);
+            uint64_t end = dmTime::GetTime();
+            model_time += mid - start;
+            spine_time += end - mid;
+        }
+
+        double vertices = (double)vert_count * iterations;
+        printf("Skinning %u vertices, %u bones, %s pose: model format %.1f vertices/ms, spine format %.1f vertices/ms\n",
+            vert_count, bone_count, static_pose ? "static" : "animated",
+            vertices / (model_time / 1000.0), vertices / (spine_time / 1000.0));
+    }
+
+    delete [] model_data;
+    delete [] spine_data;
+    DestroyInstance(instance);
+}
+
+struct AnimateTestEvent
+{
+    uint32_t m_Frame;
+    uint32_t m_Instance;
+    int32_t  m_Integer;
+};
+
+struct AnimateTestEvents
+{
+    dmArray<AnimateTestEvent> m_Events;
+    uint32_t                  m_Frame;
+};
+
+static void AnimateTestEventCallback(dmRig::RigEventType event_type, void* event_data, void* user_data1, void* user_data2)
+{
+    ASSERT_EQ(dmRig::RIG_EVENT_TYPE_KEYFRAME, event_type);
+    AnimateTestEvents* events = (AnimateTestEvents*)user_data1;
+    AnimateTestEvent event;
+    event.m_Frame = events->m_Frame;
+    event.m_Instance = (uint32_t)(uintptr_t)user_data2;
+    event.m_Integer = ((dmRig::RigKeyframeEventData*)event_data)->m_Integer;
+    if (events->m_Events.Full())
+    {
+        events->m_Events.OffsetCapacity(256);
+    }
+    events->m_Events.Push(event);
+}
+
+static bool IsEqual(const dmTransform::Transform& a, const dmTransform::Transform& b)
+{
+    Vector3 ta = a.GetTranslation(), tb = b.GetTranslation();
+    Vector3 sa = a.GetScale(), sb = b.GetScale();
+    Quat ra = a.GetRotation(), rb = b.GetRotation();
+    return ta.getX() == tb.getX() && ta.getY() == tb.getY() && ta.getZ() == tb.getZ()
+        && sa.getX() == sb.getX() && sa.getY() == sb.getY() && sa.getZ() == sb.getZ()
+        && ra.getX() == rb.getX() && ra.getY() == rb.getY() && ra.getZ() == rb.getZ() && ra.getW() == rb.getW();
+}
+
+// Instances are animated on the worker threads and their events are posted afterwards.
+// The poses and the events (and their order) must be the same as when animating serially.
+TEST_F(RigSkinningTest, ParallelAnimate)
+{
+    const uint32_t bone_count = 31;
+    const uint32_t instance_count = 64;
+    const uint32_t frame_count = 40;
+    SetUpRig(bone_count, 4);
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(3, "rig_test");
+    dmRig::HRigContext contexts[2];
+    AnimateTestEvents events[2];
+    dmRig::HRigInstance instances[2][instance_count];
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        dmRig::NewContextParams params = {0};
+        params.m_Context = &contexts[c];
+        params.m_MaxRigInstanceCount = instance_count;
+        params.m_WorkerPool = c == 0 ? 0 : pool;
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::NewContext(params));
+
+        events[c].m_Frame = 0;
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            instances[c][i] = CreateInstance(contexts[c], AnimateTestEventCallback, &events[c], (void*)(uintptr_t)i);
+            ASSERT_NE((dmRig::HRigInstance)0x0, instances[c][i]);
+            dmRig::RigPlayback playback = (i % 2) ? dmRig::PLAYBACK_LOOP_PINGPONG : dmRig::PLAYBACK_LOOP_FORWARD;
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instances[c][i], dmHashString64("loop"), playback, 0.0f, (float)i / instance_count, 1.0f + 0.25f * (i % 4)));
+        }
+    }
+
+    for (uint32_t f = 0; f < frame_count; ++f)
+    {
+        for (uint32_t c = 0; c < 2; ++c)
+        {
+            events[c].m_Frame = f;
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(contexts[c], 1.0f / 16.0f));
+        }
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            dmArray<dmTransform::Transform>& serial_pose = *dmRig::GetPose(instances[0][i]);
+            dmArray<dmTransform::Transform>& parallel_pose = *dmRig::GetPose(instances[1][i]);
+            for (uint32_t bi = 0; bi < bone_count; ++bi)
+            {
+                ASSERT_TRUE(IsEqual(serial_pose[bi], parallel_pose[bi]));
+            }
+        }
+    }
+
+    // Events are posted in frame and instance order
+    ASSERT_LT(0U, events[0].m_Events.Size());
+    ASSERT_EQ(events[0].m_Events.Size(), events[1].m_Events.Size());
+    for (uint32_t i = 0; i < events[1].m_Events.Size(); ++i)
+    {
+        const AnimateTestEvent& serial_event = events[0].m_Events[i];
+        const AnimateTestEvent& event = events[1].m_Events[i];
+        ASSERT_EQ(serial_event.m_Frame, event.m_Frame);
+        ASSERT_EQ(serial_event.m_Instance, event.m_Instance);
+        ASSERT_EQ(serial_event.m_Integer, event.m_Integer);
+        if (i > 0)
+        {
+            const AnimateTestEvent& prev_event = events[1].m_Events[i-1];
+            ASSERT_TRUE(prev_event.m_Frame < event.m_Frame || (prev_event.m_Frame == event.m_Frame && prev_event.m_Instance <= event.m_Instance));
+        }
+    }
+
+    for (uint32_t c = 0; c < 2; ++c)
+    {
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            DestroyInstance(contexts[c], instances[c][i]);
+        }
+        dmRig::DeleteContext(contexts[c]);
+    }
+    dmWorkerPool::Delete(pool);
+}
+
+struct FlushTestState
+{
+    dmRig::HRigContext   m_Context;
+    dmRig::HRigInstance  m_Instances[4];
+    AnimateTestEvents    m_Events;
+    bool                 m_Modify;
+};
+
+// On the first event of instance 0, destroys instance 1, changes the event user data of instance 2 and restarts the animation of instance 3
+static void FlushTestEventCallback(dmRig::RigEventType event_type, void* event_data, void* user_data1, void* user_data2)
+{
+    FlushTestState* state = (FlushTestState*)user_data1;
+    AnimateTestEventCallback(event_type, event_data, &state->m_Events, user_data2);
+    if (state->m_Modify && (uintptr_t)user_data2 == 0)
+    {
+        state->m_Modify = false;
+        dmRig::InstanceDestroyParams destroy_params = {0};
+        destroy_params.m_Context = state->m_Context;
+        destroy_params.m_Instance = state->m_Instances[1];
+        dmRig::InstanceDestroy(destroy_params);
+        state->m_Instances[1] = 0;
+        dmRig::SetEventCallback(state->m_Instances[2], FlushTestEventCallback, state, (void*)12);
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(state->m_Instances[3], dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    }
+}
+
+static uint32_t CountEvents(const AnimateTestEvents& events, uint32_t instance)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < events.m_Events.Size(); ++i)
+    {
+        count += events.m_Events[i].m_Instance == instance ? 1 : 0;
+    }
+    return count;
+}
+
+// The queued events are posted with the event callback of the instance at the time they are posted.
+// Events of instances destroyed, or with their animation changed, by an earlier event callback are dropped.
+TEST_F(RigSkinningTest, EventCallbackModifiesInstances)
+{
+    SetUpRig(7, 4);
+
+    FlushTestState state;
+    dmRig::NewContextParams params = {0};
+    params.m_Context = &state.m_Context;
+    params.m_MaxRigInstanceCount = 4;
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::NewContext(params));
+    state.m_Events.m_Frame = 0;
+    state.m_Modify = true;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        state.m_Instances[i] = CreateInstance(state.m_Context, FlushTestEventCallback, &state, (void*)(uintptr_t)i);
+        ASSERT_NE((dmRig::HRigInstance)0x0, state.m_Instances[i]);
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(state.m_Instances[i], dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    }
+
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(state.m_Context, 0.3f));
+    ASSERT_FALSE(state.m_Modify);
+    uint32_t count = CountEvents(state.m_Events, 0);
+    ASSERT_LT(0U, count);
+    ASSERT_EQ(0U, CountEvents(state.m_Events, 1));
+    ASSERT_EQ(0U, CountEvents(state.m_Events, 2));
+    ASSERT_EQ(count, CountEvents(state.m_Events, 12));
+    ASSERT_EQ(0U, CountEvents(state.m_Events, 3));
+
+    // The restarted animation posts its events as usual
+    state.m_Events.m_Events.SetSize(0);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(state.m_Context, 0.3f));
+    ASSERT_LT(0U, CountEvents(state.m_Events, 3));
+
+    DestroyInstance(state.m_Context, state.m_Instances[0]);
+    DestroyInstance(state.m_Context, state.m_Instances[2]);
+    DestroyInstance(state.m_Context, state.m_Instances[3]);
+    dmRig::DeleteContext(state.m_Context);
+}
+
+// An instance animated every third update gets the same pose as one animated every update, on the updates it is animated
+TEST_F(RigSkinningTest, LODUpdateInterval)
+{
+    const uint32_t bone_count = 15;
+    SetUpRig(bone_count, 4);
+
+    dmRig::HRigInstance instance = CreateInstance();
+    dmRig::HRigInstance lod_instance = CreateInstance();
+    ASSERT_NE((dmRig::HRigInstance)0x0, instance);
+    ASSERT_NE((dmRig::HRigInstance)0x0, lod_instance);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(lod_instance, dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+
+    ASSERT_EQ(1U, dmRig::GetUpdateInterval(lod_instance));
+    dmRig::SetUpdateInterval(lod_instance, 3);
+    ASSERT_EQ(3U, dmRig::GetUpdateInterval(lod_instance));
+
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(instance);
+    dmArray<dmTransform::Transform>& lod_pose = *dmRig::GetPose(lod_instance);
+    uint32_t animated_count = 0;
+    for (uint32_t f = 0; f < 12; ++f)
+    {
+        // The dt is exactly representable, so the accumulated time matches the time stepped every update
+        float cursor = dmRig::GetCursor(lod_instance, false);
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.0625f));
+        if (dmRig::GetCursor(lod_instance, false) == cursor)
+            continue;
+        ++animated_count;
+        ASSERT_EQ(dmRig::GetCursor(instance, false), dmRig::GetCursor(lod_instance, false));
+        for (uint32_t bi = 0; bi < bone_count; ++bi)
+        {
+            ASSERT_TRUE(IsEqual(pose[bi], lod_pose[bi]));
+        }
+    }
+    ASSERT_EQ(4U, animated_count);
+
+    DestroyInstance(lod_instance);
+    DestroyInstance(instance);
+}
+
+// Only the first bones of the skeleton are sampled, the others keep their bind pose
+TEST_F(RigSkinningTest, LODBoneCount)
+{
+    const uint32_t bone_count = 15;
+    const uint32_t lod_bone_count = 3;
+    SetUpRig(bone_count, 4);
+
+    dmRig::HRigInstance instance = CreateInstance();
+    dmRig::HRigInstance lod_instance = CreateInstance();
+    ASSERT_NE((dmRig::HRigInstance)0x0, instance);
+    ASSERT_NE((dmRig::HRigInstance)0x0, lod_instance);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.5f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(lod_instance, dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.5f, 1.0f));
+
+    ASSERT_EQ(0U, dmRig::GetLODBoneCount(lod_instance));
+    dmRig::SetLODBoneCount(lod_instance, lod_bone_count);
+    ASSERT_EQ(lod_bone_count, dmRig::GetLODBoneCount(lod_instance));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.1f));
+
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(instance);
+    dmArray<dmTransform::Transform>& lod_pose = *dmRig::GetPose(lod_instance);
+    for (uint32_t bi = 0; bi < bone_count; ++bi)
+    {
+        if (bi < lod_bone_count)
+        {
+            ASSERT_TRUE(IsEqual(pose[bi], lod_pose[bi]));
+        }
+        else
+        {
+            ASSERT_FALSE(IsEqual(pose[bi], lod_pose[bi]));
+            ASSERT_TRUE(IsEqual(m_BindPose[bi].m_LocalToParent, lod_pose[bi]));
+        }
+    }
+
+    DestroyInstance(lod_instance);
+    DestroyInstance(instance);
+}
+
+// A culled instance keeps its pose and generates no vertices, but its cursor advances and events are posted
+TEST_F(RigSkinningTest, LODCulled)
+{
+    const uint32_t bone_count = 15;
+    const uint32_t vert_count = 4;
+    SetUpRig(bone_count, vert_count);
+
+    AnimateTestEvents events;
+    events.m_Frame = 0;
+    dmRig::HRigInstance instance = CreateInstance(m_Context, AnimateTestEventCallback, &events, (void*)0);
+    dmRig::HRigInstance culled_instance = CreateInstance(m_Context, AnimateTestEventCallback, &events, (void*)1);
+    ASSERT_NE((dmRig::HRigInstance)0x0, instance);
+    ASSERT_NE((dmRig::HRigInstance)0x0, culled_instance);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instance, dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(culled_instance, dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, 0.0f, 1.0f));
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.1f));
+
+    ASSERT_FALSE(dmRig::GetCulled(culled_instance));
+    dmRig::SetCulled(culled_instance, true);
+    ASSERT_TRUE(dmRig::GetCulled(culled_instance));
+
+    dmArray<dmTransform::Transform>& culled_pose = *dmRig::GetPose(culled_instance);
+    dmArray<dmTransform::Transform> prev_pose;
+    prev_pose.SetCapacity(bone_count);
+    prev_pose.SetSize(bone_count);
+    for (uint32_t bi = 0; bi < bone_count; ++bi)
+    {
+        prev_pose[bi] = culled_pose[bi];
+    }
+
+    events.m_Events.SetSize(0);
+    for (uint32_t f = 0; f < 10; ++f)
+    {
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.1f));
+        ASSERT_EQ(dmRig::GetCursor(instance, false), dmRig::GetCursor(culled_instance, false));
+    }
+    for (uint32_t bi = 0; bi < bone_count; ++bi)
+    {
+        ASSERT_TRUE(IsEqual(prev_pose[bi], culled_pose[bi]));
+    }
+
+    // Both instances post the same events
+    uint32_t event_counts[2] = {0, 0};
+    for (uint32_t i = 0; i < events.m_Events.Size(); ++i)
+    {
+        event_counts[events.m_Events[i].m_Instance]++;
+    }
+    ASSERT_LT(0U, event_counts[0]);
+    ASSERT_EQ(event_counts[0], event_counts[1]);
+
+    dmRig::RigModelVertex data[vert_count];
+    ASSERT_EQ(0U, dmRig::GetVertexCount(culled_instance));
+    ASSERT_EQ((void*)data, dmRig::GenerateVertexData(m_Context, culled_instance, Matrix4::identity(), Matrix4::identity(), Vector4(1.0f), dmRig::RIG_VERTEX_FORMAT_MODEL, (void*)data));
+
+    // The pose is evaluated again once the instance is no longer culled
+    dmRig::SetCulled(culled_instance, false);
+    ASSERT_EQ(dmRig::RESULT_OK, dmRig::Update(m_Context, 0.1f));
+    dmArray<dmTransform::Transform>& pose = *dmRig::GetPose(instance);
+    for (uint32_t bi = 0; bi < bone_count; ++bi)
+    {
+        ASSERT_TRUE(IsEqual(pose[bi], culled_pose[bi]));
+    }
+    ASSERT_EQ(vert_count, dmRig::GetVertexCount(culled_instance));
+
+    DestroyInstance(culled_instance);
+    DestroyInstance(instance);
+}
+
+// Measures the animate phase of many animated instances, serially, on a worker pool and serially with
+// a level of detail where every instance is animated every other update and half of them are culled
+TEST_F(RigSkinningTest, AnimateBench)
+{
+    const uint32_t bone_count = 64;
+    const uint32_t instance_count = 256;
+    const uint32_t iterations = 100;
+    const uint32_t worker_count = 3;
+    SetUpRig(bone_count, 4);
+
+    dmWorkerPool::HWorkerPool pool = dmWorkerPool::New(worker_count, "rig_bench");
+    const char* modes[] = {"serial", "worker pool", "serial lod"};
+    for (uint32_t mode = 0; mode < 3; ++mode)
+    {
+        bool parallel = mode == 1;
+        bool lod = mode == 2;
+        dmRig::HRigContext context;
+        dmRig::NewContextParams params = {0};
+        params.m_Context = &context;
+        params.m_MaxRigInstanceCount = instance_count;
+        params.m_WorkerPool = parallel ? pool : 0;
+        ASSERT_EQ(dmRig::RESULT_OK, dmRig::NewContext(params));
+
+        dmRig::HRigInstance instances[instance_count];
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            instances[i] = CreateInstance(context, 0x0, 0x0, 0x0);
+            ASSERT_NE((dmRig::HRigInstance)0x0, instances[i]);
+            ASSERT_EQ(dmRig::RESULT_OK, dmRig::PlayAnimation(instances[i], dmHashString64("loop"), dmRig::PLAYBACK_LOOP_FORWARD, 0.0f, (float)i / instance_count, 1.0f));
+            if (lod)
+            {
+                dmRig::SetUpdateInterval(instances[i], 2);
+                dmRig::SetCulled(instances[i], i % 2);
+            }
+        }
+
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            dmRig::Update(context, 1.0f / 60.0f);
+        }
+        uint64_t end = dmTime::GetTime();
+
+        printf("Animating %u instances, %u bones, %s: %.3f ms/frame\n",
+            instance_count, bone_count, modes[mode], (end - start) / (1000.0 * iterations));
+
+        for (uint32_t i = 0; i < instance_count; ++i)
+        {
+            DestroyInstance(context, instances[i]);
+        }
+        dmRig::DeleteContext(context);
+    }
+    dmWorkerPool::Delete(pool);
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);
@@ -17,8 +17,10 @@
 #include <dlib/math.h>
 #include <dlib/mutex.h>
 #include <dlib/profile.h>
+#include <dlib/simd.h>
 #include <dlib/thread.h>
 #include <dlib/time.h>
+#include <dlib/worker_pool.h>
 
 #include "sound.h"
 #include "sound_codec.h"
@@ -119,6 +121,13 @@ namespace dmSound
             float mix = i * m_TotalSamplesRecip;
             return m_From + mix * (m_To - m_From);
         }
+
+        // Same as GetValue for four (float) sample indices
+        inline dmSIMD::Vector4f GetValue4(dmSIMD::Vector4f i) const
+        {
+            dmSIMD::Vector4f mix = dmSIMD::Mul(i, dmSIMD::Splat(m_TotalSamplesRecip));
+            return dmSIMD::Add(dmSIMD::Splat(m_From), dmSIMD::Mul(mix, dmSIMD::Splat(m_To - m_From)));
+        }
     };
 
     /**
@@ -170,7 +179,8 @@ namespace dmSound
         uint8_t     m_Looping : 1;
         uint8_t     m_EndOfStream : 1;
         uint8_t     m_Playing : 1;
-        uint8_t     : 5;
+        uint8_t     m_DecodeError : 1;
+        uint8_t     : 4;
     };
 
     struct SoundGroup
@@ -190,8 +200,11 @@ namespace dmSound
         HDevice                       m_Device;
         dmThread::Thread              m_Thread;
         dmMutex::HMutex               m_Mutex;
+        dmWorkerPool::HWorkerPool     m_DecoderPool;
 
         dmArray<SoundInstance>  m_Instances;
+        // Indices of the instances to decode and mix in the current buffer
+        dmArray<uint16_t>       m_MixInstances;
         dmIndexPool16           m_InstancesPool;
 
         dmArray<SoundData>      m_SoundData;
@@ -206,6 +219,8 @@ namespace dmSound
         uint32_t                m_PlayCounter;
 
         int16_t*                m_OutBuffers[SOUND_OUTBUFFER_COUNT];
+        // Resampled frames of the instance being mixed, left channel followed by right channel
+        float*                  m_ResampleBuffer;
         uint16_t                m_NextOutBuffer;
 
         bool                    m_IsDeviceStarted;
@@ -246,6 +261,7 @@ namespace dmSound
         params->m_FrameCount = 768;
         params->m_MaxInstances = 256;
         params->m_UseThread = true;
+        params->m_DecoderThreadCount = 0;
     }
 
     Result RegisterDevice(struct DeviceType* device)
@@ -332,6 +348,7 @@ namespace dmSound
         uint32_t max_buffers = params->m_MaxBuffers;
         uint32_t max_sources = params->m_MaxSources;
         uint32_t max_instances = params->m_MaxInstances;
+        uint32_t decoder_thread_count = params->m_DecoderThreadCount;
 
         if (config)
         {
@@ -340,11 +357,13 @@ namespace dmSound
             max_buffers = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_buffers", (int32_t) max_buffers);
             max_sources = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_sources", (int32_t) max_sources);
             max_instances = (uint32_t) dmConfigFile::GetInt(config, "sound.max_sound_instances", (int32_t) max_instances);
+            decoder_thread_count = (uint32_t) dmConfigFile::GetInt(config, "sound.decoder_threads", (int32_t) decoder_thread_count);
         }
 
         sound->m_Instances.SetCapacity(max_instances);
         sound->m_Instances.SetSize(max_instances);
         sound->m_InstancesPool.SetCapacity(max_instances);
+        sound->m_MixInstances.SetCapacity(max_instances);
         for (uint32_t i = 0; i < max_instances; ++i)
         {
             SoundInstance* instance = &sound->m_Instances[i];
@@ -371,6 +390,7 @@ namespace dmSound
         for (int i = 0; i < SOUND_OUTBUFFER_COUNT; ++i) {
             sound->m_OutBuffers[i] = (int16_t*) malloc(params->m_FrameCount * sizeof(int16_t) * SOUND_MAX_MIX_CHANNELS);
         }
+        sound->m_ResampleBuffer = (float*) malloc(params->m_FrameCount * sizeof(float) * SOUND_MAX_MIX_CHANNELS);
         sound->m_NextOutBuffer = 0;
 
         sound->m_GroupMap.SetCapacity(MAX_GROUPS * 2 + 1, MAX_GROUPS);
@@ -382,6 +402,12 @@ namespace dmSound
         SoundGroup* master = &sound->m_Groups[master_index];
         master->m_Gain.Reset(master_gain);
 
+        sound->m_DecoderPool = 0;
+        if (decoder_thread_count > 0)
+        {
+            sound->m_DecoderPool = dmWorkerPool::New(decoder_thread_count, "sound_decoder");
+        }
+
         sound->m_Thread = 0;
         sound->m_Mutex = 0;
         if (params->m_UseThread)
@@ -413,6 +439,11 @@ namespace dmSound
 
         if (sound)
         {
+            if (sound->m_DecoderPool)
+            {
+                dmWorkerPool::Delete(sound->m_DecoderPool);
+            }
+
             dmSoundCodec::Delete(sound->m_CodecContext);
 
             for (uint32_t i = 0; i < sound->m_Instances.Size(); ++i)
@@ -427,6 +458,7 @@ namespace dmSound
             for (int i = 0; i < SOUND_OUTBUFFER_COUNT; ++i) {
                 free((void*) sound->m_OutBuffers[i]);
             }
+            free((void*) sound->m_ResampleBuffer);
 
             for (uint32_t i = 0; i < MAX_GROUPS; i++) {
                 SoundGroup* g = &sound->m_Groups[i];
@@ -822,17 +854,87 @@ namespace dmSound
         return RESULT_OK;
     }
 
-    static inline void GetPanScale(float pan, float* left_scale, float* right_scale)
+    // Polynomial approximation of sin(x) for x in [0, pi/2]. The error is below 4e-6, and unlike sinf it is
+    // cheap to evaluate for four samples at a time.
+    static inline dmSIMD::Vector4f Sin4(dmSIMD::Vector4f x)
+    {
+        dmSIMD::Vector4f x2 = dmSIMD::Mul(x, x);
+        dmSIMD::Vector4f r = dmSIMD::Splat(1.0f / 362880.0f);
+        r = dmSIMD::MulAdd(r, x2, dmSIMD::Splat(-1.0f / 5040.0f));
+        r = dmSIMD::MulAdd(r, x2, dmSIMD::Splat(1.0f / 120.0f));
+        r = dmSIMD::MulAdd(r, x2, dmSIMD::Splat(-1.0f / 6.0f));
+        r = dmSIMD::MulAdd(r, x2, dmSIMD::Splat(1.0f));
+        return dmSIMD::Mul(r, x);
+    }
+
+    static inline float Sin(float x)
+    {
+        float x2 = x * x;
+        float r = 1.0f / 362880.0f;
+        r = r * x2 + (-1.0f / 5040.0f);
+        r = r * x2 + (1.0f / 120.0f);
+        r = r * x2 + (-1.0f / 6.0f);
+        r = r * x2 + 1.0f;
+        return r * x;
+    }
+
+    static inline void GetPanScale4(dmSIMD::Vector4f pan, dmSIMD::Vector4f* left_scale, dmSIMD::Vector4f* right_scale)
     {
         // Constant power panning: https://www.cs.cmu.edu/~music/icm-online/readings/panlaws/index.html
-        const float theta = pan * M_PI_2;
-        *left_scale = cosf(theta);
-        *right_scale = sinf(theta);
+        const dmSIMD::Vector4f half_pi = dmSIMD::Splat((float) M_PI_2);
+        dmSIMD::Vector4f theta = dmSIMD::Mul(pan, half_pi);
+        *left_scale = Sin4(dmSIMD::Sub(half_pi, theta));
+        *right_scale = Sin4(theta);
+    }
+
+    static inline void GetPanScale(float pan, float* left_scale, float* right_scale)
+    {
+        const float half_pi = (float) M_PI_2;
+        float theta = pan * half_pi;
+        *left_scale = Sin(half_pi - theta);
+        *right_scale = Sin(theta);
+    }
+
+    /**
+     * Apply the gain and pan ramps to the resampled frames and add them to the (interleaved stereo) mix buffer.
+     * For mono sounds, left and right point to the same frames.
+     */
+    static void MixPanned(const MixContext* mix_context, SoundInstance* instance, const float* left, const float* right, float* mix_buffer, uint32_t mix_buffer_count)
+    {
+        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
+        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
+
+        uint32_t i = 0;
+        dmSIMD::Vector4f index = dmSIMD::Set(0.0f, 1.0f, 2.0f, 3.0f);
+        const dmSIMD::Vector4f four = dmSIMD::Splat(4.0f);
+        for (; i + 4 <= mix_buffer_count; i += 4)
+        {
+            dmSIMD::Vector4f gain = gain_ramp.GetValue4(index);
+            dmSIMD::Vector4f left_scale, right_scale;
+            GetPanScale4(pan_ramp.GetValue4(index), &left_scale, &right_scale);
+
+            dmSIMD::Vector4f l = dmSIMD::Mul(dmSIMD::Mul(dmSIMD::Load(left + i), gain), left_scale);
+            dmSIMD::Vector4f r = dmSIMD::Mul(dmSIMD::Mul(dmSIMD::Load(right + i), gain), right_scale);
+            float* out = mix_buffer + 2 * i;
+            dmSIMD::Store(out, dmSIMD::Add(dmSIMD::Load(out), dmSIMD::InterleaveLo(l, r)));
+            dmSIMD::Store(out + 4, dmSIMD::Add(dmSIMD::Load(out + 4), dmSIMD::InterleaveHi(l, r)));
+            index = dmSIMD::Add(index, four);
+        }
+
+        for (; i < mix_buffer_count; i++)
+        {
+            float gain = gain_ramp.GetValue(i);
+            float left_scale, right_scale;
+            GetPanScale(pan_ramp.GetValue(i), &left_scale, &right_scale);
+            mix_buffer[2 * i]       += left[i] * gain * left_scale;
+            mix_buffer[2 * i + 1]   += right[i] * gain * right_scale;
+        }
     }
 
     template <typename T, int offset, int scale>
-    static void MixResampleUpMono(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
+    static void ResampleUpMono(SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* left, float* right, uint32_t mix_buffer_count)
     {
+        (void)right;
         const uint32_t mask = (1U << RESAMPLE_FRACTION_BITS) - 1U;
         const float range_recip = 1.0f / mask; // TODO: Divide by (1 << RESAMPLE_FRACTION_BITS) OR (1 << RESAMPLE_FRACTION_BITS) - 1?
 
@@ -848,24 +950,15 @@ namespace dmSound
         // We never overfetch for identity mixing as identity mixing is a special case
         frames[instance->m_FrameCount] = frames[instance->m_FrameCount-1];
 
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip;
             T s1 = frames[index];
             T s2 = frames[index + 1];
             s1 = (s1 - offset) * scale;
             s2 = (s2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-
-            float s = (1.0f - mix) * s1 + mix * s2;
-            mix_buffer[2 * i] += s * gain * left_scale;
-            mix_buffer[2 * i + 1] += s * gain * right_scale;
+            left[i] = (1.0f - mix) * s1 + mix * s2;
 
             prev_index = index;
             frac += delta;
@@ -883,7 +976,7 @@ namespace dmSound
     }
 
     template <typename T, int offset, int scale>
-    static void MixResampleUpStereo(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
+    static void ResampleUpStereo(SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* left, float* right, uint32_t mix_buffer_count)
     {
         const uint32_t mask = (1U << RESAMPLE_FRACTION_BITS) - 1U;
         const float range_recip = 1.0f / mask; // TODO: Divide by (1 << RESAMPLE_FRACTION_BITS) OR (1 << RESAMPLE_FRACTION_BITS) - 1?
@@ -901,12 +994,8 @@ namespace dmSound
         frames[2 * instance->m_FrameCount] = frames[2 * instance->m_FrameCount - 2];
         frames[2 * instance->m_FrameCount + 1] = frames[2 * instance->m_FrameCount - 1];
 
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float mix = frac * range_recip;
             T sl1 = frames[2 * index];
             T sl2 = frames[2 * index + 2];
@@ -918,13 +1007,8 @@ namespace dmSound
             sr1 = (sr1 - offset) * scale;
             sr2 = (sr2 - offset) * scale;
 
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-
-            float sl = (1.0f - mix) * sl1 + mix * sl2;
-            float sr = (1.0f - mix) * sr1 + mix * sr2;
-            mix_buffer[2 * i]       += sl * gain * left_scale;
-            mix_buffer[2 * i + 1]   += sr * gain * right_scale;
+            left[i] = (1.0f - mix) * sl1 + mix * sl2;
+            right[i] = (1.0f - mix) * sr1 + mix * sr2;
 
             prev_index = index;
             frac += delta;
@@ -941,84 +1025,67 @@ namespace dmSound
     }
 
     template <typename T, int offset, int scale>
-    static void MixResampleIdentityMono(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
+    static void ResampleIdentityMono(SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* left, float* right, uint32_t mix_buffer_count)
     {
         (void)rate;
         (void)mix_rate;
+        (void)right;
         assert(instance->m_FrameCount == mix_buffer_count);
         T* frames = (T*) instance->m_Frames;
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float s = frames[i];
-            s = (s - offset) * scale * gain;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-            mix_buffer[2 * i]       += s * left_scale;
-            mix_buffer[2 * i + 1]   += s * right_scale;
+            left[i] = (s - offset) * scale;
         }
         instance->m_FrameCount -= mix_buffer_count;
     }
 
     template <typename T, int offset, int scale>
-    static void MixResampleIdentityStereo(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
+    static void ResampleIdentityStereo(SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* left, float* right, uint32_t mix_buffer_count)
     {
         (void)rate;
         (void)mix_rate;
         assert(instance->m_FrameCount == mix_buffer_count);
         T* frames = (T*) instance->m_Frames;
-        Ramp gain_ramp = GetRamp(mix_context, &instance->m_Gain, mix_buffer_count);
-        Ramp pan_ramp = GetRamp(mix_context, &instance->m_Pan, mix_buffer_count);
 
         for (uint32_t i = 0; i < mix_buffer_count; i++)
         {
-            float gain = gain_ramp.GetValue(i);
-            float pan = pan_ramp.GetValue(i);
             float s1 = frames[2 * i];
             float s2 = frames[2 * i + 1];
-            s1 = (s1 - offset) * scale * gain;
-            s2 = (s2 - offset) * scale * gain;
-
-            float left_scale, right_scale;
-            GetPanScale(pan, &left_scale, &right_scale);
-            mix_buffer[2 * i]       += s1 * left_scale;
-            mix_buffer[2 * i + 1]   += s2 * right_scale;
+            left[i] = (s1 - offset) * scale;
+            right[i] = (s2 - offset) * scale;
         }
         instance->m_FrameCount -= mix_buffer_count;
     }
 
-    typedef void (*MixerFunction)(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count);
+    typedef void (*ResamplerFunction)(SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* left, float* right, uint32_t mix_buffer_count);
 
-    struct Mixer
+    struct Resampler
     {
-        uint32_t        m_Channels;
-        uint32_t        m_BitsPerSample;
-        MixerFunction   m_Mixer;
-        Mixer(uint32_t channels, uint32_t bits_per_sample, MixerFunction mixer)
+        uint32_t            m_Channels;
+        uint32_t            m_BitsPerSample;
+        ResamplerFunction   m_Resampler;
+        Resampler(uint32_t channels, uint32_t bits_per_sample, ResamplerFunction resampler)
         {
             m_Channels = channels;
             m_BitsPerSample = bits_per_sample;
-            m_Mixer = mixer;
+            m_Resampler = resampler;
         }
     };
 
-    Mixer g_Mixers[] = {
-            Mixer(1, 8, MixResampleUpMono<uint8_t, 128, 255>),
-            Mixer(1, 16, MixResampleUpMono<int16_t, 0, 1>),
-            Mixer(2, 8, MixResampleUpStereo<uint8_t, 128, 255>),
-            Mixer(2, 16, MixResampleUpStereo<int16_t, 0, 1>),
+    Resampler g_Resamplers[] = {
+            Resampler(1, 8, ResampleUpMono<uint8_t, 128, 255>),
+            Resampler(1, 16, ResampleUpMono<int16_t, 0, 1>),
+            Resampler(2, 8, ResampleUpStereo<uint8_t, 128, 255>),
+            Resampler(2, 16, ResampleUpStereo<int16_t, 0, 1>),
     };
 
-    Mixer g_IdentityMixers[] = {
-            Mixer(1, 8, MixResampleIdentityMono<uint8_t, 128, 255>),
-            Mixer(1, 16, MixResampleIdentityMono<int16_t, 0, 1>),
-            Mixer(2, 8, MixResampleIdentityStereo<uint8_t, 128, 255>),
-            Mixer(2, 16, MixResampleIdentityStereo<int16_t, 0, 1>),
+    Resampler g_IdentityResamplers[] = {
+            Resampler(1, 8, ResampleIdentityMono<uint8_t, 128, 255>),
+            Resampler(1, 16, ResampleIdentityMono<int16_t, 0, 1>),
+            Resampler(2, 8, ResampleIdentityStereo<uint8_t, 128, 255>),
+            Resampler(2, 16, ResampleIdentityStereo<int16_t, 0, 1>),
     };
 
     static void MixResample(const MixContext* mix_context, SoundInstance* instance, const dmSoundCodec::Info* info, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count)
@@ -1026,32 +1093,26 @@ namespace dmSound
         const uint32_t rate = info->m_Rate;
         assert(rate <= mix_rate);
 
-        void (*mixer)(const MixContext* mix_context, SoundInstance* instance, uint32_t rate, uint32_t mix_rate, float* mix_buffer, uint32_t mix_buffer_count) = 0;
+        ResamplerFunction resampler = 0;
 
         bool identity_mixer = rate == mix_rate && instance->m_Speed == 1.0f;
 
-        if (identity_mixer) {
-            uint32_t n = sizeof(g_IdentityMixers) / sizeof(g_IdentityMixers[0]);
-            for (uint32_t i = 0; i < n; i++) {
-                const Mixer& m = g_IdentityMixers[i];
-                if (m.m_BitsPerSample == info->m_BitsPerSample &&
-                    m.m_Channels == info->m_Channels) {
-                    mixer = m.m_Mixer;
-                    break;
-                }
-            }
-        } else {
-            uint32_t n = sizeof(g_Mixers) / sizeof(g_Mixers[0]);
-            for (uint32_t i = 0; i < n; i++) {
-                const Mixer& m = g_Mixers[i];
-                if (m.m_BitsPerSample == info->m_BitsPerSample &&
-                    m.m_Channels == info->m_Channels) {
-                    mixer = m.m_Mixer;
-                    break;
-                }
+        const Resampler* resamplers = identity_mixer ? g_IdentityResamplers : g_Resamplers;
+        uint32_t n = identity_mixer ? sizeof(g_IdentityResamplers) / sizeof(g_IdentityResamplers[0]) : sizeof(g_Resamplers) / sizeof(g_Resamplers[0]);
+        for (uint32_t i = 0; i < n; i++) {
+            const Resampler& r = resamplers[i];
+            if (r.m_BitsPerSample == info->m_BitsPerSample &&
+                r.m_Channels == info->m_Channels) {
+                resampler = r.m_Resampler;
+                break;
             }
         }
-        mixer(mix_context, instance, rate, mix_rate, mix_buffer, mix_buffer_count);
+
+        // Resample to float frames first, and then pan and mix them four frames at a time
+        float* left = g_SoundSystem->m_ResampleBuffer;
+        float* right = left + g_SoundSystem->m_FrameCount;
+        resampler(instance, rate, mix_rate, left, right, mix_buffer_count);
+        MixPanned(mix_context, instance, left, info->m_Channels == 2 ? right : left, mix_buffer, mix_buffer_count);
     }
 
     static void Mix(const MixContext* mix_context, SoundInstance* instance, const dmSoundCodec::Info* info)
@@ -1103,10 +1164,16 @@ namespace dmSound
         return false;
     }
 
-    static void MixInstance(const MixContext* mix_context, SoundInstance* instance) {
+    /**
+     * Decodes enough frames for the next mix buffer into the instance frame buffer.
+     * Only touches the instance itself and its decoder, so different instances can be decoded in parallel.
+     */
+    static void DecodeInstance(SoundInstance* instance) {
         SoundSystem* sound = g_SoundSystem;
         uint32_t decoded = 0;
 
+        instance->m_DecodeError = 0;
+
         dmSoundCodec::Info info;
         dmSoundCodec::GetInfo(sound->m_CodecContext, instance->m_Decoder, &info);
         bool correct_bit_depth = info.m_BitsPerSample == 16 || info.m_BitsPerSample == 8;
@@ -1114,12 +1181,14 @@ namespace dmSound
         if (!correct_bit_depth || !correct_num_channels) {
             dmLogError("Only mono/stereo with 8/16 bits per sample is supported (%s): %u bpp %u ch", GetSoundName(sound, instance), (uint32_t)info.m_BitsPerSample, (uint32_t)info.m_Channels);
             instance->m_Playing = 0;
+            instance->m_DecodeError = 1;
             return;
         }
 
         if (info.m_Rate > sound->m_MixRate) {
             dmLogError("Sounds with rate higher than sample-rate not supported (%d hz > %d hz) (%s)", info.m_Rate, sound->m_MixRate, GetSoundName(sound, instance));
             instance->m_Playing = 0;
+            instance->m_DecodeError = 1;
             return;
         }
 
@@ -1181,9 +1250,28 @@ namespace dmSound
         if (r != dmSoundCodec::RESULT_OK) {
             dmLogWarning("Unable to decode file '%s'. Result %d", GetSoundName(sound, instance), r);
             instance->m_Playing = 0;
+            instance->m_DecodeError = 1;
+        }
+    }
+
+    static void DecodeInstancesRange(void* context, uint32_t begin, uint32_t end) {
+        DM_PROFILE(Sound, "DecodeInstances")
+        SoundSystem* sound = (SoundSystem*) context;
+        for (uint32_t i = begin; i < end; ++i) {
+            DecodeInstance(&sound->m_Instances[sound->m_MixInstances[i]]);
+        }
+    }
+
+    static void MixInstance(const MixContext* mix_context, SoundInstance* instance) {
+        SoundSystem* sound = g_SoundSystem;
+
+        if (instance->m_DecodeError) {
             return;
         }
 
+        dmSoundCodec::Info info;
+        dmSoundCodec::GetInfo(sound->m_CodecContext, instance->m_Decoder, &info);
+
         if (instance->m_FrameCount > 0)
             Mix(mix_context, instance, &info);
 
@@ -1204,14 +1292,28 @@ namespace dmSound
 
             if (g->m_MixBuffer) {
                 uint32_t frame_count = sound->m_FrameCount;
-                float sum_sq_left = 0;
-                float sum_sq_right = 0;
-                float max_sq_left = 0;
-                float max_sq_right = 0;
-                for (uint32_t j = 0; j < frame_count; j++) {
-
-                    float gain = g->m_Gain.m_Current;
-
+                float gain = g->m_Gain.m_Current;
+
+                // Two interleaved stereo frames at a time, i.e. left in x and z, right in y and w
+                uint32_t j = 0;
+                dmSIMD::Vector4f gain4 = dmSIMD::Splat(gain);
+                dmSIMD::Vector4f sum_sq = dmSIMD::Splat(0.0f);
+                dmSIMD::Vector4f max_sq = dmSIMD::Splat(0.0f);
+                for (; j + 2 <= frame_count; j += 2) {
+                    dmSIMD::Vector4f s = dmSIMD::Mul(dmSIMD::Load(g->m_MixBuffer + 2 * j), gain4);
+                    dmSIMD::Vector4f s_sq = dmSIMD::Mul(s, s);
+                    sum_sq = dmSIMD::Add(sum_sq, s_sq);
+                    max_sq = dmSIMD::Max(max_sq, s_sq);
+                }
+                float sum_sq_v[4], max_sq_v[4];
+                dmSIMD::Store(sum_sq_v, sum_sq);
+                dmSIMD::Store(max_sq_v, max_sq);
+                float sum_sq_left = sum_sq_v[0] + sum_sq_v[2];
+                float sum_sq_right = sum_sq_v[1] + sum_sq_v[3];
+                float max_sq_left = dmMath::Max(max_sq_v[0], max_sq_v[2]);
+                float max_sq_right = dmMath::Max(max_sq_v[1], max_sq_v[3]);
+
+                for (; j < frame_count; j++) {
                     float left = g->m_MixBuffer[2 * j + 0] * gain;
                     float right = g->m_MixBuffer[2 * j + 1] * gain;
                     float left_sq = left * left;
@@ -1232,12 +1334,23 @@ namespace dmSound
         }
 
         uint32_t instances = sound->m_Instances.Size();
+        sound->m_MixInstances.SetSize(0);
         for (uint32_t i = 0; i < instances; ++i) {
             SoundInstance* instance = &sound->m_Instances[i];
             if (instance->m_Playing || instance->m_FrameCount > 0)
             {
-                MixInstance(mix_context, instance);
+                sound->m_MixInstances.Push((uint16_t) i);
             }
+        }
+
+        // Decoding (e.g. Vorbis) is by far the most expensive part, so it is spread over the decoder threads.
+        // The mixing into the group buffers is cheap and stays on this thread.
+        dmWorkerPool::ParallelFor(sound->m_DecoderPool, sound->m_MixInstances.Size(), 1, DecodeInstancesRange, sound);
+
+        uint32_t mix_instances = sound->m_MixInstances.Size();
+        for (uint32_t i = 0; i < mix_instances; ++i) {
+            SoundInstance* instance = &sound->m_Instances[sound->m_MixInstances[i]];
+            MixInstance(mix_context, instance);
 
             if (instance->m_EndOfStream && instance->m_FrameCount == 0) {
                 instance->m_Playing = 0;
@@ -1261,8 +1374,8 @@ namespace dmSound
             return;
         }
 
-        for (uint32_t i = 0; i < MAX_GROUPS; i++) {
-            SoundGroup* g = &sound->m_Groups[i];
+        for (uint32_t group_i = 0; group_i < MAX_GROUPS; group_i++) {
+            SoundGroup* g = &sound->m_Groups[group_i];
             if (g->m_MixBuffer == 0x0)
             {
                 continue;
@@ -1276,7 +1389,19 @@ namespace dmSound
                 continue;
             }
             Ramp ramp = GetRamp(mix_context, &g->m_Gain, n);
-            for (uint32_t i = 0; i < n; i++) {
+            uint32_t i = 0;
+            dmSIMD::Vector4f index = dmSIMD::Set(0.0f, 1.0f, 2.0f, 3.0f);
+            for (; i + 4 <= n; i += 4) {
+                dmSIMD::Vector4f gain = ramp.GetValue4(index);
+                gain = dmSIMD::Min(dmSIMD::Max(gain, dmSIMD::Splat(0.0f)), dmSIMD::Splat(1.0f));
+
+                float* s = g->m_MixBuffer + 2 * i;
+                float* d = mix_buffer + 2 * i;
+                dmSIMD::Store(d, dmSIMD::MulAdd(dmSIMD::Load(s), dmSIMD::InterleaveLo(gain, gain), dmSIMD::Load(d)));
+                dmSIMD::Store(d + 4, dmSIMD::MulAdd(dmSIMD::Load(s + 4), dmSIMD::InterleaveHi(gain, gain), dmSIMD::Load(d + 4)));
+                index = dmSIMD::Add(index, dmSIMD::Splat(4.0f));
+            }
+            for (; i < n; i++) {
                 float gain = ramp.GetValue(i);
                 gain = dmMath::Clamp(gain, 0.0f, 1.0f);
 
@@ -1288,7 +1413,22 @@ namespace dmSound
         }
 
         Ramp ramp = GetRamp(mix_context, &master->m_Gain, n);
-        for (uint32_t i = 0; i < n; i++) {
+        uint32_t i = 0;
+        dmSIMD::Vector4f index = dmSIMD::Set(0.0f, 1.0f, 2.0f, 3.0f);
+        const dmSIMD::Vector4f min_value = dmSIMD::Splat(-32768.0f);
+        const dmSIMD::Vector4f max_value = dmSIMD::Splat(32767.0f);
+        for (; i + 4 <= n; i += 4) {
+            dmSIMD::Vector4f gain = ramp.GetValue4(index);
+            float* s = mix_buffer + 2 * i;
+            float clamped[8];
+            dmSIMD::Store(clamped, dmSIMD::Max(min_value, dmSIMD::Min(max_value, dmSIMD::Mul(dmSIMD::Load(s), dmSIMD::InterleaveLo(gain, gain)))));
+            dmSIMD::Store(clamped + 4, dmSIMD::Max(min_value, dmSIMD::Min(max_value, dmSIMD::Mul(dmSIMD::Load(s + 4), dmSIMD::InterleaveHi(gain, gain)))));
+            for (uint32_t j = 0; j < 8; ++j) {
+                out[2 * i + j] = (int16_t) clamped[j];
+            }
+            index = dmSIMD::Add(index, dmSIMD::Splat(4.0f));
+        }
+        for (; i < n; i++) {
             float gain = ramp.GetValue(i);
             float s1 = mix_buffer[2 * i] * gain;
             float s2 = mix_buffer[2 * i + 1] * gain;
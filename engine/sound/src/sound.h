@@ -81,6 +81,8 @@ namespace dmSound
         uint32_t m_BufferSize;
         uint32_t m_FrameCount;
         uint32_t m_MaxInstances;
+        // Number of threads decoding sound instances in parallel with the mixer. Zero (default) decodes on the mixer thread
+        uint32_t m_DecoderThreadCount;
         bool     m_UseThread;
 
         InitializeParams()
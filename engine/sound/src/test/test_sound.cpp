@@ -491,6 +491,125 @@ TEST_P(dmSoundVerifyTest, NoEarlyBailOnSoundInstances)
     ASSERT_EQ(dmSound::RESULT_OK, r);
 }
 
+TEST_P(dmSoundVerifyTest, Pan)
+{
+    TestParams params = GetParam();
+    dmSound::Result r;
+    dmSound::HSoundData sd = 0;
+    // A constant signal makes it easy to verify the constant power panning
+    dmSound::NewSoundData(MONO_DC_44100_88200_WAV, MONO_DC_44100_88200_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV, &sd, 1234);
+
+    dmSound::HSoundInstance instance = 0;
+    r = dmSound::NewSoundInstance(sd, &instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::Play(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+
+    const float pans[] = { -1.0f, -0.5f, 0.0f, 0.3f, 1.0f };
+    for (uint32_t p = 0; p < sizeof(pans) / sizeof(pans[0]); ++p) {
+        r = dmSound::SetParameter(instance, dmSound::PARAMETER_PAN, Vectormath::Aos::Vector4(pans[p], 0, 0, 0));
+        ASSERT_EQ(dmSound::RESULT_OK, r);
+
+        // The pan is ramped during the first update that mixes any buffers, and is constant in the next
+        uint32_t mix_count = 0;
+        while (mix_count < 2) {
+            uint32_t queued = g_LoopbackDevice->m_TotalBuffersQueued;
+            r = dmSound::Update();
+            ASSERT_EQ(dmSound::RESULT_OK, r);
+            if (g_LoopbackDevice->m_TotalBuffersQueued > queued) {
+                ++mix_count;
+            }
+        }
+
+        double theta = (pans[p] + 1.0) * 0.5 * M_PI_2;
+        double expected_left = 0.8 * 32768.0 * cos(theta);
+        double expected_right = 0.8 * 32768.0 * sin(theta);
+        uint32_t frame_count = g_LoopbackDevice->m_AllOutput.Size() / 2;
+        for (uint32_t i = frame_count - params.m_BufferFrameCount; i < frame_count; ++i) {
+            ASSERT_NEAR(expected_left, g_LoopbackDevice->m_AllOutput[2 * i], 2.0);
+            ASSERT_NEAR(expected_right, g_LoopbackDevice->m_AllOutput[2 * i + 1], 2.0);
+        }
+    }
+
+    r = dmSound::DeleteSoundInstance(instance);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+    r = dmSound::DeleteSoundData(sd);
+    ASSERT_EQ(dmSound::RESULT_OK, r);
+}
+
+struct DecodeSound
+{
+    void*                   m_Sound;
+    uint32_t                m_SoundSize;
+    dmSound::SoundDataType  m_Type;
+};
+
+// Plays a mix of looping Ogg and wav voices on the loopback device and returns everything that was output
+static void MixWithDecoderThreads(uint32_t decoder_thread_count, std::vector<int16_t>& output)
+{
+    const DecodeSound sounds[] = {
+        { CLICK_TRACK_OGG, CLICK_TRACK_OGG_SIZE, dmSound::SOUND_DATA_TYPE_OGG_VORBIS },
+        { LAYER_GUITAR_A_OGG, LAYER_GUITAR_A_OGG_SIZE, dmSound::SOUND_DATA_TYPE_OGG_VORBIS },
+        { TONE_MONO_22050_OGG, TONE_MONO_22050_OGG_SIZE, dmSound::SOUND_DATA_TYPE_OGG_VORBIS },
+        { DRUMLOOP_WAV, DRUMLOOP_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV },
+        { MONO_TONE_440_32000_64000_WAV, MONO_TONE_440_32000_64000_WAV_SIZE, dmSound::SOUND_DATA_TYPE_WAV },
+    };
+    const uint32_t sound_count = sizeof(sounds) / sizeof(sounds[0]);
+    const uint32_t instance_count = 12;
+
+    dmSound::InitializeParams params;
+    params.m_MaxBuffers = MAX_BUFFERS;
+    params.m_MaxSources = MAX_SOURCES;
+    params.m_OutputDevice = "loopback";
+    params.m_FrameCount = 2048;
+    params.m_UseThread = false;
+    params.m_DecoderThreadCount = decoder_thread_count;
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+
+    dmSound::HSoundData sound_data[sound_count];
+    for (uint32_t i = 0; i < sound_count; ++i) {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(sounds[i].m_Sound, sounds[i].m_SoundSize, sounds[i].m_Type, &sound_data[i], i));
+    }
+
+    dmSound::HSoundInstance instances[instance_count];
+    for (uint32_t i = 0; i < instance_count; ++i) {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sound_data[i % sound_count], &instances[i]));
+        dmSound::SetLooping(instances[i], true);
+        dmSound::SetParameter(instances[i], dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(1.0f / instance_count, 0, 0, 0));
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instances[i]));
+    }
+
+    for (uint32_t i = 0; i < 200; ++i) {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Update());
+    }
+    output.assign(g_LoopbackDevice->m_AllOutput.Begin(), g_LoopbackDevice->m_AllOutput.End());
+
+    for (uint32_t i = 0; i < instance_count; ++i) {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundInstance(instances[i]));
+    }
+    for (uint32_t i = 0; i < sound_count; ++i) {
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::DeleteSoundData(sound_data[i]));
+    }
+    ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+}
+
+TEST(dmSoundDecoderThreads, SameOutput)
+{
+    std::vector<int16_t> serial;
+    MixWithDecoderThreads(0, serial);
+    ASSERT_LT(0u, serial.size());
+    uint32_t non_zero = 0;
+    for (uint32_t i = 0; i < serial.size(); ++i) {
+        non_zero += serial[i] != 0;
+    }
+    ASSERT_LT(serial.size() / 2, non_zero);
+
+    std::vector<int16_t> threaded;
+    MixWithDecoderThreads(3, threaded);
+    ASSERT_EQ(serial.size(), threaded.size());
+    ASSERT_TRUE(serial == threaded);
+}
+
 const TestParams params_verify_test[] = {
 TestParams("loopback",
             MONO_TONE_440_22050_44100_WAV,
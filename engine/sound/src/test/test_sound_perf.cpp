@@ -23,6 +23,13 @@
 #include "../sound_codec.h"
 #include "../sound_decoder.h"
 
+#include "test/mono_tone_440_22050_44100.wav.embed.h"
+#include "test/mono_tone_440_32000_64000.wav.embed.h"
+#include "test/mono_tone_440_44100_88200.wav.embed.h"
+#include "test/stereo_tone_440_22050_44100.wav.embed.h"
+#include "test/stereo_tone_440_32000_64000.wav.embed.h"
+#include "test/stereo_tone_440_44100_88200.wav.embed.h"
+
 #define DEF_EMBED(x) \
     extern unsigned char x[]; \
     extern uint32_t x##_SIZE;
@@ -155,6 +162,126 @@ TEST_F(dmSoundTest, MeasureTremoloSkip)
 }
 #endif
 
+// Like the null device, but it always wants more data, which lets the mixer run headless
+namespace dmDeviceBench
+{
+    static uint32_t g_BuffersQueued = 0;
+
+    dmSound::Result DeviceBenchOpen(const dmSound::OpenDeviceParams* params, dmSound::HDevice* device)
+    {
+        *device = (dmSound::HDevice) &g_BuffersQueued;
+        return dmSound::RESULT_OK;
+    }
+
+    void DeviceBenchClose(dmSound::HDevice device)
+    {
+    }
+
+    dmSound::Result DeviceBenchQueue(dmSound::HDevice device, const int16_t* samples, uint32_t sample_count)
+    {
+        g_BuffersQueued++;
+        return dmSound::RESULT_OK;
+    }
+
+    uint32_t DeviceBenchFreeBufferSlots(dmSound::HDevice device)
+    {
+        return 1;
+    }
+
+    void DeviceBenchDeviceInfo(dmSound::HDevice device, dmSound::DeviceInfo* info)
+    {
+        info->m_MixRate = 44100;
+    }
+
+    void DeviceBenchRestart(dmSound::HDevice device)
+    {
+    }
+
+    void DeviceBenchStop(dmSound::HDevice device)
+    {
+    }
+
+    DM_DECLARE_SOUND_DEVICE(BenchSoundDevice, "bench", DeviceBenchOpen, DeviceBenchClose, DeviceBenchQueue, DeviceBenchFreeBufferSlots, DeviceBenchDeviceInfo, DeviceBenchRestart, DeviceBenchStop);
+}
+
+struct MixSound
+{
+    unsigned char* m_Sound;
+    uint32_t       m_Size;
+};
+
+// Mixes a mix of mono/stereo, resampled and identity rate voices with different pan and gain
+TEST(dmSoundMixTest, MeasureMix)
+{
+    const MixSound sounds[] = {
+        { MONO_TONE_440_22050_44100_WAV, MONO_TONE_440_22050_44100_WAV_SIZE },
+        { MONO_TONE_440_32000_64000_WAV, MONO_TONE_440_32000_64000_WAV_SIZE },
+        { MONO_TONE_440_44100_88200_WAV, MONO_TONE_440_44100_88200_WAV_SIZE },
+        { STEREO_TONE_440_22050_44100_WAV, STEREO_TONE_440_22050_44100_WAV_SIZE },
+        { STEREO_TONE_440_32000_64000_WAV, STEREO_TONE_440_32000_64000_WAV_SIZE },
+        { STEREO_TONE_440_44100_88200_WAV, STEREO_TONE_440_44100_88200_WAV_SIZE },
+    };
+    const uint32_t sound_count = sizeof(sounds) / sizeof(sounds[0]);
+    const uint32_t voice_counts[] = { 8, 32, 64 };
+    const uint32_t iterations = 500;
+
+    printf("\n");
+    for (uint32_t v = 0; v < sizeof(voice_counts) / sizeof(voice_counts[0]); ++v)
+    {
+        const uint32_t voice_count = voice_counts[v];
+
+        dmSound::InitializeParams params;
+        params.m_OutputDevice = "bench";
+        params.m_MaxSources = voice_count;
+        params.m_MaxInstances = voice_count;
+        params.m_UseThread = false;
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Initialize(0, &params));
+
+        dmSound::HSoundData sound_data[sound_count];
+        for (uint32_t i = 0; i < sound_count; ++i)
+        {
+            ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundData(sounds[i].m_Sound, sounds[i].m_Size, dmSound::SOUND_DATA_TYPE_WAV, &sound_data[i], i));
+        }
+
+        std::vector<dmSound::HSoundInstance> instances(voice_count);
+        for (uint32_t i = 0; i < voice_count; ++i)
+        {
+            ASSERT_EQ(dmSound::RESULT_OK, dmSound::NewSoundInstance(sound_data[i % sound_count], &instances[i]));
+            dmSound::SetLooping(instances[i], true);
+            dmSound::SetParameter(instances[i], dmSound::PARAMETER_GAIN, Vectormath::Aos::Vector4(1.0f / voice_count, 0, 0, 0));
+            dmSound::SetParameter(instances[i], dmSound::PARAMETER_PAN, Vectormath::Aos::Vector4(-1.0f + 2.0f * i / voice_count, 0, 0, 0));
+            ASSERT_EQ(dmSound::RESULT_OK, dmSound::Play(instances[i]));
+        }
+
+        // Let the gain and pan ramps settle
+        dmSound::Update();
+        dmSound::Update();
+
+        uint32_t buffers_queued = dmDeviceBench::g_BuffersQueued;
+        uint64_t start = dmTime::GetTime();
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            dmSound::Update();
+        }
+        uint64_t elapsed = dmTime::GetTime() - start;
+        buffers_queued = dmDeviceBench::g_BuffersQueued - buffers_queued;
+        ASSERT_EQ(iterations, buffers_queued);
+
+        printf("%3u voices: %7.1f us/buffer (%u frames)\n", voice_count, elapsed / (float) buffers_queued, params.m_FrameCount);
+
+        for (uint32_t i = 0; i < voice_count; ++i)
+        {
+            dmSound::Stop(instances[i]);
+            dmSound::DeleteSoundInstance(instances[i]);
+        }
+        for (uint32_t i = 0; i < sound_count; ++i)
+        {
+            dmSound::DeleteSoundData(sound_data[i]);
+        }
+        ASSERT_EQ(dmSound::RESULT_OK, dmSound::Finalize());
+    }
+}
+
 int main(int argc, char **argv)
 {
     jc_test_init(&argc, argv);